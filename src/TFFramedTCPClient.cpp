@@ -0,0 +1,345 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include "TFFramedTCPClient.h"
+
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+
+#include "TFNetwork.h"
+
+#define debugfln(fmt, ...) tf_network_debugfln("TFFramedTCPClient[%p]::" fmt, static_cast<void *>(this) __VA_OPT__(,) __VA_ARGS__)
+
+const char *get_tf_framed_tcp_client_frame_length_name(TFFramedTCPClientFrameLength frame_length)
+{
+    switch (frame_length) {
+    case TFFramedTCPClientFrameLength::Fixed:
+        return "Fixed";
+
+    case TFFramedTCPClientFrameLength::LengthField:
+        return "LengthField";
+
+    case TFFramedTCPClientFrameLength::EndByte:
+        return "EndByte";
+
+    case TFFramedTCPClientFrameLength::Custom:
+        return "Custom";
+    }
+
+    return "<Unknown>";
+}
+
+TFFramedTCPClient::TFFramedTCPClient(const TFFramedTCPClientFraming *framing_) : framing(*framing_)
+{
+    framing.max_frame_length = std::clamp<uint16_t>(framing.max_frame_length, 1, TF_FRAMED_TCP_CLIENT_MAX_FRAME_LENGTH);
+    framing.fixed_length     = std::clamp<uint16_t>(framing.fixed_length, 1, framing.max_frame_length);
+    framing.length_size      = framing.length_size == 2 || framing.length_size == 4 ? framing.length_size : 1;
+
+    // the length field has to fit into the frame buffer, otherwise it is read
+    // beyond the maximum frame length
+    if (framing.frame_length == TFFramedTCPClientFrameLength::LengthField
+     && static_cast<size_t>(framing.length_offset) + framing.length_size > framing.max_frame_length) {
+        debugfln("TFFramedTCPClient() length field beyond maximum frame length (length_offset=%u length_size=%u max_frame_length=%u)",
+                 framing.length_offset, framing.length_size, framing.max_frame_length);
+
+        if (framing.length_size > framing.max_frame_length) {
+            framing.length_size = 1;
+        }
+
+        framing.length_offset = framing.max_frame_length - framing.length_size;
+    }
+
+    reset_frame();
+}
+
+TFFramedTCPClient::~TFFramedTCPClient()
+{
+    delete[] send_buffer;
+}
+
+bool TFFramedTCPClient::queue_send(const uint8_t *buffer, size_t length)
+{
+    if (send_used + length > TF_FRAMED_TCP_CLIENT_SEND_BUFFER_SIZE && !flush_send()) {
+        return false;
+    }
+
+    if (length > TF_FRAMED_TCP_CLIENT_SEND_BUFFER_SIZE) {
+        if (!send(buffer, length)) {
+            disconnect(TFGenericTCPClientDisconnectReason::SocketSendFailed, errno);
+            return false;
+        }
+
+        return true;
+    }
+
+    if (send_buffer == nullptr) {
+        send_buffer = new uint8_t[TF_FRAMED_TCP_CLIENT_SEND_BUFFER_SIZE];
+    }
+
+    memcpy(send_buffer + send_used, buffer, length);
+    send_used += length;
+
+    return true;
+}
+
+bool TFFramedTCPClient::flush_send()
+{
+    if (send_used == 0) {
+        return true;
+    }
+
+    size_t length = send_used;
+    send_used = 0;
+
+    if (!send(send_buffer, length)) {
+        disconnect(TFGenericTCPClientDisconnectReason::SocketSendFailed, errno);
+        return false;
+    }
+
+    return true;
+}
+
+void TFFramedTCPClient::reset_frame()
+{
+    frame_used     = 0;
+    frame_length   = framing.frame_length == TFFramedTCPClientFrameLength::Fixed ? framing.fixed_length : 0;
+    frame_started  = framing.start_byte < 0;
+    escape_pending = false;
+}
+
+void TFFramedTCPClient::close_hook()
+{
+    reset_frame();
+    send_used = 0;
+
+    framed_close_hook();
+}
+
+void TFFramedTCPClient::tick_hook()
+{
+    framed_tick_hook();
+
+    if (socket_fd >= 0) {
+        flush_send();
+    }
+}
+
+bool TFFramedTCPClient::recv_hook()
+{
+    ssize_t result = recv(receive_buffer, sizeof(receive_buffer));
+
+    if (result < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            disconnect(TFGenericTCPClientDisconnectReason::SocketReceiveFailed, errno);
+        }
+
+        return false;
+    }
+
+    if (result == 0) {
+        disconnect(TFGenericTCPClientDisconnectReason::DisconnectedByPeer, -1);
+        return false;
+    }
+
+    received_hook(receive_buffer, static_cast<size_t>(result));
+
+    return consume(receive_buffer, static_cast<size_t>(result));
+}
+
+// Returns false if the client got disconnected
+bool TFFramedTCPClient::consume(const uint8_t *buffer, size_t length)
+{
+    size_t offset = 0;
+
+    // Without start and escape bytes the frame can be copied in chunks
+    if (framing.start_byte < 0 && framing.escape_byte < 0 && framing.frame_length != TFFramedTCPClientFrameLength::Custom) {
+        while (offset < length) {
+            size_t chunk_length;
+
+            if (framing.frame_length == TFFramedTCPClientFrameLength::EndByte) {
+                const uint8_t *end = static_cast<const uint8_t *>(memchr(buffer + offset, framing.end_byte, length - offset));
+
+                chunk_length = end != nullptr ? static_cast<size_t>(end - (buffer + offset)) + 1 : length - offset;
+
+                if (frame_used + chunk_length > framing.max_frame_length) {
+                    return drop_frame("Frame is longer than maximum");
+                }
+            }
+            else if (frame_length > 0) {
+                chunk_length = std::min(frame_length - frame_used, length - offset);
+            }
+            else {
+                chunk_length = std::min(framing.length_offset + framing.length_size - frame_used, length - offset);
+            }
+
+            memcpy(frame + frame_used, buffer + offset, chunk_length);
+            frame_used += chunk_length;
+            offset += chunk_length;
+
+            if (!check_frame(false)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    for (; offset < length; ++offset) {
+        uint8_t byte = buffer[offset];
+        bool escaped = false;
+
+        if (escape_pending) {
+            escape_pending = false;
+            escaped        = true;
+        }
+        else if (framing.escape_byte >= 0 && byte == framing.escape_byte) {
+            escape_pending = true;
+            continue;
+        }
+        else if (framing.start_byte >= 0 && byte == framing.start_byte) {
+            if (frame_used > 0) {
+                debugfln("consume() unexpected start byte, dropping %zu bytes", frame_used);
+            }
+
+            reset_frame();
+            frame_started = true;
+            continue;
+        }
+
+        if (!frame_started) {
+            continue;
+        }
+
+        if (frame_used >= framing.max_frame_length) {
+            if (!drop_frame("Frame is longer than maximum")) {
+                return false;
+            }
+
+            continue;
+        }
+
+        frame[frame_used++] = byte;
+
+        if (!check_frame(escaped)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Returns false if the client got disconnected
+bool TFFramedTCPClient::check_frame(bool escaped)
+{
+    if (frame_used == 0) {
+        return true;
+    }
+
+    if (frame_length == 0) {
+        switch (framing.frame_length) {
+        case TFFramedTCPClientFrameLength::Fixed:
+            frame_length = framing.fixed_length;
+            break;
+
+        case TFFramedTCPClientFrameLength::LengthField:
+            if (frame_used < static_cast<size_t>(framing.length_offset + framing.length_size)) {
+                return true;
+            }
+
+            frame_length = decode_length_field();
+
+            if (frame_length == 0) {
+                return drop_frame("Length field is out-of-range");
+            }
+
+            break;
+
+        case TFFramedTCPClientFrameLength::EndByte:
+            if (escaped || frame[frame_used - 1] != framing.end_byte) {
+                return true;
+            }
+
+            frame_length = frame_used;
+            break;
+
+        case TFFramedTCPClientFrameLength::Custom:
+            frame_length = frame_length_hook(frame, frame_used);
+
+            if (frame_length == 0) {
+                return true;
+            }
+
+            if (frame_length < frame_used || frame_length > framing.max_frame_length) {
+                return drop_frame("Custom frame length is out-of-range");
+            }
+
+            break;
+        }
+    }
+
+    if (frame_used < frame_length) {
+        return true;
+    }
+
+    size_t length = frame_used;
+
+    // The frame stays in the buffer until the next byte is appended
+    reset_frame();
+    frame_hook(frame, length);
+
+    return socket_fd >= 0;
+}
+
+// Returns 0 if the frame length is out-of-range
+size_t TFFramedTCPClient::decode_length_field() const
+{
+    size_t header_length = framing.length_offset + framing.length_size;
+    uint32_t value = 0;
+
+    for (size_t i = 0; i < framing.length_size; ++i) {
+        value = (value << 8) | frame[framing.length_offset + (framing.length_big_endian ? i : framing.length_size - 1u - i)];
+    }
+
+    int64_t length = static_cast<int64_t>(value) + framing.length_adjustment;
+
+    if (length < static_cast<int64_t>(header_length) || length > framing.max_frame_length) {
+        return 0;
+    }
+
+    return static_cast<size_t>(length);
+}
+
+// Returns false if the client got disconnected
+bool TFFramedTCPClient::drop_frame(const char *reason)
+{
+    (void)reason;
+
+    if (framing.start_byte < 0) {
+        debugfln("drop_frame() cannot resynchronize, disconnecting (reason=%s)", reason);
+        disconnect(TFGenericTCPClientDisconnectReason::ProtocolError, -1);
+        return false;
+    }
+
+    debugfln("drop_frame() dropping %zu bytes (reason=%s)", frame_used, reason);
+    reset_frame();
+
+    return true;
+}
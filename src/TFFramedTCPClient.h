@@ -0,0 +1,118 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "TFGenericTCPClient.h"
+
+// configuration
+#ifndef TF_FRAMED_TCP_CLIENT_RECEIVE_BUFFER_SIZE
+#define TF_FRAMED_TCP_CLIENT_RECEIVE_BUFFER_SIZE 256
+#endif
+
+#ifndef TF_FRAMED_TCP_CLIENT_MAX_FRAME_LENGTH
+#define TF_FRAMED_TCP_CLIENT_MAX_FRAME_LENGTH    260
+#endif
+
+#ifndef TF_FRAMED_TCP_CLIENT_SEND_BUFFER_SIZE
+#define TF_FRAMED_TCP_CLIENT_SEND_BUFFER_SIZE    260
+#endif
+
+static_assert(TF_FRAMED_TCP_CLIENT_MAX_FRAME_LENGTH >= 4, "Framed TCP client frame buffer too small for a length field");
+
+enum class TFFramedTCPClientFrameLength
+{
+    Fixed,       // fixed_length bytes
+    LengthField, // value of the length field plus length_adjustment bytes
+    EndByte,     // up to and including the end_byte
+    Custom,      // decided by frame_length_hook()
+};
+
+const char *get_tf_framed_tcp_client_frame_length_name(TFFramedTCPClientFrameLength frame_length);
+
+// Describes how frames are delimited in the received byte stream. If a start
+// byte is given, bytes before it are skipped and it is not part of the frame.
+// If an escape byte is given, it is removed and the following byte is taken
+// literally. The frame length is determined on the unescaped frame. With a
+// start byte a broken frame is dropped and the next start byte is awaited,
+// without a start byte the stream cannot be resynchronized and a broken frame
+// disconnects with the ProtocolError reason. A length field that does not fit
+// into max_frame_length is moved to the end of the maximum frame
+struct TFFramedTCPClientFraming
+{
+    int16_t start_byte                        = -1; // -1 if there is no start byte
+    int16_t escape_byte                       = -1; // -1 if there is no escape byte
+    TFFramedTCPClientFrameLength frame_length = TFFramedTCPClientFrameLength::Fixed;
+    uint16_t fixed_length                     = 0;
+    uint16_t length_offset                    = 0;
+    uint8_t length_size                       = 1; // 1, 2 or 4 bytes
+    bool length_big_endian                    = true;
+    int16_t length_adjustment                 = 0;
+    uint8_t end_byte                          = 0;
+    uint16_t max_frame_length                 = TF_FRAMED_TCP_CLIENT_MAX_FRAME_LENGTH;
+};
+
+// Base for clients of framed protocols. Received data is read in chunks of up
+// to TF_FRAMED_TCP_CLIENT_RECEIVE_BUFFER_SIZE bytes per recv call and split
+// into frames according to the framing, each complete frame is passed to
+// frame_hook(). Data queued by queue_send() is sent with a single send call per
+// tick, after framed_tick_hook() returned. Matching responses to requests is
+// left to the subclass, because the key is protocol specific
+class TFFramedTCPClient : public TFGenericTCPClient
+{
+public:
+    TFFramedTCPClient(const TFFramedTCPClientFraming *framing_);
+    virtual ~TFFramedTCPClient();
+
+protected:
+    virtual void framed_close_hook() = 0;
+    virtual void framed_tick_hook()  = 0;
+    virtual void frame_hook(const uint8_t *frame, size_t length) = 0; // can disconnect
+    virtual size_t frame_length_hook(const uint8_t * /*frame*/, size_t /*length*/) { return 0; } // 0 if not known yet
+    virtual void received_hook(const uint8_t * /*buffer*/, size_t /*length*/) {} // raw bytes, before framing
+
+    bool queue_send(const uint8_t *buffer, size_t length); // false if the client got disconnected
+    bool flush_send(); // false if the client got disconnected
+    void reset_frame();
+
+private:
+    void close_hook() override final;
+    void tick_hook() override final;
+    bool recv_hook() override final;
+
+    bool consume(const uint8_t *buffer, size_t length);
+    bool append_frame_byte(uint8_t byte);
+    bool check_frame(bool escaped);
+    size_t decode_length_field() const;
+    bool drop_frame(const char *reason);
+
+    TFFramedTCPClientFraming framing;
+    uint8_t receive_buffer[TF_FRAMED_TCP_CLIENT_RECEIVE_BUFFER_SIZE];
+    uint8_t frame[TF_FRAMED_TCP_CLIENT_MAX_FRAME_LENGTH];
+    size_t frame_used    = 0;
+    size_t frame_length  = 0; // 0 if not known yet
+    bool frame_started   = false;
+    bool escape_pending  = false;
+    uint8_t *send_buffer = nullptr;
+    size_t send_used     = 0;
+};
@@ -126,6 +126,9 @@ const char *get_tf_generic_tcp_client_disconnect_reason_name(TFGenericTCPClientD
 
     case TFGenericTCPClientDisconnectReason::ProtocolError:
         return "ProtocolError";
+
+    case TFGenericTCPClientDisconnectReason::IdleProbeFailed:
+        return "IdleProbeFailed";
     }
 
     return "<Unknown>";
@@ -213,6 +216,7 @@ void TFGenericTCPClient::connect(const char *host, uint16_t port,
     }
 
     TFNetwork::NonReentrantScope scope(&non_reentrant);
+    tf_network_allocation_scope(Connect);
 
     if (host == nullptr || strlen(host) == 0 || port == 0 || !disconnect_callback) {
         debugfln("connect(host=%s port=%u) invalid argument", TFNetwork::printf_safe(host), port);
@@ -243,6 +247,7 @@ TFGenericTCPClientDisconnectResult TFGenericTCPClient::disconnect()
     }
 
     TFNetwork::NonReentrantScope scope(&non_reentrant);
+    tf_network_allocation_scope(Disconnect);
 
     if (host == nullptr) {
         debugfln("disconnect() not connected");
@@ -292,6 +297,7 @@ void TFGenericTCPClient::tick()
     }
 
     TFNetwork::NonReentrantScope scope(&non_reentrant);
+    tf_network_allocation_scope(ClientTick);
 
     if (host == nullptr) {
         return;
@@ -366,7 +372,7 @@ void TFGenericTCPClient::tick()
 
             pending_host_address = 0;
 
-            if (::connect(pending_socket_fd, reinterpret_cast<struct sockaddr *>(&addr_in), sizeof(addr_in)) < 0 && errno != EINPROGRESS) {
+            if (tf_network_socket_connect(pending_socket_fd, reinterpret_cast<struct sockaddr *>(&addr_in), sizeof(addr_in)) < 0 && errno != EINPROGRESS) {
                 abort_connect(TFGenericTCPClientConnectResult::SocketConnectFailed, errno);
                 return;
             }
@@ -419,6 +425,7 @@ void TFGenericTCPClient::tick()
 
         socket_fd                   = pending_socket_fd;
         pending_socket_fd           = -1;
+        last_received               = now_us();
         this->connect_callback      = nullptr;
         disconnect_callback         = std::move(pending_disconnect_callback);
         pending_disconnect_callback = nullptr;
@@ -442,13 +449,13 @@ void TFGenericTCPClient::close()
 {
     if (pending_socket_fd >= 0) {
         ::shutdown(pending_socket_fd, SHUT_RDWR);
-        ::close(pending_socket_fd);
+        tf_network_socket_close(pending_socket_fd);
         pending_socket_fd = -1;
     }
 
     if (socket_fd >= 0) {
         ::shutdown(socket_fd, SHUT_RDWR);
-        ::close(socket_fd);
+        tf_network_socket_close(socket_fd);
         socket_fd = -1;
     }
 
@@ -496,7 +503,7 @@ bool TFGenericTCPClient::send(const uint8_t *buffer, size_t length)
         --tries_remaining;
 
         errno = 0; // clear errno, because it will be logged unconditionally
-        ssize_t result = ::send(socket_fd, buffer + offset, length - offset, MSG_NOSIGNAL);
+        ssize_t result = tf_network_socket_send(socket_fd, buffer + offset, length - offset, MSG_NOSIGNAL);
         saved_errno = errno;
 
 #if defined(TF_NETWORK_DEBUG_LOG) && TF_NETWORK_DEBUG_LOG > 1
@@ -537,7 +544,7 @@ bool TFGenericTCPClient::send(const uint8_t *buffer, size_t length)
 ssize_t TFGenericTCPClient::recv(uint8_t *buffer, size_t length)
 {
     errno = 0; // clear errno, because it will be logged unconditionally
-    ssize_t result = ::recv(socket_fd, buffer, length, 0);
+    ssize_t result = tf_network_socket_recv(socket_fd, buffer, length, 0);
     int saved_errno = errno;
 
 #if defined(TF_NETWORK_DEBUG_LOG) && TF_NETWORK_DEBUG_LOG > 1
@@ -565,13 +572,17 @@ ssize_t TFGenericTCPClient::recv(uint8_t *buffer, size_t length)
     }
 #endif
 
+    if (result > 0) {
+        last_received = now_us();
+    }
+
     if (result > 0 && transfer_hook_head != nullptr) {
         TFGenericTCPClientTransferHook *hook = transfer_hook_head;
 
         while (hook != nullptr) {
             TFGenericTCPClientTransferHook *next = hook->next;
 
-            hook->callback(TFGenericTCPClientTransferDirection::Receive, buffer, length);
+            hook->callback(TFGenericTCPClientTransferDirection::Receive, buffer, static_cast<size_t>(result));
 
             hook = next;
         }
@@ -80,6 +80,7 @@ enum class TFGenericTCPClientDisconnectReason
     SocketSendFailed,    // errno
     DisconnectedByPeer,
     ProtocolError,
+    IdleProbeFailed,
 };
 
 const char *get_tf_generic_tcp_client_disconnect_reason_name(TFGenericTCPClientDisconnectReason reason);
@@ -150,6 +151,7 @@ protected:
     int pending_socket_fd         = -1;
     micros_t connect_deadline     = 0_s;
     int socket_fd                 = -1;
+    micros_t last_received        = 0_s; // or connected, for idle probes
 };
 
 class TFGenericTCPSharedClient
@@ -58,6 +58,7 @@ void TFGenericTCPClientPool::acquire(const char *host, uint16_t port,
     }
 
     TFNetwork::NonReentrantScope scope(&non_reentrant);
+    tf_network_allocation_scope(Acquire);
 
     if (host == nullptr || strlen(host) == 0 || port == 0 || !disconnect_callback) {
         debugfln("acquire(host=%s port=%u) invalid argument", TFNetwork::printf_safe(host), port);
@@ -159,6 +160,8 @@ void TFGenericTCPClientPool::acquire(const char *host, uint16_t port,
     slot->shares[0] = share;
     ++slot->share_count;
 
+    prepare_client(slot->client, host, port);
+
     slot->client->connect(host, port,
     [this, slot_index](TFGenericTCPClientConnectResult result, int error_number) {
         TFGenericTCPClientPoolSlot *slot = slots[slot_index];
@@ -229,6 +232,7 @@ TFGenericTCPClientDisconnectResult TFGenericTCPClientPool::release(TFGenericTCPS
     }
 
     TFNetwork::NonReentrantScope scope(&non_reentrant);
+    tf_network_allocation_scope(Release);
 
     debugfln("release(shared_client=%p force_disconnect=%u)", static_cast<void *>(shared_client), force_disconnect ? 1 : 0);
 
@@ -273,6 +277,32 @@ TFGenericTCPClientDisconnectResult TFGenericTCPClientPool::release(TFGenericTCPS
     return TFGenericTCPClientDisconnectResult::NotConnected;
 }
 
+size_t TFGenericTCPClientPool::get_slot_count() const
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT; ++i) {
+        if (slots[i] != nullptr) {
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+size_t TFGenericTCPClientPool::get_share_count() const
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT; ++i) {
+        if (slots[i] != nullptr) {
+            count += slots[i]->share_count;
+        }
+    }
+
+    return count;
+}
+
 // non-reentrant
 void TFGenericTCPClientPool::tick()
 {
@@ -282,6 +312,7 @@ void TFGenericTCPClientPool::tick()
     }
 
     TFNetwork::NonReentrantScope scope(&non_reentrant);
+    tf_network_allocation_scope(PoolTick);
 
     for (size_t i = 0; i < TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT; ++i) {
         TFGenericTCPClientPoolSlot *slot = slots[i];
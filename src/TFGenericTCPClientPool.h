@@ -74,9 +74,17 @@ public:
     TFGenericTCPClientDisconnectResult release(TFGenericTCPSharedClient *shared_client, bool force_disconnect = false); // non-reentrant
     void tick(); // non-reentrant
 
+    size_t get_slot_count() const;  // slots with a client, connected or not
+    size_t get_share_count() const; // shares over all slots
+
+    // index is below TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT, nullptr for unused slots
+    const TFGenericTCPClient *get_slot_client(size_t index) const { return index < TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT && slots[index] != nullptr ? slots[index]->client : nullptr; }
+    size_t get_slot_share_count(size_t index) const { return index < TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT && slots[index] != nullptr ? slots[index]->share_count : 0; }
+
 protected:
     virtual TFGenericTCPClient *create_client() = 0;
     virtual TFGenericTCPSharedClient *create_shared_client(TFGenericTCPClient *client) = 0;
+    virtual void prepare_client(TFGenericTCPClient * /*client*/, const char * /*host*/, uint16_t /*port*/) {} // called before each connect
 
 private:
     void release(size_t slot_index, size_t share_index, TFGenericTCPClientDisconnectReason reason, int error_number, bool disconnect);
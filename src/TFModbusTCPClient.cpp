@@ -24,6 +24,7 @@
 #include <stdio.h>
 #include <sys/types.h>
 #include <lwip/sockets.h>
+#include <algorithm>
 
 #include "TFNetwork.h"
 
@@ -121,11 +122,288 @@ const char *get_tf_modbus_tcp_client_transaction_result_name(TFModbusTCPClientTr
 
     case TFModbusTCPClientTransactionResult::ResponseShorterThanExpected:
         return "ResponseShorterThanExpected";
+
+    case TFModbusTCPClientTransactionResult::ResponseFileRecordMismatch:
+        return "ResponseFileRecordMismatch";
     }
 
     return "<Unknown>";
 }
 
+TFModbusTCPExceptionCode get_tf_modbus_tcp_client_transaction_result_exception_code(TFModbusTCPClientTransactionResult result)
+{
+    switch (result) {
+    case TFModbusTCPClientTransactionResult::Success:
+        return TFModbusTCPExceptionCode::Success;
+
+    case TFModbusTCPClientTransactionResult::ModbusIllegalFunction:
+    case TFModbusTCPClientTransactionResult::ModbusIllegalDataAddress:
+    case TFModbusTCPClientTransactionResult::ModbusIllegalDataValue:
+    case TFModbusTCPClientTransactionResult::ModbusServerDeviceFailure:
+    case TFModbusTCPClientTransactionResult::ModbusAcknowledge:
+    case TFModbusTCPClientTransactionResult::ModbusServerDeviceBusy:
+    case TFModbusTCPClientTransactionResult::ModbusMemoryParityError:
+    case TFModbusTCPClientTransactionResult::ModbusGatewayPathUnvailable:
+    case TFModbusTCPClientTransactionResult::ModbusGatewayTargetDeviceFailedToRespond:
+        return static_cast<TFModbusTCPExceptionCode>(result);
+
+    case TFModbusTCPClientTransactionResult::Timeout:
+        return TFModbusTCPExceptionCode::GatewayTargetDeviceFailedToRespond;
+
+    default:
+        return TFModbusTCPExceptionCode::GatewayPathUnvailable;
+    }
+}
+
+bool is_tf_modbus_tcp_client_transaction_result_modbus_exception(TFModbusTCPClientTransactionResult result)
+{
+    switch (result) {
+    case TFModbusTCPClientTransactionResult::ModbusIllegalFunction:
+    case TFModbusTCPClientTransactionResult::ModbusIllegalDataAddress:
+    case TFModbusTCPClientTransactionResult::ModbusIllegalDataValue:
+    case TFModbusTCPClientTransactionResult::ModbusServerDeviceFailure:
+    case TFModbusTCPClientTransactionResult::ModbusAcknowledge:
+    case TFModbusTCPClientTransactionResult::ModbusServerDeviceBusy:
+    case TFModbusTCPClientTransactionResult::ModbusMemoryParityError:
+    case TFModbusTCPClientTransactionResult::ModbusGatewayPathUnvailable:
+    case TFModbusTCPClientTransactionResult::ModbusGatewayTargetDeviceFailedToRespond:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+struct TFModbusTCPClientWriteShadowEntry
+{
+    bool used;
+    bool coil;
+    uint8_t unit_id;
+    uint16_t address;
+    uint16_t value; // coils as 0 or 1, registers in the configured register byte order
+    micros_t acknowledged;
+};
+
+struct TFModbusTCPClientBusSchedulerUnit
+{
+    uint8_t bus;
+    uint8_t pending_transaction_count;
+    uint32_t last_served;
+    micros_t response_latency; // moving average, 0 if unknown
+};
+
+struct TFModbusTCPClientBusSchedulerBus
+{
+    uint8_t pending_transaction_count;
+    uint8_t max_pending_transaction_count;
+};
+
+struct TFModbusTCPClientBusScheduler
+{
+    TFModbusTCPClientBusSchedulerUnit units[256];
+    TFModbusTCPClientBusSchedulerBus buses[TF_MODBUS_TCP_CLIENT_MAX_BUS_COUNT];
+    uint8_t unit_max_pending_transaction_count;
+    uint32_t serve_counter;
+};
+
+static bool is_coil_write(TFModbusTCPFunctionCode function_code)
+{
+    return function_code == TFModbusTCPFunctionCode::WriteSingleCoil
+        || function_code == TFModbusTCPFunctionCode::WriteMultipleCoils;
+}
+
+static bool is_register_write(TFModbusTCPFunctionCode function_code)
+{
+    return function_code == TFModbusTCPFunctionCode::WriteSingleRegister
+        || function_code == TFModbusTCPFunctionCode::WriteMultipleRegisters
+        || function_code == TFModbusTCPFunctionCode::MaskWriteRegister;
+}
+
+static uint16_t get_data_value(TFModbusTCPFunctionCode function_code, const void *buffer, size_t index)
+{
+    switch (function_code) {
+    case TFModbusTCPFunctionCode::WriteSingleCoil:
+        return static_cast<const uint8_t *>(buffer)[0] != 0 ? 1 : 0;
+
+    case TFModbusTCPFunctionCode::ReadCoils:
+    case TFModbusTCPFunctionCode::WriteMultipleCoils:
+        return (static_cast<const uint8_t *>(buffer)[index / 8] >> (index % 8)) & 1;
+
+    default:
+        return static_cast<const uint16_t *>(buffer)[index];
+    }
+}
+
+static size_t get_file_record_request_byte_count(TFModbusTCPFunctionCode function_code, const TFModbusTCPFileRecord *records, size_t record_count)
+{
+    size_t byte_count = record_count * TF_MODBUS_TCP_FILE_RECORD_SUB_REQUEST_LENGTH;
+
+    if (function_code == TFModbusTCPFunctionCode::WriteFileRecord) {
+        for (size_t i = 0; i < record_count; ++i) {
+            byte_count += records[i].record_length * 2u;
+        }
+    }
+
+    return byte_count;
+}
+
+static size_t get_file_record_response_byte_count(TFModbusTCPFunctionCode function_code, const TFModbusTCPFileRecord *records, size_t record_count)
+{
+    if (function_code == TFModbusTCPFunctionCode::WriteFileRecord) {
+        return get_file_record_request_byte_count(function_code, records, record_count); // echo
+    }
+
+    size_t byte_count = 0;
+
+    for (size_t i = 0; i < record_count; ++i) {
+        byte_count += TF_MODBUS_TCP_FILE_RECORD_SUB_RESPONSE_LENGTH + records[i].record_length * 2u;
+    }
+
+    return byte_count;
+}
+
+// Write the sub-requests to buffer, returns the used length
+static size_t build_file_record_request(TFModbusTCPFunctionCode function_code, const TFModbusTCPFileRecord *records, size_t record_count, uint8_t *buffer)
+{
+    size_t offset = 0;
+
+    for (size_t i = 0; i < record_count; ++i) {
+        const TFModbusTCPFileRecord *record = &records[i];
+
+        buffer[offset++] = TF_MODBUS_TCP_FILE_RECORD_REFERENCE_TYPE;
+        buffer[offset++] = static_cast<uint8_t>(record->file_number >> 8);
+        buffer[offset++] = static_cast<uint8_t>(record->file_number & 0xFF);
+        buffer[offset++] = static_cast<uint8_t>(record->record_number >> 8);
+        buffer[offset++] = static_cast<uint8_t>(record->record_number & 0xFF);
+        buffer[offset++] = static_cast<uint8_t>(record->record_length >> 8);
+        buffer[offset++] = static_cast<uint8_t>(record->record_length & 0xFF);
+
+        if (function_code == TFModbusTCPFunctionCode::WriteFileRecord) {
+            memcpy(buffer + offset, record->record_data, record->record_length * 2u);
+            offset += record->record_length * 2u;
+        }
+    }
+
+    return offset;
+}
+
+TFModbusTCPClient::~TFModbusTCPClient()
+{
+    delete[] write_shadow;
+    delete bus_scheduler;
+}
+
+void TFModbusTCPClient::set_write_shadow_enabled(bool enabled, micros_t refresh_interval /*= 60_s*/)
+{
+    if (!enabled) {
+        delete[] write_shadow;
+        write_shadow = nullptr;
+        return;
+    }
+
+    if (write_shadow == nullptr) {
+        write_shadow = new TFModbusTCPClientWriteShadowEntry[TF_MODBUS_TCP_CLIENT_WRITE_SHADOW_SIZE];
+
+        for (size_t i = 0; i < TF_MODBUS_TCP_CLIENT_WRITE_SHADOW_SIZE; ++i) {
+            write_shadow[i].used = false;
+        }
+    }
+
+    write_shadow_refresh_interval = refresh_interval;
+}
+
+void TFModbusTCPClient::set_device_profile(const TFModbusTCPDeviceProfile *profile)
+{
+    device_profile = *profile;
+
+    device_profile.max_read_register_count       = std::clamp<uint16_t>(device_profile.max_read_register_count, TF_MODBUS_TCP_MIN_READ_REGISTER_COUNT, TF_MODBUS_TCP_MAX_READ_REGISTER_COUNT);
+    device_profile.max_write_register_count      = std::clamp<uint16_t>(device_profile.max_write_register_count, TF_MODBUS_TCP_MIN_WRITE_REGISTER_COUNT, TF_MODBUS_TCP_MAX_WRITE_REGISTER_COUNT);
+    device_profile.max_pending_transaction_count = std::max<uint8_t>(device_profile.max_pending_transaction_count, 1);
+}
+
+void TFModbusTCPClient::set_idle_probe(const TFModbusTCPClientIdleProbe *probe)
+{
+    if (probe == nullptr) {
+        idle_probe.idle_interval = 0_s;
+        return;
+    }
+
+    idle_probe = *probe;
+}
+
+void TFModbusTCPClient::set_bus_scheduling_enabled(bool enabled)
+{
+    if (!enabled) {
+        delete bus_scheduler;
+        bus_scheduler = nullptr;
+        return;
+    }
+
+    if (bus_scheduler != nullptr) {
+        return;
+    }
+
+    bus_scheduler = new TFModbusTCPClientBusScheduler;
+
+    for (size_t i = 0; i < 256; ++i) {
+        TFModbusTCPClientBusSchedulerUnit *unit = &bus_scheduler->units[i];
+
+        unit->bus                       = 0;
+        unit->pending_transaction_count = 0;
+        unit->last_served               = 0;
+        unit->response_latency          = 0_s;
+    }
+
+    for (size_t i = 0; i < TF_MODBUS_TCP_CLIENT_MAX_BUS_COUNT; ++i) {
+        bus_scheduler->buses[i].pending_transaction_count     = 0;
+        bus_scheduler->buses[i].max_pending_transaction_count = 1;
+    }
+
+    bus_scheduler->unit_max_pending_transaction_count = 1;
+    bus_scheduler->serve_counter                      = 0;
+}
+
+void TFModbusTCPClient::set_unit_bus(uint8_t unit_id, uint8_t bus)
+{
+    if (bus_scheduler != nullptr && bus < TF_MODBUS_TCP_CLIENT_MAX_BUS_COUNT) {
+        bus_scheduler->units[unit_id].bus = bus;
+    }
+}
+
+void TFModbusTCPClient::set_unit_max_pending_transaction_count(uint8_t count)
+{
+    if (bus_scheduler != nullptr) {
+        bus_scheduler->unit_max_pending_transaction_count = std::max<uint8_t>(count, 1);
+    }
+}
+
+void TFModbusTCPClient::set_bus_max_pending_transaction_count(uint8_t bus, uint8_t count)
+{
+    if (bus_scheduler != nullptr && bus < TF_MODBUS_TCP_CLIENT_MAX_BUS_COUNT) {
+        bus_scheduler->buses[bus].max_pending_transaction_count = std::max<uint8_t>(count, 1);
+    }
+}
+
+micros_t TFModbusTCPClient::get_unit_response_latency(uint8_t unit_id) const
+{
+    if (bus_scheduler == nullptr) {
+        return 0_s;
+    }
+
+    return bus_scheduler->units[unit_id].response_latency;
+}
+
+size_t TFModbusTCPClient::get_scheduled_transaction_count() const
+{
+    size_t count = 0;
+
+    for (TFModbusTCPClientTransaction *transaction = scheduled_transaction_head; transaction != nullptr; transaction = transaction->next) {
+        ++count;
+    }
+
+    return count;
+}
+
 void TFModbusTCPClient::transact(uint8_t unit_id,
                                  TFModbusTCPFunctionCode function_code,
                                  uint16_t start_address,
@@ -135,6 +413,8 @@ void TFModbusTCPClient::transact(uint8_t unit_id,
                                  TFModbusTCPClientTransactionCallback &&callback,
                                  uint16_t transaction_id_mask /*= UINT16_MAX*/)
 {
+    tf_network_allocation_scope(Transact);
+
     if (!callback) {
         return;
     }
@@ -243,6 +523,182 @@ void TFModbusTCPClient::transact(uint8_t unit_id,
         return;
     }
 
+    if (write_shadow != nullptr && is_write_shadowed(unit_id, function_code, start_address, data_count, buffer)) {
+        debugfln("transact(unit_id=%u function_code=%s start_address=%u data_count=%u) suppressing write of unchanged values",
+                 unit_id, get_tf_modbus_tcp_function_code_name(function_code), start_address, data_count);
+
+        callback(TFModbusTCPClientTransactionResult::Success, nullptr);
+        return;
+    }
+
+    schedule_transaction(unit_id, function_code, start_address, data_count, buffer, timeout, std::move(callback), transaction_id_mask, nullptr, nullptr);
+}
+
+void TFModbusTCPClient::transact_file_records(uint8_t unit_id,
+                                              TFModbusTCPFunctionCode function_code,
+                                              TFModbusTCPFileRecord *records,
+                                              uint16_t record_count,
+                                              micros_t timeout,
+                                              TFModbusTCPClientTransactionCallback &&callback,
+                                              uint16_t transaction_id_mask /*= UINT16_MAX*/)
+{
+    tf_network_allocation_scope(Transact);
+
+    if (!callback) {
+        return;
+    }
+
+    if (function_code != TFModbusTCPFunctionCode::ReadFileRecord && function_code != TFModbusTCPFunctionCode::WriteFileRecord) {
+        callback(TFModbusTCPClientTransactionResult::InvalidArgument, "Function code is out-of-range");
+        return;
+    }
+
+    if (records == nullptr) {
+        callback(TFModbusTCPClientTransactionResult::InvalidArgument, "Records pointer is null");
+        return;
+    }
+
+    if (record_count < 1) {
+        callback(TFModbusTCPClientTransactionResult::InvalidArgument, "Record count is out-of-range");
+        return;
+    }
+
+    for (size_t i = 0; i < record_count; ++i) {
+        if (records[i].file_number < TF_MODBUS_TCP_MIN_FILE_NUMBER) {
+            callback(TFModbusTCPClientTransactionResult::InvalidArgument, "File number is out-of-range");
+            return;
+        }
+
+        if (records[i].record_number > TF_MODBUS_TCP_MAX_RECORD_NUMBER) {
+            callback(TFModbusTCPClientTransactionResult::InvalidArgument, "Record number is out-of-range");
+            return;
+        }
+
+        if (records[i].record_length < 1) {
+            callback(TFModbusTCPClientTransactionResult::InvalidArgument, "Record length is out-of-range");
+            return;
+        }
+
+        if (records[i].record_data == nullptr) {
+            callback(TFModbusTCPClientTransactionResult::InvalidArgument, "Record data pointer is null");
+            return;
+        }
+    }
+
+    if (get_file_record_request_byte_count(function_code, records, record_count) > TF_MODBUS_TCP_MAX_FILE_RECORD_BYTE_COUNT
+     || get_file_record_response_byte_count(function_code, records, record_count) > TF_MODBUS_TCP_MAX_FILE_RECORD_BYTE_COUNT) {
+        callback(TFModbusTCPClientTransactionResult::InvalidArgument, "Total record length is out-of-range");
+        return;
+    }
+
+    if (timeout < 0_s) {
+        callback(TFModbusTCPClientTransactionResult::InvalidArgument, "Timeout is negative");
+        return;
+    }
+
+    if (socket_fd < 0) {
+        callback(TFModbusTCPClientTransactionResult::NotConnected, nullptr);
+        return;
+    }
+
+    schedule_transaction(unit_id, function_code, 0, record_count, records, timeout, std::move(callback), transaction_id_mask, nullptr, nullptr);
+}
+
+void TFModbusTCPClient::read_fifo_queue(uint8_t unit_id,
+                                        uint16_t fifo_pointer_address,
+                                        uint16_t *fifo_values,
+                                        uint16_t *fifo_count,
+                                        micros_t timeout,
+                                        TFModbusTCPClientTransactionCallback &&callback,
+                                        uint16_t transaction_id_mask /*= UINT16_MAX*/)
+{
+    tf_network_allocation_scope(Transact);
+
+    if (!callback) {
+        return;
+    }
+
+    if (fifo_values == nullptr || fifo_count == nullptr) {
+        callback(TFModbusTCPClientTransactionResult::InvalidArgument, "FIFO values or count pointer is null");
+        return;
+    }
+
+    if (timeout < 0_s) {
+        callback(TFModbusTCPClientTransactionResult::InvalidArgument, "Timeout is negative");
+        return;
+    }
+
+    if (socket_fd < 0) {
+        callback(TFModbusTCPClientTransactionResult::NotConnected, nullptr);
+        return;
+    }
+
+    schedule_transaction(unit_id, TFModbusTCPFunctionCode::ReadFIFOQueue, fifo_pointer_address, TF_MODBUS_TCP_MAX_FIFO_COUNT, fifo_values,
+                         timeout, std::move(callback), transaction_id_mask, fifo_count, nullptr);
+}
+
+void TFModbusTCPClient::read_view(uint8_t unit_id,
+                                  TFModbusTCPFunctionCode function_code,
+                                  uint16_t start_address,
+                                  uint16_t data_count,
+                                  micros_t timeout,
+                                  TFModbusTCPClientReadViewCallback &&callback,
+                                  uint16_t transaction_id_mask /*= UINT16_MAX*/)
+{
+    tf_network_allocation_scope(Transact);
+
+    if (!callback) {
+        return;
+    }
+
+    switch (function_code) {
+    case TFModbusTCPFunctionCode::ReadCoils:
+    case TFModbusTCPFunctionCode::ReadDiscreteInputs:
+        if (data_count < TF_MODBUS_TCP_MIN_READ_COIL_COUNT || data_count > TF_MODBUS_TCP_MAX_READ_COIL_COUNT) {
+            callback(TFModbusTCPClientTransactionResult::InvalidArgument, "Data count is out-of-range", nullptr);
+            return;
+        }
+
+        break;
+
+    case TFModbusTCPFunctionCode::ReadHoldingRegisters:
+    case TFModbusTCPFunctionCode::ReadInputRegisters:
+        if (data_count < TF_MODBUS_TCP_MIN_READ_REGISTER_COUNT || data_count > TF_MODBUS_TCP_MAX_READ_REGISTER_COUNT) {
+            callback(TFModbusTCPClientTransactionResult::InvalidArgument, "Data count is out-of-range", nullptr);
+            return;
+        }
+
+        break;
+
+    default:
+        callback(TFModbusTCPClientTransactionResult::InvalidArgument, "Function code is out-of-range", nullptr);
+        return;
+    }
+
+    if (timeout < 0_s) {
+        callback(TFModbusTCPClientTransactionResult::InvalidArgument, "Timeout is negative", nullptr);
+        return;
+    }
+
+    if (socket_fd < 0) {
+        callback(TFModbusTCPClientTransactionResult::NotConnected, nullptr, nullptr);
+        return;
+    }
+
+    schedule_transaction(unit_id, function_code, start_address, data_count, nullptr, timeout, nullptr, transaction_id_mask, nullptr, std::move(callback));
+}
+
+void TFModbusTCPClient::schedule_transaction(uint8_t unit_id,
+                                             TFModbusTCPFunctionCode function_code,
+                                             uint16_t start_address,
+                                             uint16_t data_count,
+                                             void *buffer,
+                                             micros_t timeout,
+                                             TFModbusTCPClientTransactionCallback &&callback,
+                                             uint16_t transaction_id_mask,
+                                             uint16_t *fifo_count,
+                                             TFModbusTCPClientReadViewCallback &&read_view_callback)
+{
     TFModbusTCPClientTransaction **tail_ptr = &scheduled_transaction_head;
     size_t scheduled_transaction_count = 0;
 
@@ -252,7 +708,13 @@ void TFModbusTCPClient::transact(uint8_t unit_id,
     }
 
     if (scheduled_transaction_count >= TF_MODBUS_TCP_CLIENT_MAX_SCHEDULED_TRANSACTION_COUNT) {
-        callback(TFModbusTCPClientTransactionResult::NoTransactionAvailable, nullptr);
+        if (read_view_callback) {
+            read_view_callback(TFModbusTCPClientTransactionResult::NoTransactionAvailable, nullptr, nullptr);
+        }
+        else {
+            callback(TFModbusTCPClientTransactionResult::NoTransactionAvailable, nullptr);
+        }
+
         return;
     }
 
@@ -265,7 +727,10 @@ void TFModbusTCPClient::transact(uint8_t unit_id,
     transaction->buffer              = buffer;
     transaction->timeout             = timeout;
     transaction->callback            = std::move(callback);
-    transaction->transaction_id_mask = transaction_id_mask;
+    transaction->read_view_callback  = std::move(read_view_callback);
+    transaction->transaction_id_mask = transaction_id_mask & device_profile.transaction_id_mask;
+    transaction->fifo_count          = fifo_count;
+    transaction->bus                 = 0;
     transaction->next                = nullptr;
 
     *tail_ptr = transaction;
@@ -273,117 +738,292 @@ void TFModbusTCPClient::transact(uint8_t unit_id,
 
 void TFModbusTCPClient::close_hook()
 {
+    if (write_shadow != nullptr) {
+        for (size_t i = 0; i < TF_MODBUS_TCP_CLIENT_WRITE_SHADOW_SIZE; ++i) {
+            write_shadow[i].used = false;
+        }
+    }
+
     reset_pending_response();
     finish_all_transactions(TFModbusTCPClientTransactionResult::Aborted, "Connection got closed");
+
+    idle_probe_failed = false;
 }
 
 void TFModbusTCPClient::tick_hook()
 {
     check_pending_transaction_timeout();
 
-    if (pending_transaction != nullptr && pending_transaction_ticks < UINT32_MAX) {
-        ++pending_transaction_ticks;
-    }
-
-    if (pending_transaction == nullptr && scheduled_transaction_head != nullptr) {
-        pending_transaction          = scheduled_transaction_head;
-        scheduled_transaction_head   = scheduled_transaction_head->next;
-        pending_transaction->next    = nullptr;
-        pending_transaction_id       = (next_transaction_id++) & pending_transaction->transaction_id_mask;
-        pending_transaction_deadline = calculate_deadline(pending_transaction->timeout);
-        pending_transaction_ticks    = 0;
-        pending_transaction_recvs    = 0;
-        pending_transaction_since    = now_us();
-
-        TFModbusTCPRequest request;
-        size_t payload_length;
-
-        request.header.transaction_id = htons(pending_transaction_id);
-        request.header.protocol_id    = htons(0);
-        request.header.unit_id        = pending_transaction->unit_id;
-
-        request.payload.function_code = static_cast<uint8_t>(pending_transaction->function_code);
-        request.payload.start_address = htons(pending_transaction->start_address);
-
-        switch (pending_transaction->function_code) {
-        case TFModbusTCPFunctionCode::ReadCoils:
-        case TFModbusTCPFunctionCode::ReadDiscreteInputs:
-        case TFModbusTCPFunctionCode::ReadHoldingRegisters:
-        case TFModbusTCPFunctionCode::ReadInputRegisters:
-            request.payload.data_count = htons(pending_transaction->data_count);
-            payload_length             = offsetof(TFModbusTCPRequestPayload, byte_count);
-            break;
+    for (TFModbusTCPClientTransaction *transaction = pending_transaction_head; transaction != nullptr; transaction = transaction->next) {
+        if (transaction->ticks < UINT32_MAX) {
+            ++transaction->ticks;
+        }
+    }
+
+    while (pending_transaction_count < device_profile.max_pending_transaction_count && scheduled_transaction_head != nullptr) {
+        TFModbusTCPClientTransaction **transaction_ptr = bus_scheduler != nullptr ? select_scheduled_transaction() : &scheduled_transaction_head;
 
-        case TFModbusTCPFunctionCode::WriteSingleCoil:
-            request.payload.data_value = htons(static_cast<uint8_t *>(pending_transaction->buffer)[0] != 0 ? 0xFF00 : 0x0000);
-            payload_length             = offsetof(TFModbusTCPRequestPayload, byte_count);
+        if (transaction_ptr == nullptr || !send_scheduled_transaction(transaction_ptr)) {
             break;
+        }
+    }
 
-        case TFModbusTCPFunctionCode::WriteSingleRegister:
-            if (register_byte_order == TFModbusTCPByteOrder::Host) {
-                request.payload.data_value = htons(static_cast<uint16_t *>(pending_transaction->buffer)[0]);
-            }
-            else { // TFModbusTCPByteOrder::Network
-                request.payload.data_value = static_cast<uint16_t *>(pending_transaction->buffer)[0];
-            }
+    check_idle_probe();
+}
 
-            payload_length = offsetof(TFModbusTCPRequestPayload, byte_count);
-            break;
+void TFModbusTCPClient::check_idle_probe()
+{
+    if (socket_fd < 0) {
+        return;
+    }
 
-        case TFModbusTCPFunctionCode::WriteMultipleCoils:
-            request.payload.data_count = htons(pending_transaction->data_count);
-            request.payload.byte_count = (pending_transaction->data_count + 7) / 8;
-            payload_length             = offsetof(TFModbusTCPRequestPayload, coil_values) + request.payload.byte_count;
+    // Disconnect here instead of in the probe callback, because the callback
+    // can be called from recv_hook that might disconnect on its own afterwards
+    if (idle_probe_failed) {
+        idle_probe_failed = false;
+        disconnect(TFGenericTCPClientDisconnectReason::IdleProbeFailed, -1);
+        return;
+    }
 
-            memcpy(request.payload.coil_values, pending_transaction->buffer, request.payload.byte_count);
-            break;
+    if (idle_probe.idle_interval <= 0_s
+     || idle_probe_pending
+     || pending_transaction_count > 0
+     || scheduled_transaction_head != nullptr
+     || !deadline_elapsed(last_received + idle_probe.idle_interval)) {
+        return;
+    }
 
-        case TFModbusTCPFunctionCode::WriteMultipleRegisters:
-            request.payload.data_count = htons(pending_transaction->data_count);
-            request.payload.byte_count = pending_transaction->data_count * 2;
-            payload_length             = offsetof(TFModbusTCPRequestPayload, register_values) + request.payload.byte_count;
+    debugfln("check_idle_probe() sending probe (unit_id=%u function_code=%u start_address=%u data_count=%u)",
+             idle_probe.unit_id,
+             static_cast<uint8_t>(idle_probe.function_code),
+             idle_probe.start_address,
+             idle_probe.data_count);
 
-            if (register_byte_order == TFModbusTCPByteOrder::Host) {
-                uint16_t *buffer = static_cast<uint16_t *>(pending_transaction->buffer);
+    idle_probe_pending = true;
 
-                for (size_t i = 0; i < pending_transaction->data_count; ++i) {
-                    request.payload.register_values[i] = htons(buffer[i]);
-                }
-            }
-            else { // TFModbusTCPByteOrder::Network
-                memcpy(request.payload.register_values, pending_transaction->buffer, request.payload.byte_count);
-            }
+    read_view(idle_probe.unit_id, idle_probe.function_code, idle_probe.start_address, idle_probe.data_count, idle_probe.timeout,
+    [this](TFModbusTCPClientTransactionResult result, const char *error_message, const TFModbusTCPReadView *view) {
+        (void)error_message;
+        (void)view;
 
-            break;
+        idle_probe_pending = false;
 
-        case TFModbusTCPFunctionCode::MaskWriteRegister:
-            if (register_byte_order == TFModbusTCPByteOrder::Host) {
-                request.payload.and_mask = htons(static_cast<uint16_t *>(pending_transaction->buffer)[0]);
-                request.payload.or_mask  = htons(static_cast<uint16_t *>(pending_transaction->buffer)[1]);
-            }
-            else { // TFModbusTCPByteOrder::Network
-                request.payload.and_mask = static_cast<uint16_t *>(pending_transaction->buffer)[0];
-                request.payload.or_mask  = static_cast<uint16_t *>(pending_transaction->buffer)[1];
-            }
+        switch (result) {
+        case TFModbusTCPClientTransactionResult::Aborted:
+        case TFModbusTCPClientTransactionResult::NotConnected:
+        case TFModbusTCPClientTransactionResult::NoTransactionAvailable:
+            return;
 
-            payload_length = offsetof(TFModbusTCPRequestPayload, sentinel);
-            break;
+        case TFModbusTCPClientTransactionResult::InvalidArgument:
+            debugfln("check_idle_probe() invalid probe, disabling it (error_message=%s)", TFNetwork::printf_safe(error_message));
+            idle_probe.idle_interval = 0_s;
+            return;
 
         default:
-            return; // unreachable, just here to stop the compiler from warning about "payload_length may be used uninitialized"
+            break;
         }
 
-        request.header.frame_length = htons(TF_MODBUS_TCP_FRAME_IN_HEADER_LENGTH + payload_length);
+        // A Modbus exception still proves that the peer is alive
+        if (result == TFModbusTCPClientTransactionResult::Success || is_tf_modbus_tcp_client_transaction_result_modbus_exception(result)) {
+            return;
+        }
 
-        if (!send(request.bytes, sizeof(request.header) + payload_length)) {
-            int saved_errno = errno;
-            char error_message[128];
+        debugfln("check_idle_probe() probe failed (result=%s error_message=%s)",
+                 get_tf_modbus_tcp_client_transaction_result_name(result),
+                 TFNetwork::printf_safe(error_message));
 
-            snprintf(error_message, sizeof(error_message), "%s (%d)", strerror(saved_errno), saved_errno);
-            finish_pending_transaction(TFModbusTCPClientTransactionResult::SendFailed, error_message);
-            disconnect(TFGenericTCPClientDisconnectReason::SocketSendFailed, saved_errno);
+        idle_probe_failed = true;
+    });
+}
+
+// Select the first scheduled transaction of the unit that waited the longest
+// and whose unit and bus are both below their pending transaction limit. Only
+// the first scheduled transaction of each unit is considered, to keep the order
+// of transactions per unit
+TFModbusTCPClientTransaction **TFModbusTCPClient::select_scheduled_transaction()
+{
+    uint32_t seen_units[256 / 32];
+    TFModbusTCPClientTransaction **selected_ptr = nullptr;
+    uint32_t selected_last_served = 0;
+
+    memset(seen_units, 0, sizeof(seen_units));
+
+    for (TFModbusTCPClientTransaction **transaction_ptr = &scheduled_transaction_head; *transaction_ptr != nullptr; transaction_ptr = &(*transaction_ptr)->next) {
+        uint8_t unit_id = (*transaction_ptr)->unit_id;
+
+        if ((seen_units[unit_id / 32] & (1u << (unit_id % 32))) != 0) {
+            continue;
         }
+
+        seen_units[unit_id / 32] |= 1u << (unit_id % 32);
+
+        const TFModbusTCPClientBusSchedulerUnit *unit = &bus_scheduler->units[unit_id];
+        const TFModbusTCPClientBusSchedulerBus *bus   = &bus_scheduler->buses[unit->bus];
+
+        if (unit->pending_transaction_count >= bus_scheduler->unit_max_pending_transaction_count
+         || bus->pending_transaction_count >= bus->max_pending_transaction_count) {
+            continue;
+        }
+
+        // Serve counter differences stay correct across wrap-around
+        if (selected_ptr == nullptr || static_cast<int32_t>(unit->last_served - selected_last_served) < 0) {
+            selected_ptr         = transaction_ptr;
+            selected_last_served = unit->last_served;
+        }
+    }
+
+    return selected_ptr;
+}
+
+// Returns false if no further scheduled transaction can be sent right now
+bool TFModbusTCPClient::send_scheduled_transaction(TFModbusTCPClientTransaction **transaction_ptr)
+{
+    if (write_combining_enabled) {
+        combine_scheduled_writes(transaction_ptr);
+    }
+
+    TFModbusTCPClientTransaction *transaction = *transaction_ptr;
+    uint16_t transaction_id = next_transaction_id & transaction->transaction_id_mask;
+
+    // With a narrow transaction ID mask the next ID might still be in use. Wait
+    // for that transaction to finish, otherwise the responses would be ambiguous
+    if (find_pending_transaction(transaction_id) != nullptr) {
+        return false;
+    }
+
+    ++next_transaction_id;
+
+    *transaction_ptr            = transaction->next;
+    transaction->next           = nullptr;
+    transaction->transaction_id = transaction_id;
+    transaction->deadline       = calculate_deadline(transaction->timeout);
+    transaction->ticks          = 0;
+    transaction->recvs          = 0;
+    transaction->since          = now_us();
+
+    TFModbusTCPClientTransaction **tail_ptr = &pending_transaction_head;
+
+    while (*tail_ptr != nullptr) {
+        tail_ptr = &(*tail_ptr)->next;
+    }
+
+    *tail_ptr = transaction;
+    ++pending_transaction_count;
+
+    if (bus_scheduler != nullptr) {
+        TFModbusTCPClientBusSchedulerUnit *unit = &bus_scheduler->units[transaction->unit_id];
+
+        transaction->bus = unit->bus;
+        unit->last_served = ++bus_scheduler->serve_counter;
+
+        ++unit->pending_transaction_count;
+        ++bus_scheduler->buses[transaction->bus].pending_transaction_count;
+    }
+
+    TFModbusTCPRequest request;
+    size_t payload_length;
+
+    request.header.transaction_id = htons(transaction->transaction_id);
+    request.header.protocol_id    = htons(0);
+    request.header.unit_id        = transaction->unit_id;
+
+    request.payload.function_code = static_cast<uint8_t>(transaction->function_code);
+    request.payload.start_address = htons(transaction->start_address);
+
+    switch (transaction->function_code) {
+    case TFModbusTCPFunctionCode::ReadCoils:
+    case TFModbusTCPFunctionCode::ReadDiscreteInputs:
+    case TFModbusTCPFunctionCode::ReadHoldingRegisters:
+    case TFModbusTCPFunctionCode::ReadInputRegisters:
+        request.payload.data_count = htons(transaction->data_count);
+        payload_length             = offsetof(TFModbusTCPRequestPayload, byte_count);
+        break;
+
+    case TFModbusTCPFunctionCode::WriteSingleCoil:
+        request.payload.data_value = htons(static_cast<uint8_t *>(transaction->buffer)[0] != 0 ? 0xFF00 : 0x0000);
+        payload_length             = offsetof(TFModbusTCPRequestPayload, byte_count);
+        break;
+
+    case TFModbusTCPFunctionCode::WriteSingleRegister:
+        if (register_byte_order == TFModbusTCPByteOrder::Host) {
+            request.payload.data_value = htons(static_cast<uint16_t *>(transaction->buffer)[0]);
+        }
+        else { // TFModbusTCPByteOrder::Network
+            request.payload.data_value = static_cast<uint16_t *>(transaction->buffer)[0];
+        }
+
+        payload_length = offsetof(TFModbusTCPRequestPayload, byte_count);
+        break;
+
+    case TFModbusTCPFunctionCode::WriteMultipleCoils:
+        request.payload.data_count = htons(transaction->data_count);
+        request.payload.byte_count = (transaction->data_count + 7) / 8;
+        payload_length             = offsetof(TFModbusTCPRequestPayload, coil_values) + request.payload.byte_count;
+
+        memcpy(request.payload.coil_values, transaction->buffer, request.payload.byte_count);
+        break;
+
+    case TFModbusTCPFunctionCode::WriteMultipleRegisters:
+        request.payload.data_count = htons(transaction->data_count);
+        request.payload.byte_count = transaction->data_count * 2;
+        payload_length             = offsetof(TFModbusTCPRequestPayload, register_values) + request.payload.byte_count;
+
+        if (register_byte_order == TFModbusTCPByteOrder::Host) {
+            uint16_t *buffer = static_cast<uint16_t *>(transaction->buffer);
+
+            for (size_t i = 0; i < transaction->data_count; ++i) {
+                request.payload.register_values[i] = htons(buffer[i]);
+            }
+        }
+        else { // TFModbusTCPByteOrder::Network
+            memcpy(request.payload.register_values, transaction->buffer, request.payload.byte_count);
+        }
+
+        break;
+
+    case TFModbusTCPFunctionCode::MaskWriteRegister:
+        if (register_byte_order == TFModbusTCPByteOrder::Host) {
+            request.payload.and_mask = htons(static_cast<uint16_t *>(transaction->buffer)[0]);
+            request.payload.or_mask  = htons(static_cast<uint16_t *>(transaction->buffer)[1]);
+        }
+        else { // TFModbusTCPByteOrder::Network
+            request.payload.and_mask = static_cast<uint16_t *>(transaction->buffer)[0];
+            request.payload.or_mask  = static_cast<uint16_t *>(transaction->buffer)[1];
+        }
+
+        payload_length = offsetof(TFModbusTCPRequestPayload, sentinel);
+        break;
+
+    case TFModbusTCPFunctionCode::ReadFIFOQueue:
+        payload_length = offsetof(TFModbusTCPRequestPayload, data_count);
+        break;
+
+    case TFModbusTCPFunctionCode::ReadFileRecord:
+    case TFModbusTCPFunctionCode::WriteFileRecord:
+        request.payload.file_byte_count = build_file_record_request(transaction->function_code,
+                                                                    static_cast<TFModbusTCPFileRecord *>(transaction->buffer),
+                                                                    transaction->data_count,
+                                                                    request.payload.file_bytes);
+        payload_length = offsetof(TFModbusTCPRequestPayload, file_bytes) + request.payload.file_byte_count;
+        break;
+
+    default:
+        return true; // unreachable, just here to stop the compiler from warning about "payload_length may be used uninitialized"
+    }
+
+    request.header.frame_length = htons(TF_MODBUS_TCP_FRAME_IN_HEADER_LENGTH + payload_length);
+
+    if (!send(request.bytes, sizeof(request.header) + payload_length)) {
+        int saved_errno = errno;
+        char error_message[128];
+
+        snprintf(error_message, sizeof(error_message), "%s (%d)", strerror(saved_errno), saved_errno);
+        finish_pending_transaction(transaction, TFModbusTCPClientTransactionResult::SendFailed, error_message);
+        disconnect(TFGenericTCPClientDisconnectReason::SocketSendFailed, saved_errno);
+        return false;
     }
+
+    return true;
 }
 
 bool TFModbusTCPClient::recv_hook()
@@ -410,9 +1050,7 @@ bool TFModbusTCPClient::recv_hook()
             return false;
         }
 
-        if (pending_transaction != nullptr && pending_transaction_recvs < UINT32_MAX) {
-            ++pending_transaction_recvs;
-        }
+        count_pending_transaction_recv();
 
         pending_response_header_used += result;
         return true;
@@ -465,10 +1103,11 @@ bool TFModbusTCPClient::recv_hook()
     // A full header and longer can be another Modbus response. Anything shorter
     // than a full header is either garbage or the header indicated fewer bytes
     // than were actually present. If there is a possible trailing fragment
-    // append it to the payload.
-    int readable;
+    // append it to the payload. With more than one transaction in flight the
+    // trailing data can also be the start of the next response, don't touch it
+    int readable = 0;
 
-    if (ioctl(socket_fd, FIONREAD, &readable) < 0) {
+    if (pending_transaction_count <= 1 && ioctl(socket_fd, FIONREAD, &readable) < 0) {
         int saved_errno = errno;
 
         snprintf(error_message, sizeof(error_message), "%s (%d)", strerror(saved_errno), saved_errno);
@@ -502,39 +1141,34 @@ bool TFModbusTCPClient::recv_hook()
         return false;
     }
 
-    if (pending_transaction == nullptr) {
-        debugfln("recv_hook() no pending transaction for response");
-
-        reset_pending_response();
-        return true;
-    }
+    TFModbusTCPClientTransaction *transaction = find_pending_transaction(pending_response.header.transaction_id);
 
-    if (pending_transaction_id != pending_response.header.transaction_id) {
-        debugfln("recv_hook() transaction ID mismatch (pending_response.header.transaction_id=%u pending_transaction_id=%u)",
-                 pending_transaction_id, pending_response.header.transaction_id);
+    if (transaction == nullptr) {
+        debugfln("recv_hook() no pending transaction for response (pending_response.header.transaction_id=%u)",
+                 pending_response.header.transaction_id);
 
         reset_pending_response();
         return true;
     }
 
-    if (pending_transaction->unit_id != pending_response.header.unit_id) {
-        debugfln("recv_hook() unit ID mismatch (pending_response.header.unit_id=%u pending_transaction->unit_id=%u)",
-                 pending_response.header.unit_id, pending_transaction->unit_id);
+    if (transaction->unit_id != pending_response.header.unit_id) {
+        debugfln("recv_hook() unit ID mismatch (pending_response.header.unit_id=%u transaction->unit_id=%u)",
+                 pending_response.header.unit_id, transaction->unit_id);
 
-        snprintf(error_message, sizeof(error_message), "Actual unit ID is %u, expected is %u", pending_response.header.unit_id, pending_transaction->unit_id);
+        snprintf(error_message, sizeof(error_message), "Actual unit ID is %u, expected is %u", pending_response.header.unit_id, transaction->unit_id);
         reset_pending_response();
-        finish_pending_transaction(TFModbusTCPClientTransactionResult::ResponseUnitIDMismatch, error_message);
+        finish_pending_transaction(transaction, TFModbusTCPClientTransactionResult::ResponseUnitIDMismatch, error_message);
         return true;
     }
 
-    if (pending_transaction->function_code != static_cast<TFModbusTCPFunctionCode>(pending_response.payload.function_code & 0x7F)) {
-        debugfln("recv_hook() function code mismatch (pending_response.payload.function_code=0x%02x pending_transaction->function_code=0x%02x)",
-                 pending_response.payload.function_code, static_cast<uint8_t>(pending_transaction->function_code));
+    if (transaction->function_code != static_cast<TFModbusTCPFunctionCode>(pending_response.payload.function_code & 0x7F)) {
+        debugfln("recv_hook() function code mismatch (pending_response.payload.function_code=0x%02x transaction->function_code=0x%02x)",
+                 pending_response.payload.function_code, static_cast<uint8_t>(transaction->function_code));
 
         snprintf(error_message, sizeof(error_message), "Actual function code is 0x%02x, expected is 0x%02x or 0x%02x",
-                 pending_response.payload.function_code, static_cast<uint8_t>(pending_transaction->function_code), static_cast<uint8_t>(pending_transaction->function_code) | 0x80);
+                 pending_response.payload.function_code, static_cast<uint8_t>(transaction->function_code), static_cast<uint8_t>(transaction->function_code) | 0x80);
         reset_pending_response();
-        finish_pending_transaction(TFModbusTCPClientTransactionResult::ResponseFunctionCodeMismatch, error_message);
+        finish_pending_transaction(transaction, TFModbusTCPClientTransactionResult::ResponseFunctionCodeMismatch, error_message);
         return true;
     }
 
@@ -542,7 +1176,7 @@ bool TFModbusTCPClient::recv_hook()
         debugfln("recv_hook() error response (pending_response.payload.exception_code=0x%02x)", pending_response.payload.exception_code);
 
         reset_pending_response();
-        finish_pending_transaction(static_cast<TFModbusTCPClientTransactionResult>(pending_response.payload.exception_code), nullptr);
+        finish_pending_transaction(transaction, static_cast<TFModbusTCPClientTransactionResult>(pending_response.payload.exception_code), nullptr);
         return true;
     }
 
@@ -552,24 +1186,27 @@ bool TFModbusTCPClient::recv_hook()
     bool copy_register_values   = false;
     bool check_start_address    = false;
     bool check_data_value       = false;
-    uint16_t expected_data_value; // as TFModbusTCPByteOrder::Host
+    uint16_t expected_data_value = 0; // as TFModbusTCPByteOrder::Host
     bool check_data_count       = false;
     bool check_and_mask         = false;
     uint16_t expected_and_mask;   // as TFModbusTCPByteOrder::Host
     bool check_or_mask          = false;
     uint16_t expected_or_mask;    // as TFModbusTCPByteOrder::Host
+    bool copy_file_records      = false;
+    bool check_file_records     = false;
+    bool copy_fifo_values       = false;
 
     switch (static_cast<TFModbusTCPFunctionCode>(pending_response.payload.function_code)) {
     case TFModbusTCPFunctionCode::ReadCoils:
     case TFModbusTCPFunctionCode::ReadDiscreteInputs:
-        expected_byte_count     = (pending_transaction->data_count + 7) / 8;
+        expected_byte_count     = (transaction->data_count + 7) / 8;
         expected_payload_length = offsetof(TFModbusTCPResponsePayload, coil_values) + expected_byte_count;
         copy_coil_values        = true;
         break;
 
     case TFModbusTCPFunctionCode::ReadHoldingRegisters:
     case TFModbusTCPFunctionCode::ReadInputRegisters:
-        expected_byte_count     = pending_transaction->data_count * 2;
+        expected_byte_count     = transaction->data_count * 2;
         expected_payload_length = offsetof(TFModbusTCPResponsePayload, register_values) + expected_byte_count;
         copy_register_values    = true;
         break;
@@ -578,7 +1215,7 @@ bool TFModbusTCPClient::recv_hook()
         expected_payload_length = offsetof(TFModbusTCPResponsePayload, or_mask);
         check_start_address     = true;
         check_data_value        = true;
-        expected_data_value     = static_cast<uint8_t *>(pending_transaction->buffer)[0] != 0 ? 0xFF00 : 0x0000;
+        expected_data_value     = static_cast<uint8_t *>(transaction->buffer)[0] != 0 ? 0xFF00 : 0x0000;
         break;
 
     case TFModbusTCPFunctionCode::WriteSingleRegister:
@@ -587,10 +1224,10 @@ bool TFModbusTCPClient::recv_hook()
         check_data_value        = true;
 
         if (register_byte_order == TFModbusTCPByteOrder::Host) {
-            expected_data_value = static_cast<uint16_t *>(pending_transaction->buffer)[0];
+            expected_data_value = static_cast<uint16_t *>(transaction->buffer)[0];
         }
         else { // TFModbusTCPByteOrder::Network
-            expected_data_value = ntohs(static_cast<uint16_t *>(pending_transaction->buffer)[0]);
+            expected_data_value = ntohs(static_cast<uint16_t *>(transaction->buffer)[0]);
         }
 
         break;
@@ -609,20 +1246,45 @@ bool TFModbusTCPClient::recv_hook()
         check_or_mask           = true;
 
         if (register_byte_order == TFModbusTCPByteOrder::Host) {
-            expected_and_mask = static_cast<uint16_t *>(pending_transaction->buffer)[0];
-            expected_or_mask  = static_cast<uint16_t *>(pending_transaction->buffer)[1];
+            expected_and_mask = static_cast<uint16_t *>(transaction->buffer)[0];
+            expected_or_mask  = static_cast<uint16_t *>(transaction->buffer)[1];
         }
         else { // TFModbusTCPByteOrder::Network
-            expected_and_mask = ntohs(static_cast<uint16_t *>(pending_transaction->buffer)[0]);
-            expected_or_mask  = ntohs(static_cast<uint16_t *>(pending_transaction->buffer)[1]);
+            expected_and_mask = ntohs(static_cast<uint16_t *>(transaction->buffer)[0]);
+            expected_or_mask  = ntohs(static_cast<uint16_t *>(transaction->buffer)[1]);
+        }
+
+        break;
+
+    case TFModbusTCPFunctionCode::ReadFileRecord:
+        expected_byte_count     = get_file_record_response_byte_count(transaction->function_code, static_cast<TFModbusTCPFileRecord *>(transaction->buffer), transaction->data_count);
+        expected_payload_length = offsetof(TFModbusTCPResponsePayload, file_bytes) + expected_byte_count;
+        copy_file_records       = true;
+        break;
+
+    case TFModbusTCPFunctionCode::WriteFileRecord:
+        expected_byte_count     = get_file_record_response_byte_count(transaction->function_code, static_cast<TFModbusTCPFileRecord *>(transaction->buffer), transaction->data_count);
+        expected_payload_length = offsetof(TFModbusTCPResponsePayload, file_bytes) + expected_byte_count;
+        check_file_records      = true;
+        break;
+
+    case TFModbusTCPFunctionCode::ReadFIFOQueue:
+        // The FIFO count is only known from the response itself. If the
+        // response is too short to contain it, expect an empty FIFO for the
+        // length check below to fail
+        expected_payload_length = offsetof(TFModbusTCPResponsePayload, fifo_values);
+
+        if (pending_response_payload_used >= expected_payload_length) {
+            expected_payload_length += ntohs(pending_response.payload.fifo_count) * 2u;
         }
 
+        copy_fifo_values = true;
         break;
 
     default:
         snprintf(error_message, sizeof(error_message), "Unsupported function code is 0x%02x", pending_response.payload.function_code);
         reset_pending_response();
-        finish_pending_transaction(TFModbusTCPClientTransactionResult::ResponseFunctionCodeNotSupported, error_message);
+        finish_pending_transaction(transaction, TFModbusTCPClientTransactionResult::ResponseFunctionCodeNotSupported, error_message);
         return true;
     }
 
@@ -632,7 +1294,7 @@ bool TFModbusTCPClient::recv_hook()
 
         snprintf(error_message, sizeof(error_message), "Actual length is %zu, expected is %zu", pending_response_payload_used, expected_payload_length);
         reset_pending_response();
-        finish_pending_transaction(TFModbusTCPClientTransactionResult::ResponseShorterThanExpected, error_message);
+        finish_pending_transaction(transaction, TFModbusTCPClientTransactionResult::ResponseShorterThanExpected, error_message);
         return true;
     }
 
@@ -649,41 +1311,115 @@ bool TFModbusTCPClient::recv_hook()
 
             snprintf(error_message, sizeof(error_message), "Actual byte count is %u, expected is %u", pending_response.payload.byte_count, expected_byte_count);
             reset_pending_response();
-            finish_pending_transaction(TFModbusTCPClientTransactionResult::ResponseByteCountMismatch, error_message);
+            finish_pending_transaction(transaction, TFModbusTCPClientTransactionResult::ResponseByteCountMismatch, error_message);
             return true;
         }
 
-        if (pending_transaction->buffer != nullptr) {
+        if (transaction->buffer == nullptr && copy_coil_values && (transaction->data_count % 8) != 0) {
+            // read view, clear the padding bits in place
+            pending_response.payload.coil_values[pending_response.payload.byte_count - 1] &= (1u << (transaction->data_count % 8)) - 1;
+        }
+
+        if (transaction->buffer != nullptr) {
             if (copy_coil_values) {
-                memcpy(pending_transaction->buffer, pending_response.payload.coil_values, pending_response.payload.byte_count);
-                static_cast<uint8_t *>(pending_transaction->buffer)[pending_response.payload.byte_count - 1] &= (1u << (pending_transaction->data_count % 8)) - 1;
+                memcpy(transaction->buffer, pending_response.payload.coil_values, pending_response.payload.byte_count);
+
+                if ((transaction->data_count % 8) != 0) {
+                    static_cast<uint8_t *>(transaction->buffer)[pending_response.payload.byte_count - 1] &= (1u << (transaction->data_count % 8)) - 1;
+                }
             }
 
             if (copy_register_values) {
                 if (register_byte_order == TFModbusTCPByteOrder::Host) {
-                    uint16_t *buffer = static_cast<uint16_t *>(pending_transaction->buffer);
+                    uint16_t *buffer = static_cast<uint16_t *>(transaction->buffer);
 
-                    for (size_t i = 0; i < pending_transaction->data_count; ++i) {
+                    for (size_t i = 0; i < transaction->data_count; ++i) {
                         buffer[i] = ntohs(pending_response.payload.register_values[i]);
                     }
                 }
                 else { // TFModbusTCPByteOrder::Network
-                    memcpy(pending_transaction->buffer, pending_response.payload.register_values, pending_response.payload.byte_count);
+                    memcpy(transaction->buffer, pending_response.payload.register_values, pending_response.payload.byte_count);
+                }
+            }
+        }
+
+        if (copy_file_records) {
+            TFModbusTCPFileRecord *records = static_cast<TFModbusTCPFileRecord *>(transaction->buffer);
+            const uint8_t *sub_response = pending_response.payload.file_bytes;
+
+            for (size_t i = 0; i < transaction->data_count; ++i) {
+                uint8_t expected_sub_response_length = static_cast<uint8_t>(1 + records[i].record_length * 2);
+
+                if (sub_response[0] != expected_sub_response_length || sub_response[1] != TF_MODBUS_TCP_FILE_RECORD_REFERENCE_TYPE) {
+                    debugfln("recv_hook() file record mismatch (index=%zu length=%u expected_length=%u reference_type=%u)",
+                             i, sub_response[0], expected_sub_response_length, sub_response[1]);
+
+                    snprintf(error_message, sizeof(error_message), "Record %zu has length %u and reference type %u, expected is %u and %u",
+                             i, sub_response[0], sub_response[1], expected_sub_response_length, TF_MODBUS_TCP_FILE_RECORD_REFERENCE_TYPE);
+                    reset_pending_response();
+                    finish_pending_transaction(transaction, TFModbusTCPClientTransactionResult::ResponseFileRecordMismatch, error_message);
+                    return true;
                 }
+
+                memcpy(records[i].record_data, sub_response + TF_MODBUS_TCP_FILE_RECORD_SUB_RESPONSE_LENGTH, records[i].record_length * 2u);
+                sub_response += TF_MODBUS_TCP_FILE_RECORD_SUB_RESPONSE_LENGTH + records[i].record_length * 2u;
+            }
+        }
+
+        if (check_file_records) {
+            uint8_t expected_file_bytes[TF_MODBUS_TCP_MAX_FILE_RECORD_BYTE_COUNT];
+
+            build_file_record_request(transaction->function_code, static_cast<TFModbusTCPFileRecord *>(transaction->buffer), transaction->data_count, expected_file_bytes);
+
+            if (memcmp(pending_response.payload.file_bytes, expected_file_bytes, expected_byte_count) != 0) {
+                debugfln("recv_hook() file record echo mismatch");
+
+                reset_pending_response();
+                finish_pending_transaction(transaction, TFModbusTCPClientTransactionResult::ResponseFileRecordMismatch, "Echoed records differ from written records");
+                return true;
+            }
+        }
+    }
+
+    if (copy_fifo_values) {
+        uint16_t fifo_byte_count = ntohs(pending_response.payload.fifo_byte_count);
+        uint16_t fifo_count      = ntohs(pending_response.payload.fifo_count);
+
+        if (fifo_count > TF_MODBUS_TCP_MAX_FIFO_COUNT || fifo_byte_count != 2 + fifo_count * 2) {
+            debugfln("recv_hook() FIFO byte count mismatch (pending_response.payload.fifo_byte_count=%u fifo_count=%u)",
+                     fifo_byte_count, fifo_count);
+
+            snprintf(error_message, sizeof(error_message), "Actual FIFO byte count is %u for %u values, maximum is %u values",
+                     fifo_byte_count, fifo_count, TF_MODBUS_TCP_MAX_FIFO_COUNT);
+            reset_pending_response();
+            finish_pending_transaction(transaction, TFModbusTCPClientTransactionResult::ResponseByteCountMismatch, error_message);
+            return true;
+        }
+
+        uint16_t *buffer = static_cast<uint16_t *>(transaction->buffer);
+
+        for (size_t i = 0; i < fifo_count; ++i) {
+            if (register_byte_order == TFModbusTCPByteOrder::Host) {
+                buffer[i] = ntohs(pending_response.payload.fifo_values[i]);
+            }
+            else { // TFModbusTCPByteOrder::Network
+                buffer[i] = pending_response.payload.fifo_values[i];
             }
         }
+
+        *transaction->fifo_count = fifo_count;
     }
 
     if (check_start_address) {
         uint16_t actual_start_address = ntohs(pending_response.payload.start_address);
 
-        if (actual_start_address != pending_transaction->start_address) {
-            debugfln("recv_hook() start address mismatch (pending_response.payload.start_address=%u pending_transaction->start_address=%u)",
-                     actual_start_address, pending_transaction->start_address);
+        if (actual_start_address != transaction->start_address) {
+            debugfln("recv_hook() start address mismatch (pending_response.payload.start_address=%u transaction->start_address=%u)",
+                     actual_start_address, transaction->start_address);
 
-            snprintf(error_message, sizeof(error_message), "Actual start address is %u, expected is %u", actual_start_address, pending_transaction->start_address);
+            snprintf(error_message, sizeof(error_message), "Actual start address is %u, expected is %u", actual_start_address, transaction->start_address);
             reset_pending_response();
-            finish_pending_transaction(TFModbusTCPClientTransactionResult::ResponseStartAddressMismatch, error_message);
+            finish_pending_transaction(transaction, TFModbusTCPClientTransactionResult::ResponseStartAddressMismatch, error_message);
             return true;
         }
     }
@@ -697,7 +1433,7 @@ bool TFModbusTCPClient::recv_hook()
 
             snprintf(error_message, sizeof(error_message), "Actual data value is %u, expected is %u", actual_data_value, expected_data_value);
             reset_pending_response();
-            finish_pending_transaction(TFModbusTCPClientTransactionResult::ResponseDataValueMismatch, error_message);
+            finish_pending_transaction(transaction, TFModbusTCPClientTransactionResult::ResponseDataValueMismatch, error_message);
             return true;
         }
     }
@@ -705,13 +1441,13 @@ bool TFModbusTCPClient::recv_hook()
     if (check_data_count) {
         uint16_t actual_data_count = ntohs(pending_response.payload.data_count);
 
-        if (actual_data_count != pending_transaction->data_count) {
-            debugfln("recv_hook() data count mismatch (pending_response.payload.data_count=%u pending_transaction->data_count=%u)",
-                     actual_data_count, pending_transaction->data_count);
+        if (actual_data_count != transaction->data_count) {
+            debugfln("recv_hook() data count mismatch (pending_response.payload.data_count=%u transaction->data_count=%u)",
+                     actual_data_count, transaction->data_count);
 
-            snprintf(error_message, sizeof(error_message), "Actual data count is %u, expected is %u", actual_data_count, pending_transaction->data_count);
+            snprintf(error_message, sizeof(error_message), "Actual data count is %u, expected is %u", actual_data_count, transaction->data_count);
             reset_pending_response();
-            finish_pending_transaction(TFModbusTCPClientTransactionResult::ResponseDataCountMismatch, error_message);
+            finish_pending_transaction(transaction, TFModbusTCPClientTransactionResult::ResponseDataCountMismatch, error_message);
             return true;
         }
     }
@@ -725,7 +1461,7 @@ bool TFModbusTCPClient::recv_hook()
 
             snprintf(error_message, sizeof(error_message), "Actual AND mask is %u, expected is %u", actual_and_mask, expected_and_mask);
             reset_pending_response();
-            finish_pending_transaction(TFModbusTCPClientTransactionResult::ResponseAndMaskMismatch, error_message);
+            finish_pending_transaction(transaction, TFModbusTCPClientTransactionResult::ResponseAndMaskMismatch, error_message);
             return true;
         }
     }
@@ -738,13 +1474,16 @@ bool TFModbusTCPClient::recv_hook()
 
             snprintf(error_message, sizeof(error_message), "Actual OR mask is %u, expected is %u", actual_or_mask, expected_or_mask);
             reset_pending_response();
-            finish_pending_transaction(TFModbusTCPClientTransactionResult::ResponseOrMaskMismatch, error_message);
+            finish_pending_transaction(transaction, TFModbusTCPClientTransactionResult::ResponseOrMaskMismatch, error_message);
             return true;
         }
     }
 
+    // the payload stays untouched until the next recv_hook call
+    TFModbusTCPReadView read_view(transaction->function_code, transaction->start_address, transaction->data_count, pending_response.payload.coil_values);
+
     reset_pending_response();
-    finish_pending_transaction(TFModbusTCPClientTransactionResult::Success, nullptr);
+    finish_pending_transaction(transaction, TFModbusTCPClientTransactionResult::Success, nullptr, &read_view);
     return true;
 }
 
@@ -776,78 +1515,188 @@ ssize_t TFModbusTCPClient::receive_response_payload(size_t length)
         return -1;
     }
 
-    if (pending_transaction != nullptr && pending_transaction_recvs < UINT32_MAX) {
-        ++pending_transaction_recvs;
-    }
+    count_pending_transaction_recv();
 
     pending_response_payload_used += result;
     return result;
 }
 
+void TFModbusTCPClient::count_pending_transaction_recv()
+{
+    for (TFModbusTCPClientTransaction *transaction = pending_transaction_head; transaction != nullptr; transaction = transaction->next) {
+        if (transaction->recvs < UINT32_MAX) {
+            ++transaction->recvs;
+        }
+    }
+}
+
+TFModbusTCPClientTransaction *TFModbusTCPClient::find_pending_transaction(uint16_t transaction_id)
+{
+    for (TFModbusTCPClientTransaction *transaction = pending_transaction_head; transaction != nullptr; transaction = transaction->next) {
+        if (transaction->transaction_id == transaction_id) {
+            return transaction;
+        }
+    }
+
+    return nullptr;
+}
+
 void TFModbusTCPClient::finish_pending_transaction(uint16_t transaction_id, TFModbusTCPClientTransactionResult result, const char *error_message)
 {
-    if (pending_transaction != nullptr && pending_transaction_id == transaction_id) {
-        finish_pending_transaction(result, error_message);
+    TFModbusTCPClientTransaction *transaction = find_pending_transaction(transaction_id);
+
+    if (transaction != nullptr) {
+        finish_pending_transaction(transaction, result, error_message);
     }
 }
 
-void TFModbusTCPClient::finish_pending_transaction(TFModbusTCPClientTransactionResult result, const char *error_message)
+void TFModbusTCPClient::finish_pending_transaction(TFModbusTCPClientTransaction *transaction, TFModbusTCPClientTransactionResult result, const char *error_message, const TFModbusTCPReadView *read_view /*= nullptr*/)
 {
-    if (pending_transaction != nullptr) {
-        debugfln("finish_pending_transaction(result=%s, error_message=%s) finish after %zu ticks, %zu recvs, %zu ms",
-                 get_tf_modbus_tcp_client_transaction_result_name(result),
-                 TFNetwork::printf_safe(error_message),
-                 pending_transaction_ticks,
-                 pending_transaction_recvs,
-                 (now_us() - pending_transaction_since).to<millis_t>().as<size_t>());
+    TFModbusTCPClientTransaction **prev_next_ptr = &pending_transaction_head;
+
+    while (*prev_next_ptr != nullptr && *prev_next_ptr != transaction) {
+        prev_next_ptr = &(*prev_next_ptr)->next;
+    }
+
+    if (*prev_next_ptr == nullptr) {
+        return;
+    }
+
+    *prev_next_ptr = transaction->next;
+    --pending_transaction_count;
+
+    debugfln("finish_pending_transaction(transaction_id=%u result=%s, error_message=%s) finish after %zu ticks, %zu recvs, %zu ms",
+             transaction->transaction_id,
+             get_tf_modbus_tcp_client_transaction_result_name(result),
+             TFNetwork::printf_safe(error_message),
+             transaction->ticks,
+             transaction->recvs,
+             (now_us() - transaction->since).to<millis_t>().as<size_t>());
+
+    if (write_shadow != nullptr) {
+        update_write_shadow(transaction, result == TFModbusTCPClientTransactionResult::Success);
+    }
+
+    if (bus_scheduler != nullptr) {
+        update_bus_scheduler(transaction, result);
+    }
+
+    micros_t latency = now_us() - transaction->since;
+
+    update_statistics(result);
+    statistics.latency.add(latency.as<int64_t>());
+
+    if (transaction_observer) {
+        transaction_observer(transaction, result, latency);
+    }
 
-        TFModbusTCPClientTransactionCallback callback = std::move(pending_transaction->callback);
-        pending_transaction->callback = nullptr;
+    TFModbusTCPClientTransactionCallback callback        = std::move(transaction->callback);
+    TFModbusTCPClientReadViewCallback read_view_callback = std::move(transaction->read_view_callback);
 
-        delete pending_transaction;
-        pending_transaction          = nullptr;
-        pending_transaction_id       = 0;
-        pending_transaction_deadline = 0_s;
+    transaction->callback           = nullptr;
+    transaction->read_view_callback = nullptr;
 
+    delete transaction;
+
+    if (read_view_callback) {
+        read_view_callback(result, error_message, result == TFModbusTCPClientTransactionResult::Success ? read_view : nullptr);
+    }
+    else {
         callback(result, error_message);
     }
 }
 
 void TFModbusTCPClient::finish_all_transactions(TFModbusTCPClientTransactionResult result, const char *error_message)
 {
-    finish_pending_transaction(result, error_message);
+    while (pending_transaction_head != nullptr) {
+        finish_pending_transaction(pending_transaction_head, result, error_message);
+    }
 
     TFModbusTCPClientTransaction *scheduled_transaction = scheduled_transaction_head;
     scheduled_transaction_head = nullptr;
 
     while (scheduled_transaction != nullptr) {
-        TFModbusTCPClientTransactionCallback callback = std::move(scheduled_transaction->callback);
-        scheduled_transaction->callback = nullptr;
+        update_statistics(result);
+
+        if (transaction_observer) {
+            transaction_observer(scheduled_transaction, result, 0_us);
+        }
+
+        TFModbusTCPClientTransactionCallback callback        = std::move(scheduled_transaction->callback);
+        TFModbusTCPClientReadViewCallback read_view_callback = std::move(scheduled_transaction->read_view_callback);
+
+        scheduled_transaction->callback           = nullptr;
+        scheduled_transaction->read_view_callback = nullptr;
 
         TFModbusTCPClientTransaction *scheduled_transaction_next = scheduled_transaction->next;
 
         delete scheduled_transaction;
         scheduled_transaction = scheduled_transaction_next;
 
-        callback(result, error_message);
+        if (read_view_callback) {
+            read_view_callback(result, error_message, nullptr);
+        }
+        else {
+            callback(result, error_message);
+        }
+    }
+}
+
+void TFModbusTCPClient::update_statistics(TFModbusTCPClientTransactionResult result)
+{
+    switch (result) {
+    case TFModbusTCPClientTransactionResult::Success:
+        ++statistics.success_count;
+        break;
+
+    case TFModbusTCPClientTransactionResult::ModbusIllegalFunction:
+    case TFModbusTCPClientTransactionResult::ModbusIllegalDataAddress:
+    case TFModbusTCPClientTransactionResult::ModbusIllegalDataValue:
+    case TFModbusTCPClientTransactionResult::ModbusServerDeviceFailure:
+    case TFModbusTCPClientTransactionResult::ModbusAcknowledge:
+    case TFModbusTCPClientTransactionResult::ModbusServerDeviceBusy:
+    case TFModbusTCPClientTransactionResult::ModbusMemoryParityError:
+    case TFModbusTCPClientTransactionResult::ModbusGatewayPathUnvailable:
+    case TFModbusTCPClientTransactionResult::ModbusGatewayTargetDeviceFailedToRespond:
+        ++statistics.exception_count;
+        break;
+
+    case TFModbusTCPClientTransactionResult::Timeout:
+        ++statistics.timeout_count;
+        break;
+
+    default:
+        ++statistics.failure_count;
+        break;
     }
 }
 
 void TFModbusTCPClient::check_pending_transaction_timeout()
 {
-    if (pending_transaction != nullptr && deadline_elapsed(pending_transaction_deadline)) {
-        debugfln("check_pending_transaction_timeout() timeout after %zu ticks, %zu recvs, %zu ms",
-                 pending_transaction_ticks,
-                 pending_transaction_recvs,
-                 (now_us() - pending_transaction_since).to<millis_t>().as<size_t>());
+    TFModbusTCPClientTransaction *transaction = pending_transaction_head;
+
+    while (transaction != nullptr) {
+        if (!deadline_elapsed(transaction->deadline)) {
+            transaction = transaction->next;
+            continue;
+        }
+
+        debugfln("check_pending_transaction_timeout() timeout after %zu ticks, %zu recvs, %zu ms (transaction_id=%u)",
+                 transaction->ticks,
+                 transaction->recvs,
+                 (now_us() - transaction->since).to<millis_t>().as<size_t>(),
+                 transaction->transaction_id);
 
         char error_message[128];
         snprintf(error_message, sizeof(error_message), "After %zu ticks, %zu recvs, %zu ms",
-                 pending_transaction_ticks,
-                 pending_transaction_recvs,
-                 (now_us() - pending_transaction_since).to<millis_t>().as<size_t>());
+                 transaction->ticks,
+                 transaction->recvs,
+                 (now_us() - transaction->since).to<millis_t>().as<size_t>());
+
+        finish_pending_transaction(transaction, TFModbusTCPClientTransactionResult::Timeout, error_message);
 
-        finish_pending_transaction(TFModbusTCPClientTransactionResult::Timeout, error_message);
+        // The callback might have changed the list, start over
+        transaction = pending_transaction_head;
     }
 }
 
@@ -857,3 +1706,322 @@ void TFModbusTCPClient::reset_pending_response()
     pending_response_header_checked = false;
     pending_response_payload_used   = 0;
 }
+
+// Merge a run of scheduled register or coil writes at the head of the schedule
+// into a single Write Multiple Registers or Write Multiple Coils transaction, if
+// each write continues the address range of the previous one. Only directly
+// consecutive scheduled transactions are merged, therefore the order relative
+// to all other scheduled transactions stays unchanged.
+void TFModbusTCPClient::combine_scheduled_writes(TFModbusTCPClientTransaction **first_ptr)
+{
+    TFModbusTCPClientTransaction *first = *first_ptr;
+    bool coils = is_coil_write(first->function_code);
+    size_t max_data_count;
+
+    if (coils) {
+        max_data_count = TF_MODBUS_TCP_MAX_WRITE_COIL_COUNT;
+    }
+    else if (first->function_code == TFModbusTCPFunctionCode::WriteSingleRegister
+          || first->function_code == TFModbusTCPFunctionCode::WriteMultipleRegisters) {
+        max_data_count = device_profile.max_write_register_count;
+    }
+    else {
+        return;
+    }
+
+    TFModbusTCPClientTransaction *last = first;
+    size_t data_count                  = first->data_count;
+    size_t member_count                = 1;
+    micros_t timeout                   = first->timeout;
+
+    while (last->next != nullptr) {
+        TFModbusTCPClientTransaction *candidate = last->next;
+
+        if (candidate->function_code != TFModbusTCPFunctionCode::WriteSingleCoil
+         && candidate->function_code != TFModbusTCPFunctionCode::WriteMultipleCoils
+         && candidate->function_code != TFModbusTCPFunctionCode::WriteSingleRegister
+         && candidate->function_code != TFModbusTCPFunctionCode::WriteMultipleRegisters) {
+            break;
+        }
+
+        if (is_coil_write(candidate->function_code) != coils
+         || candidate->unit_id != first->unit_id
+         || candidate->transaction_id_mask != first->transaction_id_mask
+         || static_cast<size_t>(candidate->start_address) != first->start_address + data_count
+         || data_count + candidate->data_count > max_data_count) {
+            break;
+        }
+
+        data_count += candidate->data_count;
+        timeout     = std::min(timeout, candidate->timeout);
+        last        = candidate;
+        ++member_count;
+    }
+
+    if (member_count < 2) {
+        return;
+    }
+
+    debugfln("combine_scheduled_writes() combining %zu writes (unit_id=%u start_address=%u data_count=%zu coils=%d)",
+             member_count, first->unit_id, first->start_address, data_count, coils ? 1 : 0);
+
+    uint8_t *buffer;
+
+    if (coils) {
+        buffer = new uint8_t[(data_count + 7) / 8];
+        memset(buffer, 0, (data_count + 7) / 8);
+
+        size_t offset = 0;
+
+        for (TFModbusTCPClientTransaction *member = first; member != last->next; member = member->next) {
+            const uint8_t *member_buffer = static_cast<const uint8_t *>(member->buffer);
+
+            for (size_t i = 0; i < member->data_count; ++i, ++offset) {
+                bool value;
+
+                if (member->function_code == TFModbusTCPFunctionCode::WriteSingleCoil) {
+                    value = member_buffer[0] != 0;
+                }
+                else {
+                    value = ((member_buffer[i / 8] >> (i % 8)) & 1) != 0;
+                }
+
+                if (value) {
+                    buffer[offset / 8] |= static_cast<uint8_t>(1u << (offset % 8));
+                }
+            }
+        }
+    }
+    else {
+        buffer = new uint8_t[data_count * 2];
+
+        size_t offset = 0;
+
+        for (TFModbusTCPClientTransaction *member = first; member != last->next; member = member->next) {
+            memcpy(buffer + offset * 2, member->buffer, member->data_count * 2); // same byte order on both sides
+            offset += member->data_count;
+        }
+    }
+
+    TFModbusTCPClientTransaction *combined = new TFModbusTCPClientTransaction;
+
+    combined->unit_id             = first->unit_id;
+    combined->function_code       = coils ? TFModbusTCPFunctionCode::WriteMultipleCoils : TFModbusTCPFunctionCode::WriteMultipleRegisters;
+    combined->start_address       = first->start_address;
+    combined->data_count          = static_cast<uint16_t>(data_count);
+    combined->buffer              = buffer;
+    combined->timeout             = timeout;
+    combined->transaction_id_mask = first->transaction_id_mask;
+    combined->fifo_count          = nullptr;
+    combined->bus                 = 0;
+    combined->next                = last->next;
+
+    last->next = nullptr;
+
+    combined->callback = [first, buffer](TFModbusTCPClientTransactionResult result, const char *error_message) {
+        delete[] buffer;
+
+        TFModbusTCPClientTransaction *member = first;
+
+        while (member != nullptr) {
+            TFModbusTCPClientTransactionCallback callback = std::move(member->callback);
+            member->callback = nullptr;
+
+            TFModbusTCPClientTransaction *member_next = member->next;
+
+            delete member;
+            member = member_next;
+
+            callback(result, error_message);
+        }
+    };
+
+    *first_ptr = combined;
+}
+
+void TFModbusTCPClient::update_bus_scheduler(TFModbusTCPClientTransaction *transaction, TFModbusTCPClientTransactionResult result)
+{
+    TFModbusTCPClientBusSchedulerUnit *unit = &bus_scheduler->units[transaction->unit_id];
+    TFModbusTCPClientBusSchedulerBus *bus   = &bus_scheduler->buses[transaction->bus];
+
+    // Bus scheduling might have been enabled while this transaction was pending
+    if (unit->pending_transaction_count > 0) {
+        --unit->pending_transaction_count;
+    }
+
+    if (bus->pending_transaction_count > 0) {
+        --bus->pending_transaction_count;
+    }
+
+    // Modbus exceptions are responses from the unit too, except for the gateway
+    // exceptions. Count only those for the latency
+    if (result >= TFModbusTCPClientTransactionResult::ModbusGatewayPathUnvailable) {
+        return;
+    }
+
+    micros_t latency = now_us() - transaction->since;
+
+    if (unit->response_latency == 0_s) {
+        unit->response_latency = latency;
+    }
+    else {
+        unit->response_latency = micros_t{unit->response_latency.as<int64_t>() + (latency - unit->response_latency).as<int64_t>() / 8};
+    }
+}
+
+// A write is shadowed if all its values match the last acknowledged values and
+// no other write to an overlapping range is scheduled or pending, because that
+// write could change the values before this write would have been executed.
+bool TFModbusTCPClient::is_write_shadowed(uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, const void *buffer)
+{
+    bool coil = is_coil_write(function_code);
+
+    if (!coil && (!is_register_write(function_code) || function_code == TFModbusTCPFunctionCode::MaskWriteRegister)) {
+        return false;
+    }
+
+    TFModbusTCPClientTransaction *transaction = pending_transaction_head;
+    bool scheduled = false;
+
+    while (true) {
+        if (transaction == nullptr) {
+            if (scheduled) {
+                break;
+            }
+
+            transaction = scheduled_transaction_head;
+            scheduled   = true;
+            continue;
+        }
+
+        if (transaction->unit_id == unit_id
+         && (coil ? is_coil_write(transaction->function_code) : is_register_write(transaction->function_code))
+         && transaction->start_address < start_address + data_count
+         && start_address < transaction->start_address + transaction->data_count) {
+            return false;
+        }
+
+        transaction = transaction->next;
+    }
+
+    for (size_t i = 0; i < data_count; ++i) {
+        uint16_t address = start_address + i;
+        uint16_t value   = get_data_value(function_code, buffer, i);
+        bool found       = false;
+
+        for (size_t k = 0; k < TF_MODBUS_TCP_CLIENT_WRITE_SHADOW_SIZE; ++k) {
+            TFModbusTCPClientWriteShadowEntry *entry = &write_shadow[k];
+
+            if (entry->used && entry->unit_id == unit_id && entry->coil == coil && entry->address == address) {
+                found = entry->value == value && !deadline_elapsed(entry->acknowledged + write_shadow_refresh_interval);
+                break;
+            }
+        }
+
+        if (!found) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void TFModbusTCPClient::update_write_shadow(TFModbusTCPClientTransaction *transaction, bool success)
+{
+    bool coil;
+    bool store;
+
+    switch (transaction->function_code) {
+    case TFModbusTCPFunctionCode::ReadCoils:
+    case TFModbusTCPFunctionCode::ReadHoldingRegisters:
+        // A successful read reveals values changed by the device itself, drop
+        // all mismatching entries. Keep the matching entries as they are, the
+        // refresh interval is about writes, not reads
+        if (!success) {
+            return;
+        }
+
+        // a read view has no buffer to compare with, drop all entries instead
+        if (transaction->buffer == nullptr) {
+            success = false;
+        }
+
+        coil  = transaction->function_code == TFModbusTCPFunctionCode::ReadCoils;
+        store = false;
+        break;
+
+    case TFModbusTCPFunctionCode::WriteSingleCoil:
+    case TFModbusTCPFunctionCode::WriteMultipleCoils:
+        coil  = true;
+        store = success;
+        break;
+
+    case TFModbusTCPFunctionCode::WriteSingleRegister:
+    case TFModbusTCPFunctionCode::WriteMultipleRegisters:
+        coil  = false;
+        store = success;
+        break;
+
+    case TFModbusTCPFunctionCode::MaskWriteRegister:
+        coil  = false;
+        store = false;
+        break;
+
+    default:
+        return;
+    }
+
+    micros_t now = now_us();
+    size_t data_count = transaction->function_code == TFModbusTCPFunctionCode::MaskWriteRegister ? 1 : transaction->data_count;
+
+    for (size_t i = 0; i < data_count; ++i) {
+        uint16_t address = transaction->start_address + i;
+        uint16_t value   = transaction->function_code == TFModbusTCPFunctionCode::MaskWriteRegister || transaction->buffer == nullptr ? 0 : get_data_value(transaction->function_code, transaction->buffer, i);
+        TFModbusTCPClientWriteShadowEntry *free_entry = nullptr;
+        TFModbusTCPClientWriteShadowEntry *oldest_entry = nullptr;
+        bool found = false;
+
+        for (size_t k = 0; k < TF_MODBUS_TCP_CLIENT_WRITE_SHADOW_SIZE; ++k) {
+            TFModbusTCPClientWriteShadowEntry *entry = &write_shadow[k];
+
+            if (!entry->used) {
+                if (free_entry == nullptr) {
+                    free_entry = entry;
+                }
+
+                continue;
+            }
+
+            if (entry->unit_id == transaction->unit_id && entry->coil == coil && entry->address == address) {
+                if (store) {
+                    entry->value        = value;
+                    entry->acknowledged = now;
+                }
+                else if (success && transaction->function_code != TFModbusTCPFunctionCode::MaskWriteRegister) {
+                    entry->used = entry->value == value; // read
+                }
+                else {
+                    entry->used = false;
+                }
+
+                found = true;
+                break;
+            }
+
+            if (oldest_entry == nullptr || entry->acknowledged < oldest_entry->acknowledged) {
+                oldest_entry = entry;
+            }
+        }
+
+        if (!found && store) {
+            TFModbusTCPClientWriteShadowEntry *entry = free_entry != nullptr ? free_entry : oldest_entry;
+
+            entry->used         = true;
+            entry->coil         = coil;
+            entry->unit_id      = transaction->unit_id;
+            entry->address      = address;
+            entry->value        = value;
+            entry->acknowledged = now;
+        }
+    }
+}
@@ -20,9 +20,11 @@
 #pragma once
 
 #include <sys/types.h>
+#include <string.h>
 
 #include "TFGenericTCPClient.h"
 #include "TFModbusTCPCommon.h"
+#include "TFModbusTCPDeviceProfile.h"
 #include "TFNetwork.h"
 
 // configuration
@@ -30,6 +32,14 @@
 #define TF_MODBUS_TCP_CLIENT_MAX_SCHEDULED_TRANSACTION_COUNT 16
 #endif
 
+#ifndef TF_MODBUS_TCP_CLIENT_WRITE_SHADOW_SIZE
+#define TF_MODBUS_TCP_CLIENT_WRITE_SHADOW_SIZE 32
+#endif
+
+#ifndef TF_MODBUS_TCP_CLIENT_MAX_BUS_COUNT
+#define TF_MODBUS_TCP_CLIENT_MAX_BUS_COUNT 4
+#endif
+
 enum class TFModbusTCPClientTransactionResult
 {
     Success = 0,
@@ -64,29 +74,114 @@ enum class TFModbusTCPClientTransactionResult
     ResponseAndMaskMismatch,
     ResponseOrMaskMismatch,
     ResponseShorterThanExpected,
+    ResponseFileRecordMismatch,
 };
 
 const char *get_tf_modbus_tcp_client_transaction_result_name(TFModbusTCPClientTransactionResult result);
 
+// maps a downstream result to the exception code a gateway should answer with
+TFModbusTCPExceptionCode get_tf_modbus_tcp_client_transaction_result_exception_code(TFModbusTCPClientTransactionResult result);
+
+// true if the result is an exception response of the peer
+bool is_tf_modbus_tcp_client_transaction_result_modbus_exception(TFModbusTCPClientTransactionResult result);
+
 typedef std::function<void(TFModbusTCPClientTransactionResult result, const char *error_message)> TFModbusTCPClientTransactionCallback;
 
+// Read-only view into the receive buffer of the client. Register values are
+// in network byte order and not necessarily 2-byte aligned, coil values are
+// packed bits, LSB first. The helpers decode single values, 32 bit values are
+// two registers, high word first. Out-of-range indices decode as 0
+class TFModbusTCPReadView final
+{
+public:
+    TFModbusTCPReadView(TFModbusTCPFunctionCode function_code_, uint16_t start_address_, uint16_t data_count_, const uint8_t *bytes_) :
+        function_code(function_code_), start_address(start_address_), data_count(data_count_), bytes(bytes_) {}
+
+    TFModbusTCPReadView(TFModbusTCPReadView const &other) = delete;
+    TFModbusTCPReadView &operator=(TFModbusTCPReadView const &other) = delete;
+
+    TFModbusTCPFunctionCode get_function_code() const { return function_code; }
+    uint16_t get_start_address() const { return start_address; }
+    uint16_t get_data_count() const { return data_count; }
+    bool is_bits() const { return function_code == TFModbusTCPFunctionCode::ReadCoils || function_code == TFModbusTCPFunctionCode::ReadDiscreteInputs; }
+    const uint8_t *get_bytes() const { return bytes; }
+    size_t get_byte_count() const { return is_bits() ? (data_count + 7u) / 8u : data_count * 2u; }
+
+    bool get_bit(size_t index) const { return index < data_count && ((bytes[index / 8] >> (index % 8)) & 1) != 0; }
+    uint16_t get_u16(size_t index) const { return index < data_count ? static_cast<uint16_t>((bytes[index * 2] << 8) | bytes[index * 2 + 1]) : 0; }
+    int16_t get_i16(size_t index) const { return static_cast<int16_t>(get_u16(index)); }
+    uint32_t get_u32(size_t index) const { return index + 1 < data_count ? (static_cast<uint32_t>(get_u16(index)) << 16) | get_u16(index + 1) : 0; }
+    int32_t get_i32(size_t index) const { return static_cast<int32_t>(get_u32(index)); }
+    float get_f32(size_t index) const { uint32_t value = get_u32(index); float result; memcpy(&result, &value, sizeof(result)); return result; }
+
+private:
+    TFModbusTCPFunctionCode function_code;
+    uint16_t start_address;
+    uint16_t data_count;
+    const uint8_t *bytes;
+};
+
+// The view is only valid during the call and nullptr if the read failed
+typedef std::function<void(TFModbusTCPClientTransactionResult result, const char *error_message, const TFModbusTCPReadView *view)> TFModbusTCPClientReadViewCallback;
+
 struct TFModbusTCPClientTransaction
 {
     uint8_t unit_id;
     TFModbusTCPFunctionCode function_code;
     uint16_t start_address;
     uint16_t data_count;
-    void *buffer;
+    void *buffer;            // nullptr for read view transactions
     micros_t timeout;
     TFModbusTCPClientTransactionCallback callback;
+    TFModbusTCPClientReadViewCallback read_view_callback; // set instead of callback
     uint16_t transaction_id_mask;
+    uint16_t *fifo_count;    // Read FIFO Queue (24)
+    uint16_t transaction_id; // valid while pending
+    micros_t deadline;       // valid while pending
+    micros_t since;          // valid while pending
+    size_t ticks;            // valid while pending
+    size_t recvs;            // valid while pending
+    uint8_t bus;             // valid while pending and bus scheduling is enabled
     TFModbusTCPClientTransaction *next;
 };
 
+// The transaction and its buffer are only valid during the call. Transactions
+// that were never sent have a latency of 0. Read view transactions have no
+// buffer
+typedef std::function<void(const TFModbusTCPClientTransaction *transaction, TFModbusTCPClientTransactionResult result, micros_t latency)> TFModbusTCPClientTransactionObserver;
+
+struct TFModbusTCPClientStatistics
+{
+    uint64_t success_count   = 0;
+    uint64_t exception_count = 0; // Modbus exception responses
+    uint64_t timeout_count   = 0;
+    uint64_t failure_count   = 0; // everything else, including transactions that were never sent
+    TFNetworkLatencyHistogram latency; // of sent transactions
+};
+
+// Read sent by an otherwise idle client to detect a silently dead connection
+// before the next real transaction runs into its timeout. If the probe fails
+// for other reasons than a Modbus exception the client gets disconnected with
+// the IdleProbeFailed reason. Probe transactions are counted in the statistics
+// and reported to the transaction observer like any other transaction
+struct TFModbusTCPClientIdleProbe
+{
+    micros_t idle_interval                = 0_s; // 0 disables the probe
+    uint8_t unit_id                       = 1;
+    TFModbusTCPFunctionCode function_code = TFModbusTCPFunctionCode::ReadHoldingRegisters;
+    uint16_t start_address                = 0;
+    uint16_t data_count                   = 1;
+    micros_t timeout                      = 2_s;
+};
+
+struct TFModbusTCPClientWriteShadowEntry;
+struct TFModbusTCPClientBusScheduler;
+
 class TFModbusTCPClient final : public TFGenericTCPClient
 {
 public:
     TFModbusTCPClient(TFModbusTCPByteOrder register_byte_order_) : register_byte_order(register_byte_order_), next_transaction_id(TFNetwork::get_random_uint16()) {}
+    ~TFModbusTCPClient();
 
     void transact(uint8_t unit_id,
                   TFModbusTCPFunctionCode function_code,
@@ -97,26 +192,109 @@ public:
                   TFModbusTCPClientTransactionCallback &&callback,
                   uint16_t transaction_id_mask = UINT16_MAX);
 
+    // Read File Record (20) or Write File Record (21) with one or more records
+    // per request. The records array has to stay valid until the callback
+    void transact_file_records(uint8_t unit_id,
+                               TFModbusTCPFunctionCode function_code,
+                               TFModbusTCPFileRecord *records,
+                               uint16_t record_count,
+                               micros_t timeout,
+                               TFModbusTCPClientTransactionCallback &&callback,
+                               uint16_t transaction_id_mask = UINT16_MAX);
+
+    // Read FIFO Queue (24). The fifo_values buffer has to have room for
+    // TF_MODBUS_TCP_MAX_FIFO_COUNT values, fifo_count is set on success
+    void read_fifo_queue(uint8_t unit_id,
+                         uint16_t fifo_pointer_address,
+                         uint16_t *fifo_values,
+                         uint16_t *fifo_count,
+                         micros_t timeout,
+                         TFModbusTCPClientTransactionCallback &&callback,
+                         uint16_t transaction_id_mask = UINT16_MAX);
+
+    // Read Coils (1), Read Discrete Inputs (2), Read Holding Registers (3) or
+    // Read Input Registers (4) without a caller buffer. The callback decodes
+    // the values directly from the receive buffer, instead of getting a copy
+    // in the configured register byte order
+    void read_view(uint8_t unit_id,
+                   TFModbusTCPFunctionCode function_code,
+                   uint16_t start_address,
+                   uint16_t data_count,
+                   micros_t timeout,
+                   TFModbusTCPClientReadViewCallback &&callback,
+                   uint16_t transaction_id_mask = UINT16_MAX);
+
+    void set_write_combining_enabled(bool enabled) { write_combining_enabled = enabled; }
+    void set_write_shadow_enabled(bool enabled, micros_t refresh_interval = 60_s);
+    void set_device_profile(const TFModbusTCPDeviceProfile *profile);
+    const TFModbusTCPDeviceProfile *get_device_profile() const { return &device_profile; }
+    void set_idle_probe(const TFModbusTCPClientIdleProbe *probe); // nullptr disables the probe
+
+    // Bus scheduling is meant for gateways that forward to one or more serial
+    // buses with several units each. A scheduled transaction is only sent if
+    // neither its unit nor its bus is at their pending transaction limit. Units
+    // take turns fairly, the order of transactions per unit is kept. The limit
+    // for the whole gateway is the max pending transaction count of the device
+    // profile. All units are on bus 0 by default
+    void set_bus_scheduling_enabled(bool enabled);
+    void set_unit_bus(uint8_t unit_id, uint8_t bus);
+    void set_unit_max_pending_transaction_count(uint8_t count);
+    void set_bus_max_pending_transaction_count(uint8_t bus, uint8_t count);
+    micros_t get_unit_response_latency(uint8_t unit_id) const; // 0 if unknown
+
+    // called for every finished transaction, before its callback
+    void set_transaction_observer(TFModbusTCPClientTransactionObserver &&observer) { transaction_observer = std::move(observer); }
+
+    size_t get_pending_transaction_count() const { return pending_transaction_count; }
+    size_t get_scheduled_transaction_count() const;
+    const TFModbusTCPClientStatistics *get_statistics() const { return &statistics; }
+
 private:
     void close_hook() override;
     void tick_hook() override;
     bool recv_hook() override;
 
+    void schedule_transaction(uint8_t unit_id,
+                              TFModbusTCPFunctionCode function_code,
+                              uint16_t start_address,
+                              uint16_t data_count,
+                              void *buffer,
+                              micros_t timeout,
+                              TFModbusTCPClientTransactionCallback &&callback,
+                              uint16_t transaction_id_mask,
+                              uint16_t *fifo_count,
+                              TFModbusTCPClientReadViewCallback &&read_view_callback);
+    TFModbusTCPClientTransaction **select_scheduled_transaction();
+    bool send_scheduled_transaction(TFModbusTCPClientTransaction **transaction_ptr);
     ssize_t receive_response_payload(size_t length);
+    void count_pending_transaction_recv();
+    TFModbusTCPClientTransaction *find_pending_transaction(uint16_t transaction_id);
     void finish_pending_transaction(uint16_t transaction_id, TFModbusTCPClientTransactionResult result, const char *error_message);
-    void finish_pending_transaction(TFModbusTCPClientTransactionResult result, const char *error_message);
+    void finish_pending_transaction(TFModbusTCPClientTransaction *transaction, TFModbusTCPClientTransactionResult result, const char *error_message, const TFModbusTCPReadView *read_view = nullptr);
     void finish_all_transactions(TFModbusTCPClientTransactionResult result, const char *error_message);
     void check_pending_transaction_timeout();
     void reset_pending_response();
+    void combine_scheduled_writes(TFModbusTCPClientTransaction **first_ptr);
+    bool is_write_shadowed(uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, const void *buffer);
+    void update_write_shadow(TFModbusTCPClientTransaction *transaction, bool success);
+    void update_bus_scheduler(TFModbusTCPClientTransaction *transaction, TFModbusTCPClientTransactionResult result);
+    void update_statistics(TFModbusTCPClientTransactionResult result);
+    void check_idle_probe();
 
     TFModbusTCPByteOrder register_byte_order;
     uint16_t next_transaction_id;
-    TFModbusTCPClientTransaction *pending_transaction        = nullptr;
-    uint16_t pending_transaction_id                          = 0;
-    micros_t pending_transaction_deadline                    = 0_s;
-    size_t pending_transaction_ticks                         = 0;
-    size_t pending_transaction_recvs                         = 0;
-    micros_t pending_transaction_since                       = 0_s;
+    bool write_combining_enabled                             = false;
+    TFModbusTCPClientWriteShadowEntry *write_shadow          = nullptr;
+    micros_t write_shadow_refresh_interval                   = 0_s;
+    TFModbusTCPDeviceProfile device_profile;
+    TFModbusTCPClientBusScheduler *bus_scheduler             = nullptr;
+    TFModbusTCPClientIdleProbe idle_probe;
+    bool idle_probe_pending                                  = false;
+    bool idle_probe_failed                                   = false;
+    TFModbusTCPClientTransactionObserver transaction_observer;
+    TFModbusTCPClientStatistics statistics;
+    TFModbusTCPClientTransaction *pending_transaction_head   = nullptr;
+    size_t pending_transaction_count                         = 0;
     TFModbusTCPClientTransaction *scheduled_transaction_head = nullptr;
     TFModbusTCPResponse pending_response;
     size_t pending_response_header_used                      = 0;
@@ -141,6 +319,45 @@ public:
         client->transact(unit_id, function_code, start_address, data_count, buffer, timeout, std::move(callback), transaction_id_mask);
     }
 
+    void transact_file_records(uint8_t unit_id,
+                               TFModbusTCPFunctionCode function_code,
+                               TFModbusTCPFileRecord *records,
+                               uint16_t record_count,
+                               micros_t timeout,
+                               TFModbusTCPClientTransactionCallback &&callback,
+                               uint16_t transaction_id_mask = UINT16_MAX)
+    {
+        client->transact_file_records(unit_id, function_code, records, record_count, timeout, std::move(callback), transaction_id_mask);
+    }
+
+    void read_fifo_queue(uint8_t unit_id,
+                         uint16_t fifo_pointer_address,
+                         uint16_t *fifo_values,
+                         uint16_t *fifo_count,
+                         micros_t timeout,
+                         TFModbusTCPClientTransactionCallback &&callback,
+                         uint16_t transaction_id_mask = UINT16_MAX)
+    {
+        client->read_fifo_queue(unit_id, fifo_pointer_address, fifo_values, fifo_count, timeout, std::move(callback), transaction_id_mask);
+    }
+
+    void read_view(uint8_t unit_id,
+                   TFModbusTCPFunctionCode function_code,
+                   uint16_t start_address,
+                   uint16_t data_count,
+                   micros_t timeout,
+                   TFModbusTCPClientReadViewCallback &&callback,
+                   uint16_t transaction_id_mask = UINT16_MAX)
+    {
+        client->read_view(unit_id, function_code, start_address, data_count, timeout, std::move(callback), transaction_id_mask);
+    }
+
+    const TFModbusTCPDeviceProfile *get_device_profile() const { return client->get_device_profile(); }
+
+    size_t get_pending_transaction_count() const { return client->get_pending_transaction_count(); }
+    size_t get_scheduled_transaction_count() const { return client->get_scheduled_transaction_count(); }
+    const TFModbusTCPClientStatistics *get_statistics() const { return client->get_statistics(); }
+
 private:
     TFModbusTCPClient *client;
 };
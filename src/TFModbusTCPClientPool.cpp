@@ -19,8 +19,149 @@
 
 #include "TFModbusTCPClientPool.h"
 
+#include <string.h>
+
 #include "TFModbusTCPClient.h"
 
+struct TFModbusTCPClientPoolDeviceProfile
+{
+    char *host;
+    uint16_t port;
+    TFModbusTCPDeviceProfile profile;
+    TFModbusTCPClientPoolDeviceProfile *next;
+};
+
+struct TFModbusTCPClientPoolIdleProbe
+{
+    char *host;
+    uint16_t port;
+    TFModbusTCPClientIdleProbe probe;
+    TFModbusTCPClientPoolIdleProbe *next;
+};
+
+TFModbusTCPClientPool::~TFModbusTCPClientPool()
+{
+    while (device_profile_head != nullptr) {
+        TFModbusTCPClientPoolDeviceProfile *device_profile = device_profile_head;
+
+        device_profile_head = device_profile->next;
+
+        delete[] device_profile->host;
+        delete device_profile;
+    }
+
+    while (idle_probe_head != nullptr) {
+        TFModbusTCPClientPoolIdleProbe *idle_probe = idle_probe_head;
+
+        idle_probe_head = idle_probe->next;
+
+        delete[] idle_probe->host;
+        delete idle_probe;
+    }
+}
+
+void TFModbusTCPClientPool::set_device_profile(const char *host, uint16_t port, const TFModbusTCPDeviceProfile *profile)
+{
+    TFModbusTCPClientPoolDeviceProfile **device_profile_ptr = &device_profile_head;
+
+    while (*device_profile_ptr != nullptr) {
+        TFModbusTCPClientPoolDeviceProfile *device_profile = *device_profile_ptr;
+
+        if (device_profile->port == port && strcmp(device_profile->host, host) == 0) {
+            if (profile != nullptr) {
+                device_profile->profile = *profile;
+            }
+            else {
+                *device_profile_ptr = device_profile->next;
+
+                delete[] device_profile->host;
+                delete device_profile;
+            }
+
+            return;
+        }
+
+        device_profile_ptr = &device_profile->next;
+    }
+
+    if (profile == nullptr) {
+        return;
+    }
+
+    TFModbusTCPClientPoolDeviceProfile *device_profile = new TFModbusTCPClientPoolDeviceProfile;
+    size_t host_length = strlen(host);
+
+    device_profile->host = new char[host_length + 1];
+    memcpy(device_profile->host, host, host_length + 1);
+    device_profile->port    = port;
+    device_profile->profile = *profile;
+    device_profile->next    = nullptr;
+
+    *device_profile_ptr = device_profile;
+}
+
+const TFModbusTCPDeviceProfile *TFModbusTCPClientPool::get_device_profile(const char *host, uint16_t port) const
+{
+    for (TFModbusTCPClientPoolDeviceProfile *device_profile = device_profile_head; device_profile != nullptr; device_profile = device_profile->next) {
+        if (device_profile->port == port && strcmp(device_profile->host, host) == 0) {
+            return &device_profile->profile;
+        }
+    }
+
+    return nullptr;
+}
+
+void TFModbusTCPClientPool::set_idle_probe(const char *host, uint16_t port, const TFModbusTCPClientIdleProbe *probe)
+{
+    TFModbusTCPClientPoolIdleProbe **idle_probe_ptr = &idle_probe_head;
+
+    while (*idle_probe_ptr != nullptr) {
+        TFModbusTCPClientPoolIdleProbe *idle_probe = *idle_probe_ptr;
+
+        if (idle_probe->port == port && strcmp(idle_probe->host, host) == 0) {
+            if (probe != nullptr) {
+                idle_probe->probe = *probe;
+            }
+            else {
+                *idle_probe_ptr = idle_probe->next;
+
+                delete[] idle_probe->host;
+                delete idle_probe;
+            }
+
+            return;
+        }
+
+        idle_probe_ptr = &idle_probe->next;
+    }
+
+    if (probe == nullptr) {
+        return;
+    }
+
+    TFModbusTCPClientPoolIdleProbe *idle_probe = new TFModbusTCPClientPoolIdleProbe;
+    size_t host_length = strlen(host);
+
+    idle_probe->host = new char[host_length + 1];
+    memcpy(idle_probe->host, host, host_length + 1);
+    idle_probe->port  = port;
+    idle_probe->probe = *probe;
+    idle_probe->next  = nullptr;
+
+    *idle_probe_ptr = idle_probe;
+}
+
+const TFModbusTCPClientIdleProbe *TFModbusTCPClientPool::get_idle_probe(const char *host, uint16_t port) const
+{
+    for (TFModbusTCPClientPoolIdleProbe *idle_probe = idle_probe_head; idle_probe != nullptr; idle_probe = idle_probe->next) {
+        if (idle_probe->port == port && strcmp(idle_probe->host, host) == 0) {
+            return &idle_probe->probe;
+        }
+    }
+
+    return nullptr;
+}
+
 TFGenericTCPClient *TFModbusTCPClientPool::create_client()
 {
     return new TFModbusTCPClient(register_byte_order);
@@ -30,3 +171,17 @@ TFGenericTCPSharedClient *TFModbusTCPClientPool::create_shared_client(TFGenericT
 {
     return new TFModbusTCPSharedClient(static_cast<TFModbusTCPClient *>(client));
 }
+
+void TFModbusTCPClientPool::prepare_client(TFGenericTCPClient *client, const char *host, uint16_t port)
+{
+    const TFModbusTCPDeviceProfile *profile = get_device_profile(host, port);
+    TFModbusTCPDeviceProfile default_profile;
+
+    // Clients are reused for other hosts, always overwrite a previous profile
+    static_cast<TFModbusTCPClient *>(client)->set_device_profile(profile != nullptr ? profile : &default_profile);
+
+    // Overwrite a previous probe for the same reason
+    static_cast<TFModbusTCPClient *>(client)->set_idle_probe(get_idle_probe(host, port));
+
+    static_cast<TFModbusTCPClient *>(client)->set_transaction_observer(TFModbusTCPClientTransactionObserver(transaction_observer));
+}
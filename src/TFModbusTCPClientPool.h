@@ -21,16 +21,41 @@
 
 #include "TFGenericTCPClientPool.h"
 #include "TFModbusTCPCommon.h"
+#include "TFModbusTCPClient.h"
+#include "TFModbusTCPDeviceProfile.h"
+
+struct TFModbusTCPClientPoolDeviceProfile;
+struct TFModbusTCPClientPoolIdleProbe;
 
 class TFModbusTCPClientPool : public TFGenericTCPClientPool
 {
 public:
     TFModbusTCPClientPool(TFModbusTCPByteOrder register_byte_order_) : register_byte_order(register_byte_order_) {}
+    virtual ~TFModbusTCPClientPool();
+
+    // Device profiles are applied to the client of a host and port before each
+    // connect. Pass nullptr as profile to remove a stored profile
+    void set_device_profile(const char *host, uint16_t port, const TFModbusTCPDeviceProfile *profile);
+    const TFModbusTCPDeviceProfile *get_device_profile(const char *host, uint16_t port) const;
+
+    // Idle probes are applied to the client of a host and port before each
+    // connect, clients of other hosts and ports get no idle probe. Pass nullptr
+    // as probe to remove a stored probe. A client disconnected by a failed
+    // probe is released like after any other disconnect
+    void set_idle_probe(const char *host, uint16_t port, const TFModbusTCPClientIdleProbe *probe);
+    const TFModbusTCPClientIdleProbe *get_idle_probe(const char *host, uint16_t port) const;
+
+    // The observer is applied to every client before each connect
+    void set_transaction_observer(TFModbusTCPClientTransactionObserver &&observer) { transaction_observer = std::move(observer); }
 
 protected:
     TFGenericTCPClient *create_client() override;
     TFGenericTCPSharedClient *create_shared_client(TFGenericTCPClient *client) override;
+    void prepare_client(TFGenericTCPClient *client, const char *host, uint16_t port) override;
 
 private:
     TFModbusTCPByteOrder register_byte_order;
+    TFModbusTCPClientPoolDeviceProfile *device_profile_head = nullptr;
+    TFModbusTCPClientPoolIdleProbe *idle_probe_head         = nullptr;
+    TFModbusTCPClientTransactionObserver transaction_observer;
 };
@@ -102,8 +102,17 @@ const char *get_tf_modbus_tcp_function_code_name(TFModbusTCPFunctionCode functio
     case TFModbusTCPFunctionCode::WriteMultipleRegisters:
         return "WriteMultipleRegisters";
 
+    case TFModbusTCPFunctionCode::ReadFileRecord:
+        return "ReadFileRecord";
+
+    case TFModbusTCPFunctionCode::WriteFileRecord:
+        return "WriteFileRecord";
+
     case TFModbusTCPFunctionCode::MaskWriteRegister:
         return "MaskWriteRegister";
+
+    case TFModbusTCPFunctionCode::ReadFIFOQueue:
+        return "ReadFIFOQueue";
     }
 
     return "<Unknown>";
@@ -118,6 +127,9 @@ const char *get_tf_modbus_tcp_exception_code_name(TFModbusTCPExceptionCode excep
     case TFModbusTCPExceptionCode::ForceTimeout:
         return "<ForceTimeout>";
 
+    case TFModbusTCPExceptionCode::Deferred:
+        return "<Deferred>";
+
     case TFModbusTCPExceptionCode::IllegalFunction:
         return "IllegalFunction";
 
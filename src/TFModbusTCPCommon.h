@@ -23,7 +23,7 @@
 
 // specification
 #define TF_MODBUS_TCP_HEADER_LENGTH                       7u
-#define TF_MODBUS_TCP_MIN_REQUEST_FRAME_LENGTH            6u
+#define TF_MODBUS_TCP_MIN_REQUEST_FRAME_LENGTH            4u
 #define TF_MODBUS_TCP_MAX_REQUEST_FRAME_LENGTH            253u
 #define TF_MODBUS_TCP_MIN_RESPONSE_FRAME_LENGTH           3u
 #define TF_MODBUS_TCP_MAX_RESPONSE_FRAME_LENGTH           253u
@@ -45,6 +45,14 @@
 #define TF_MODBUS_TCP_MAX_WRITE_REGISTER_COUNT            123u
 #define TF_MODBUS_TCP_MIN_DATA_BYTE_COUNT                 1u
 #define TF_MODBUS_TCP_MAX_DATA_BYTE_COUNT                 250u
+#define TF_MODBUS_TCP_MIN_FILE_RECORD_BYTE_COUNT          7u
+#define TF_MODBUS_TCP_MAX_FILE_RECORD_BYTE_COUNT          245u
+#define TF_MODBUS_TCP_FILE_RECORD_SUB_REQUEST_LENGTH      7u
+#define TF_MODBUS_TCP_FILE_RECORD_SUB_RESPONSE_LENGTH     2u
+#define TF_MODBUS_TCP_FILE_RECORD_REFERENCE_TYPE          6u
+#define TF_MODBUS_TCP_MIN_FILE_NUMBER                     1u
+#define TF_MODBUS_TCP_MAX_RECORD_NUMBER                   9999u
+#define TF_MODBUS_TCP_MAX_FIFO_COUNT                      31u
 
 enum class TFModbusTCPByteOrder
 {
@@ -64,7 +72,10 @@ enum class TFModbusTCPFunctionCode : uint8_t
     WriteSingleRegister    = 6,
     WriteMultipleCoils     = 15,
     WriteMultipleRegisters = 16,
+    ReadFileRecord         = 20,
+    WriteFileRecord        = 21,
     MaskWriteRegister      = 22,
+    ReadFIFOQueue          = 24,
 };
 
 const char *get_tf_modbus_tcp_function_code_name(TFModbusTCPFunctionCode function_code);
@@ -73,6 +84,7 @@ enum class TFModbusTCPExceptionCode : uint8_t
 {
     Success                            = 0,
     ForceTimeout                       = 255,
+    Deferred                           = 254, // see TFModbusTCPServer::defer_response
 
     IllegalFunction                    = 0x01,
     IllegalDataAddress                 = 0x02,
@@ -87,6 +99,16 @@ enum class TFModbusTCPExceptionCode : uint8_t
 
 const char *get_tf_modbus_tcp_exception_code_name(TFModbusTCPExceptionCode exception_code);
 
+// A file record is a sequence of registers. The record data is passed as bytes
+// in network byte order, because it is typically a blob, not a set of values
+struct TFModbusTCPFileRecord
+{
+    uint16_t file_number;
+    uint16_t record_number;
+    uint16_t record_length; // in registers
+    uint8_t *record_data;   // record_length * 2 bytes
+};
+
 #if defined(__GNUC__)
     #pragma GCC diagnostic push
     #pragma GCC diagnostic ignored "-Wattributes"
@@ -107,40 +129,51 @@ union TFModbusTCPRequestPayload
 {
     struct [[gnu::packed]] {
         uint8_t function_code;
-        uint16_t start_address;          // Read Coils (1),
-                                         // Read Discrete Inputs (2),
-                                         // Read Holding Registers (3),
-                                         // Read Input Registers(4),
-                                         // Write Single Coil (5),
-                                         // Write Single Register (6),
-                                         // Write Multiple Coils (15),
-                                         // Write Multiple Registers (16)
-                                         // Mask Write Register (22)
         union {
             struct [[gnu::packed]] {
+                uint16_t start_address;          // Read Coils (1),
+                                                 // Read Discrete Inputs (2),
+                                                 // Read Holding Registers (3),
+                                                 // Read Input Registers(4),
+                                                 // Write Single Coil (5),
+                                                 // Write Single Register (6),
+                                                 // Write Multiple Coils (15),
+                                                 // Write Multiple Registers (16)
+                                                 // Mask Write Register (22)
+                                                 // Read FIFO Queue (24) as FIFO pointer address
                 union {
-                    uint16_t data_count; // Read Coils (1),
-                                         // Read Discrete Inputs (2),
-                                         // Read Holding Registers (3),
-                                         // Read Input Registers (4),
-                                         // Write Multiple Coils (15),
-                                         // Write Multiple registers (16)
-                    uint16_t data_value; // Write Single Coil (5),
-                                         // Write Single Register (6)
-                };
-                struct [[gnu::packed]] {
-                    uint8_t byte_count;  // Write Multiple Coils (15),
-                                         // Write Multiple Registers (16)
-                    union {
-                        uint8_t coil_values[TF_MODBUS_TCP_MAX_WRITE_COIL_BYTE_COUNT];     // Write Multiple Coils (15),
-                        uint16_t register_values[TF_MODBUS_TCP_MAX_WRITE_REGISTER_COUNT]; // Write Multiple Registers (16)
+                    struct [[gnu::packed]] {
+                        union {
+                            uint16_t data_count; // Read Coils (1),
+                                                 // Read Discrete Inputs (2),
+                                                 // Read Holding Registers (3),
+                                                 // Read Input Registers (4),
+                                                 // Write Multiple Coils (15),
+                                                 // Write Multiple registers (16)
+                            uint16_t data_value; // Write Single Coil (5),
+                                                 // Write Single Register (6)
+                        };
+                        struct [[gnu::packed]] {
+                            uint8_t byte_count;  // Write Multiple Coils (15),
+                                                 // Write Multiple Registers (16)
+                            union {
+                                uint8_t coil_values[TF_MODBUS_TCP_MAX_WRITE_COIL_BYTE_COUNT];     // Write Multiple Coils (15),
+                                uint16_t register_values[TF_MODBUS_TCP_MAX_WRITE_REGISTER_COUNT]; // Write Multiple Registers (16)
+                            };
+                        };
+                    };
+                    struct [[gnu::packed]] {
+                        uint16_t and_mask;       // Mask Write Register (22)
+                        uint16_t or_mask;        // Mask Write Register (22)
+                        uint8_t sentinel;        // Not part of the actual protocol, there for offsetof() calculations
                     };
                 };
             };
             struct [[gnu::packed]] {
-                uint16_t and_mask;       // Mask Write Register (22)
-                uint16_t or_mask;        // Mask Write Register (22)
-                uint8_t sentinel;        // Not part of the actual protocol, there for offsetof() calculations
+                uint8_t file_byte_count;         // Read File Record (20),
+                                                 // Write File Record (21)
+                uint8_t file_bytes[TF_MODBUS_TCP_MAX_FILE_RECORD_BYTE_COUNT]; // Read File Record (20),
+                                                                               // Write File Record (21)
             };
         };
     };
@@ -167,13 +200,17 @@ union TFModbusTCPResponsePayload
                     uint8_t byte_count;  // Read Coils (1),
                                          // Read Discrete Inputs (2),
                                          // Read Holding Registers (3),
-                                         // Read Input Registers (4)
+                                         // Read Input Registers (4),
+                                         // Read File Record (20),
+                                         // Write File Record (21)
                 };
                 union {
                     uint8_t coil_values[TF_MODBUS_TCP_MAX_READ_COIL_BYTE_COUNT];     // Read Coils (1),
                                                                                      // Read Discrete Inputs (2)
                     uint16_t register_values[TF_MODBUS_TCP_MAX_READ_REGISTER_COUNT]; // Read Holding Registers (3),
                                                                                      // Read Input Registers (4)
+                    uint8_t file_bytes[TF_MODBUS_TCP_MAX_FILE_RECORD_BYTE_COUNT];    // Read File Record (20),
+                                                                                     // Write File Record (21)
                     uint8_t exception_sentinel;                                      // Not part of the actual protocol, there for offsetof() calculations
                 };
             };
@@ -192,6 +229,11 @@ union TFModbusTCPResponsePayload
                 uint16_t or_mask;        // Mask Write Register (22)
                 uint8_t sentinel;        // Not part of the actual protocol, there for offsetof() calculations
             };
+            struct [[gnu::packed]] {
+                uint16_t fifo_byte_count; // Read FIFO Queue (24)
+                uint16_t fifo_count;      // Read FIFO Queue (24)
+                uint16_t fifo_values[TF_MODBUS_TCP_MAX_FIFO_COUNT]; // Read FIFO Queue (24)
+            };
         };
     };
     uint8_t bytes[TF_MODBUS_TCP_MAX_RESPONSE_PAYLOAD_LENGTH];
@@ -0,0 +1,260 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include "TFModbusTCPDeviceProber.h"
+
+#include "TFNetwork.h"
+
+#define debugfln(fmt, ...) tf_network_debugfln("TFModbusTCPDeviceProber[%p]::" fmt, static_cast<void *>(this) __VA_OPT__(,) __VA_ARGS__)
+
+const char *get_tf_modbus_tcp_device_prober_step_name(TFModbusTCPDeviceProberStep step)
+{
+    switch (step) {
+    case TFModbusTCPDeviceProberStep::Idle:
+        return "Idle";
+
+    case TFModbusTCPDeviceProberStep::TransactionIDMask:
+        return "TransactionIDMask";
+
+    case TFModbusTCPDeviceProberStep::MaxReadRegisterCount:
+        return "MaxReadRegisterCount";
+
+    case TFModbusTCPDeviceProberStep::PipelineDepth:
+        return "PipelineDepth";
+    }
+
+    return "<Unknown>";
+}
+
+// A device signals a too large read by an exception or by not answering at all
+static bool is_read_rejected(TFModbusTCPClientTransactionResult result)
+{
+    return result == TFModbusTCPClientTransactionResult::Timeout
+        || (result > TFModbusTCPClientTransactionResult::Success && result <= TFModbusTCPClientTransactionResult::ModbusGatewayTargetDeviceFailedToRespond);
+}
+
+void TFModbusTCPDeviceProber::probe(TFModbusTCPClient *client_,
+                                    uint8_t unit_id_,
+                                    TFModbusTCPFunctionCode function_code_,
+                                    uint16_t start_address_,
+                                    micros_t timeout_,
+                                    TFModbusTCPDeviceProberCallback &&callback_)
+{
+    if (!callback_) {
+        return;
+    }
+
+    if (client_ == nullptr) {
+        callback_(TFModbusTCPClientTransactionResult::InvalidArgument, nullptr);
+        return;
+    }
+
+    if (function_code_ != TFModbusTCPFunctionCode::ReadHoldingRegisters && function_code_ != TFModbusTCPFunctionCode::ReadInputRegisters) {
+        callback_(TFModbusTCPClientTransactionResult::InvalidArgument, nullptr);
+        return;
+    }
+
+    if (is_probing()) {
+        callback_(TFModbusTCPClientTransactionResult::NoTransactionAvailable, nullptr);
+        return;
+    }
+
+    client        = client_;
+    callback      = std::move(callback_);
+    unit_id       = unit_id_;
+    function_code = function_code_;
+    start_address = start_address_;
+    timeout       = timeout_;
+    latency_sum   = 0_s;
+    latency_count = 0;
+
+    original_profile = *client->get_device_profile();
+    profile          = original_profile;
+
+    // Start from the most conservative settings that only use the transaction
+    // ID mask to be probed
+    profile.max_read_register_count       = TF_MODBUS_TCP_MIN_READ_REGISTER_COUNT;
+    profile.max_pending_transaction_count = 1;
+    profile.transaction_id_mask           = UINT16_MAX;
+    profile.typical_response_latency      = 0_s;
+
+    step = TFModbusTCPDeviceProberStep::TransactionIDMask;
+
+    probe_transaction_id_mask();
+}
+
+void TFModbusTCPDeviceProber::read(uint16_t data_count, uint16_t *buffer, TFModbusTCPClientTransactionCallback &&read_callback)
+{
+    micros_t since = now_us();
+
+    client->transact(unit_id, function_code, start_address, data_count, buffer, timeout,
+    [this, since, read_callback](TFModbusTCPClientTransactionResult result, const char *error_message) {
+        if (result == TFModbusTCPClientTransactionResult::Success && pipeline_pending_count == 0) {
+            latency_sum += now_us() - since;
+            ++latency_count;
+        }
+
+        read_callback(result, error_message);
+    });
+}
+
+void TFModbusTCPDeviceProber::probe_transaction_id_mask()
+{
+    client->set_device_profile(&profile);
+
+    debugfln("probe_transaction_id_mask() trying 0x%04x", profile.transaction_id_mask);
+
+    pipeline_pending_count = 0;
+
+    read(1, register_values, [this](TFModbusTCPClientTransactionResult result, const char *error_message) {
+        (void)error_message;
+
+        if (result == TFModbusTCPClientTransactionResult::Success) {
+            lower_register_count = 1;
+            upper_register_count = std::min<uint32_t>(TF_MODBUS_TCP_MAX_READ_REGISTER_COUNT, 65536u - start_address);
+            step                 = TFModbusTCPDeviceProberStep::MaxReadRegisterCount;
+
+            probe_max_read_register_count();
+            return;
+        }
+
+        // A device that doesn't echo the transaction ID correctly produces
+        // responses that don't match any pending transaction
+        if (result == TFModbusTCPClientTransactionResult::Timeout && profile.transaction_id_mask != 0) {
+            profile.transaction_id_mask = profile.transaction_id_mask == UINT16_MAX ? 0x00FF : 0;
+
+            probe_transaction_id_mask();
+            return;
+        }
+
+        finish(result);
+    });
+}
+
+void TFModbusTCPDeviceProber::probe_max_read_register_count()
+{
+    if (lower_register_count >= upper_register_count) {
+        profile.max_read_register_count = lower_register_count;
+        pipeline_depth                  = TF_MODBUS_TCP_DEVICE_PROBER_MAX_PIPELINE_DEPTH;
+        step                            = TFModbusTCPDeviceProberStep::PipelineDepth;
+
+        probe_pipeline_depth();
+        return;
+    }
+
+    // Try the upper bound first, most devices support the full protocol maximum
+    uint16_t data_count;
+
+    if (upper_register_count == TF_MODBUS_TCP_MAX_READ_REGISTER_COUNT && lower_register_count == 1) {
+        data_count = upper_register_count;
+    }
+    else {
+        data_count = static_cast<uint16_t>((lower_register_count + upper_register_count + 1) / 2);
+    }
+
+    debugfln("probe_max_read_register_count() trying %u (lower=%u upper=%u)", data_count, lower_register_count, upper_register_count);
+
+    pipeline_pending_count = 0;
+
+    read(data_count, register_values, [this, data_count](TFModbusTCPClientTransactionResult result, const char *error_message) {
+        (void)error_message;
+
+        if (result == TFModbusTCPClientTransactionResult::Success) {
+            lower_register_count = data_count;
+        }
+        else if (is_read_rejected(result)) {
+            upper_register_count = data_count - 1;
+        }
+        else {
+            finish(result);
+            return;
+        }
+
+        probe_max_read_register_count();
+    });
+}
+
+void TFModbusTCPDeviceProber::probe_pipeline_depth()
+{
+    if (pipeline_depth <= 1) {
+        profile.max_pending_transaction_count = 1;
+
+        finish(TFModbusTCPClientTransactionResult::Success);
+        return;
+    }
+
+    debugfln("probe_pipeline_depth() trying %u", pipeline_depth);
+
+    profile.max_pending_transaction_count = pipeline_depth;
+    client->set_device_profile(&profile);
+
+    pipeline_pending_count = pipeline_depth;
+    pipeline_failed        = false;
+
+    for (uint8_t i = 0; i < pipeline_depth; ++i) {
+        read(1, &register_values[i], [this](TFModbusTCPClientTransactionResult result, const char *error_message) {
+            (void)error_message;
+
+            if (result != TFModbusTCPClientTransactionResult::Success) {
+                pipeline_failed = true;
+            }
+
+            if (--pipeline_pending_count > 0) {
+                return;
+            }
+
+            if (!pipeline_failed) {
+                finish(TFModbusTCPClientTransactionResult::Success);
+                return;
+            }
+
+            if (client->get_connection_status() != TFGenericTCPClientConnectionStatus::Connected) {
+                finish(TFModbusTCPClientTransactionResult::NotConnected);
+                return;
+            }
+
+            pipeline_depth /= 2;
+
+            probe_pipeline_depth();
+        });
+    }
+}
+
+void TFModbusTCPDeviceProber::finish(TFModbusTCPClientTransactionResult result)
+{
+    debugfln("finish(result=%s) in step %s", get_tf_modbus_tcp_client_transaction_result_name(result), get_tf_modbus_tcp_device_prober_step_name(step));
+
+    TFModbusTCPDeviceProberCallback finish_callback = std::move(callback);
+    callback = nullptr;
+    step     = TFModbusTCPDeviceProberStep::Idle;
+
+    if (result != TFModbusTCPClientTransactionResult::Success) {
+        client->set_device_profile(&original_profile);
+        finish_callback(result, nullptr);
+        return;
+    }
+
+    if (latency_count > 0) {
+        profile.typical_response_latency = micros_t{latency_sum.as<int64_t>() / static_cast<int64_t>(latency_count)};
+    }
+
+    client->set_device_profile(&profile);
+    finish_callback(result, &profile);
+}
@@ -0,0 +1,97 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <TFTools/Micros.h>
+
+#include "TFModbusTCPClient.h"
+#include "TFModbusTCPDeviceProfile.h"
+
+#define TF_MODBUS_TCP_DEVICE_PROBER_MAX_PIPELINE_DEPTH 4
+
+enum class TFModbusTCPDeviceProberStep
+{
+    Idle,
+    TransactionIDMask,
+    MaxReadRegisterCount,
+    PipelineDepth,
+};
+
+const char *get_tf_modbus_tcp_device_prober_step_name(TFModbusTCPDeviceProberStep step);
+
+// profile is only valid during the callback and only set on success
+typedef std::function<void(TFModbusTCPClientTransactionResult result, const TFModbusTCPDeviceProfile *profile)> TFModbusTCPDeviceProberCallback;
+
+// Determines the device profile by reading from a register range that is known
+// to be readable, starting at start_address. The following is probed in order:
+//
+// - the transaction ID mask: full, low byte only, none
+// - the maximum register count per read: 125 first, then binary search
+// - the pipeline depth: 4, 2, then 1 concurrent reads
+// - the typical response latency: average over all successful single reads
+//
+// The maximum register count per write is not probed, because this would
+// require writing to the device. It is kept as it was. On success the profile
+// is applied to the client. Persist it with TFModbusTCPDeviceProfile::serialize
+// and load it on startup to skip probing on the next start.
+class TFModbusTCPDeviceProber final
+{
+public:
+    TFModbusTCPDeviceProber() {}
+
+    TFModbusTCPDeviceProber(TFModbusTCPDeviceProber const &other) = delete;
+    TFModbusTCPDeviceProber &operator=(TFModbusTCPDeviceProber const &other) = delete;
+
+    void probe(TFModbusTCPClient *client,
+               uint8_t unit_id,
+               TFModbusTCPFunctionCode function_code,
+               uint16_t start_address,
+               micros_t timeout,
+               TFModbusTCPDeviceProberCallback &&callback);
+    bool is_probing() const { return step != TFModbusTCPDeviceProberStep::Idle; }
+    TFModbusTCPDeviceProberStep get_step() const { return step; }
+
+private:
+    void start(TFModbusTCPClient *client);
+    void read(uint16_t data_count, uint16_t *buffer, TFModbusTCPClientTransactionCallback &&callback);
+    void probe_transaction_id_mask();
+    void probe_max_read_register_count();
+    void probe_pipeline_depth();
+    void finish(TFModbusTCPClientTransactionResult result);
+
+    TFModbusTCPClient *client = nullptr;
+    TFModbusTCPDeviceProberStep step = TFModbusTCPDeviceProberStep::Idle;
+    TFModbusTCPDeviceProberCallback callback;
+    uint8_t unit_id;
+    TFModbusTCPFunctionCode function_code;
+    uint16_t start_address;
+    micros_t timeout;
+    TFModbusTCPDeviceProfile original_profile;
+    TFModbusTCPDeviceProfile profile;
+    uint16_t lower_register_count; // known to work
+    uint16_t upper_register_count; // not known to fail
+    uint8_t pipeline_depth;
+    uint8_t pipeline_pending_count;
+    bool pipeline_failed;
+    micros_t latency_sum;
+    size_t latency_count;
+    uint16_t register_values[TF_MODBUS_TCP_MAX_READ_REGISTER_COUNT];
+};
@@ -0,0 +1,92 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include "TFModbusTCPDeviceProfile.h"
+
+#define TF_MODBUS_TCP_DEVICE_PROFILE_VERSION 1
+
+// CRC-8 with polynomial 0x07
+static uint8_t crc8(const uint8_t *buffer, size_t length)
+{
+    uint8_t checksum = 0;
+
+    for (size_t i = 0; i < length; ++i) {
+        checksum ^= buffer[i];
+
+        for (size_t k = 0; k < 8; ++k) {
+            checksum = (checksum & 0x80) != 0 ? static_cast<uint8_t>((checksum << 1) ^ 0x07) : static_cast<uint8_t>(checksum << 1);
+        }
+    }
+
+    return checksum;
+}
+
+size_t TFModbusTCPDeviceProfile::serialize(uint8_t *buffer, size_t length) const
+{
+    if (length < TF_MODBUS_TCP_DEVICE_PROFILE_SERIALIZED_LENGTH) {
+        return 0;
+    }
+
+    int64_t latency_us = typical_response_latency.as<int64_t>();
+
+    if (latency_us < 0) {
+        latency_us = 0;
+    }
+    else if (latency_us > UINT32_MAX) {
+        latency_us = UINT32_MAX;
+    }
+
+    buffer[0]  = TF_MODBUS_TCP_DEVICE_PROFILE_VERSION;
+    buffer[1]  = static_cast<uint8_t>(max_read_register_count);
+    buffer[2]  = static_cast<uint8_t>(max_write_register_count);
+    buffer[3]  = max_pending_transaction_count;
+    buffer[4]  = static_cast<uint8_t>(transaction_id_mask >> 8);
+    buffer[5]  = static_cast<uint8_t>(transaction_id_mask & 0xFF);
+    buffer[6]  = static_cast<uint8_t>((latency_us >> 24) & 0xFF);
+    buffer[7]  = static_cast<uint8_t>((latency_us >> 16) & 0xFF);
+    buffer[8]  = static_cast<uint8_t>((latency_us >>  8) & 0xFF);
+    buffer[9]  = static_cast<uint8_t>((latency_us >>  0) & 0xFF);
+    buffer[10] = crc8(buffer, 10);
+
+    return TF_MODBUS_TCP_DEVICE_PROFILE_SERIALIZED_LENGTH;
+}
+
+bool TFModbusTCPDeviceProfile::deserialize(const uint8_t *buffer, size_t length)
+{
+    if (length < TF_MODBUS_TCP_DEVICE_PROFILE_SERIALIZED_LENGTH
+     || buffer[0] != TF_MODBUS_TCP_DEVICE_PROFILE_VERSION
+     || buffer[10] != crc8(buffer, 10)
+     || buffer[1] < TF_MODBUS_TCP_MIN_READ_REGISTER_COUNT || buffer[1] > TF_MODBUS_TCP_MAX_READ_REGISTER_COUNT
+     || buffer[2] < TF_MODBUS_TCP_MIN_WRITE_REGISTER_COUNT || buffer[2] > TF_MODBUS_TCP_MAX_WRITE_REGISTER_COUNT
+     || buffer[3] < 1) {
+        return false;
+    }
+
+    max_read_register_count       = buffer[1];
+    max_write_register_count      = buffer[2];
+    max_pending_transaction_count = buffer[3];
+    transaction_id_mask           = static_cast<uint16_t>((buffer[4] << 8) | buffer[5]);
+    typical_response_latency      = micros_t{static_cast<int64_t>((static_cast<uint32_t>(buffer[6]) << 24) |
+                                                                  (static_cast<uint32_t>(buffer[7]) << 16) |
+                                                                  (static_cast<uint32_t>(buffer[8]) <<  8) |
+                                                                  (static_cast<uint32_t>(buffer[9]) <<  0))};
+
+    return true;
+}
@@ -0,0 +1,43 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <TFTools/Micros.h>
+
+#include "TFModbusTCPCommon.h"
+
+#define TF_MODBUS_TCP_DEVICE_PROFILE_SERIALIZED_LENGTH 11u
+
+struct TFModbusTCPDeviceProfile
+{
+    uint16_t max_read_register_count      = TF_MODBUS_TCP_MAX_READ_REGISTER_COUNT;
+    uint16_t max_write_register_count     = TF_MODBUS_TCP_MAX_WRITE_REGISTER_COUNT;
+    uint8_t max_pending_transaction_count = 1; // 1 means no pipelining
+    uint16_t transaction_id_mask          = UINT16_MAX;
+    micros_t typical_response_latency     = 0_s; // 0 means unknown
+
+    // Compact binary form for persisting a probed profile, returns the used
+    // length or 0 if the buffer is too short
+    size_t serialize(uint8_t *buffer, size_t length) const;
+    bool deserialize(const uint8_t *buffer, size_t length);
+};
@@ -0,0 +1,250 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include "TFModbusTCPDiagnostics.h"
+
+#include <string.h>
+
+#include "TFNetwork.h"
+
+#define debugfln(fmt, ...) tf_network_debugfln("TFModbusTCPDiagnostics[%p]::" fmt, static_cast<void *>(this) __VA_OPT__(,) __VA_ARGS__)
+
+// high word first, truncated to 32 bit
+static uint16_t get_word(uint64_t value, uint16_t index)
+{
+    return static_cast<uint16_t>(index == 0 ? (value >> 16) & 0xFFFF : value & 0xFFFF);
+}
+
+size_t TFModbusTCPDiagnostics::get_device_count() const
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < source_count; ++i) {
+        count += sources[i].pool ? TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT : 1;
+    }
+
+    return count;
+}
+
+TFModbusTCPExceptionCode TFModbusTCPDiagnostics::read(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, void *data_values)
+{
+    if (data_type != TFModbusTCPDataType::InputRegister) {
+        return TFModbusTCPExceptionCode::IllegalDataAddress;
+    }
+
+    if (static_cast<uint32_t>(start_address) + data_count > get_register_count()) {
+        return TFModbusTCPExceptionCode::IllegalDataAddress;
+    }
+
+    // the values can be part of a packed response, store them byte-wise
+    uint8_t *register_values = static_cast<uint8_t *>(data_values);
+
+    // the device block is looked up once per request and only changes when
+    // the request crosses a block boundary
+    const TFModbusTCPClient *client = nullptr;
+    size_t client_device_index      = SIZE_MAX;
+
+    for (uint16_t i = 0; i < data_count; ++i) {
+        uint16_t address = start_address + i;
+
+        uint16_t register_value;
+
+        if (address < TF_MODBUS_TCP_DIAGNOSTICS_SERVER_REGISTER_COUNT) {
+            register_value = get_server_register(address);
+            memcpy(register_values + i * sizeof(register_value), &register_value, sizeof(register_value));
+            continue;
+        }
+
+        size_t device_index = (address - TF_MODBUS_TCP_DIAGNOSTICS_SERVER_REGISTER_COUNT) / TF_MODBUS_TCP_DIAGNOSTICS_DEVICE_REGISTER_COUNT;
+        uint16_t offset     = (address - TF_MODBUS_TCP_DIAGNOSTICS_SERVER_REGISTER_COUNT) % TF_MODBUS_TCP_DIAGNOSTICS_DEVICE_REGISTER_COUNT;
+
+        if (device_index != client_device_index) {
+            client              = get_device_client(device_index);
+            client_device_index = device_index;
+        }
+
+        register_value = get_device_register(client, offset);
+        memcpy(register_values + i * sizeof(register_value), &register_value, sizeof(register_value));
+    }
+
+    return TFModbusTCPExceptionCode::Success;
+}
+
+TFModbusTCPExceptionCode TFModbusTCPDiagnostics::write(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, const void *data_values)
+{
+    (void)data_type;
+    (void)start_address;
+    (void)data_count;
+    (void)data_values;
+
+    return TFModbusTCPExceptionCode::IllegalFunction;
+}
+
+bool TFModbusTCPDiagnostics::add_source(const void *object, bool pool)
+{
+    if (object == nullptr) {
+        debugfln("add_source(pool=%d) invalid argument", pool ? 1 : 0);
+        return false;
+    }
+
+    if (source_count >= TF_MODBUS_TCP_DIAGNOSTICS_MAX_SOURCE_COUNT
+     || get_device_count() + (pool ? TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT : 1) > TF_MODBUS_TCP_DIAGNOSTICS_MAX_DEVICE_COUNT) {
+        debugfln("add_source(pool=%d) too many sources", pool ? 1 : 0);
+        return false;
+    }
+
+    sources[source_count].object = object;
+    sources[source_count].pool   = pool;
+
+    ++source_count;
+
+    return true;
+}
+
+const TFModbusTCPClient *TFModbusTCPDiagnostics::get_device_client(size_t device_index) const
+{
+    for (size_t i = 0; i < source_count; ++i) {
+        if (!sources[i].pool) {
+            if (device_index == 0) {
+                return static_cast<const TFModbusTCPClient *>(sources[i].object);
+            }
+
+            --device_index;
+        }
+        else {
+            if (device_index < TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT) {
+                // the pool only creates TFModbusTCPClient instances
+                return static_cast<const TFModbusTCPClient *>(static_cast<const TFModbusTCPClientPool *>(sources[i].object)->get_slot_client(device_index));
+            }
+
+            device_index -= TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT;
+        }
+    }
+
+    return nullptr;
+}
+
+uint16_t TFModbusTCPDiagnostics::get_server_register(uint16_t offset) const
+{
+    switch (offset) {
+    case 0:
+        return TF_MODBUS_TCP_DIAGNOSTICS_LAYOUT_VERSION;
+
+    case 1:
+        return static_cast<uint16_t>(get_device_count());
+
+    case 2:
+        return server != nullptr ? static_cast<uint16_t>(server->get_client_count()) : 0;
+
+    default:
+        break;
+    }
+
+    if (server == nullptr || offset < 4 || offset >= 18) {
+        return 0;
+    }
+
+    const TFModbusTCPServerStatistics *statistics = server->get_statistics();
+    const uint64_t counters[]                     = {
+        statistics->accepted_connection_count,
+        statistics->rejected_connection_count,
+        statistics->disconnected_connection_count,
+        statistics->response_count,
+        statistics->exception_response_count,
+        statistics->deferred_response_count,
+        statistics->unanswered_request_count,
+    };
+
+    return get_word(counters[(offset - 4) / 2], offset % 2);
+}
+
+uint16_t TFModbusTCPDiagnostics::get_device_register(const TFModbusTCPClient *client, uint16_t offset) const
+{
+    if (client == nullptr) {
+        return 0;
+    }
+
+    switch (offset) {
+    case 0:
+        return static_cast<uint16_t>(client->get_connection_status()) + 1;
+
+    case 1:
+        return client->get_port();
+
+    case 2:
+        return static_cast<uint16_t>(client->get_pending_transaction_count());
+
+    case 3:
+        return static_cast<uint16_t>(client->get_scheduled_transaction_count());
+
+    default:
+        break;
+    }
+
+    if (offset >= 20) {
+        return 0;
+    }
+
+    const TFModbusTCPClientStatistics *statistics = client->get_statistics();
+    uint64_t value;
+
+    switch (offset) {
+    case 4:
+    case 5:
+        value = statistics->success_count;
+        break;
+
+    case 6:
+    case 7:
+        value = statistics->exception_count;
+        break;
+
+    case 8:
+    case 9:
+        value = statistics->timeout_count;
+        break;
+
+    case 10:
+    case 11:
+        value = statistics->failure_count;
+        break;
+
+    case 12:
+    case 13:
+        value = statistics->latency.get_percentile_us(50);
+        break;
+
+    case 14:
+    case 15:
+        value = statistics->latency.get_percentile_us(90);
+        break;
+
+    case 16:
+    case 17:
+        value = statistics->latency.get_percentile_us(99);
+        break;
+
+    default: // mean latency
+        value = statistics->latency.count > 0 ? statistics->latency.sum_us / statistics->latency.count : 0;
+        break;
+    }
+
+    return get_word(value, offset % 2);
+}
@@ -0,0 +1,112 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "TFModbusTCPCommon.h"
+#include "TFModbusTCPServer.h"
+#include "TFModbusTCPClient.h"
+#include "TFModbusTCPClientPool.h"
+#include "TFModbusTCPRegisterBank.h"
+
+// configuration
+#ifndef TF_MODBUS_TCP_DIAGNOSTICS_MAX_SOURCE_COUNT
+#define TF_MODBUS_TCP_DIAGNOSTICS_MAX_SOURCE_COUNT 8
+#endif
+
+#define TF_MODBUS_TCP_DIAGNOSTICS_LAYOUT_VERSION         1
+#define TF_MODBUS_TCP_DIAGNOSTICS_SERVER_REGISTER_COUNT  32
+#define TF_MODBUS_TCP_DIAGNOSTICS_DEVICE_REGISTER_COUNT  32
+#define TF_MODBUS_TCP_DIAGNOSTICS_MAX_DEVICE_COUNT       ((65536 - TF_MODBUS_TCP_DIAGNOSTICS_SERVER_REGISTER_COUNT) / TF_MODBUS_TCP_DIAGNOSTICS_DEVICE_REGISTER_COUNT)
+
+struct TFModbusTCPDiagnosticsSource
+{
+    const void *object;
+    bool pool;
+};
+
+// Read-only register bank that maps the live statistics of a server and of
+// the downstream clients and pools to input registers, for SCADA systems that
+// can only read Modbus. Each read evaluates the statistics at that moment,
+// nothing is copied in between. Serve it with set_diagnostics_unit() of the
+// server. 32 bit values are two registers, high word first, and wrap around.
+// Both words of a 32 bit value have to be read in the same request, otherwise
+// they can come from different states of the statistics, e.g. around a carry
+// into the high word.
+//
+// Server block, starting at address 0:
+//
+//    0      layout version
+//    1      device count
+//    2      connected server clients
+//    4-5    accepted connections
+//    6-7    rejected connections
+//    8-9    disconnected connections
+//   10-11   responses
+//   12-13   exception responses
+//   14-15   deferred responses
+//   16-17   unanswered requests
+//
+// Followed by one block per device, starting at address 32 + index * 32. A
+// client is one device, a pool is TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT
+// devices, one per slot, so that device indices stay stable:
+//
+//    0      status: 0 = unused slot, 1 = disconnected, 2 = connecting, 3 = connected
+//    1      port
+//    2      pending transactions
+//    3      scheduled transactions
+//    4-5    successful transactions
+//    6-7    exception responses
+//    8-9    timeouts
+//   10-11   other failures
+//   12-13   latency 50th percentile in microseconds
+//   14-15   latency 90th percentile in microseconds
+//   16-17   latency 99th percentile in microseconds
+//   18-19   mean latency in microseconds
+//
+// Percentiles are upper bucket bounds of the latency histogram, 0xFFFFFFFF if
+// above the largest bound. Unlisted registers read as 0
+class TFModbusTCPDiagnostics final : public TFModbusTCPRegisterBank
+{
+public:
+    TFModbusTCPDiagnostics(const TFModbusTCPServer *server_) : server(server_) {}
+
+    bool add_client(const TFModbusTCPClient *client) { return add_source(client, false); }
+    bool add_pool(const TFModbusTCPClientPool *pool) { return add_source(pool, true); }
+
+    size_t get_device_count() const;
+    uint32_t get_register_count() const { return TF_MODBUS_TCP_DIAGNOSTICS_SERVER_REGISTER_COUNT + static_cast<uint32_t>(get_device_count()) * TF_MODBUS_TCP_DIAGNOSTICS_DEVICE_REGISTER_COUNT; }
+
+    TFModbusTCPExceptionCode read(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, void *data_values) override;
+    TFModbusTCPExceptionCode write(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, const void *data_values) override;
+
+private:
+    bool add_source(const void *object, bool pool);
+    const TFModbusTCPClient *get_device_client(size_t device_index) const;
+    uint16_t get_server_register(uint16_t offset) const;
+    uint16_t get_device_register(const TFModbusTCPClient *client, uint16_t offset) const;
+
+    const TFModbusTCPServer *server;
+    TFModbusTCPDiagnosticsSource sources[TF_MODBUS_TCP_DIAGNOSTICS_MAX_SOURCE_COUNT];
+    size_t source_count = 0;
+};
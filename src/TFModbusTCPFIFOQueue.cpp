@@ -0,0 +1,68 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include "TFModbusTCPFIFOQueue.h"
+
+bool TFModbusTCPFIFOQueue::push(uint16_t value)
+{
+    size_t current_head = head.load(std::memory_order_relaxed);
+    size_t next_head    = current_head + 1 < storage_length ? current_head + 1 : 0;
+
+    if (next_head == tail.load(std::memory_order_acquire)) {
+        dropped_count.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    storage[current_head] = value;
+    head.store(next_head, std::memory_order_release);
+
+    return true;
+}
+
+uint16_t TFModbusTCPFIFOQueue::pop(uint16_t *values, uint16_t max_count)
+{
+    size_t current_tail = tail.load(std::memory_order_relaxed);
+    size_t current_head = head.load(std::memory_order_acquire);
+    uint16_t count      = 0;
+
+    while (count < max_count && current_tail != current_head) {
+        values[count++] = storage[current_tail];
+        current_tail    = current_tail + 1 < storage_length ? current_tail + 1 : 0;
+    }
+
+    tail.store(current_tail, std::memory_order_release);
+
+    return count;
+}
+
+size_t TFModbusTCPFIFOQueue::get_count() const
+{
+    size_t current_head = head.load(std::memory_order_acquire);
+    size_t current_tail = tail.load(std::memory_order_acquire);
+
+    return current_head >= current_tail ? current_head - current_tail : storage_length - current_tail + current_head;
+}
+
+TFModbusTCPExceptionCode TFModbusTCPFIFOQueue::handle(uint16_t *fifo_values, uint16_t *fifo_count)
+{
+    *fifo_count = pop(fifo_values, TF_MODBUS_TCP_MAX_FIFO_COUNT);
+
+    return TFModbusTCPExceptionCode::Success;
+}
@@ -0,0 +1,57 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#include "TFModbusTCPCommon.h"
+
+// Lock-free single-producer single-consumer ring buffer for serving Read FIFO
+// Queue (24) requests. The producer can push from another task or an interrupt,
+// while the server drains up to TF_MODBUS_TCP_MAX_FIFO_COUNT values per request
+// by calling handle() from its FIFO queue callback. Values are passed through
+// unchanged, push them in the register byte order of the server. A drained value
+// is gone, even if the response is lost on its way to the client
+class TFModbusTCPFIFOQueue final
+{
+public:
+    // One slot of the storage stays unused to tell a full from an empty queue
+    TFModbusTCPFIFOQueue(uint16_t *storage_, size_t storage_length_) : storage(storage_), storage_length(storage_length_) {}
+
+    TFModbusTCPFIFOQueue(TFModbusTCPFIFOQueue const &other) = delete;
+    TFModbusTCPFIFOQueue &operator=(TFModbusTCPFIFOQueue const &other) = delete;
+
+    bool push(uint16_t value); // producer only, false if full
+    uint16_t pop(uint16_t *values, uint16_t max_count); // consumer only, returns the popped count
+    size_t get_count() const;
+    size_t get_dropped_count() const { return dropped_count.load(std::memory_order_relaxed); }
+
+    TFModbusTCPExceptionCode handle(uint16_t *fifo_values, uint16_t *fifo_count); // consumer only
+
+private:
+    uint16_t *storage;
+    size_t storage_length;
+    std::atomic<size_t> head{0}; // next slot to write, owned by the producer
+    std::atomic<size_t> tail{0}; // next slot to read, owned by the consumer
+    std::atomic<size_t> dropped_count{0};
+};
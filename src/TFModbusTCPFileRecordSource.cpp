@@ -0,0 +1,92 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include "TFModbusTCPFileRecordSource.h"
+
+#include <string.h>
+
+TFModbusTCPExceptionCode TFModbusTCPFileRecordSource::handle(TFModbusTCPFunctionCode function_code, uint16_t record_number, uint16_t record_length, uint8_t *record_data)
+{
+    size_t offset      = record_number * 2u;
+    size_t data_length = record_length * 2u;
+
+    switch (function_code) {
+    case TFModbusTCPFunctionCode::ReadFileRecord:
+        return read(offset, data_length, record_data);
+
+    case TFModbusTCPFunctionCode::WriteFileRecord:
+        if (!writable) {
+            return TFModbusTCPExceptionCode::IllegalFunction;
+        }
+
+        return write(offset, data_length, record_data);
+
+    default:
+        return TFModbusTCPExceptionCode::IllegalFunction;
+    }
+}
+
+TFModbusTCPExceptionCode TFModbusTCPFileRecordBufferSource::read(size_t offset, size_t data_length, uint8_t *data)
+{
+    if (offset + data_length > length) {
+        return TFModbusTCPExceptionCode::IllegalDataAddress;
+    }
+
+    memcpy(data, buffer + offset, data_length);
+    return TFModbusTCPExceptionCode::Success;
+}
+
+TFModbusTCPExceptionCode TFModbusTCPFileRecordBufferSource::write(size_t offset, size_t data_length, const uint8_t *data)
+{
+    if (offset + data_length > length) {
+        return TFModbusTCPExceptionCode::IllegalDataAddress;
+    }
+
+    memcpy(buffer + offset, data, data_length);
+    return TFModbusTCPExceptionCode::Success;
+}
+
+TFModbusTCPExceptionCode TFModbusTCPFileRecordFileSource::read(size_t offset, size_t data_length, uint8_t *data)
+{
+    if (fseek(file, static_cast<long>(offset), SEEK_SET) < 0) {
+        return TFModbusTCPExceptionCode::ServerDeviceFailure;
+    }
+
+    if (fread(data, 1, data_length, file) != data_length) {
+        bool past_end = feof(file) != 0;
+
+        clearerr(file);
+        return past_end ? TFModbusTCPExceptionCode::IllegalDataAddress : TFModbusTCPExceptionCode::ServerDeviceFailure;
+    }
+
+    return TFModbusTCPExceptionCode::Success;
+}
+
+TFModbusTCPExceptionCode TFModbusTCPFileRecordFileSource::write(size_t offset, size_t data_length, const uint8_t *data)
+{
+    if (fseek(file, static_cast<long>(offset), SEEK_SET) < 0
+     || fwrite(data, 1, data_length, file) != data_length
+     || fflush(file) != 0) {
+        clearerr(file);
+        return TFModbusTCPExceptionCode::ServerDeviceFailure;
+    }
+
+    return TFModbusTCPExceptionCode::Success;
+}
@@ -0,0 +1,80 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "TFModbusTCPCommon.h"
+
+// Serves the records of one file number from a byte source. Record N is the
+// register at byte offset N * 2. Use handle() from a file record callback of
+// TFModbusTCPServer for the file numbers that the source should serve.
+// Writes to a read-only source are answered with an Illegal Function exception
+class TFModbusTCPFileRecordSource
+{
+public:
+    TFModbusTCPFileRecordSource(bool writable_) : writable(writable_) {}
+    virtual ~TFModbusTCPFileRecordSource() {}
+
+    TFModbusTCPFileRecordSource(TFModbusTCPFileRecordSource const &other) = delete;
+    TFModbusTCPFileRecordSource &operator=(TFModbusTCPFileRecordSource const &other) = delete;
+
+    TFModbusTCPExceptionCode handle(TFModbusTCPFunctionCode function_code, uint16_t record_number, uint16_t record_length, uint8_t *record_data);
+
+protected:
+    virtual TFModbusTCPExceptionCode read(size_t offset, size_t length, uint8_t *data) = 0;
+    virtual TFModbusTCPExceptionCode write(size_t offset, size_t length, const uint8_t *data) = 0;
+
+private:
+    bool writable;
+};
+
+class TFModbusTCPFileRecordBufferSource final : public TFModbusTCPFileRecordSource
+{
+public:
+    TFModbusTCPFileRecordBufferSource(uint8_t *buffer_, size_t length_, bool writable_) : TFModbusTCPFileRecordSource(writable_), buffer(buffer_), length(length_) {}
+
+protected:
+    TFModbusTCPExceptionCode read(size_t offset, size_t data_length, uint8_t *data) override;
+    TFModbusTCPExceptionCode write(size_t offset, size_t data_length, const uint8_t *data) override;
+
+private:
+    uint8_t *buffer;
+    size_t length;
+};
+
+// The file is not owned and has to stay open while the source is in use. Reads
+// past the current end of the file are answered with an Illegal Data Address
+// exception, so a growing log file can be served directly
+class TFModbusTCPFileRecordFileSource final : public TFModbusTCPFileRecordSource
+{
+public:
+    TFModbusTCPFileRecordFileSource(FILE *file_, bool writable_) : TFModbusTCPFileRecordSource(writable_), file(file_) {}
+
+protected:
+    TFModbusTCPExceptionCode read(size_t offset, size_t data_length, uint8_t *data) override;
+    TFModbusTCPExceptionCode write(size_t offset, size_t data_length, const uint8_t *data) override;
+
+private:
+    FILE *file;
+};
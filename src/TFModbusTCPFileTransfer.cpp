@@ -0,0 +1,181 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include "TFModbusTCPFileTransfer.h"
+
+#include <algorithm>
+
+#include "TFNetwork.h"
+
+#define debugfln(fmt, ...) tf_network_debugfln("TFModbusTCPFileTransfer[%p]::" fmt, static_cast<void *>(this) __VA_OPT__(,) __VA_ARGS__)
+
+#define RECORDS_PER_FILE (TF_MODBUS_TCP_MAX_RECORD_NUMBER + 1u)
+
+void TFModbusTCPFileTransfer::start(TFModbusTCPClient *client_,
+                                    uint8_t unit_id_,
+                                    TFModbusTCPFunctionCode function_code_,
+                                    uint16_t file_number_,
+                                    uint16_t record_number_,
+                                    uint8_t *data_,
+                                    size_t length_,
+                                    micros_t timeout_,
+                                    TFModbusTCPClientTransactionCallback &&callback_)
+{
+    if (!callback_) {
+        return;
+    }
+
+    if (is_active()) {
+        callback_(TFModbusTCPClientTransactionResult::NoTransactionAvailable, "Transfer is already active");
+        return;
+    }
+
+    if (client_ == nullptr || data_ == nullptr) {
+        callback_(TFModbusTCPClientTransactionResult::InvalidArgument, "Client or data pointer is null");
+        return;
+    }
+
+    if (function_code_ != TFModbusTCPFunctionCode::ReadFileRecord && function_code_ != TFModbusTCPFunctionCode::WriteFileRecord) {
+        callback_(TFModbusTCPClientTransactionResult::InvalidArgument, "Function code is out-of-range");
+        return;
+    }
+
+    if (file_number_ < TF_MODBUS_TCP_MIN_FILE_NUMBER || record_number_ > TF_MODBUS_TCP_MAX_RECORD_NUMBER) {
+        callback_(TFModbusTCPClientTransactionResult::InvalidArgument, "File or record number is out-of-range");
+        return;
+    }
+
+    uint64_t last_file_number = file_number_ + (record_number_ + length_ / 2 - 1) / RECORDS_PER_FILE;
+
+    if (length_ == 0 || (length_ % 2) != 0 || last_file_number > UINT16_MAX) {
+        callback_(TFModbusTCPClientTransactionResult::InvalidArgument, "Length is out-of-range");
+        return;
+    }
+
+    client             = client_;
+    unit_id            = unit_id_;
+    function_code      = function_code_;
+    file_number        = file_number_;
+    record_position    = record_number_;
+    data               = data_;
+    length             = length_;
+    scheduled_length   = 0;
+    transferred_length = 0;
+    timeout            = timeout_;
+    callback           = std::move(callback_);
+    result             = TFModbusTCPClientTransactionResult::Success;
+    window_size        = std::clamp<size_t>(client->get_device_profile()->max_pending_transaction_count, 2, TF_MODBUS_TCP_FILE_TRANSFER_MAX_WINDOW_SIZE);
+    pending_count      = 0;
+    sending            = false;
+
+    for (size_t i = 0; i < TF_MODBUS_TCP_FILE_TRANSFER_MAX_WINDOW_SIZE; ++i) {
+        requests[i].used = false;
+    }
+
+    send_next();
+}
+
+void TFModbusTCPFileTransfer::send_next()
+{
+    // Per record a read response carries its length and reference type, a
+    // write request carries the full record header
+    size_t record_overhead = function_code == TFModbusTCPFunctionCode::ReadFileRecord ? TF_MODBUS_TCP_FILE_RECORD_SUB_RESPONSE_LENGTH
+                                                                                     : TF_MODBUS_TCP_FILE_RECORD_SUB_REQUEST_LENGTH;
+
+    sending = true;
+
+    while (result == TFModbusTCPClientTransactionResult::Success && pending_count < window_size && scheduled_length < length) {
+        TFModbusTCPFileTransferRequest *request = nullptr;
+
+        for (size_t i = 0; i < TF_MODBUS_TCP_FILE_TRANSFER_MAX_WINDOW_SIZE; ++i) {
+            if (!requests[i].used) {
+                request = &requests[i];
+                break;
+            }
+        }
+
+        size_t remaining_count = (length - scheduled_length) / 2;
+        size_t byte_budget     = TF_MODBUS_TCP_MAX_FILE_RECORD_BYTE_COUNT;
+
+        request->used         = true;
+        request->record_count = 0;
+
+        // A second record is only needed if the first one ends at the end of a file
+        while (request->record_count < 2 && remaining_count > 0 && byte_budget > record_overhead + 1) {
+            TFModbusTCPFileRecord *record = &request->records[request->record_count++];
+            size_t file_end_count         = RECORDS_PER_FILE - record_position % RECORDS_PER_FILE;
+            size_t record_length          = std::min(std::min(remaining_count, (byte_budget - record_overhead) / 2), file_end_count);
+
+            record->file_number   = static_cast<uint16_t>(file_number + record_position / RECORDS_PER_FILE);
+            record->record_number = static_cast<uint16_t>(record_position % RECORDS_PER_FILE);
+            record->record_length = static_cast<uint16_t>(record_length);
+            record->record_data   = data + scheduled_length;
+
+            record_position  += record_length;
+            scheduled_length += record_length * 2;
+            remaining_count  -= record_length;
+            byte_budget      -= record_overhead + record_length * 2;
+        }
+
+        ++pending_count;
+
+        client->transact_file_records(unit_id, function_code, request->records, request->record_count, timeout,
+        [this, request](TFModbusTCPClientTransactionResult transaction_result, const char *error_message) {
+            (void)error_message;
+
+            request->used = false;
+            --pending_count;
+
+            if (transaction_result == TFModbusTCPClientTransactionResult::Success) {
+                for (size_t i = 0; i < request->record_count; ++i) {
+                    transferred_length += request->records[i].record_length * 2u;
+                }
+            }
+            else if (result == TFModbusTCPClientTransactionResult::Success) {
+                debugfln("send_next() transaction failed (result=%s error_message=%s)",
+                         get_tf_modbus_tcp_client_transaction_result_name(transaction_result), TFNetwork::printf_safe(error_message));
+
+                result = transaction_result;
+            }
+
+            if (!sending) {
+                send_next();
+            }
+        });
+    }
+
+    sending = false;
+
+    if (pending_count == 0 && (result != TFModbusTCPClientTransactionResult::Success || scheduled_length >= length)) {
+        finish();
+    }
+}
+
+void TFModbusTCPFileTransfer::finish()
+{
+    if (!is_active()) {
+        return;
+    }
+
+    TFModbusTCPClientTransactionCallback finish_callback = std::move(callback);
+    callback = nullptr;
+
+    finish_callback(result, nullptr);
+}
@@ -0,0 +1,89 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <TFTools/Micros.h>
+
+#include "TFModbusTCPClient.h"
+
+// configuration
+#ifndef TF_MODBUS_TCP_FILE_TRANSFER_MAX_WINDOW_SIZE
+#define TF_MODBUS_TCP_FILE_TRANSFER_MAX_WINDOW_SIZE 4
+#endif
+
+struct TFModbusTCPFileTransferRequest
+{
+    bool used;
+    TFModbusTCPFileRecord records[2];
+    uint16_t record_count;
+};
+
+// Reads or writes a blob of arbitrary even length as consecutive file records
+// using Read File Record (20) or Write File Record (21). The blob starts at the
+// given file and record number and continues with record 0 of the next file
+// number after record 9999. Each request carries as many registers as fit into
+// one frame, crossing into the next file number by using a second record in
+// the same request. Up to the max pending transaction count of the client's
+// device profile requests are kept in flight, but at least two, so that the
+// next request is already scheduled when a response arrives
+class TFModbusTCPFileTransfer final
+{
+public:
+    TFModbusTCPFileTransfer() {}
+
+    TFModbusTCPFileTransfer(TFModbusTCPFileTransfer const &other) = delete;
+    TFModbusTCPFileTransfer &operator=(TFModbusTCPFileTransfer const &other) = delete;
+
+    void start(TFModbusTCPClient *client,
+               uint8_t unit_id,
+               TFModbusTCPFunctionCode function_code,
+               uint16_t file_number,
+               uint16_t record_number,
+               uint8_t *data,
+               size_t length,
+               micros_t timeout,
+               TFModbusTCPClientTransactionCallback &&callback);
+    bool is_active() const { return callback != nullptr; }
+    size_t get_transferred_length() const { return transferred_length; }
+
+private:
+    void send_next();
+    void finish();
+
+    TFModbusTCPClient *client = nullptr;
+    uint8_t unit_id;
+    TFModbusTCPFunctionCode function_code;
+    uint16_t file_number;
+    uint32_t record_position; // record number of the next request, counted from record 0 of file_number
+    uint8_t *data;
+    size_t length;
+    size_t scheduled_length;
+    size_t transferred_length = 0;
+    micros_t timeout;
+    TFModbusTCPClientTransactionCallback callback;
+    TFModbusTCPClientTransactionResult result;
+    size_t window_size;
+    size_t pending_count;
+    bool sending;
+    TFModbusTCPFileTransferRequest requests[TF_MODBUS_TCP_FILE_TRANSFER_MAX_WINDOW_SIZE];
+};
@@ -0,0 +1,434 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include "TFModbusTCPGateway.h"
+
+#include <string.h>
+#include <algorithm>
+
+#include "TFNetwork.h"
+
+#define debugfln(fmt, ...) tf_network_debugfln("TFModbusTCPGateway[%p]::" fmt, static_cast<void *>(this) __VA_OPT__(,) __VA_ARGS__)
+
+enum class TFModbusTCPGatewayOperationState
+{
+    Pending, // not sent yet, reads can be widened
+    Sent,
+    Finished,
+};
+
+struct TFModbusTCPGatewayWaiter
+{
+    uint32_t request_id;
+    uint16_t start_address;
+    uint16_t data_count;
+};
+
+struct TFModbusTCPGatewayOperation
+{
+    TFModbusTCPGatewayOperation *next;
+    TFModbusTCPGatewayOperationState state;
+    bool joinable;
+    uint8_t unit_id;
+    TFModbusTCPFunctionCode function_code;
+    uint16_t start_address;
+    uint16_t data_count;
+    TFModbusTCPExceptionCode exception_code;
+    TFModbusTCPGatewayWaiter waiters[TF_MODBUS_TCP_SERVER_MAX_CLIENT_COUNT];
+    size_t waiter_count;
+
+    union {
+        uint8_t coil_values[(TF_MODBUS_TCP_MAX_READ_COIL_COUNT + 7) / 8];
+        uint16_t register_values[TF_MODBUS_TCP_MAX_READ_REGISTER_COUNT];
+    };
+};
+
+static bool is_read(TFModbusTCPFunctionCode function_code)
+{
+    return function_code == TFModbusTCPFunctionCode::ReadCoils
+        || function_code == TFModbusTCPFunctionCode::ReadDiscreteInputs
+        || function_code == TFModbusTCPFunctionCode::ReadHoldingRegisters
+        || function_code == TFModbusTCPFunctionCode::ReadInputRegisters;
+}
+
+static bool is_bit_access(TFModbusTCPFunctionCode function_code)
+{
+    return function_code == TFModbusTCPFunctionCode::ReadCoils
+        || function_code == TFModbusTCPFunctionCode::ReadDiscreteInputs
+        || function_code == TFModbusTCPFunctionCode::WriteSingleCoil
+        || function_code == TFModbusTCPFunctionCode::WriteMultipleCoils;
+}
+
+static void copy_bits(uint8_t *destination, const uint8_t *source, uint32_t source_offset, uint32_t count)
+{
+    memset(destination, 0, (count + 7) / 8);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t k = source_offset + i;
+
+        if ((source[k / 8] >> (k % 8)) & 1) {
+            destination[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+        }
+    }
+}
+
+TFModbusTCPGateway::~TFModbusTCPGateway()
+{
+    stop();
+}
+
+bool TFModbusTCPGateway::start(const char *host, uint16_t port, micros_t timeout /*= 2_s*/)
+{
+    if (host == nullptr || strlen(host) == 0 || port == 0) {
+        debugfln("start(host=%s port=%u) invalid argument", TFNetwork::printf_safe(host), port);
+        return false;
+    }
+
+    if (this->host != nullptr) {
+        debugfln("start(host=%s port=%u) already started", TFNetwork::printf_safe(host), port);
+        return false;
+    }
+
+    debugfln("start(host=%s port=%u)", host, port);
+
+    this->host    = strdup(host);
+    this->port    = port;
+    this->timeout = timeout;
+
+    return true;
+}
+
+// Pending server requests are answered with a Gateway Path Unavailable exception
+void TFModbusTCPGateway::stop()
+{
+    if (host == nullptr) {
+        return;
+    }
+
+    debugfln("stop()");
+
+    free(host);
+    host = nullptr;
+
+    if (shared_client != nullptr) {
+        TFModbusTCPSharedClient *released = shared_client;
+
+        shared_client = nullptr;
+
+        // force the disconnect, so that all sent operations are finished as
+        // aborted before they are deleted
+        pool->release(released, true);
+    }
+
+    for (TFModbusTCPGatewayOperation *operation = operation_head; operation != nullptr; operation = operation->next) {
+        if (operation->state != TFModbusTCPGatewayOperationState::Finished) {
+            operation->state          = TFModbusTCPGatewayOperationState::Finished;
+            operation->exception_code = TFModbusTCPExceptionCode::GatewayPathUnvailable;
+        }
+    }
+
+    finish_operations();
+}
+
+void TFModbusTCPGateway::tick()
+{
+    if (host == nullptr) {
+        return;
+    }
+
+    if (shared_client == nullptr && !acquiring) {
+        acquiring = true;
+
+        pool->acquire(host, port,
+        [this](TFGenericTCPClientConnectResult result, int error_number, TFGenericTCPSharedClient *client, TFGenericTCPClientPoolShareLevel share_level) {
+            (void)error_number;
+            (void)share_level;
+
+            acquiring = false;
+
+            if (result != TFGenericTCPClientConnectResult::Connected) {
+                debugfln("tick() could not connect downstream (result=%s error_number=%d)",
+                         get_tf_generic_tcp_client_connect_result_name(result), error_number);
+                return;
+            }
+
+            shared_client = static_cast<TFModbusTCPSharedClient *>(client);
+        },
+        [this](TFGenericTCPClientDisconnectReason reason, int error_number, TFGenericTCPSharedClient *client, TFGenericTCPClientPoolShareLevel share_level) {
+            (void)reason;
+            (void)error_number;
+            (void)share_level;
+
+            debugfln("tick() disconnected downstream (reason=%s error_number=%d)",
+                     get_tf_generic_tcp_client_disconnect_reason_name(reason), error_number);
+
+            if (shared_client == client) {
+                shared_client = nullptr;
+            }
+        });
+    }
+
+    for (TFModbusTCPGatewayOperation *operation = operation_head; operation != nullptr; operation = operation->next) {
+        if (operation->state == TFModbusTCPGatewayOperationState::Pending) {
+            send_operation(operation);
+        }
+    }
+
+    finish_operations();
+}
+
+TFModbusTCPExceptionCode TFModbusTCPGateway::handle_request(uint8_t unit_id,
+                                                            TFModbusTCPFunctionCode function_code,
+                                                            uint16_t start_address,
+                                                            uint16_t data_count,
+                                                            void *data_values)
+{
+    if (shared_client == nullptr) {
+        return TFModbusTCPExceptionCode::GatewayPathUnvailable;
+    }
+
+    if (is_read(function_code)) {
+        uint32_t end_address = static_cast<uint32_t>(start_address) + data_count;
+
+        for (TFModbusTCPGatewayOperation *operation = operation_head; operation != nullptr; operation = operation->next) {
+            if (!operation->joinable || operation->unit_id != unit_id || operation->function_code != function_code) {
+                continue;
+            }
+
+            uint32_t operation_end_address = static_cast<uint32_t>(operation->start_address) + operation->data_count;
+
+            if (operation->state == TFModbusTCPGatewayOperationState::Sent) {
+                // join a read in flight that covers the requested range
+                if (start_address < operation->start_address || end_address > operation_end_address) {
+                    continue;
+                }
+            }
+            else if (operation->state == TFModbusTCPGatewayOperationState::Pending) {
+                // widen a pending read that overlaps or touches the requested range
+                if (end_address < operation->start_address || start_address > operation_end_address) {
+                    continue;
+                }
+
+                uint16_t union_start_address = std::min(start_address, operation->start_address);
+                uint32_t union_end_address   = std::max(end_address, operation_end_address);
+
+                if (union_end_address - union_start_address > get_max_read_count(function_code)) {
+                    continue;
+                }
+
+                operation->start_address = union_start_address;
+                operation->data_count    = static_cast<uint16_t>(union_end_address - union_start_address);
+            }
+            else {
+                continue;
+            }
+
+            uint32_t request_id = server->defer_response();
+
+            if (!add_waiter(operation, request_id, start_address, data_count)) {
+                return TFModbusTCPExceptionCode::ServerDeviceBusy;
+            }
+
+            ++coalesced_read_count;
+
+            return TFModbusTCPExceptionCode::Deferred;
+        }
+    }
+    else {
+        // reads that were requested before the write must not be used for later requests
+        send_pending_operations(unit_id);
+
+        for (TFModbusTCPGatewayOperation *operation = operation_head; operation != nullptr; operation = operation->next) {
+            if (operation->unit_id == unit_id) {
+                operation->joinable = false;
+            }
+        }
+    }
+
+    TFModbusTCPGatewayOperation *operation = add_operation(unit_id, function_code, start_address, data_count);
+
+    if (operation == nullptr) {
+        return TFModbusTCPExceptionCode::ServerDeviceBusy;
+    }
+
+    uint32_t request_id = server->defer_response();
+
+    if (is_read(function_code)) {
+        add_waiter(operation, request_id, start_address, data_count);
+    }
+    else {
+        size_t length;
+
+        if (function_code == TFModbusTCPFunctionCode::MaskWriteRegister) {
+            length = 2 * sizeof(uint16_t);
+        }
+        else if (is_bit_access(function_code)) {
+            length = (data_count + 7u) / 8u;
+        }
+        else {
+            length = data_count * sizeof(uint16_t);
+        }
+
+        memcpy(operation->register_values, data_values, length); // only valid during the request callback
+        add_waiter(operation, request_id, start_address, data_count);
+        send_operation(operation);
+    }
+
+    return TFModbusTCPExceptionCode::Deferred;
+}
+
+TFModbusTCPGatewayOperation *TFModbusTCPGateway::add_operation(uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count)
+{
+    if (operation_count >= TF_MODBUS_TCP_GATEWAY_MAX_OPERATION_COUNT) {
+        debugfln("add_operation(unit_id=%u function_code=%s) too many operations", unit_id, get_tf_modbus_tcp_function_code_name(function_code));
+        return nullptr;
+    }
+
+    TFModbusTCPGatewayOperation *operation = new TFModbusTCPGatewayOperation;
+
+    operation->state          = TFModbusTCPGatewayOperationState::Pending;
+    operation->joinable       = is_read(function_code);
+    operation->unit_id        = unit_id;
+    operation->function_code  = function_code;
+    operation->start_address  = start_address;
+    operation->data_count     = data_count;
+    operation->exception_code = TFModbusTCPExceptionCode::Success;
+    operation->waiter_count   = 0;
+
+    // keep the request order, the downstream client sends in scheduling order
+    TFModbusTCPGatewayOperation **tail_ptr = &operation_head;
+
+    while (*tail_ptr != nullptr) {
+        tail_ptr = &(*tail_ptr)->next;
+    }
+
+    operation->next = nullptr;
+    *tail_ptr       = operation;
+
+    ++operation_count;
+
+    return operation;
+}
+
+bool TFModbusTCPGateway::add_waiter(TFModbusTCPGatewayOperation *operation, uint32_t request_id, uint16_t start_address, uint16_t data_count)
+{
+    if (operation->waiter_count >= TF_MODBUS_TCP_SERVER_MAX_CLIENT_COUNT) {
+        return false;
+    }
+
+    TFModbusTCPGatewayWaiter *waiter = &operation->waiters[operation->waiter_count++];
+
+    waiter->request_id    = request_id;
+    waiter->start_address = start_address;
+    waiter->data_count    = data_count;
+
+    return true;
+}
+
+void TFModbusTCPGateway::send_operation(TFModbusTCPGatewayOperation *operation)
+{
+    if (shared_client == nullptr) {
+        operation->state          = TFModbusTCPGatewayOperationState::Finished;
+        operation->exception_code = TFModbusTCPExceptionCode::GatewayPathUnvailable;
+        return;
+    }
+
+    operation->state = TFModbusTCPGatewayOperationState::Sent;
+
+    if (is_read(operation->function_code)) {
+        ++downstream_read_count;
+    }
+    else {
+        ++downstream_write_count;
+    }
+
+    // the callback can be called synchronously, e.g. if the client is not
+    // connected anymore. therefore the server responses are always finished
+    // from tick(), outside of the request callback
+    shared_client->transact(operation->unit_id, operation->function_code, operation->start_address, operation->data_count, operation->register_values, timeout,
+    [operation](TFModbusTCPClientTransactionResult result, const char *error_message) {
+        (void)error_message;
+
+        operation->state          = TFModbusTCPGatewayOperationState::Finished;
+        operation->exception_code = get_tf_modbus_tcp_client_transaction_result_exception_code(result);
+    });
+}
+
+void TFModbusTCPGateway::send_pending_operations(uint8_t unit_id)
+{
+    for (TFModbusTCPGatewayOperation *operation = operation_head; operation != nullptr; operation = operation->next) {
+        if (operation->state == TFModbusTCPGatewayOperationState::Pending && operation->unit_id == unit_id) {
+            send_operation(operation);
+        }
+    }
+}
+
+void TFModbusTCPGateway::finish_operations()
+{
+    TFModbusTCPGatewayOperation **operation_ptr = &operation_head;
+
+    while (*operation_ptr != nullptr) {
+        TFModbusTCPGatewayOperation *operation = *operation_ptr;
+
+        if (operation->state != TFModbusTCPGatewayOperationState::Finished) {
+            operation_ptr = &operation->next;
+            continue;
+        }
+
+        *operation_ptr = operation->next;
+        --operation_count;
+
+        for (size_t i = 0; i < operation->waiter_count; ++i) {
+            TFModbusTCPGatewayWaiter *waiter = &operation->waiters[i];
+            const void *data_values          = nullptr;
+            uint16_t data_count              = 0;
+            uint8_t coil_values[(TF_MODBUS_TCP_MAX_READ_COIL_COUNT + 7) / 8];
+
+            if (operation->exception_code == TFModbusTCPExceptionCode::Success && is_read(operation->function_code)) {
+                uint16_t offset = waiter->start_address - operation->start_address;
+
+                if (is_bit_access(operation->function_code)) {
+                    copy_bits(coil_values, operation->coil_values, offset, waiter->data_count);
+                    data_values = coil_values;
+                }
+                else {
+                    data_values = operation->register_values + offset;
+                }
+
+                data_count = waiter->data_count;
+            }
+
+            // the server only copies the values if the server client is still
+            // connected, otherwise this fails
+            server->finish_deferred_response(waiter->request_id, operation->exception_code, data_values, data_count);
+        }
+
+        delete operation;
+    }
+}
+
+uint16_t TFModbusTCPGateway::get_max_read_count(TFModbusTCPFunctionCode function_code) const
+{
+    if (is_bit_access(function_code)) {
+        return TF_MODBUS_TCP_MAX_READ_COIL_COUNT;
+    }
+
+    return std::min<uint16_t>(TF_MODBUS_TCP_MAX_READ_REGISTER_COUNT, shared_client->get_device_profile()->max_read_register_count);
+}
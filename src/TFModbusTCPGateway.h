@@ -0,0 +1,93 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <TFTools/Micros.h>
+
+#include "TFModbusTCPCommon.h"
+#include "TFModbusTCPServer.h"
+#include "TFModbusTCPClient.h"
+#include "TFModbusTCPClientPool.h"
+
+// configuration
+#ifndef TF_MODBUS_TCP_GATEWAY_MAX_OPERATION_COUNT
+#define TF_MODBUS_TCP_GATEWAY_MAX_OPERATION_COUNT 16
+#endif
+
+struct TFModbusTCPGatewayOperation;
+
+// Forwards the requests of a TFModbusTCPServer to a downstream device via a
+// TFModbusTCPClientPool, using deferred server responses. Reads from different
+// server clients are coalesced: reads of the same unit and function code that
+// overlap each other are merged into one downstream read if they arrive before
+// it is sent, and reads that are covered by a downstream read that is already
+// in flight are answered from its response. A write ends coalescing for reads
+// of its unit that were requested before it.
+//
+// Server and pool have to use the same register byte order. Single coil and
+// register writes are forwarded as multiple coil and register writes
+class TFModbusTCPGateway final
+{
+public:
+    TFModbusTCPGateway(TFModbusTCPServer *server_, TFModbusTCPClientPool *pool_) : server(server_), pool(pool_) {}
+    ~TFModbusTCPGateway();
+
+    TFModbusTCPGateway(TFModbusTCPGateway const &other) = delete;
+    TFModbusTCPGateway &operator=(TFModbusTCPGateway const &other) = delete;
+
+    bool start(const char *host, uint16_t port, micros_t timeout = 2_s);
+    void stop(); // don't call from a server or pool callback
+    void tick(); // call after the server tick
+
+    // to be called from the request callback of the server
+    TFModbusTCPExceptionCode handle_request(uint8_t unit_id,
+                                            TFModbusTCPFunctionCode function_code,
+                                            uint16_t start_address,
+                                            uint16_t data_count,
+                                            void *data_values);
+
+    size_t get_downstream_read_count() const { return downstream_read_count; }
+    size_t get_coalesced_read_count() const { return coalesced_read_count; }
+    size_t get_downstream_write_count() const { return downstream_write_count; }
+
+private:
+    TFModbusTCPGatewayOperation *add_operation(uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count);
+    bool add_waiter(TFModbusTCPGatewayOperation *operation, uint32_t request_id, uint16_t start_address, uint16_t data_count);
+    void send_operation(TFModbusTCPGatewayOperation *operation);
+    void send_pending_operations(uint8_t unit_id);
+    void finish_operations();
+    uint16_t get_max_read_count(TFModbusTCPFunctionCode function_code) const;
+
+    TFModbusTCPServer *server;
+    TFModbusTCPClientPool *pool;
+    char *host                                  = nullptr;
+    uint16_t port                               = 0;
+    micros_t timeout                            = 0_s;
+    TFModbusTCPSharedClient *shared_client      = nullptr;
+    bool acquiring                              = false;
+    TFModbusTCPGatewayOperation *operation_head = nullptr;
+    size_t operation_count                      = 0;
+    size_t downstream_read_count                = 0;
+    size_t coalesced_read_count                 = 0;
+    size_t downstream_write_count               = 0;
+};
@@ -0,0 +1,566 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include "TFModbusTCPHistory.h"
+
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#include "TFNetwork.h"
+
+#define debugfln(fmt, ...) tf_network_debugfln("TFModbusTCPHistory[%p]::" fmt, static_cast<void *>(this) __VA_OPT__(,) __VA_ARGS__)
+
+// worst case: 5 bit prefix and 64 bit value for the timestamp and for an
+// integer value, a float value needs at most 2 + 5 + 5 + 32 bits
+#define MAX_SAMPLE_BIT_COUNT (2 * (5 + 64))
+
+#define BLOCK_BIT_COUNT (TF_MODBUS_TCP_HISTORY_BLOCK_BYTE_COUNT * 8)
+
+#define NO_WINDOW 0xFF
+
+static_assert(BLOCK_BIT_COUNT >= MAX_SAMPLE_BIT_COUNT, "History block too small");
+static_assert(BLOCK_BIT_COUNT <= UINT16_MAX, "History block too big");
+
+struct TFModbusTCPHistorySeries
+{
+    TFModbusTCPHistorySeries *next;
+    TFModbusTCPDataType data_type;
+    uint16_t address;
+    TFModbusTCPHistoryValueType value_type;
+    TFModbusTCPHistoryBlock *head; // oldest
+    TFModbusTCPHistoryBlock *tail; // newest, appended to
+};
+
+struct TFModbusTCPHistoryBlock
+{
+    TFModbusTCPHistoryBlock *next_in_series;
+    TFModbusTCPHistoryBlock *next_in_history;
+    TFModbusTCPHistorySeries *series;
+    int64_t first_ticks;
+    int64_t last_ticks;
+    int64_t last_delta;
+    uint64_t first_raw_value;
+    uint64_t last_raw_value;
+    uint16_t sample_count;
+    uint16_t bit_count;
+    uint8_t leading_zeros;  // XOR window of the last float value
+    uint8_t trailing_zeros;
+    uint8_t bits[TF_MODBUS_TCP_HISTORY_BLOCK_BYTE_COUNT];
+};
+
+struct TFModbusTCPHistoryBitReader
+{
+    const uint8_t *bits;
+    uint16_t position;
+};
+
+const char *get_tf_modbus_tcp_history_value_type_name(TFModbusTCPHistoryValueType value_type)
+{
+    switch (value_type) {
+    case TFModbusTCPHistoryValueType::U16:
+        return "U16";
+
+    case TFModbusTCPHistoryValueType::S16:
+        return "S16";
+
+    case TFModbusTCPHistoryValueType::U32:
+        return "U32";
+
+    case TFModbusTCPHistoryValueType::S32:
+        return "S32";
+
+    case TFModbusTCPHistoryValueType::Float32:
+        return "Float32";
+    }
+
+    return "<Unknown>";
+}
+
+static uint16_t get_register_count(TFModbusTCPHistoryValueType value_type)
+{
+    return value_type == TFModbusTCPHistoryValueType::U16 || value_type == TFModbusTCPHistoryValueType::S16 ? 1 : 2;
+}
+
+static uint64_t zigzag_encode(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+static int64_t zigzag_decode(uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+static void write_bits(TFModbusTCPHistoryBlock *block, uint64_t value, uint8_t count)
+{
+    while (count > 0) {
+        --count;
+
+        if (((value >> count) & 1) != 0) {
+            block->bits[block->bit_count / 8] |= static_cast<uint8_t>(0x80u >> (block->bit_count % 8));
+        }
+
+        ++block->bit_count;
+    }
+}
+
+static uint64_t read_bits(TFModbusTCPHistoryBitReader *reader, uint8_t count)
+{
+    uint64_t value = 0;
+
+    while (count > 0) {
+        --count;
+
+        value = (value << 1) | ((reader->bits[reader->position / 8] >> (7 - reader->position % 8)) & 1);
+
+        ++reader->position;
+    }
+
+    return value;
+}
+
+// 0 takes 1 bit, small values take 5, 10, 16 or 25 bits, everything else 69 bits
+static const uint8_t varying_bit_counts[] = {0, 3, 7, 12, 20, 64};
+
+#define VARYING_PREFIX_COUNT (sizeof(varying_bit_counts) / sizeof(varying_bit_counts[0]) - 1)
+
+static void write_varying(TFModbusTCPHistoryBlock *block, int64_t value)
+{
+    uint64_t zigzag = zigzag_encode(value);
+    uint8_t prefix  = 0;
+
+    if (zigzag != 0) {
+        prefix = 1;
+
+        while (prefix < VARYING_PREFIX_COUNT && zigzag >= (1ull << varying_bit_counts[prefix])) {
+            ++prefix;
+        }
+    }
+
+    // prefix is a run of ones, terminated by a zero unless it is the longest
+    write_bits(block, (1u << prefix) - 1, prefix);
+
+    if (prefix < VARYING_PREFIX_COUNT) {
+        write_bits(block, 0b0, 1);
+    }
+
+    write_bits(block, zigzag, varying_bit_counts[prefix]);
+}
+
+static int64_t read_varying(TFModbusTCPHistoryBitReader *reader)
+{
+    uint8_t prefix = 0;
+
+    while (prefix < VARYING_PREFIX_COUNT && read_bits(reader, 1) != 0) {
+        ++prefix;
+    }
+
+    return zigzag_decode(read_bits(reader, varying_bit_counts[prefix]));
+}
+
+static double get_value(TFModbusTCPHistoryValueType value_type, uint64_t raw_value)
+{
+    switch (value_type) {
+    case TFModbusTCPHistoryValueType::Float32:
+        {
+            uint32_t bits = static_cast<uint32_t>(raw_value);
+            float value;
+
+            memcpy(&value, &bits, sizeof(value));
+
+            return value;
+        }
+
+    default:
+        return static_cast<double>(static_cast<int64_t>(raw_value));
+    }
+}
+
+TFModbusTCPHistory::TFModbusTCPHistory(size_t memory_budget, micros_t resolution_) :
+    resolution(resolution_.as<int64_t>() > 0 ? resolution_.as<int64_t>() : 1),
+    max_block_count(memory_budget / sizeof(TFModbusTCPHistoryBlock) > 0 ? memory_budget / sizeof(TFModbusTCPHistoryBlock) : 1)
+{
+}
+
+TFModbusTCPHistory::~TFModbusTCPHistory()
+{
+    while (oldest_block != nullptr) {
+        TFModbusTCPHistoryBlock *block = oldest_block;
+
+        oldest_block = block->next_in_history;
+
+        delete block;
+    }
+
+    while (series_head != nullptr) {
+        TFModbusTCPHistorySeries *series = series_head;
+
+        series_head = series->next;
+
+        delete series;
+    }
+}
+
+TFModbusTCPHistorySeries *TFModbusTCPHistory::add_series(TFModbusTCPDataType data_type, uint16_t address, TFModbusTCPHistoryValueType value_type)
+{
+    if ((data_type != TFModbusTCPDataType::InputRegister && data_type != TFModbusTCPDataType::HoldingRegister)
+     || static_cast<uint32_t>(address) + get_register_count(value_type) > 65536u) {
+        debugfln("add_series(data_type=%s address=%u value_type=%s) invalid argument",
+                 get_tf_modbus_tcp_data_type_name(data_type), address, get_tf_modbus_tcp_history_value_type_name(value_type));
+        return nullptr;
+    }
+
+    TFModbusTCPHistorySeries *series = new TFModbusTCPHistorySeries;
+
+    series->data_type  = data_type;
+    series->address    = address;
+    series->value_type = value_type;
+    series->head       = nullptr;
+    series->tail       = nullptr;
+    series->next       = series_head;
+    series_head        = series;
+
+    return series;
+}
+
+void TFModbusTCPHistory::feed(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, const uint16_t *register_values, micros_t timestamp)
+{
+    uint32_t end_address = static_cast<uint32_t>(start_address) + data_count;
+    int64_t ticks        = timestamp.as<int64_t>() / resolution;
+
+    for (TFModbusTCPHistorySeries *series = series_head; series != nullptr; series = series->next) {
+        if (series->data_type != data_type
+         || series->address < start_address
+         || static_cast<uint32_t>(series->address) + get_register_count(series->value_type) > end_address) {
+            continue;
+        }
+
+        const uint16_t *values = register_values + (series->address - start_address);
+        uint64_t raw_value;
+
+        switch (series->value_type) {
+        case TFModbusTCPHistoryValueType::U16:
+            raw_value = values[0];
+            break;
+
+        case TFModbusTCPHistoryValueType::S16:
+            raw_value = static_cast<uint64_t>(static_cast<int64_t>(static_cast<int16_t>(values[0])));
+            break;
+
+        case TFModbusTCPHistoryValueType::U32:
+        case TFModbusTCPHistoryValueType::Float32:
+            raw_value = (static_cast<uint32_t>(values[0]) << 16) | values[1];
+            break;
+
+        case TFModbusTCPHistoryValueType::S32:
+            raw_value = static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>((static_cast<uint32_t>(values[0]) << 16) | values[1])));
+            break;
+
+        default:
+            continue;
+        }
+
+        append_raw(series, ticks, raw_value);
+    }
+}
+
+bool TFModbusTCPHistory::append(TFModbusTCPHistorySeries *series, micros_t timestamp, double value)
+{
+    uint64_t raw_value;
+
+    if (series->value_type == TFModbusTCPHistoryValueType::Float32) {
+        float float_value = static_cast<float>(value);
+        uint32_t bits;
+
+        memcpy(&bits, &float_value, sizeof(bits));
+
+        raw_value = bits;
+    }
+    else {
+        raw_value = static_cast<uint64_t>(static_cast<int64_t>(llround(value)));
+    }
+
+    return append_raw(series, timestamp.as<int64_t>() / resolution, raw_value);
+}
+
+bool TFModbusTCPHistory::append_raw(TFModbusTCPHistorySeries *series, int64_t ticks, uint64_t raw_value)
+{
+    TFModbusTCPHistoryBlock *block = series->tail;
+
+    if (block != nullptr && ticks < block->last_ticks) {
+        return false;
+    }
+
+    if (block == nullptr || block->sample_count == UINT16_MAX || block->bit_count + MAX_SAMPLE_BIT_COUNT > BLOCK_BIT_COUNT) {
+        block = add_block(series);
+
+        block->first_ticks     = ticks;
+        block->last_ticks      = ticks;
+        block->last_delta      = 0;
+        block->first_raw_value = raw_value;
+        block->last_raw_value  = raw_value;
+        block->sample_count    = 1;
+
+        return true;
+    }
+
+    int64_t delta = ticks - block->last_ticks;
+
+    write_varying(block, delta - block->last_delta);
+
+    if (series->value_type == TFModbusTCPHistoryValueType::Float32) {
+        uint32_t xored = static_cast<uint32_t>(raw_value ^ block->last_raw_value);
+
+        if (xored == 0) {
+            write_bits(block, 0b0, 1);
+        }
+        else {
+            uint8_t leading_zeros  = static_cast<uint8_t>(__builtin_clz(xored));
+            uint8_t trailing_zeros = static_cast<uint8_t>(__builtin_ctz(xored));
+
+            if (block->leading_zeros != NO_WINDOW && leading_zeros >= block->leading_zeros && trailing_zeros >= block->trailing_zeros) {
+                // the changed bits fit into the previous window
+                write_bits(block, 0b10, 2);
+                write_bits(block, xored >> block->trailing_zeros, 32 - block->leading_zeros - block->trailing_zeros);
+            }
+            else {
+                uint8_t meaningful_bits = 32 - leading_zeros - trailing_zeros;
+
+                write_bits(block, 0b11, 2);
+                write_bits(block, leading_zeros, 5);
+                write_bits(block, meaningful_bits - 1, 5);
+                write_bits(block, xored >> trailing_zeros, meaningful_bits);
+
+                block->leading_zeros  = leading_zeros;
+                block->trailing_zeros = trailing_zeros;
+            }
+        }
+    }
+    else {
+        write_varying(block, static_cast<int64_t>(raw_value - block->last_raw_value));
+    }
+
+    block->last_ticks     = ticks;
+    block->last_delta     = delta;
+    block->last_raw_value = raw_value;
+
+    ++block->sample_count;
+
+    return true;
+}
+
+// reuses the oldest block of all series if the memory budget is used up
+TFModbusTCPHistoryBlock *TFModbusTCPHistory::add_block(TFModbusTCPHistorySeries *series)
+{
+    TFModbusTCPHistoryBlock *block;
+
+    if (block_count < max_block_count) {
+        block = new TFModbusTCPHistoryBlock;
+
+        ++block_count;
+    }
+    else {
+        block        = oldest_block;
+        oldest_block = block->next_in_history;
+
+        if (oldest_block == nullptr) {
+            newest_block = nullptr;
+        }
+
+        // blocks are allocated in order, the oldest block of all series is
+        // also the oldest block of its own series
+        TFModbusTCPHistorySeries *evicted_series = block->series;
+
+        evicted_series->head = block->next_in_series;
+
+        if (evicted_series->tail == block) {
+            evicted_series->tail = nullptr;
+        }
+
+        ++evicted_block_count;
+    }
+
+    block->next_in_series  = nullptr;
+    block->next_in_history = nullptr;
+    block->series          = series;
+    block->sample_count    = 0;
+    block->bit_count       = 0;
+    block->leading_zeros   = NO_WINDOW;
+    block->trailing_zeros  = NO_WINDOW;
+
+    memset(block->bits, 0, sizeof(block->bits));
+
+    if (series->tail != nullptr) {
+        series->tail->next_in_series = block;
+    }
+    else {
+        series->head = block;
+    }
+
+    series->tail = block;
+
+    if (newest_block != nullptr) {
+        newest_block->next_in_history = block;
+    }
+    else {
+        oldest_block = block;
+    }
+
+    newest_block = block;
+
+    return block;
+}
+
+void TFModbusTCPHistory::decode(const TFModbusTCPHistorySeries *series,
+                                const TFModbusTCPHistoryBlock *block,
+                                int64_t begin_ticks,
+                                int64_t end_ticks,
+                                const std::function<void(int64_t ticks, double value)> &callback) const
+{
+    TFModbusTCPHistoryBitReader reader = {block->bits, 0};
+    int64_t ticks                      = block->first_ticks;
+    int64_t delta                      = 0;
+    uint64_t raw_value                 = block->first_raw_value;
+    uint8_t leading_zeros              = NO_WINDOW;
+    uint8_t trailing_zeros             = NO_WINDOW;
+
+    for (uint16_t i = 0; i < block->sample_count; ++i) {
+        if (i > 0) {
+            delta += read_varying(&reader);
+            ticks += delta;
+
+            if (series->value_type == TFModbusTCPHistoryValueType::Float32) {
+                if (read_bits(&reader, 1) != 0) {
+                    if (read_bits(&reader, 1) != 0) {
+                        leading_zeros  = static_cast<uint8_t>(read_bits(&reader, 5));
+                        trailing_zeros = static_cast<uint8_t>(32 - leading_zeros - (read_bits(&reader, 5) + 1));
+                    }
+
+                    raw_value ^= read_bits(&reader, 32 - leading_zeros - trailing_zeros) << trailing_zeros;
+                }
+            }
+            else {
+                raw_value += static_cast<uint64_t>(read_varying(&reader));
+            }
+        }
+
+        if (ticks >= end_ticks) {
+            break;
+        }
+
+        if (ticks >= begin_ticks) {
+            callback(ticks, get_value(series->value_type, raw_value));
+        }
+    }
+}
+
+void TFModbusTCPHistory::query(TFModbusTCPHistorySeries *series, micros_t begin, micros_t end, TFModbusTCPHistorySampleCallback &&callback) const
+{
+    int64_t begin_ticks = (begin.as<int64_t>() + resolution - 1) / resolution;
+    int64_t end_ticks   = (end.as<int64_t>() + resolution - 1) / resolution;
+
+    for (const TFModbusTCPHistoryBlock *block = series->head; block != nullptr && block->first_ticks < end_ticks; block = block->next_in_series) {
+        if (block->last_ticks < begin_ticks) {
+            continue;
+        }
+
+        decode(series, block, begin_ticks, end_ticks, [this, &callback](int64_t ticks, double value) {
+            callback(micros_t{ticks * resolution}, value);
+        });
+    }
+}
+
+size_t TFModbusTCPHistory::downsample(TFModbusTCPHistorySeries *series,
+                                      micros_t begin,
+                                      micros_t end,
+                                      micros_t bucket_duration,
+                                      TFModbusTCPHistoryBucket *buckets,
+                                      size_t bucket_count) const
+{
+    if (bucket_duration <= 0_us || end <= begin) {
+        return 0;
+    }
+
+    int64_t duration = bucket_duration.as<int64_t>();
+    int64_t span     = (end - begin).as<int64_t>();
+
+    bucket_count = static_cast<size_t>(std::min<int64_t>(static_cast<int64_t>(bucket_count), (span + duration - 1) / duration));
+
+    for (size_t i = 0; i < bucket_count; ++i) {
+        buckets[i].timestamp = begin + micros_t{static_cast<int64_t>(i) * duration};
+        buckets[i].count     = 0;
+        buckets[i].min       = 0;
+        buckets[i].max       = 0;
+        buckets[i].average   = 0;
+    }
+
+    query(series, begin, end, [begin, duration, buckets, bucket_count](micros_t timestamp, double value) {
+        size_t i = static_cast<size_t>((timestamp - begin).as<int64_t>() / duration);
+
+        if (i >= bucket_count) {
+            return;
+        }
+
+        TFModbusTCPHistoryBucket *bucket = &buckets[i];
+
+        if (bucket->count == 0 || value < bucket->min) {
+            bucket->min = value;
+        }
+
+        if (bucket->count == 0 || value > bucket->max) {
+            bucket->max = value;
+        }
+
+        bucket->average += value; // sum until all samples are seen
+
+        ++bucket->count;
+    });
+
+    for (size_t i = 0; i < bucket_count; ++i) {
+        if (buckets[i].count > 0) {
+            buckets[i].average /= static_cast<double>(buckets[i].count);
+        }
+    }
+
+    return bucket_count;
+}
+
+size_t TFModbusTCPHistory::get_sample_count(TFModbusTCPHistorySeries *series) const
+{
+    size_t sample_count = 0;
+
+    for (const TFModbusTCPHistoryBlock *block = series->head; block != nullptr; block = block->next_in_series) {
+        sample_count += block->sample_count;
+    }
+
+    return sample_count;
+}
+
+size_t TFModbusTCPHistory::get_memory_usage() const
+{
+    size_t series_count = 0;
+
+    for (const TFModbusTCPHistorySeries *series = series_head; series != nullptr; series = series->next) {
+        ++series_count;
+    }
+
+    return block_count * sizeof(TFModbusTCPHistoryBlock) + series_count * sizeof(TFModbusTCPHistorySeries);
+}
@@ -0,0 +1,123 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <TFTools/Micros.h>
+
+#include "TFModbusTCPRegisterBank.h"
+
+// configuration
+#ifndef TF_MODBUS_TCP_HISTORY_BLOCK_BYTE_COUNT
+#define TF_MODBUS_TCP_HISTORY_BLOCK_BYTE_COUNT 256
+#endif
+
+enum class TFModbusTCPHistoryValueType : uint8_t
+{
+    U16,
+    S16,
+    U32,     // two registers, high word first
+    S32,     // two registers, high word first
+    Float32, // two registers, high word first
+};
+
+const char *get_tf_modbus_tcp_history_value_type_name(TFModbusTCPHistoryValueType value_type);
+
+struct TFModbusTCPHistoryBucket
+{
+    micros_t timestamp; // start of the bucket
+    size_t count;       // 0 if the bucket has no samples, then the values are 0
+    double min;
+    double max;
+    double average;
+};
+
+struct TFModbusTCPHistorySeries;
+struct TFModbusTCPHistoryBlock;
+
+typedef std::function<void(micros_t timestamp, double value)> TFModbusTCPHistorySampleCallback;
+
+// Compressed in-memory history of register values. Timestamps are quantized to
+// the configured resolution and stored as delta-of-delta, integer values as
+// delta to the previous value and float values as XOR to the previous value.
+// Both use variable length bit codes, so that a steady poll interval and an
+// unchanged value take one bit each. The bit streams are kept in fixed-size
+// blocks. If the memory budget is used up then the oldest block of all series
+// is reused, so the history always covers the most recent samples. A 1 Hz
+// U32 energy counter that changes in 10% of the samples takes about 2.6 bits
+// per sample in the bit streams, or about 36 kB of memory per day including
+// the block headers.
+//
+// Register values are expected in host byte order, like the register bank.
+// feed() can be called with every successful poll, e.g. by TFModbusTCPMirror
+class TFModbusTCPHistory final
+{
+public:
+    TFModbusTCPHistory(size_t memory_budget, micros_t resolution = 100_ms);
+    ~TFModbusTCPHistory();
+
+    TFModbusTCPHistory(TFModbusTCPHistory const &other) = delete;
+    TFModbusTCPHistory &operator=(TFModbusTCPHistory const &other) = delete;
+
+    // only input and holding registers
+    TFModbusTCPHistorySeries *add_series(TFModbusTCPDataType data_type, uint16_t address, TFModbusTCPHistoryValueType value_type);
+
+    // samples older than the newest sample of a series are dropped
+    void feed(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, const uint16_t *register_values, micros_t timestamp);
+    bool append(TFModbusTCPHistorySeries *series, micros_t timestamp, double value);
+
+    // samples in [begin, end), in timestamp order
+    void query(TFModbusTCPHistorySeries *series, micros_t begin, micros_t end, TFModbusTCPHistorySampleCallback &&callback) const;
+
+    // one bucket per bucket duration in [begin, end), returns the number of
+    // filled buckets, which is limited by the bucket count
+    size_t downsample(TFModbusTCPHistorySeries *series,
+                      micros_t begin,
+                      micros_t end,
+                      micros_t bucket_duration,
+                      TFModbusTCPHistoryBucket *buckets,
+                      size_t bucket_count) const;
+
+    size_t get_sample_count(TFModbusTCPHistorySeries *series) const;
+    size_t get_block_count() const { return block_count; }
+    size_t get_max_block_count() const { return max_block_count; }
+    size_t get_memory_usage() const;
+    size_t get_evicted_block_count() const { return evicted_block_count; }
+
+private:
+    bool append_raw(TFModbusTCPHistorySeries *series, int64_t ticks, uint64_t raw_value);
+    TFModbusTCPHistoryBlock *add_block(TFModbusTCPHistorySeries *series);
+    void decode(const TFModbusTCPHistorySeries *series,
+                const TFModbusTCPHistoryBlock *block,
+                int64_t begin_ticks,
+                int64_t end_ticks,
+                const std::function<void(int64_t ticks, double value)> &callback) const;
+
+    int64_t resolution;
+    size_t max_block_count;
+    size_t block_count                    = 0;
+    size_t evicted_block_count            = 0;
+    TFModbusTCPHistorySeries *series_head = nullptr;
+    TFModbusTCPHistoryBlock *oldest_block = nullptr; // blocks of all series in allocation order
+    TFModbusTCPHistoryBlock *newest_block = nullptr;
+};
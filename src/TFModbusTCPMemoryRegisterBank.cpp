@@ -0,0 +1,725 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include "TFModbusTCPMemoryRegisterBank.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "TFNetwork.h"
+
+#define debugfln(fmt, ...) tf_network_debugfln("TFModbusTCPMemoryRegisterBank[%p]::" fmt, static_cast<void *>(this) __VA_OPT__(,) __VA_ARGS__)
+
+// Image:   magic "TFRB", version, coil count, holding register count, coils,
+//          holding registers, CRC32
+// Journal: sequence of records of data type, start address, data count,
+//          values, CRC32
+// All multi-byte fields are stored big endian, coils as packed bits
+#define IMAGE_MAGIC "TFRB"
+#define IMAGE_VERSION 1
+#define MAX_RECORD_DATA_COUNT 128u // bounds the replay buffer
+
+static uint32_t update_crc32(uint32_t crc, const uint8_t *data, size_t length)
+{
+    for (size_t i = 0; i < length; ++i) {
+        crc ^= data[i];
+
+        for (int k = 0; k < 8; ++k) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+
+    return crc;
+}
+
+struct TFModbusTCPMemoryRegisterBankFile
+{
+    FILE *file;
+    uint32_t crc;
+    size_t length;
+    bool failed;
+
+    TFModbusTCPMemoryRegisterBankFile(FILE *file_) : file(file_), crc(0xFFFFFFFFu), length(0), failed(false) {}
+
+    void begin()
+    {
+        crc = 0xFFFFFFFFu;
+    }
+
+    void put(const void *data, size_t data_length)
+    {
+        if (failed) {
+            return;
+        }
+
+        if (fwrite(data, 1, data_length, file) != data_length) {
+            failed = true;
+            return;
+        }
+
+        crc     = update_crc32(crc, static_cast<const uint8_t *>(data), data_length);
+        length += data_length;
+    }
+
+    void put_uint16(uint16_t value)
+    {
+        uint8_t bytes[2] = {static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value)};
+
+        put(bytes, sizeof(bytes));
+    }
+
+    void put_registers(const uint16_t *values, size_t count)
+    {
+        uint8_t bytes[64];
+
+        while (count > 0) {
+            size_t chunk = count < sizeof(bytes) / 2 ? count : sizeof(bytes) / 2;
+
+            for (size_t i = 0; i < chunk; ++i) {
+                bytes[i * 2]     = static_cast<uint8_t>(values[i] >> 8);
+                bytes[i * 2 + 1] = static_cast<uint8_t>(values[i]);
+            }
+
+            put(bytes, chunk * 2);
+
+            values += chunk;
+            count  -= chunk;
+        }
+    }
+
+    void end()
+    {
+        uint32_t final_crc = ~crc;
+        uint8_t bytes[4]   = {static_cast<uint8_t>(final_crc >> 24), static_cast<uint8_t>(final_crc >> 16),
+                              static_cast<uint8_t>(final_crc >> 8), static_cast<uint8_t>(final_crc)};
+
+        put(bytes, sizeof(bytes));
+    }
+
+    bool get(void *data, size_t data_length)
+    {
+        if (failed || fread(data, 1, data_length, file) != data_length) {
+            failed = true;
+            return false;
+        }
+
+        crc     = update_crc32(crc, static_cast<uint8_t *>(data), data_length);
+        length += data_length;
+
+        return true;
+    }
+
+    bool get_uint16(uint16_t *value)
+    {
+        uint8_t bytes[2];
+
+        if (!get(bytes, sizeof(bytes))) {
+            return false;
+        }
+
+        *value = static_cast<uint16_t>((bytes[0] << 8) | bytes[1]);
+        return true;
+    }
+
+    bool get_registers(uint16_t *values, size_t count)
+    {
+        uint8_t bytes[64];
+
+        while (count > 0) {
+            size_t chunk = count < sizeof(bytes) / 2 ? count : sizeof(bytes) / 2;
+
+            if (!get(bytes, chunk * 2)) {
+                return false;
+            }
+
+            for (size_t i = 0; i < chunk; ++i) {
+                values[i] = static_cast<uint16_t>((bytes[i * 2] << 8) | bytes[i * 2 + 1]);
+            }
+
+            values += chunk;
+            count  -= chunk;
+        }
+
+        return true;
+    }
+
+    bool check_end()
+    {
+        uint32_t expected_crc = ~crc;
+        uint8_t bytes[4];
+
+        if (!get(bytes, sizeof(bytes))) {
+            return false;
+        }
+
+        uint32_t actual_crc = (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16)
+                            | (static_cast<uint32_t>(bytes[2]) << 8) | bytes[3];
+
+        return actual_crc == expected_crc;
+    }
+};
+
+static bool sync_file(FILE *file)
+{
+    return fflush(file) == 0 && fsync(fileno(file)) == 0;
+}
+
+// A rename() is only durable once the directory entry itself is on disk.
+// Filesystems that cannot sync a directory report EINVAL and are accepted
+static bool sync_parent_directory(const char *path)
+{
+    const char *slash = strrchr(path, '/');
+    char *directory_path;
+
+    if (slash == nullptr) {
+        directory_path = new char[2];
+
+        memcpy(directory_path, ".", 2);
+    }
+    else {
+        size_t directory_path_length = slash == path ? 1 : static_cast<size_t>(slash - path);
+
+        directory_path = new char[directory_path_length + 1];
+
+        memcpy(directory_path, path, directory_path_length);
+        directory_path[directory_path_length] = '\0';
+    }
+
+    int fd = open(directory_path, O_RDONLY);
+
+    delete[] directory_path;
+
+    if (fd < 0) {
+        return false;
+    }
+
+    bool success = fsync(fd) == 0 || errno == EINVAL;
+
+    close(fd);
+
+    return success;
+}
+
+static char *concat_path(const char *path, const char *suffix)
+{
+    size_t path_length   = strlen(path);
+    size_t suffix_length = strlen(suffix);
+    char *result         = new char[path_length + suffix_length + 1];
+
+    memcpy(result, path, path_length);
+    memcpy(result + path_length, suffix, suffix_length + 1);
+
+    return result;
+}
+
+TFModbusTCPMemoryRegisterBank::TFModbusTCPMemoryRegisterBank(uint16_t coil_count_, uint16_t discrete_input_count_, uint16_t input_register_count_, uint16_t holding_register_count_) :
+    coil_count(coil_count_),
+    discrete_input_count(discrete_input_count_),
+    input_register_count(input_register_count_),
+    holding_register_count(holding_register_count_)
+{
+    coils             = new uint8_t[(coil_count + 7) / 8]();
+    discrete_inputs   = new uint8_t[(discrete_input_count + 7) / 8]();
+    input_registers   = new uint16_t[input_register_count]();
+    holding_registers = new uint16_t[holding_register_count]();
+}
+
+TFModbusTCPMemoryRegisterBank::~TFModbusTCPMemoryRegisterBank()
+{
+    delete[] coils;
+    delete[] discrete_inputs;
+    delete[] input_registers;
+    delete[] holding_registers;
+    delete[] image_path;
+    delete[] journal_path;
+    delete[] dirty_coils;
+    delete[] dirty_holding_registers;
+}
+
+uint8_t *TFModbusTCPMemoryRegisterBank::get_bits(TFModbusTCPDataType data_type, uint16_t *count)
+{
+    switch (data_type) {
+    case TFModbusTCPDataType::Coil:
+        *count = coil_count;
+        return coils;
+
+    case TFModbusTCPDataType::DiscreteInput:
+        *count = discrete_input_count;
+        return discrete_inputs;
+
+    default:
+        *count = 0;
+        return nullptr;
+    }
+}
+
+uint16_t *TFModbusTCPMemoryRegisterBank::get_registers(TFModbusTCPDataType data_type, uint16_t *count)
+{
+    switch (data_type) {
+    case TFModbusTCPDataType::InputRegister:
+        *count = input_register_count;
+        return input_registers;
+
+    case TFModbusTCPDataType::HoldingRegister:
+        *count = holding_register_count;
+        return holding_registers;
+
+    default:
+        *count = 0;
+        return nullptr;
+    }
+}
+
+TFModbusTCPExceptionCode TFModbusTCPMemoryRegisterBank::read(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, void *data_values)
+{
+    uint16_t count;
+    uint8_t *bits = get_bits(data_type, &count);
+
+    if (bits != nullptr) {
+        if (static_cast<uint32_t>(start_address) + data_count > count) {
+            return TFModbusTCPExceptionCode::IllegalDataAddress;
+        }
+
+        copy_bits(static_cast<uint8_t *>(data_values), 0, bits, start_address, data_count);
+        return TFModbusTCPExceptionCode::Success;
+    }
+
+    uint16_t *registers = get_registers(data_type, &count);
+
+    if (static_cast<uint32_t>(start_address) + data_count > count) {
+        return TFModbusTCPExceptionCode::IllegalDataAddress;
+    }
+
+    memcpy(data_values, registers + start_address, data_count * sizeof(uint16_t));
+    return TFModbusTCPExceptionCode::Success;
+}
+
+TFModbusTCPExceptionCode TFModbusTCPMemoryRegisterBank::write(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, const void *data_values)
+{
+    uint16_t count;
+    uint8_t *bits = get_bits(data_type, &count);
+
+    if (bits != nullptr) {
+        if (static_cast<uint32_t>(start_address) + data_count > count) {
+            return TFModbusTCPExceptionCode::IllegalDataAddress;
+        }
+
+        copy_bits(bits, start_address, static_cast<const uint8_t *>(data_values), 0, data_count);
+
+        if (data_type == TFModbusTCPDataType::Coil && dirty_coils != nullptr) {
+            mark_dirty(dirty_coils, start_address, data_count);
+        }
+
+        return TFModbusTCPExceptionCode::Success;
+    }
+
+    uint16_t *registers = get_registers(data_type, &count);
+
+    if (static_cast<uint32_t>(start_address) + data_count > count) {
+        return TFModbusTCPExceptionCode::IllegalDataAddress;
+    }
+
+    memcpy(registers + start_address, data_values, data_count * sizeof(uint16_t));
+
+    if (data_type == TFModbusTCPDataType::HoldingRegister && dirty_holding_registers != nullptr) {
+        mark_dirty(dirty_holding_registers, start_address, data_count);
+    }
+
+    return TFModbusTCPExceptionCode::Success;
+}
+
+void TFModbusTCPMemoryRegisterBank::mark_dirty(uint32_t *dirty_bits, uint16_t start_address, uint16_t data_count)
+{
+    if (dirty_count == 0) {
+        dirty_since = now_us();
+    }
+
+    for (uint32_t address = start_address; address < static_cast<uint32_t>(start_address) + data_count; ++address) {
+        uint32_t mask = 1u << (address % 32);
+
+        if ((dirty_bits[address / 32] & mask) == 0) {
+            dirty_bits[address / 32] |= mask;
+            ++dirty_count;
+        }
+    }
+}
+
+bool TFModbusTCPMemoryRegisterBank::enable_persistence(const char *path, micros_t flush_interval_)
+{
+    if (path == nullptr || strlen(path) == 0 || flush_interval_ < 0_s) {
+        debugfln("enable_persistence(path=%s) invalid argument", path != nullptr ? path : "<nullptr>");
+
+        return false;
+    }
+
+    if (image_path != nullptr) {
+        debugfln("enable_persistence(path=%s) already enabled", path);
+        return false;
+    }
+
+    image_path              = concat_path(path, "");
+    journal_path            = concat_path(path, ".journal");
+    flush_interval          = flush_interval_;
+    dirty_coils             = new uint32_t[(coil_count + 31) / 32]();
+    dirty_holding_registers = new uint32_t[(holding_register_count + 31) / 32]();
+
+    return true;
+}
+
+bool TFModbusTCPMemoryRegisterBank::load()
+{
+    if (image_path == nullptr) {
+        return false;
+    }
+
+    if (!read_image()) {
+        return false;
+    }
+
+    if (!replay_journal()) {
+        // Appending after a torn record would hide every later record
+        // from the next replay, rewrite the image and start over instead
+        return compact();
+    }
+
+    return true;
+}
+
+void TFModbusTCPMemoryRegisterBank::tick()
+{
+    if (dirty_count > 0 && deadline_elapsed(dirty_since + flush_interval)) {
+        if (!flush()) {
+            dirty_since = now_us(); // retry after another flush interval
+        }
+    }
+}
+
+bool TFModbusTCPMemoryRegisterBank::flush()
+{
+    if (image_path == nullptr) {
+        return false;
+    }
+
+    if (dirty_count == 0) {
+        return true;
+    }
+
+    if (image_length == 0) {
+        return compact();
+    }
+
+    FILE *file = fopen(journal_path, "ab");
+
+    if (file == nullptr) {
+        debugfln("flush() could not open journal (journal_path=%s errno=%d)", journal_path, errno);
+        return false;
+    }
+
+    TFModbusTCPMemoryRegisterBankFile journal(file);
+
+    bool success = append_dirty_ranges(&journal, TFModbusTCPDataType::Coil, dirty_coils, coil_count)
+                && append_dirty_ranges(&journal, TFModbusTCPDataType::HoldingRegister, dirty_holding_registers, holding_register_count)
+                && sync_file(file);
+
+    fclose(file);
+
+    if (!success) {
+        debugfln("flush() could not append to journal (journal_path=%s)", journal_path);
+        return false;
+    }
+
+    journal_length += journal.length;
+
+    memset(dirty_coils, 0, ((coil_count + 31) / 32) * sizeof(uint32_t));
+    memset(dirty_holding_registers, 0, ((holding_register_count + 31) / 32) * sizeof(uint32_t));
+    dirty_count = 0;
+
+    if (journal_length > image_length && journal_length > TF_MODBUS_TCP_MEMORY_REGISTER_BANK_MIN_JOURNAL_LENGTH) {
+        return compact();
+    }
+
+    return true;
+}
+
+bool TFModbusTCPMemoryRegisterBank::append_dirty_ranges(TFModbusTCPMemoryRegisterBankFile *journal, TFModbusTCPDataType data_type, const uint32_t *dirty_bits, uint16_t count)
+{
+    uint32_t address = 0;
+
+    while (address < count) {
+        if ((dirty_bits[address / 32] & (1u << (address % 32))) == 0) {
+            // skip clean words at once
+            address = (dirty_bits[address / 32] >> (address % 32)) == 0 ? (address / 32 + 1) * 32 : address + 1;
+            continue;
+        }
+
+        uint32_t start_address = address;
+
+        while (address < count
+            && address - start_address < MAX_RECORD_DATA_COUNT
+            && (dirty_bits[address / 32] & (1u << (address % 32))) != 0) {
+            ++address;
+        }
+
+        uint16_t data_count = static_cast<uint16_t>(address - start_address);
+
+        journal->begin();
+        journal->put(&data_type, 1);
+        journal->put_uint16(static_cast<uint16_t>(start_address));
+        journal->put_uint16(data_count);
+
+        if (data_type == TFModbusTCPDataType::Coil) {
+            uint8_t data_bytes[MAX_RECORD_DATA_COUNT / 8] = {};
+
+            copy_bits(data_bytes, 0, coils, start_address, data_count);
+            journal->put(data_bytes, (data_count + 7u) / 8u);
+        }
+        else {
+            journal->put_registers(holding_registers + start_address, data_count);
+        }
+
+        journal->end();
+
+        if (journal->failed) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool TFModbusTCPMemoryRegisterBank::compact()
+{
+    if (image_path == nullptr) {
+        return false;
+    }
+
+    if (!write_image()) {
+        return false;
+    }
+
+    // The image now contains every value, a crash before truncating the
+    // journal only replays values that are already in the image
+    FILE *file = fopen(journal_path, "wb");
+
+    if (file == nullptr) {
+        debugfln("compact() could not truncate journal (journal_path=%s errno=%d)", journal_path, errno);
+        return false;
+    }
+
+    bool success = sync_file(file);
+
+    fclose(file);
+
+    if (!success) {
+        return false;
+    }
+
+    journal_length = 0;
+
+    memset(dirty_coils, 0, ((coil_count + 31) / 32) * sizeof(uint32_t));
+    memset(dirty_holding_registers, 0, ((holding_register_count + 31) / 32) * sizeof(uint32_t));
+    dirty_count = 0;
+
+    return true;
+}
+
+bool TFModbusTCPMemoryRegisterBank::write_image()
+{
+    char *temporary_path = concat_path(image_path, ".tmp");
+    FILE *file           = fopen(temporary_path, "wb");
+
+    if (file == nullptr) {
+        debugfln("write_image() could not open image (temporary_path=%s errno=%d)", temporary_path, errno);
+        delete[] temporary_path;
+        return false;
+    }
+
+    TFModbusTCPMemoryRegisterBankFile image(file);
+    uint8_t version = IMAGE_VERSION;
+
+    image.put(IMAGE_MAGIC, 4);
+    image.put(&version, 1);
+    image.put_uint16(coil_count);
+    image.put_uint16(holding_register_count);
+    image.put(coils, (coil_count + 7) / 8);
+    image.put_registers(holding_registers, holding_register_count);
+    image.end();
+
+    bool success = !image.failed && sync_file(file);
+
+    fclose(file);
+
+    // rename() replaces the old image atomically, so there is always one
+    // complete image on disk
+    if (!success || rename(temporary_path, image_path) < 0) {
+        debugfln("write_image() could not write image (image_path=%s errno=%d)", image_path, errno);
+        remove(temporary_path);
+        delete[] temporary_path;
+        return false;
+    }
+
+    delete[] temporary_path;
+
+    // The journal is truncated next, which must not reach the disk before
+    // the new image does
+    if (!sync_parent_directory(image_path)) {
+        debugfln("write_image() could not sync image directory (image_path=%s errno=%d)", image_path, errno);
+        return false;
+    }
+
+    image_length = image.length;
+
+    return true;
+}
+
+bool TFModbusTCPMemoryRegisterBank::read_image()
+{
+    FILE *file = fopen(image_path, "rb");
+
+    if (file == nullptr) {
+        if (errno == ENOENT) {
+            image_length = 0; // first start, keep the initial values
+            return true;
+        }
+
+        debugfln("read_image() could not open image (image_path=%s errno=%d)", image_path, errno);
+        return false;
+    }
+
+    TFModbusTCPMemoryRegisterBankFile image(file);
+    char magic[4];
+    uint8_t version;
+    uint16_t image_coil_count;
+    uint16_t image_holding_register_count;
+    bool success = false;
+
+    if (image.get(magic, sizeof(magic))
+     && memcmp(magic, IMAGE_MAGIC, sizeof(magic)) == 0
+     && image.get(&version, 1)
+     && version == IMAGE_VERSION
+     && image.get_uint16(&image_coil_count)
+     && image.get_uint16(&image_holding_register_count)
+     && image_coil_count == coil_count
+     && image_holding_register_count == holding_register_count) {
+        // read into scratch buffers, a corrupt image must not clobber the
+        // initial values
+        uint8_t *image_coils              = new uint8_t[(coil_count + 7) / 8];
+        uint16_t *image_holding_registers = new uint16_t[holding_register_count];
+
+        if (image.get(image_coils, (coil_count + 7) / 8)
+         && image.get_registers(image_holding_registers, holding_register_count)
+         && image.check_end()) {
+            memcpy(coils, image_coils, (coil_count + 7) / 8);
+            memcpy(holding_registers, image_holding_registers, holding_register_count * sizeof(uint16_t));
+            success = true;
+        }
+
+        delete[] image_coils;
+        delete[] image_holding_registers;
+    }
+
+    fclose(file);
+
+    if (!success) {
+        debugfln("read_image() image is invalid (image_path=%s)", image_path);
+        return false;
+    }
+
+    image_length = image.length;
+
+    return true;
+}
+
+bool TFModbusTCPMemoryRegisterBank::replay_journal()
+{
+    FILE *file = fopen(journal_path, "rb");
+
+    journal_length = 0;
+
+    if (file == nullptr) {
+        return errno == ENOENT;
+    }
+
+    TFModbusTCPMemoryRegisterBankFile journal(file);
+    bool complete = false;
+
+    while (true) {
+        uint8_t data_type;
+        uint16_t start_address;
+        uint16_t data_count;
+        uint16_t count;
+        size_t data_length;
+        uint8_t data_bytes[MAX_RECORD_DATA_COUNT * 2];
+
+        journal.begin();
+
+        if (!journal.get(&data_type, 1)) {
+            complete = feof(file) != 0; // clean end between two records
+            break;
+        }
+
+        if (!journal.get_uint16(&start_address)
+         || !journal.get_uint16(&data_count)
+         || data_count == 0
+         || data_count > MAX_RECORD_DATA_COUNT) {
+            break;
+        }
+
+        if (data_type == static_cast<uint8_t>(TFModbusTCPDataType::Coil)) {
+            count       = coil_count;
+            data_length = (data_count + 7u) / 8u;
+        }
+        else if (data_type == static_cast<uint8_t>(TFModbusTCPDataType::HoldingRegister)) {
+            count       = holding_register_count;
+            data_length = data_count * 2u;
+        }
+        else {
+            break;
+        }
+
+        // only apply a record after its CRC has been checked
+        if (static_cast<uint32_t>(start_address) + data_count > count
+         || !journal.get(data_bytes, data_length)
+         || !journal.check_end()) {
+            break;
+        }
+
+        if (data_type == static_cast<uint8_t>(TFModbusTCPDataType::Coil)) {
+            copy_bits(coils, start_address, data_bytes, 0, data_count);
+        }
+        else {
+            for (size_t i = 0; i < data_count; ++i) {
+                holding_registers[start_address + i] = static_cast<uint16_t>((data_bytes[i * 2] << 8) | data_bytes[i * 2 + 1]);
+            }
+        }
+
+        journal_length = journal.length;
+    }
+
+    fclose(file);
+
+    if (!complete) {
+        debugfln("replay_journal() journal is torn or corrupt (journal_path=%s journal_length=%zu)", journal_path, journal_length);
+    }
+
+    return complete;
+}
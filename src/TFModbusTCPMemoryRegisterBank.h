@@ -0,0 +1,93 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <TFTools/Micros.h>
+
+#include "TFModbusTCPRegisterBank.h"
+
+struct TFModbusTCPMemoryRegisterBankFile;
+
+// configuration
+#ifndef TF_MODBUS_TCP_MEMORY_REGISTER_BANK_MIN_JOURNAL_LENGTH
+#define TF_MODBUS_TCP_MEMORY_REGISTER_BANK_MIN_JOURNAL_LENGTH 4096
+#endif
+
+// Register bank that keeps all four tables in RAM, starting at address 0.
+//
+// Coils and holding registers can optionally be persisted. Writes only mark
+// the touched values as dirty, tick() then appends the dirty ranges to a
+// journal file once per flush interval, so a burst of writes costs one batch
+// of flash or disk writes instead of one per request. Once the journal grows
+// larger than the image, or TF_MODBUS_TCP_MEMORY_REGISTER_BANK_MIN_JOURNAL_LENGTH
+// whichever is larger, it is compacted into a new image that atomically
+// replaces the old one. load() restores the image and replays the journal up
+// to the first torn or corrupt record. Call flush() before shutting down
+class TFModbusTCPMemoryRegisterBank final : public TFModbusTCPRegisterBank
+{
+public:
+    TFModbusTCPMemoryRegisterBank(uint16_t coil_count_, uint16_t discrete_input_count_, uint16_t input_register_count_, uint16_t holding_register_count_);
+    ~TFModbusTCPMemoryRegisterBank();
+
+    TFModbusTCPExceptionCode read(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, void *data_values) override;
+    TFModbusTCPExceptionCode write(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, const void *data_values) override;
+
+    // The image is stored at path, the journal at path + ".journal". Both
+    // strings are copied. A flush interval of 0 flushes on every tick()
+    bool enable_persistence(const char *path, micros_t flush_interval);
+    bool load(); // non-reentrant, call before serving requests
+    void tick(); // non-reentrant
+    bool flush(); // non-reentrant
+    bool compact(); // non-reentrant
+    bool is_dirty() const { return dirty_count > 0; }
+    size_t get_journal_length() const { return journal_length; }
+
+private:
+    uint8_t *get_bits(TFModbusTCPDataType data_type, uint16_t *count);
+    uint16_t *get_registers(TFModbusTCPDataType data_type, uint16_t *count);
+    void mark_dirty(uint32_t *dirty_bits, uint16_t start_address, uint16_t data_count);
+    bool append_dirty_ranges(TFModbusTCPMemoryRegisterBankFile *journal, TFModbusTCPDataType data_type, const uint32_t *dirty_bits, uint16_t count);
+    bool write_image();
+    bool read_image();
+    bool replay_journal();
+
+    uint16_t coil_count;
+    uint16_t discrete_input_count;
+    uint16_t input_register_count;
+    uint16_t holding_register_count;
+    uint8_t *coils                    = nullptr;
+    uint8_t *discrete_inputs          = nullptr;
+    uint16_t *input_registers         = nullptr;
+    uint16_t *holding_registers       = nullptr;
+
+    char *image_path                  = nullptr;
+    char *journal_path                = nullptr;
+    micros_t flush_interval           = 0_s;
+    micros_t dirty_since              = 0_s;
+    uint32_t *dirty_coils             = nullptr;
+    uint32_t *dirty_holding_registers = nullptr;
+    size_t dirty_count                = 0;
+    size_t image_length               = 0;
+    size_t journal_length             = 0;
+};
@@ -0,0 +1,490 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include "TFModbusTCPMirror.h"
+
+#include <string.h>
+
+#include "TFNetwork.h"
+
+#define debugfln(fmt, ...) tf_network_debugfln("TFModbusTCPMirror[%p]::" fmt, static_cast<void *>(this) __VA_OPT__(,) __VA_ARGS__)
+
+struct TFModbusTCPMirrorBlock
+{
+    TFModbusTCPMirrorBlock *next;
+    TFModbusTCPDataType data_type;
+    uint16_t start_address;
+    uint16_t data_count;
+    micros_t poll_interval;
+    micros_t next_poll;
+    micros_t last_update;
+    bool updated;   // polled successfully at least once
+    bool in_flight;
+    void *values;   // packed bits or registers, as passed to the register bank
+    uint8_t *hole_mask;      // one bit per value, set for addresses the remote device rejected
+    uint8_t *poll_hole_mask; // hole mask of the poll in flight, copied on success
+};
+
+struct TFModbusTCPMirrorWrite
+{
+    TFModbusTCPMirrorWrite *next;
+    uint32_t request_id;
+    TFModbusTCPFunctionCode function_code;
+    uint16_t start_address;
+    uint16_t data_count;
+    bool finished;
+    TFModbusTCPExceptionCode exception_code;
+
+    union {
+        uint8_t coil_values[TF_MODBUS_TCP_MAX_WRITE_COIL_BYTE_COUNT];
+        uint16_t register_values[TF_MODBUS_TCP_MAX_WRITE_REGISTER_COUNT];
+    };
+};
+
+static TFModbusTCPFunctionCode get_read_function_code(TFModbusTCPDataType data_type)
+{
+    switch (data_type) {
+    case TFModbusTCPDataType::Coil:
+        return TFModbusTCPFunctionCode::ReadCoils;
+
+    case TFModbusTCPDataType::DiscreteInput:
+        return TFModbusTCPFunctionCode::ReadDiscreteInputs;
+
+    case TFModbusTCPDataType::InputRegister:
+        return TFModbusTCPFunctionCode::ReadInputRegisters;
+
+    case TFModbusTCPDataType::HoldingRegister:
+        return TFModbusTCPFunctionCode::ReadHoldingRegisters;
+    }
+
+    return TFModbusTCPFunctionCode::ReadHoldingRegisters;
+}
+
+static bool is_bit_type(TFModbusTCPDataType data_type)
+{
+    return data_type == TFModbusTCPDataType::Coil || data_type == TFModbusTCPDataType::DiscreteInput;
+}
+
+static bool is_hole(const uint8_t *hole_mask, uint16_t offset)
+{
+    return (hole_mask[offset / 8] & (1u << (offset % 8))) != 0;
+}
+
+TFModbusTCPMirror::~TFModbusTCPMirror()
+{
+    stop();
+
+    while (block_head != nullptr) {
+        TFModbusTCPMirrorBlock *block = block_head;
+
+        block_head = block->next;
+
+        if (is_bit_type(block->data_type)) {
+            delete[] static_cast<uint8_t *>(block->values);
+        }
+        else {
+            delete[] static_cast<uint16_t *>(block->values);
+        }
+
+        delete[] block->hole_mask;
+        delete[] block->poll_hole_mask;
+        delete block;
+    }
+}
+
+bool TFModbusTCPMirror::add_block(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, micros_t poll_interval)
+{
+    if (data_count == 0 || static_cast<uint32_t>(start_address) + data_count > 65536u || poll_interval <= 0_s) {
+        debugfln("add_block(data_type=%s start_address=%u data_count=%u) invalid argument",
+                 get_tf_modbus_tcp_data_type_name(data_type), start_address, data_count);
+        return false;
+    }
+
+    if (host != nullptr) {
+        debugfln("add_block(data_type=%s start_address=%u data_count=%u) already started",
+                 get_tf_modbus_tcp_data_type_name(data_type), start_address, data_count);
+        return false;
+    }
+
+    TFModbusTCPMirrorBlock *block = new TFModbusTCPMirrorBlock;
+
+    block->data_type     = data_type;
+    block->start_address = start_address;
+    block->data_count    = data_count;
+    block->poll_interval = poll_interval;
+    block->next_poll     = 0_s;
+    block->last_update   = 0_s;
+    block->updated       = false;
+    block->in_flight     = false;
+
+    if (is_bit_type(data_type)) {
+        block->values = new uint8_t[(data_count + 7u) / 8u];
+    }
+    else {
+        block->values = new uint16_t[data_count];
+    }
+
+    block->hole_mask      = new uint8_t[(data_count + 7u) / 8u];
+    block->poll_hole_mask = new uint8_t[(data_count + 7u) / 8u];
+
+    memset(block->hole_mask, 0, (data_count + 7u) / 8u);
+
+    block->next = block_head;
+    block_head  = block;
+
+    return true;
+}
+
+bool TFModbusTCPMirror::start(const char *host, uint16_t port, uint8_t unit_id, micros_t timeout /*= 2_s*/)
+{
+    if (host == nullptr || strlen(host) == 0 || port == 0) {
+        debugfln("start(host=%s port=%u unit_id=%u) invalid argument", TFNetwork::printf_safe(host), port, unit_id);
+        return false;
+    }
+
+    if (this->host != nullptr) {
+        debugfln("start(host=%s port=%u unit_id=%u) already started", TFNetwork::printf_safe(host), port, unit_id);
+        return false;
+    }
+
+    debugfln("start(host=%s port=%u unit_id=%u)", host, port, unit_id);
+
+    this->host    = strdup(host);
+    this->port    = port;
+    this->unit_id = unit_id;
+    this->timeout = timeout;
+
+    for (TFModbusTCPMirrorBlock *block = block_head; block != nullptr; block = block->next) {
+        block->next_poll = 0_s;
+        block->updated   = false;
+    }
+
+    return true;
+}
+
+// Pending server writes are answered with a Gateway Path Unavailable exception.
+// The register bank keeps the last polled values
+void TFModbusTCPMirror::stop()
+{
+    if (host == nullptr) {
+        return;
+    }
+
+    debugfln("stop()");
+
+    free(host);
+    host = nullptr;
+
+    if (shared_client != nullptr) {
+        TFModbusTCPSharedClient *released = shared_client;
+
+        shared_client = nullptr;
+
+        // force the disconnect, so that all polls and writes in flight are
+        // finished as aborted before the mirror can be destroyed
+        pool->release(released, true);
+    }
+
+    for (TFModbusTCPMirrorWrite *write = write_head; write != nullptr; write = write->next) {
+        if (!write->finished) {
+            write->finished       = true;
+            write->exception_code = TFModbusTCPExceptionCode::GatewayPathUnvailable;
+        }
+    }
+
+    finish_writes();
+}
+
+void TFModbusTCPMirror::tick()
+{
+    if (host == nullptr) {
+        return;
+    }
+
+    if (shared_client == nullptr && !acquiring) {
+        acquiring = true;
+
+        pool->acquire(host, port,
+        [this](TFGenericTCPClientConnectResult result, int error_number, TFGenericTCPSharedClient *client, TFGenericTCPClientPoolShareLevel share_level) {
+            (void)error_number;
+            (void)share_level;
+
+            acquiring = false;
+
+            if (result != TFGenericTCPClientConnectResult::Connected) {
+                debugfln("tick() could not connect to remote device (result=%s error_number=%d)",
+                         get_tf_generic_tcp_client_connect_result_name(result), error_number);
+                return;
+            }
+
+            shared_client = static_cast<TFModbusTCPSharedClient *>(client);
+        },
+        [this](TFGenericTCPClientDisconnectReason reason, int error_number, TFGenericTCPSharedClient *client, TFGenericTCPClientPoolShareLevel share_level) {
+            (void)reason;
+            (void)error_number;
+            (void)share_level;
+
+            debugfln("tick() disconnected from remote device (reason=%s error_number=%d)",
+                     get_tf_generic_tcp_client_disconnect_reason_name(reason), error_number);
+
+            if (shared_client == client) {
+                shared_client = nullptr;
+            }
+        });
+    }
+
+    for (TFModbusTCPMirrorBlock *block = block_head; block != nullptr && shared_client != nullptr; block = block->next) {
+        if (!block->in_flight && deadline_elapsed(block->next_poll)) {
+            poll(block);
+        }
+    }
+
+    finish_writes();
+}
+
+TFModbusTCPExceptionCode TFModbusTCPMirror::handle_request(uint8_t unit_id,
+                                                           TFModbusTCPFunctionCode function_code,
+                                                           uint16_t start_address,
+                                                           uint16_t data_count,
+                                                           void *data_values)
+{
+    (void)unit_id;
+
+    TFModbusTCPDataType data_type;
+
+    switch (function_code) {
+    case TFModbusTCPFunctionCode::ReadCoils:
+        data_type = TFModbusTCPDataType::Coil;
+        break;
+
+    case TFModbusTCPFunctionCode::ReadDiscreteInputs:
+        data_type = TFModbusTCPDataType::DiscreteInput;
+        break;
+
+    case TFModbusTCPFunctionCode::ReadHoldingRegisters:
+        data_type = TFModbusTCPDataType::HoldingRegister;
+        break;
+
+    case TFModbusTCPFunctionCode::ReadInputRegisters:
+        data_type = TFModbusTCPDataType::InputRegister;
+        break;
+
+    case TFModbusTCPFunctionCode::WriteMultipleCoils:
+    case TFModbusTCPFunctionCode::WriteMultipleRegisters:
+    case TFModbusTCPFunctionCode::MaskWriteRegister:
+        {
+            if (shared_client == nullptr) {
+                return TFModbusTCPExceptionCode::GatewayPathUnvailable;
+            }
+
+            TFModbusTCPMirrorWrite *write = new TFModbusTCPMirrorWrite;
+            size_t length;
+
+            if (function_code == TFModbusTCPFunctionCode::MaskWriteRegister) {
+                length = 2 * sizeof(uint16_t);
+            }
+            else if (function_code == TFModbusTCPFunctionCode::WriteMultipleCoils) {
+                length = (data_count + 7u) / 8u;
+            }
+            else {
+                length = data_count * sizeof(uint16_t);
+            }
+
+            write->request_id     = server->defer_response();
+            write->function_code  = function_code;
+            write->start_address  = start_address;
+            write->data_count     = data_count;
+            write->finished       = false;
+            write->exception_code = TFModbusTCPExceptionCode::Success;
+
+            memcpy(write->register_values, data_values, length); // only valid during the request callback
+
+            write->next = write_head;
+            write_head  = write;
+
+            ++forwarded_write_count;
+
+            // the callback can be called synchronously, e.g. if the client is
+            // not connected anymore. therefore the server response is always
+            // finished from tick(), outside of the request callback
+            shared_client->transact(this->unit_id, function_code, start_address, data_count, write->register_values, timeout,
+            [write](TFModbusTCPClientTransactionResult result, const char *error_message) {
+                (void)error_message;
+
+                write->finished       = true;
+                write->exception_code = get_tf_modbus_tcp_client_transaction_result_exception_code(result);
+            });
+
+            return TFModbusTCPExceptionCode::Deferred;
+        }
+
+    default:
+        return TFModbusTCPExceptionCode::IllegalFunction;
+    }
+
+    TFModbusTCPExceptionCode exception_code = check_coverage(data_type, start_address, data_count);
+
+    if (exception_code != TFModbusTCPExceptionCode::Success) {
+        return exception_code;
+    }
+
+    return bank->read(data_type, start_address, data_count, data_values);
+}
+
+void TFModbusTCPMirror::poll(TFModbusTCPMirrorBlock *block)
+{
+    block->in_flight = true;
+    block->next_poll = calculate_deadline(block->poll_interval);
+
+    ++poll_count;
+
+    planner.read(shared_client, unit_id, get_read_function_code(block->data_type), block->start_address, block->data_count, block->values, timeout,
+    [this, block](TFModbusTCPClientTransactionResult result, const char *error_message) {
+        (void)error_message;
+
+        block->in_flight = false;
+
+        if (result != TFModbusTCPClientTransactionResult::Success) {
+            debugfln("poll() failed (data_type=%s start_address=%u data_count=%u result=%s error_message=%s)",
+                     get_tf_modbus_tcp_data_type_name(block->data_type), block->start_address, block->data_count,
+                     get_tf_modbus_tcp_client_transaction_result_name(result), TFNetwork::printf_safe(error_message));
+
+            ++poll_error_count;
+            return;
+        }
+
+        TFModbusTCPExceptionCode exception_code = bank->write(block->data_type, block->start_address, block->data_count, block->values);
+
+        if (exception_code != TFModbusTCPExceptionCode::Success) {
+            debugfln("poll() could not update register bank (data_type=%s start_address=%u data_count=%u exception_code=%s)",
+                     get_tf_modbus_tcp_data_type_name(block->data_type), block->start_address, block->data_count,
+                     get_tf_modbus_tcp_exception_code_name(exception_code));
+
+            ++poll_error_count;
+            return;
+        }
+
+        memcpy(block->hole_mask, block->poll_hole_mask, (block->data_count + 7u) / 8u);
+
+        block->updated     = true;
+        block->last_update = now_us();
+
+        if (history != nullptr && !is_bit_type(block->data_type)) {
+            uint16_t *values = static_cast<uint16_t *>(block->values);
+            uint16_t offset  = 0;
+
+            // holes are read as zeros, only feed the registers in between
+            while (offset < block->data_count) {
+                if (is_hole(block->hole_mask, offset)) {
+                    ++offset;
+                    continue;
+                }
+
+                uint16_t run_offset = offset;
+
+                while (offset < block->data_count && !is_hole(block->hole_mask, offset)) {
+                    ++offset;
+                }
+
+                history->feed(block->data_type, static_cast<uint16_t>(block->start_address + run_offset), static_cast<uint16_t>(offset - run_offset), values + run_offset, block->last_update);
+            }
+        }
+    },
+    block->poll_hole_mask);
+}
+
+// every address has to be covered by a block that was polled recently enough
+// and must not be a hole of that block
+TFModbusTCPExceptionCode TFModbusTCPMirror::check_coverage(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count) const
+{
+    uint32_t address     = start_address;
+    uint32_t end_address = static_cast<uint32_t>(start_address) + data_count;
+
+    while (address < end_address) {
+        const TFModbusTCPMirrorBlock *covering_block = nullptr;
+
+        for (const TFModbusTCPMirrorBlock *block = block_head; block != nullptr; block = block->next) {
+            if (block->data_type == data_type
+             && address >= block->start_address
+             && address < static_cast<uint32_t>(block->start_address) + block->data_count) {
+                covering_block = block;
+                break;
+            }
+        }
+
+        if (covering_block == nullptr) {
+            return TFModbusTCPExceptionCode::IllegalDataAddress;
+        }
+
+        if (!covering_block->updated || (max_age > 0_s && deadline_elapsed(covering_block->last_update + max_age))) {
+            return TFModbusTCPExceptionCode::GatewayTargetDeviceFailedToRespond;
+        }
+
+        uint32_t block_end_address = static_cast<uint32_t>(covering_block->start_address) + covering_block->data_count;
+
+        for (; address < block_end_address && address < end_address; ++address) {
+            if (is_hole(covering_block->hole_mask, static_cast<uint16_t>(address - covering_block->start_address))) {
+                return TFModbusTCPExceptionCode::IllegalDataAddress;
+            }
+        }
+
+        address = block_end_address;
+    }
+
+    return TFModbusTCPExceptionCode::Success;
+}
+
+void TFModbusTCPMirror::finish_writes()
+{
+    TFModbusTCPMirrorWrite **write_ptr = &write_head;
+
+    while (*write_ptr != nullptr) {
+        TFModbusTCPMirrorWrite *write = *write_ptr;
+
+        if (!write->finished) {
+            write_ptr = &write->next;
+            continue;
+        }
+
+        *write_ptr = write->next;
+
+        if (write->exception_code == TFModbusTCPExceptionCode::Success) {
+            // the remote device accepted the write, show it to following
+            // reads right away and confirm it with the next poll
+            bank->handle_request(write->function_code, write->start_address, write->data_count, write->register_values);
+
+            TFModbusTCPDataType data_type = write->function_code == TFModbusTCPFunctionCode::WriteMultipleCoils ? TFModbusTCPDataType::Coil : TFModbusTCPDataType::HoldingRegister;
+            uint32_t end_address          = static_cast<uint32_t>(write->start_address) + (write->function_code == TFModbusTCPFunctionCode::MaskWriteRegister ? 1 : write->data_count);
+
+            for (TFModbusTCPMirrorBlock *block = block_head; block != nullptr; block = block->next) {
+                if (block->data_type == data_type
+                 && write->start_address < static_cast<uint32_t>(block->start_address) + block->data_count
+                 && end_address > block->start_address) {
+                    block->next_poll = 0_s;
+                }
+            }
+        }
+
+        // fails if the server client is gone in the meantime
+        server->finish_deferred_response(write->request_id, write->exception_code);
+
+        delete write;
+    }
+}
@@ -0,0 +1,107 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <TFTools/Micros.h>
+
+#include "TFModbusTCPCommon.h"
+#include "TFModbusTCPServer.h"
+#include "TFModbusTCPClient.h"
+#include "TFModbusTCPClientPool.h"
+#include "TFModbusTCPReadPlanner.h"
+#include "TFModbusTCPRegisterBank.h"
+#include "TFModbusTCPHistory.h"
+
+struct TFModbusTCPMirrorBlock;
+struct TFModbusTCPMirrorWrite;
+
+// Keeps a local copy of a remote device in a register bank, so that any
+// number of masters can be served by a TFModbusTCPServer from memory, while
+// the remote device only sees one connection. Each block is polled through the
+// client pool at its own interval, using a read planner to skip address holes.
+// Reads are answered from the bank without waiting for the remote device.
+// Reads that include a hole are answered with an Illegal Data Address
+// exception, like the remote device would.
+// Writes are forwarded using deferred server responses and applied to the bank
+// once the remote device accepted them.
+//
+// Pool and server have to use TFModbusTCPByteOrder::Host, like the register
+// bank. The unit ID of server requests is ignored, all requests go to the
+// configured unit of the remote device
+class TFModbusTCPMirror final
+{
+public:
+    TFModbusTCPMirror(TFModbusTCPServer *server_, TFModbusTCPClientPool *pool_, TFModbusTCPRegisterBank *bank_) : server(server_), pool(pool_), bank(bank_) {}
+    ~TFModbusTCPMirror();
+
+    TFModbusTCPMirror(TFModbusTCPMirror const &other) = delete;
+    TFModbusTCPMirror &operator=(TFModbusTCPMirror const &other) = delete;
+
+    bool add_block(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, micros_t poll_interval);
+
+    // Reads of values that were not polled successfully for longer than the
+    // max age are answered with a Gateway Target Device Failed To Respond
+    // exception. A max age of 0 means that polled values never expire
+    void set_max_age(micros_t max_age) { this->max_age = max_age; }
+
+    // successfully polled registers are fed into the history, if set
+    void set_history(TFModbusTCPHistory *history) { this->history = history; }
+
+    bool start(const char *host, uint16_t port, uint8_t unit_id, micros_t timeout = 2_s);
+    void stop(); // don't call from a server or pool callback
+    void tick(); // call after the server tick
+
+    // to be called from the request callback of the server
+    TFModbusTCPExceptionCode handle_request(uint8_t unit_id,
+                                            TFModbusTCPFunctionCode function_code,
+                                            uint16_t start_address,
+                                            uint16_t data_count,
+                                            void *data_values);
+
+    size_t get_poll_count() const { return poll_count; }
+    size_t get_poll_error_count() const { return poll_error_count; }
+    size_t get_forwarded_write_count() const { return forwarded_write_count; }
+
+private:
+    void poll(TFModbusTCPMirrorBlock *block);
+    TFModbusTCPExceptionCode check_coverage(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count) const;
+    void finish_writes();
+
+    TFModbusTCPServer *server;
+    TFModbusTCPClientPool *pool;
+    TFModbusTCPRegisterBank *bank;
+    TFModbusTCPReadPlanner planner;
+    TFModbusTCPHistory *history            = nullptr;
+    char *host                             = nullptr;
+    uint16_t port                          = 0;
+    uint8_t unit_id                        = 0;
+    micros_t timeout                       = 0_s;
+    micros_t max_age                       = 0_s;
+    TFModbusTCPSharedClient *shared_client = nullptr;
+    bool acquiring                         = false;
+    TFModbusTCPMirrorBlock *block_head     = nullptr;
+    TFModbusTCPMirrorWrite *write_head     = nullptr;
+    size_t poll_count                      = 0;
+    size_t poll_error_count                = 0;
+    size_t forwarded_write_count           = 0;
+};
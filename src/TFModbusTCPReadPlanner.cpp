@@ -0,0 +1,427 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include "TFModbusTCPReadPlanner.h"
+
+#include <string.h>
+#include <algorithm>
+
+#include "TFNetwork.h"
+
+#define debugfln(fmt, ...) tf_network_debugfln("TFModbusTCPReadPlanner[%p]::" fmt, static_cast<void *>(this) __VA_OPT__(,) __VA_ARGS__)
+
+typedef std::function<void(uint8_t unit_id,
+                           TFModbusTCPFunctionCode function_code,
+                           uint16_t start_address,
+                           uint16_t data_count,
+                           void *buffer,
+                           micros_t timeout,
+                           TFModbusTCPClientTransactionCallback &&callback)> TFModbusTCPReadPlannerTransactFunction;
+
+struct TFModbusTCPReadPlannerRange
+{
+    uint16_t start_address;
+    uint16_t data_count;
+    TFModbusTCPReadPlannerRange *next;
+};
+
+struct TFModbusTCPReadPlannerOperation
+{
+    TFModbusTCPReadPlannerTransactFunction transact;
+    uint8_t unit_id;
+    TFModbusTCPFunctionCode function_code;
+    uint16_t start_address;
+    uint16_t data_count;
+    void *buffer;
+    micros_t timeout;
+    TFModbusTCPClientTransactionCallback callback;
+    uint8_t *hole_mask;
+    uint16_t max_register_count;
+    TFModbusTCPReadPlannerRange *range_head;
+    uint8_t coil_values[TF_MODBUS_TCP_MAX_READ_COIL_BYTE_COUNT];
+};
+
+static bool is_coil_read(TFModbusTCPFunctionCode function_code)
+{
+    return function_code == TFModbusTCPFunctionCode::ReadCoils
+        || function_code == TFModbusTCPFunctionCode::ReadDiscreteInputs;
+}
+
+static void mark_hole(TFModbusTCPReadPlannerOperation *operation, uint32_t start_address, uint32_t end_address)
+{
+    if (operation->hole_mask == nullptr) {
+        return;
+    }
+
+    for (uint32_t address = start_address; address < end_address; ++address) {
+        uint32_t offset = address - operation->start_address;
+
+        operation->hole_mask[offset / 8] |= static_cast<uint8_t>(1u << (offset % 8));
+    }
+}
+
+static TFModbusTCPReadPlannerOperation *create_operation(uint8_t unit_id,
+                                                         TFModbusTCPFunctionCode function_code,
+                                                         uint16_t start_address,
+                                                         uint16_t data_count,
+                                                         void *buffer,
+                                                         micros_t timeout,
+                                                         TFModbusTCPClientTransactionCallback &&callback,
+                                                         uint8_t *hole_mask)
+{
+    if (!callback) {
+        return nullptr;
+    }
+
+    if (function_code != TFModbusTCPFunctionCode::ReadCoils
+     && function_code != TFModbusTCPFunctionCode::ReadDiscreteInputs
+     && function_code != TFModbusTCPFunctionCode::ReadHoldingRegisters
+     && function_code != TFModbusTCPFunctionCode::ReadInputRegisters) {
+        callback(TFModbusTCPClientTransactionResult::InvalidArgument, "Function code is out-of-range");
+        return nullptr;
+    }
+
+    if (data_count < 1 || static_cast<uint32_t>(start_address) + data_count > 65536u) {
+        callback(TFModbusTCPClientTransactionResult::InvalidArgument, "Data count is out-of-range");
+        return nullptr;
+    }
+
+    if (buffer == nullptr) {
+        callback(TFModbusTCPClientTransactionResult::InvalidArgument, "Data pointer is null");
+        return nullptr;
+    }
+
+    TFModbusTCPReadPlannerOperation *operation = new TFModbusTCPReadPlannerOperation;
+
+    operation->unit_id       = unit_id;
+    operation->function_code = function_code;
+    operation->start_address = start_address;
+    operation->data_count    = data_count;
+    operation->buffer        = buffer;
+    operation->timeout       = timeout;
+    operation->callback      = std::move(callback);
+    operation->hole_mask     = hole_mask;
+    operation->range_head    = nullptr;
+
+    return operation;
+}
+
+void TFModbusTCPReadPlanner::read(TFModbusTCPClient *client,
+                                  uint8_t unit_id,
+                                  TFModbusTCPFunctionCode function_code,
+                                  uint16_t start_address,
+                                  uint16_t data_count,
+                                  void *buffer,
+                                  micros_t timeout,
+                                  TFModbusTCPClientTransactionCallback &&callback,
+                                  uint8_t *hole_mask /*= nullptr*/)
+{
+    TFModbusTCPReadPlannerOperation *operation = create_operation(unit_id, function_code, start_address, data_count, buffer, timeout, std::move(callback), hole_mask);
+
+    if (operation == nullptr) {
+        return;
+    }
+
+    operation->max_register_count = client->get_device_profile()->max_read_register_count;
+    operation->transact           =
+    [client](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count,
+             void *buffer, micros_t timeout, TFModbusTCPClientTransactionCallback &&callback) {
+        client->transact(unit_id, function_code, start_address, data_count, buffer, timeout, std::move(callback));
+    };
+
+    start(operation);
+}
+
+void TFModbusTCPReadPlanner::read(TFModbusTCPSharedClient *shared_client,
+                                  uint8_t unit_id,
+                                  TFModbusTCPFunctionCode function_code,
+                                  uint16_t start_address,
+                                  uint16_t data_count,
+                                  void *buffer,
+                                  micros_t timeout,
+                                  TFModbusTCPClientTransactionCallback &&callback,
+                                  uint8_t *hole_mask /*= nullptr*/)
+{
+    TFModbusTCPReadPlannerOperation *operation = create_operation(unit_id, function_code, start_address, data_count, buffer, timeout, std::move(callback), hole_mask);
+
+    if (operation == nullptr) {
+        return;
+    }
+
+    operation->max_register_count = shared_client->get_device_profile()->max_read_register_count;
+    operation->transact           =
+    [shared_client](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count,
+                    void *buffer, micros_t timeout, TFModbusTCPClientTransactionCallback &&callback) {
+        shared_client->transact(unit_id, function_code, start_address, data_count, buffer, timeout, std::move(callback));
+    };
+
+    start(operation);
+}
+
+bool TFModbusTCPReadPlanner::is_hole(uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t address) const
+{
+    for (size_t i = 0; i < hole_count; ++i) {
+        const TFModbusTCPReadPlannerHole *hole = &holes[i];
+
+        if (hole->unit_id == unit_id
+         && hole->function_code == function_code
+         && address >= hole->start_address
+         && address < hole->start_address + hole->data_count) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TFModbusTCPReadPlanner::start(TFModbusTCPReadPlannerOperation *operation)
+{
+    bool coils            = is_coil_read(operation->function_code);
+    size_t max_data_count = coils ? TF_MODBUS_TCP_MAX_READ_COIL_COUNT : operation->max_register_count;
+    uint32_t address      = operation->start_address;
+    uint32_t end_address  = static_cast<uint32_t>(operation->start_address) + operation->data_count;
+
+    // Values inside of holes are reported as zero
+    memset(operation->buffer, 0, coils ? (operation->data_count + 7) / 8 : operation->data_count * 2);
+
+    if (operation->hole_mask != nullptr) {
+        memset(operation->hole_mask, 0, (operation->data_count + 7) / 8);
+    }
+
+    while (address < end_address) {
+        uint32_t range_end_address = std::min(end_address, static_cast<uint32_t>(address + max_data_count));
+        bool inside_hole = false;
+
+        for (size_t i = 0; i < hole_count; ++i) {
+            const TFModbusTCPReadPlannerHole *hole = &holes[i];
+
+            if (hole->unit_id != operation->unit_id || hole->function_code != operation->function_code) {
+                continue;
+            }
+
+            uint32_t hole_end_address = static_cast<uint32_t>(hole->start_address) + hole->data_count;
+
+            if (address >= hole->start_address && address < hole_end_address) {
+                mark_hole(operation, address, std::min(end_address, hole_end_address));
+
+                address     = hole_end_address;
+                inside_hole = true;
+                break;
+            }
+
+            if (hole->start_address > address && hole->start_address < range_end_address) {
+                range_end_address = hole->start_address;
+            }
+        }
+
+        if (inside_hole) {
+            continue;
+        }
+
+        add_range(operation, static_cast<uint16_t>(address), static_cast<uint16_t>(range_end_address - address), false);
+
+        address = range_end_address;
+    }
+
+    next(operation);
+}
+
+void TFModbusTCPReadPlanner::add_range(TFModbusTCPReadPlannerOperation *operation, uint16_t start_address, uint16_t data_count, bool front)
+{
+    TFModbusTCPReadPlannerRange *range = new TFModbusTCPReadPlannerRange;
+
+    range->start_address = start_address;
+    range->data_count    = data_count;
+
+    if (front) {
+        range->next           = operation->range_head;
+        operation->range_head = range;
+        return;
+    }
+
+    TFModbusTCPReadPlannerRange **tail_ptr = &operation->range_head;
+
+    while (*tail_ptr != nullptr) {
+        tail_ptr = &(*tail_ptr)->next;
+    }
+
+    range->next = nullptr;
+    *tail_ptr   = range;
+}
+
+void TFModbusTCPReadPlanner::next(TFModbusTCPReadPlannerOperation *operation)
+{
+    TFModbusTCPReadPlannerRange *range = operation->range_head;
+
+    if (range == nullptr) {
+        TFModbusTCPClientTransactionCallback callback = std::move(operation->callback);
+
+        delete operation;
+
+        callback(TFModbusTCPClientTransactionResult::Success, nullptr);
+        return;
+    }
+
+    operation->range_head = range->next;
+
+    bool coils   = is_coil_read(operation->function_code);
+    void *buffer = operation->coil_values;
+
+    if (!coils) {
+        buffer = static_cast<uint16_t *>(operation->buffer) + (range->start_address - operation->start_address);
+    }
+
+    operation->transact(operation->unit_id, operation->function_code, range->start_address, range->data_count, buffer, operation->timeout,
+    [this, operation, range, coils](TFModbusTCPClientTransactionResult result, const char *error_message) {
+        if (result == TFModbusTCPClientTransactionResult::ModbusIllegalDataAddress) {
+            if (range->data_count == 1) {
+                mark_hole(operation, range->start_address, range->start_address + 1u);
+                add_hole(operation->unit_id, operation->function_code, range->start_address);
+            }
+            else {
+                uint16_t first_data_count = range->data_count / 2;
+
+                debugfln("read(...) bisecting failing block (unit_id=%u function_code=%s start_address=%u data_count=%u)",
+                         operation->unit_id, get_tf_modbus_tcp_function_code_name(operation->function_code),
+                         range->start_address, range->data_count);
+
+                add_range(operation, range->start_address + first_data_count, range->data_count - first_data_count, true);
+                add_range(operation, range->start_address, first_data_count, true);
+            }
+
+            delete range;
+            next(operation);
+            return;
+        }
+
+        if (result != TFModbusTCPClientTransactionResult::Success) {
+            TFModbusTCPClientTransactionCallback callback = std::move(operation->callback);
+
+            while (operation->range_head != nullptr) {
+                TFModbusTCPReadPlannerRange *range_next = operation->range_head->next;
+
+                delete operation->range_head;
+                operation->range_head = range_next;
+            }
+
+            delete range;
+            delete operation;
+
+            callback(result, error_message);
+            return;
+        }
+
+        if (coils) {
+            uint8_t *buffer = static_cast<uint8_t *>(operation->buffer);
+            size_t offset   = range->start_address - operation->start_address;
+
+            for (size_t i = 0; i < range->data_count; ++i, ++offset) {
+                if (((operation->coil_values[i / 8] >> (i % 8)) & 1) != 0) {
+                    buffer[offset / 8] |= static_cast<uint8_t>(1u << (offset % 8));
+                }
+            }
+        }
+
+        delete range;
+        next(operation);
+    });
+}
+
+void TFModbusTCPReadPlanner::add_hole(uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t address)
+{
+    TFModbusTCPReadPlannerHole *merged_hole = nullptr;
+
+    for (size_t i = 0; i < hole_count; ++i) {
+        TFModbusTCPReadPlannerHole *hole = &holes[i];
+
+        if (hole->unit_id != unit_id || hole->function_code != function_code) {
+            continue;
+        }
+
+        if (address >= hole->start_address && address < hole->start_address + hole->data_count) {
+            return;
+        }
+
+        if (address + 1 == hole->start_address) {
+            --hole->start_address;
+            ++hole->data_count;
+            merged_hole = hole;
+            break;
+        }
+
+        if (address == hole->start_address + hole->data_count) {
+            ++hole->data_count;
+            merged_hole = hole;
+            break;
+        }
+    }
+
+    debugfln("add_hole(unit_id=%u function_code=%s address=%u) %s",
+             unit_id, get_tf_modbus_tcp_function_code_name(function_code), address,
+             merged_hole != nullptr ? "merged" : (hole_count < TF_MODBUS_TCP_READ_PLANNER_MAX_HOLE_COUNT ? "added" : "added, forgetting oldest hole"));
+
+    if (merged_hole == nullptr) {
+        // Holes are kept in the order they were learned, forget the oldest one
+        // instead of not recording the new one, otherwise every following read
+        // would bisect the same failing block again
+        if (hole_count >= TF_MODBUS_TCP_READ_PLANNER_MAX_HOLE_COUNT) {
+            remove_hole(0);
+        }
+
+        TFModbusTCPReadPlannerHole *hole = &holes[hole_count++];
+
+        hole->unit_id       = unit_id;
+        hole->function_code = function_code;
+        hole->start_address = address;
+        hole->data_count    = 1;
+
+        return;
+    }
+
+    // The grown hole might touch another hole now, merge both
+    for (size_t i = 0; i < hole_count; ++i) {
+        TFModbusTCPReadPlannerHole *hole = &holes[i];
+
+        if (hole == merged_hole || hole->unit_id != unit_id || hole->function_code != function_code) {
+            continue;
+        }
+
+        if (hole->start_address == merged_hole->start_address + merged_hole->data_count) {
+            merged_hole->data_count += hole->data_count;
+        }
+        else if (hole->start_address + hole->data_count == merged_hole->start_address) {
+            merged_hole->start_address  = hole->start_address;
+            merged_hole->data_count    += hole->data_count;
+        }
+        else {
+            continue;
+        }
+
+        remove_hole(i);
+        break;
+    }
+}
+
+void TFModbusTCPReadPlanner::remove_hole(size_t index)
+{
+    --hole_count;
+
+    memmove(&holes[index], &holes[index + 1], (hole_count - index) * sizeof(holes[0]));
+}
@@ -0,0 +1,91 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <TFTools/Micros.h>
+
+#include "TFModbusTCPClient.h"
+
+// configuration
+#ifndef TF_MODBUS_TCP_READ_PLANNER_MAX_HOLE_COUNT
+#define TF_MODBUS_TCP_READ_PLANNER_MAX_HOLE_COUNT 32
+#endif
+
+struct TFModbusTCPReadPlannerHole
+{
+    uint8_t unit_id;
+    TFModbusTCPFunctionCode function_code;
+    uint16_t start_address;
+    uint16_t data_count;
+};
+
+struct TFModbusTCPReadPlannerOperation;
+
+// Splits reads around address holes that the device answered with an Illegal
+// Data Address exception before. A failing block is bisected until the holes
+// are found, they are remembered and skipped by all following reads. Values
+// inside of holes are set to zero. Pass a hole mask with one bit per value to
+// tell holes apart from values that are zero, a set bit marks a hole. If more
+// than TF_MODBUS_TCP_READ_PLANNER_MAX_HOLE_COUNT holes are known the oldest
+// one is forgotten. Use one planner per endpoint and keep it across
+// reconnects to keep the learned holes.
+class TFModbusTCPReadPlanner final
+{
+public:
+    TFModbusTCPReadPlanner() {}
+
+    TFModbusTCPReadPlanner(TFModbusTCPReadPlanner const &other) = delete;
+    TFModbusTCPReadPlanner &operator=(TFModbusTCPReadPlanner const &other) = delete;
+
+    void read(TFModbusTCPClient *client,
+              uint8_t unit_id,
+              TFModbusTCPFunctionCode function_code,
+              uint16_t start_address,
+              uint16_t data_count,
+              void *buffer,
+              micros_t timeout,
+              TFModbusTCPClientTransactionCallback &&callback,
+              uint8_t *hole_mask = nullptr);
+    void read(TFModbusTCPSharedClient *shared_client,
+              uint8_t unit_id,
+              TFModbusTCPFunctionCode function_code,
+              uint16_t start_address,
+              uint16_t data_count,
+              void *buffer,
+              micros_t timeout,
+              TFModbusTCPClientTransactionCallback &&callback,
+              uint8_t *hole_mask = nullptr);
+    bool is_hole(uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t address) const;
+    size_t get_hole_count() const { return hole_count; }
+    const TFModbusTCPReadPlannerHole *get_hole(size_t index) const { return index < hole_count ? &holes[index] : nullptr; }
+    void clear_holes() { hole_count = 0; }
+
+private:
+    void start(TFModbusTCPReadPlannerOperation *operation);
+    void add_range(TFModbusTCPReadPlannerOperation *operation, uint16_t start_address, uint16_t data_count, bool front);
+    void next(TFModbusTCPReadPlannerOperation *operation);
+    void add_hole(uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t address);
+    void remove_hole(size_t index);
+
+    TFModbusTCPReadPlannerHole holes[TF_MODBUS_TCP_READ_PLANNER_MAX_HOLE_COUNT];
+    size_t hole_count = 0;
+};
@@ -0,0 +1,111 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include "TFModbusTCPRegisterBank.h"
+
+#include <string.h>
+
+const char *get_tf_modbus_tcp_data_type_name(TFModbusTCPDataType data_type)
+{
+    switch (data_type) {
+    case TFModbusTCPDataType::Coil:
+        return "Coil";
+
+    case TFModbusTCPDataType::DiscreteInput:
+        return "DiscreteInput";
+
+    case TFModbusTCPDataType::InputRegister:
+        return "InputRegister";
+
+    case TFModbusTCPDataType::HoldingRegister:
+        return "HoldingRegister";
+    }
+
+    return "<Unknown>";
+}
+
+TFModbusTCPExceptionCode TFModbusTCPRegisterBank::handle_request(TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values)
+{
+    switch (function_code) {
+    case TFModbusTCPFunctionCode::ReadCoils:
+        return read(TFModbusTCPDataType::Coil, start_address, data_count, data_values);
+
+    case TFModbusTCPFunctionCode::ReadDiscreteInputs:
+        return read(TFModbusTCPDataType::DiscreteInput, start_address, data_count, data_values);
+
+    case TFModbusTCPFunctionCode::ReadHoldingRegisters:
+        return read(TFModbusTCPDataType::HoldingRegister, start_address, data_count, data_values);
+
+    case TFModbusTCPFunctionCode::ReadInputRegisters:
+        return read(TFModbusTCPDataType::InputRegister, start_address, data_count, data_values);
+
+    case TFModbusTCPFunctionCode::WriteMultipleCoils:
+        return write(TFModbusTCPDataType::Coil, start_address, data_count, data_values);
+
+    case TFModbusTCPFunctionCode::WriteMultipleRegisters:
+        return write(TFModbusTCPDataType::HoldingRegister, start_address, data_count, data_values);
+
+    case TFModbusTCPFunctionCode::MaskWriteRegister:
+        {
+            // The server passes the AND mask and the OR mask as two values
+            const uint16_t *masks = static_cast<uint16_t *>(data_values);
+            uint16_t register_value;
+            TFModbusTCPExceptionCode exception_code = read(TFModbusTCPDataType::HoldingRegister, start_address, 1, &register_value);
+
+            if (exception_code != TFModbusTCPExceptionCode::Success) {
+                return exception_code;
+            }
+
+            register_value = (register_value & masks[0]) | (masks[1] & ~masks[0]);
+
+            return write(TFModbusTCPDataType::HoldingRegister, start_address, 1, &register_value);
+        }
+
+    default:
+        return TFModbusTCPExceptionCode::IllegalFunction;
+    }
+}
+
+static bool get_bit(const uint8_t *bits, uint32_t index)
+{
+    return ((bits[index / 8] >> (index % 8)) & 1) != 0;
+}
+
+static void set_bit(uint8_t *bits, uint32_t index, bool value)
+{
+    if (value) {
+        bits[index / 8] |= static_cast<uint8_t>(1u << (index % 8));
+    }
+    else {
+        bits[index / 8] &= static_cast<uint8_t>(~(1u << (index % 8)));
+    }
+}
+
+void TFModbusTCPRegisterBank::copy_bits(uint8_t *destination, uint32_t destination_offset, const uint8_t *source, uint32_t source_offset, uint32_t count)
+{
+    if ((destination_offset % 8) == 0 && (source_offset % 8) == 0 && (count % 8) == 0) {
+        memcpy(destination + destination_offset / 8, source + source_offset / 8, count / 8);
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        set_bit(destination, destination_offset + i, get_bit(source, source_offset + i));
+    }
+}
@@ -0,0 +1,57 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+
+#include "TFModbusTCPCommon.h"
+
+enum class TFModbusTCPDataType : uint8_t
+{
+    Coil,
+    DiscreteInput,
+    InputRegister,
+    HoldingRegister,
+};
+
+const char *get_tf_modbus_tcp_data_type_name(TFModbusTCPDataType data_type);
+
+// Register store that can serve a TFModbusTCPServer directly by calling
+// handle_request() from its request callback. Coils and discrete inputs are
+// passed as packed bits, LSB first, registers as uint16_t in host byte order.
+// Therefore the server has to be created with TFModbusTCPByteOrder::Host
+class TFModbusTCPRegisterBank
+{
+public:
+    TFModbusTCPRegisterBank() {}
+    virtual ~TFModbusTCPRegisterBank() {}
+
+    TFModbusTCPRegisterBank(TFModbusTCPRegisterBank const &other) = delete;
+    TFModbusTCPRegisterBank &operator=(TFModbusTCPRegisterBank const &other) = delete;
+
+    virtual TFModbusTCPExceptionCode read(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, void *data_values) = 0;
+    virtual TFModbusTCPExceptionCode write(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, const void *data_values) = 0;
+
+    TFModbusTCPExceptionCode handle_request(TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values);
+
+protected:
+    static void copy_bits(uint8_t *destination, uint32_t destination_offset, const uint8_t *source, uint32_t source_offset, uint32_t count);
+};
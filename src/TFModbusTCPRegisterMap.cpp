@@ -0,0 +1,858 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include "TFModbusTCPRegisterMap.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "TFNetwork.h"
+
+#define debugfln(fmt, ...) tf_network_debugfln("TFModbusTCPRegisterMap[%p]::" fmt, static_cast<void *>(this) __VA_OPT__(,) __VA_ARGS__)
+
+#define MAP_MAGIC 0x4D524654u // "TFRM" in little endian, a map compiled with the other endianness is rejected
+#define MAP_VERSION 1
+#define DATA_TYPE_COUNT 4
+#define MAX_TOKEN_COUNT 6
+
+// Followed by the entries, the value words and the NUL terminated names
+struct TFModbusTCPRegisterMapHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t entry_count;
+    uint32_t word_count;
+    uint32_t name_length;
+    uint32_t entries_offset;
+    uint32_t words_offset;
+    uint32_t names_offset;
+};
+
+static_assert(sizeof(TFModbusTCPRegisterMapHeader) == 32, "TFModbusTCPRegisterMapHeader has unexpected size");
+
+const char *get_tf_modbus_tcp_register_map_value_type_name(TFModbusTCPRegisterMapValueType value_type)
+{
+    switch (value_type) {
+    case TFModbusTCPRegisterMapValueType::Bit:
+        return "Bit";
+
+    case TFModbusTCPRegisterMapValueType::U16:
+        return "U16";
+
+    case TFModbusTCPRegisterMapValueType::I16:
+        return "I16";
+
+    case TFModbusTCPRegisterMapValueType::U32:
+        return "U32";
+
+    case TFModbusTCPRegisterMapValueType::I32:
+        return "I32";
+
+    case TFModbusTCPRegisterMapValueType::F32:
+        return "F32";
+
+    case TFModbusTCPRegisterMapValueType::String:
+        return "String";
+    }
+
+    return "<Unknown>";
+}
+
+static bool is_bit_type(uint8_t data_type)
+{
+    return data_type == static_cast<uint8_t>(TFModbusTCPDataType::Coil)
+        || data_type == static_cast<uint8_t>(TFModbusTCPDataType::DiscreteInput);
+}
+
+static bool entry_less(const TFModbusTCPRegisterMapEntry &a, const TFModbusTCPRegisterMapEntry &b)
+{
+    return a.data_type < b.data_type || (a.data_type == b.data_type && a.start_address < b.start_address);
+}
+
+// Line numbers start at 1, line number 0 is used for errors about the whole
+// file and gets no prefix
+static void set_error(char *error_message, size_t error_message_length, size_t line_number, const char *format, ...)
+{
+    if (error_message == nullptr || error_message_length == 0) {
+        return;
+    }
+
+    int prefix_length = 0;
+
+    if (line_number > 0) {
+        prefix_length = snprintf(error_message, error_message_length, "line %zu: ", line_number);
+    }
+
+    if (prefix_length < 0 || static_cast<size_t>(prefix_length) >= error_message_length) {
+        return;
+    }
+
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(error_message + prefix_length, error_message_length - prefix_length, format, args);
+    va_end(args);
+}
+
+template<typename T>
+static void ensure_capacity(T **array, size_t *capacity, size_t required)
+{
+    if (required <= *capacity) {
+        return;
+    }
+
+    size_t new_capacity = std::max<size_t>(required, *capacity * 2 + 16);
+    T *new_array        = new T[new_capacity];
+
+    if (*array != nullptr) {
+        memcpy(new_array, *array, *capacity * sizeof(T));
+        delete[] *array;
+    }
+
+    *array    = new_array;
+    *capacity = new_capacity;
+}
+
+static bool parse_integer(const char *token, int64_t min_value, int64_t max_value, int64_t *value)
+{
+    char *end;
+
+    errno  = 0;
+    *value = strtoll(token, &end, 0);
+
+    return errno == 0 && end != token && *end == '\0' && *value >= min_value && *value <= max_value;
+}
+
+// Splits a line into whitespace separated tokens in place. A quoted token
+// keeps its spaces and loses its quotes, # outside of quotes ends the line
+static int tokenize_line(char *line, char **tokens, bool *quoted)
+{
+    int token_count = 0;
+    char *p         = line;
+
+    while (true) {
+        while (*p == ' ' || *p == '\t' || *p == '\r') {
+            ++p;
+        }
+
+        if (*p == '\0' || *p == '#') {
+            return token_count;
+        }
+
+        if (token_count == MAX_TOKEN_COUNT) {
+            return -1;
+        }
+
+        if (*p == '"') {
+            char *end = strchr(p + 1, '"');
+
+            if (end == nullptr) {
+                return -1;
+            }
+
+            quoted[token_count]   = true;
+            tokens[token_count++] = p + 1;
+            *end                  = '\0';
+            p                     = end + 1;
+
+            if (*p != '\0' && *p != ' ' && *p != '\t' && *p != '\r' && *p != '#') {
+                return -1;
+            }
+
+            continue;
+        }
+
+        quoted[token_count]   = false;
+        tokens[token_count++] = p;
+
+        while (*p != '\0' && *p != ' ' && *p != '\t' && *p != '\r' && *p != '#') {
+            ++p;
+        }
+
+        if (*p == '#') {
+            *p = '\0';
+            return token_count;
+        }
+
+        if (*p != '\0') {
+            *p++ = '\0';
+        }
+    }
+}
+
+bool TFModbusTCPRegisterMap::compile(const char *source, size_t source_length, uint8_t **binary, size_t *binary_length, char *error_message, size_t error_message_length)
+{
+    TFModbusTCPRegisterMapEntry *entries = nullptr;
+    size_t entry_count                   = 0;
+    size_t entry_capacity                = 0;
+    size_t *entry_lines                  = nullptr;
+    size_t entry_line_capacity           = 0;
+    uint16_t *words                      = nullptr;
+    size_t word_count                    = 0;
+    size_t word_capacity                 = 0;
+    char *names                          = nullptr;
+    size_t name_length                   = 0;
+    size_t name_capacity                 = 0;
+    uint32_t next_addresses[DATA_TYPE_COUNT] = {0, 0, 0, 0};
+    char *line                           = new char[source_length + 1];
+    size_t line_number                   = 0;
+    size_t offset                        = 0;
+    bool success                         = false;
+
+    while (offset < source_length) {
+        size_t line_length = 0;
+
+        while (offset + line_length < source_length && source[offset + line_length] != '\n') {
+            ++line_length;
+        }
+
+        memcpy(line, source + offset, line_length);
+        line[line_length] = '\0';
+        offset           += line_length + 1;
+        ++line_number;
+
+        char *tokens[MAX_TOKEN_COUNT];
+        bool quoted[MAX_TOKEN_COUNT];
+        int token_count = tokenize_line(line, tokens, quoted);
+
+        if (token_count == 0) {
+            continue;
+        }
+
+        if (token_count < 0) {
+            set_error(error_message, error_message_length, line_number, "unterminated quote or too many fields");
+            goto cleanup;
+        }
+
+        if (token_count < 4) {
+            set_error(error_message, error_message_length, line_number, "expected <table> <address> <name> <type> [<value>] [rw]");
+            goto cleanup;
+        }
+
+        TFModbusTCPRegisterMapEntry entry;
+        const char *table = tokens[0];
+
+        memset(&entry, 0, sizeof(entry));
+
+        if (strcmp(table, "coil") == 0) {
+            entry.data_type = static_cast<uint8_t>(TFModbusTCPDataType::Coil);
+        }
+        else if (strcmp(table, "discrete") == 0) {
+            entry.data_type = static_cast<uint8_t>(TFModbusTCPDataType::DiscreteInput);
+        }
+        else if (strcmp(table, "input") == 0) {
+            entry.data_type = static_cast<uint8_t>(TFModbusTCPDataType::InputRegister);
+        }
+        else if (strcmp(table, "holding") == 0) {
+            entry.data_type = static_cast<uint8_t>(TFModbusTCPDataType::HoldingRegister);
+        }
+        else {
+            set_error(error_message, error_message_length, line_number, "unknown table '%s'", table);
+            goto cleanup;
+        }
+
+        int64_t address;
+
+        if (strcmp(tokens[1], "+") == 0) {
+            address = next_addresses[entry.data_type];
+        }
+        else if (!parse_integer(tokens[1], 0, UINT16_MAX, &address)) {
+            set_error(error_message, error_message_length, line_number, "invalid address '%s'", tokens[1]);
+            goto cleanup;
+        }
+
+        const char *type = tokens[3];
+        int64_t string_register_count;
+
+        if (strcmp(type, "bit") == 0) {
+            entry.value_type     = static_cast<uint8_t>(TFModbusTCPRegisterMapValueType::Bit);
+            entry.register_count = 1;
+        }
+        else if (strcmp(type, "u16") == 0 || strcmp(type, "i16") == 0) {
+            entry.value_type     = static_cast<uint8_t>(type[0] == 'u' ? TFModbusTCPRegisterMapValueType::U16 : TFModbusTCPRegisterMapValueType::I16);
+            entry.register_count = 1;
+        }
+        else if (strcmp(type, "u32") == 0 || strcmp(type, "i32") == 0 || strcmp(type, "f32") == 0) {
+            entry.value_type     = static_cast<uint8_t>(type[0] == 'u' ? TFModbusTCPRegisterMapValueType::U32 :
+                                                        type[0] == 'i' ? TFModbusTCPRegisterMapValueType::I32 : TFModbusTCPRegisterMapValueType::F32);
+            entry.register_count = 2;
+        }
+        else if (strncmp(type, "string", 6) == 0 && parse_integer(type + 6, 1, UINT16_MAX, &string_register_count)) {
+            entry.value_type     = static_cast<uint8_t>(TFModbusTCPRegisterMapValueType::String);
+            entry.register_count = static_cast<uint16_t>(string_register_count);
+        }
+        else {
+            set_error(error_message, error_message_length, line_number, "unknown type '%s'", type);
+            goto cleanup;
+        }
+
+        if (is_bit_type(entry.data_type) != (entry.value_type == static_cast<uint8_t>(TFModbusTCPRegisterMapValueType::Bit))) {
+            set_error(error_message, error_message_length, line_number, "type '%s' does not fit table '%s'", type, table);
+            goto cleanup;
+        }
+
+        if (address + entry.register_count > UINT16_MAX + 1) {
+            set_error(error_message, error_message_length, line_number, "entry exceeds the address space");
+            goto cleanup;
+        }
+
+        entry.start_address = static_cast<uint16_t>(address);
+        entry.value_offset  = static_cast<uint32_t>(word_count);
+
+        next_addresses[entry.data_type] = static_cast<uint32_t>(address + entry.register_count);
+
+        int value_index = 4;
+
+        if (token_count > value_index && !quoted[value_index] && strcmp(tokens[value_index], "rw") == 0) {
+            value_index = -1; // no value, only the flag
+        }
+
+        int flag_index = value_index < 0 ? 4 : 5;
+
+        if (token_count > flag_index) {
+            if (quoted[flag_index] || strcmp(tokens[flag_index], "rw") != 0 || token_count > flag_index + 1) {
+                set_error(error_message, error_message_length, line_number, "unexpected '%s'", tokens[flag_index]);
+                goto cleanup;
+            }
+
+            entry.flags |= TF_MODBUS_TCP_REGISTER_MAP_ENTRY_FLAG_WRITABLE;
+        }
+
+        ensure_capacity(&words, &word_capacity, word_count + entry.register_count);
+        memset(words + word_count, 0, entry.register_count * sizeof(uint16_t));
+
+        if (value_index >= 0 && token_count > value_index) {
+            const char *value     = tokens[value_index];
+            uint16_t *value_words = words + word_count;
+            int64_t integer       = 0;
+            bool valid            = true;
+
+            switch (static_cast<TFModbusTCPRegisterMapValueType>(entry.value_type)) {
+            case TFModbusTCPRegisterMapValueType::Bit:
+                valid = parse_integer(value, 0, 1, &integer);
+                value_words[0] = static_cast<uint16_t>(integer);
+                break;
+
+            case TFModbusTCPRegisterMapValueType::U16:
+            case TFModbusTCPRegisterMapValueType::I16:
+                valid = entry.value_type == static_cast<uint8_t>(TFModbusTCPRegisterMapValueType::U16) ? parse_integer(value, 0, UINT16_MAX, &integer)
+                                                                                                      : parse_integer(value, INT16_MIN, INT16_MAX, &integer);
+                value_words[0] = static_cast<uint16_t>(integer);
+                break;
+
+            case TFModbusTCPRegisterMapValueType::U32:
+            case TFModbusTCPRegisterMapValueType::I32:
+                valid = entry.value_type == static_cast<uint8_t>(TFModbusTCPRegisterMapValueType::U32) ? parse_integer(value, 0, UINT32_MAX, &integer)
+                                                                                                      : parse_integer(value, INT32_MIN, INT32_MAX, &integer);
+                value_words[0] = static_cast<uint16_t>(static_cast<uint32_t>(integer) >> 16);
+                value_words[1] = static_cast<uint16_t>(integer);
+                break;
+
+            case TFModbusTCPRegisterMapValueType::F32:
+                {
+                    char *end;
+                    float f32 = strtof(value, &end);
+                    uint32_t u32;
+
+                    valid = end != value && *end == '\0';
+
+                    memcpy(&u32, &f32, sizeof(u32));
+
+                    value_words[0] = static_cast<uint16_t>(u32 >> 16);
+                    value_words[1] = static_cast<uint16_t>(u32);
+                }
+
+                break;
+
+            case TFModbusTCPRegisterMapValueType::String:
+                {
+                    size_t value_length = strlen(value);
+
+                    valid = quoted[value_index] && value_length <= entry.register_count * 2u;
+
+                    for (size_t i = 0; valid && i < value_length; ++i) {
+                        value_words[i / 2] |= static_cast<uint16_t>(static_cast<uint8_t>(value[i]) << ((i % 2) == 0 ? 8 : 0));
+                    }
+                }
+
+                break;
+            }
+
+            if (!valid) {
+                set_error(error_message, error_message_length, line_number, "invalid %s value '%s'", type, value);
+                goto cleanup;
+            }
+        }
+
+        word_count += entry.register_count;
+
+        const char *name = tokens[2];
+        size_t name_size = strlen(name) + 1;
+
+        for (size_t i = 0; i < entry_count; ++i) {
+            if (strcmp(names + entries[i].name_offset, name) == 0) {
+                set_error(error_message, error_message_length, line_number, "duplicate name '%s'", name);
+                goto cleanup;
+            }
+        }
+
+        ensure_capacity(&names, &name_capacity, name_length + name_size);
+        memcpy(names + name_length, name, name_size);
+
+        entry.name_offset = static_cast<uint32_t>(name_length);
+        name_length      += name_size;
+
+        ensure_capacity(&entries, &entry_capacity, entry_count + 1);
+        ensure_capacity(&entry_lines, &entry_line_capacity, entry_count + 1);
+
+        entries[entry_count]       = entry;
+        entry_lines[entry_count++] = line_number;
+    }
+
+    {
+        // Sort by table and address. Lines are only needed to report
+        // overlaps, so sort an index and reorder afterwards
+        size_t *order = new size_t[entry_count + 1];
+
+        for (size_t i = 0; i < entry_count; ++i) {
+            order[i] = i;
+        }
+
+        std::stable_sort(order, order + entry_count, [entries](size_t a, size_t b) { return entry_less(entries[a], entries[b]); });
+
+        for (size_t i = 1; i < entry_count; ++i) {
+            const TFModbusTCPRegisterMapEntry &previous = entries[order[i - 1]];
+            const TFModbusTCPRegisterMapEntry &current  = entries[order[i]];
+
+            if (previous.data_type == current.data_type
+             && static_cast<uint32_t>(previous.start_address) + previous.register_count > current.start_address) {
+                set_error(error_message, error_message_length, entry_lines[order[i]], "entry overlaps with line %zu", entry_lines[order[i - 1]]);
+                delete[] order;
+                goto cleanup;
+            }
+        }
+
+        // Lay out the words in address order too, so that a read walks
+        // through memory sequentially
+        size_t entries_offset = sizeof(TFModbusTCPRegisterMapHeader);
+        size_t words_offset   = entries_offset + entry_count * sizeof(TFModbusTCPRegisterMapEntry);
+        size_t names_offset   = words_offset + word_count * sizeof(uint16_t);
+
+        *binary_length = names_offset + name_length;
+        *binary        = new uint8_t[*binary_length];
+
+        TFModbusTCPRegisterMapHeader header;
+
+        header.magic          = MAP_MAGIC;
+        header.version        = MAP_VERSION;
+        header.reserved       = 0;
+        header.entry_count    = static_cast<uint32_t>(entry_count);
+        header.word_count     = static_cast<uint32_t>(word_count);
+        header.name_length    = static_cast<uint32_t>(name_length);
+        header.entries_offset = static_cast<uint32_t>(entries_offset);
+        header.words_offset   = static_cast<uint32_t>(words_offset);
+        header.names_offset   = static_cast<uint32_t>(names_offset);
+
+        memcpy(*binary, &header, sizeof(header));
+
+        uint32_t value_offset = 0;
+
+        for (size_t i = 0; i < entry_count; ++i) {
+            TFModbusTCPRegisterMapEntry entry = entries[order[i]];
+
+            memcpy(*binary + words_offset + value_offset * sizeof(uint16_t), words + entry.value_offset, entry.register_count * sizeof(uint16_t));
+
+            entry.value_offset = value_offset;
+            value_offset      += entry.register_count;
+
+            memcpy(*binary + entries_offset + i * sizeof(TFModbusTCPRegisterMapEntry), &entry, sizeof(entry));
+        }
+
+        if (name_length > 0) {
+            memcpy(*binary + names_offset, names, name_length);
+        }
+
+        delete[] order;
+        success = true;
+    }
+
+cleanup:
+    delete[] entries;
+    delete[] entry_lines;
+    delete[] words;
+    delete[] names;
+    delete[] line;
+
+    return success;
+}
+
+bool TFModbusTCPRegisterMap::compile_file(const char *source_path, const char *binary_path, char *error_message, size_t error_message_length)
+{
+    FILE *file = fopen(source_path, "rb");
+
+    if (file == nullptr) {
+        set_error(error_message, error_message_length, 0, "could not open '%s': %s (%d)", source_path, strerror(errno), errno);
+        return false;
+    }
+
+    char *source         = nullptr;
+    size_t source_length = 0;
+    long file_length;
+
+    if (fseek(file, 0, SEEK_END) == 0 && (file_length = ftell(file)) >= 0 && fseek(file, 0, SEEK_SET) == 0) {
+        source        = new char[file_length + 1];
+        source_length = fread(source, 1, static_cast<size_t>(file_length), file);
+    }
+
+    fclose(file);
+
+    if (source == nullptr) {
+        set_error(error_message, error_message_length, 0, "could not read '%s'", source_path);
+        return false;
+    }
+
+    uint8_t *binary;
+    size_t binary_length;
+    bool success = compile(source, source_length, &binary, &binary_length, error_message, error_message_length);
+
+    delete[] source;
+
+    if (!success) {
+        return false;
+    }
+
+    file = fopen(binary_path, "wb");
+
+    if (file == nullptr) {
+        set_error(error_message, error_message_length, 0, "could not open '%s': %s (%d)", binary_path, strerror(errno), errno);
+        success = false;
+    }
+    else {
+        bool written    = fwrite(binary, 1, binary_length, file) == binary_length;
+        int saved_errno = errno;
+        bool closed     = fclose(file) == 0;
+
+        if (closed) {
+            errno = saved_errno;
+        }
+
+        if (!written || !closed) {
+            set_error(error_message, error_message_length, 0, "could not write '%s': %s (%d)", binary_path, strerror(errno), errno);
+            success = false;
+        }
+    }
+
+    delete[] binary;
+
+    return success;
+}
+
+bool TFModbusTCPRegisterMap::load(const char *path)
+{
+    if (buffer != nullptr) {
+        debugfln("load(path=%s) already loaded", path);
+        return false;
+    }
+
+#if defined(__linux__)
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        debugfln("load(path=%s) open failed (errno=%d)", path, errno);
+        return false;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) < 0 || st.st_size < static_cast<off_t>(sizeof(TFModbusTCPRegisterMapHeader))) {
+        debugfln("load(path=%s) file is too short", path);
+        close(fd);
+        return false;
+    }
+
+    // Private mapping, so that written values stay in this process
+    void *mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        debugfln("load(path=%s) mmap failed (errno=%d)", path, errno);
+        return false;
+    }
+
+    if (!attach(static_cast<uint8_t *>(mapping), static_cast<size_t>(st.st_size), true)) {
+        munmap(mapping, static_cast<size_t>(st.st_size));
+        return false;
+    }
+
+    return true;
+#else
+    FILE *file = fopen(path, "rb");
+
+    if (file == nullptr) {
+        debugfln("load(path=%s) fopen failed (errno=%d)", path, errno);
+        return false;
+    }
+
+    uint8_t *file_buffer = nullptr;
+    long file_length;
+    bool success = false;
+
+    if (fseek(file, 0, SEEK_END) == 0 && (file_length = ftell(file)) >= 0 && fseek(file, 0, SEEK_SET) == 0) {
+        file_buffer = new uint8_t[file_length];
+        success     = fread(file_buffer, 1, static_cast<size_t>(file_length), file) == static_cast<size_t>(file_length);
+    }
+
+    fclose(file);
+
+    if (!success || !attach(file_buffer, static_cast<size_t>(file_length), false)) {
+        delete[] file_buffer;
+        return false;
+    }
+
+    return true;
+#endif
+}
+
+bool TFModbusTCPRegisterMap::load(const uint8_t *binary, size_t binary_length)
+{
+    if (buffer != nullptr) {
+        debugfln("load(binary_length=%zu) already loaded", binary_length);
+        return false;
+    }
+
+    uint8_t *copy = new uint8_t[binary_length];
+
+    memcpy(copy, binary, binary_length);
+
+    if (!attach(copy, binary_length, false)) {
+        delete[] copy;
+        return false;
+    }
+
+    return true;
+}
+
+void TFModbusTCPRegisterMap::unload()
+{
+    if (buffer == nullptr) {
+        return;
+    }
+
+#if defined(__linux__)
+    if (mapped) {
+        munmap(buffer, buffer_length);
+    }
+    else
+#endif
+    {
+        delete[] buffer;
+    }
+
+    buffer        = nullptr;
+    buffer_length = 0;
+    mapped        = false;
+    entries       = nullptr;
+    entry_count   = 0;
+    words         = nullptr;
+    names         = nullptr;
+}
+
+// Validates the whole binary once, so that lookups can trust it
+bool TFModbusTCPRegisterMap::attach(uint8_t *buffer_, size_t buffer_length_, bool mapped_)
+{
+    if (buffer_length_ < sizeof(TFModbusTCPRegisterMapHeader)) {
+        debugfln("attach(buffer_length=%zu) binary is too short", buffer_length_);
+        return false;
+    }
+
+    TFModbusTCPRegisterMapHeader header;
+
+    memcpy(&header, buffer_, sizeof(header));
+
+    if (header.magic != MAP_MAGIC || header.version != MAP_VERSION) {
+        debugfln("attach() binary has wrong magic or version (magic=%08x version=%u)", header.magic, header.version);
+        return false;
+    }
+
+    if ((header.entries_offset % alignof(TFModbusTCPRegisterMapEntry)) != 0
+     || (header.words_offset % alignof(uint16_t)) != 0
+     || static_cast<uint64_t>(header.entries_offset) + static_cast<uint64_t>(header.entry_count) * sizeof(TFModbusTCPRegisterMapEntry) > buffer_length_
+     || static_cast<uint64_t>(header.words_offset) + static_cast<uint64_t>(header.word_count) * sizeof(uint16_t) > buffer_length_
+     || static_cast<uint64_t>(header.names_offset) + header.name_length > buffer_length_
+     || (header.name_length > 0 && buffer_[header.names_offset + header.name_length - 1] != '\0')) {
+        debugfln("attach() binary has invalid layout");
+        return false;
+    }
+
+    const TFModbusTCPRegisterMapEntry *entries_ = reinterpret_cast<const TFModbusTCPRegisterMapEntry *>(buffer_ + header.entries_offset);
+
+    for (size_t i = 0; i < header.entry_count; ++i) {
+        const TFModbusTCPRegisterMapEntry &entry = entries_[i];
+
+        if (entry.data_type >= DATA_TYPE_COUNT
+         || entry.value_type > static_cast<uint8_t>(TFModbusTCPRegisterMapValueType::String)
+         || entry.register_count == 0
+         || static_cast<uint32_t>(entry.start_address) + entry.register_count > UINT16_MAX + 1u
+         || static_cast<uint64_t>(entry.value_offset) + entry.register_count > header.word_count
+         || entry.name_offset >= header.name_length
+         || (i > 0 && (!entry_less(entries_[i - 1], entry)
+                    || (entries_[i - 1].data_type == entry.data_type
+                     && static_cast<uint32_t>(entries_[i - 1].start_address) + entries_[i - 1].register_count > entry.start_address)))) {
+            debugfln("attach() binary has invalid entry (index=%zu)", i);
+            return false;
+        }
+    }
+
+    buffer        = buffer_;
+    buffer_length = buffer_length_;
+    mapped        = mapped_;
+    entries       = entries_;
+    entry_count   = header.entry_count;
+    words         = reinterpret_cast<uint16_t *>(buffer_ + header.words_offset);
+    names         = reinterpret_cast<const char *>(buffer_ + header.names_offset);
+
+    return true;
+}
+
+const TFModbusTCPRegisterMapEntry *TFModbusTCPRegisterMap::find_entry(const char *name) const
+{
+    for (size_t i = 0; i < entry_count; ++i) {
+        if (strcmp(names + entries[i].name_offset, name) == 0) {
+            return &entries[i];
+        }
+    }
+
+    return nullptr;
+}
+
+// Returns the last entry that starts at or before the address in the given
+// table, or entry_count if there is none
+size_t TFModbusTCPRegisterMap::find_first_entry(TFModbusTCPDataType data_type, uint16_t address) const
+{
+    TFModbusTCPRegisterMapEntry key;
+
+    key.data_type     = static_cast<uint8_t>(data_type);
+    key.start_address = address;
+
+    const TFModbusTCPRegisterMapEntry *upper = std::upper_bound(entries, entries + entry_count, key, entry_less);
+
+    if (upper == entries || (upper - 1)->data_type != key.data_type) {
+        return entry_count;
+    }
+
+    return static_cast<size_t>(upper - 1 - entries);
+}
+
+TFModbusTCPExceptionCode TFModbusTCPRegisterMap::transfer(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, void *data_values, bool writing, bool check_writable)
+{
+    if (buffer == nullptr) {
+        return TFModbusTCPExceptionCode::ServerDeviceFailure;
+    }
+
+    size_t first_index   = find_first_entry(data_type, start_address);
+    uint32_t end_address = static_cast<uint32_t>(start_address) + data_count;
+    bool bit_type        = is_bit_type(static_cast<uint8_t>(data_type));
+
+    // Check the whole span first, so that a rejected write changes nothing
+    for (int stage = 0; stage < 2; ++stage) {
+        uint32_t address = start_address;
+
+        for (size_t index = first_index; address < end_address; ++index) {
+            if (index >= entry_count) {
+                return TFModbusTCPExceptionCode::IllegalDataAddress;
+            }
+
+            const TFModbusTCPRegisterMapEntry &entry = entries[index];
+            uint32_t entry_end                       = static_cast<uint32_t>(entry.start_address) + entry.register_count;
+
+            if (entry.data_type != static_cast<uint8_t>(data_type) || entry.start_address > address || entry_end <= address) {
+                return TFModbusTCPExceptionCode::IllegalDataAddress;
+            }
+
+            if (check_writable && (entry.flags & TF_MODBUS_TCP_REGISTER_MAP_ENTRY_FLAG_WRITABLE) == 0) {
+                return TFModbusTCPExceptionCode::IllegalDataAddress;
+            }
+
+            uint32_t chunk_end = std::min(entry_end, end_address);
+
+            if (stage == 1) {
+                uint16_t *entry_words = words + entry.value_offset + (address - entry.start_address);
+                uint32_t chunk_count  = chunk_end - address;
+                uint32_t value_offset = address - start_address;
+
+                if (bit_type) {
+                    uint8_t *bits = static_cast<uint8_t *>(data_values);
+
+                    for (uint32_t i = 0; i < chunk_count; ++i) {
+                        uint32_t bit = value_offset + i;
+
+                        if (writing) {
+                            entry_words[i] = (bits[bit / 8] >> (bit % 8)) & 1;
+                        }
+                        else if (entry_words[i] != 0) {
+                            bits[bit / 8] |= static_cast<uint8_t>(1u << (bit % 8));
+                        }
+                        else {
+                            bits[bit / 8] &= static_cast<uint8_t>(~(1u << (bit % 8)));
+                        }
+                    }
+                }
+                else if (writing) {
+                    memcpy(entry_words, static_cast<uint16_t *>(data_values) + value_offset, chunk_count * sizeof(uint16_t));
+                }
+                else {
+                    memcpy(static_cast<uint16_t *>(data_values) + value_offset, entry_words, chunk_count * sizeof(uint16_t));
+                }
+            }
+
+            address = chunk_end;
+        }
+    }
+
+    return TFModbusTCPExceptionCode::Success;
+}
+
+TFModbusTCPExceptionCode TFModbusTCPRegisterMap::read(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, void *data_values)
+{
+    return transfer(data_type, start_address, data_count, data_values, false, false);
+}
+
+TFModbusTCPExceptionCode TFModbusTCPRegisterMap::write(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, const void *data_values)
+{
+    return transfer(data_type, start_address, data_count, const_cast<void *>(data_values), true, true);
+}
+
+TFModbusTCPExceptionCode TFModbusTCPRegisterMap::set_values(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, const void *data_values)
+{
+    return transfer(data_type, start_address, data_count, const_cast<void *>(data_values), true, false);
+}
@@ -0,0 +1,114 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "TFModbusTCPRegisterBank.h"
+
+enum class TFModbusTCPRegisterMapValueType : uint8_t
+{
+    Bit,
+    U16,
+    I16,
+    U32,
+    I32,
+    F32,
+    String,
+};
+
+const char *get_tf_modbus_tcp_register_map_value_type_name(TFModbusTCPRegisterMapValueType value_type);
+
+#define TF_MODBUS_TCP_REGISTER_MAP_ENTRY_FLAG_WRITABLE (1u << 0)
+
+// One interval of the index, 16 bytes so that the compiled form can be used
+// in place. Values are stored as precomputed register words in host byte
+// order, bits as one word of 0 or 1 each
+struct TFModbusTCPRegisterMapEntry
+{
+    uint8_t data_type; // TFModbusTCPDataType
+    uint8_t value_type; // TFModbusTCPRegisterMapValueType
+    uint8_t flags;
+    uint8_t reserved;
+    uint16_t start_address;
+    uint16_t register_count;
+    uint32_t value_offset; // in words
+    uint32_t name_offset; // in bytes
+};
+
+static_assert(sizeof(TFModbusTCPRegisterMapEntry) == 16, "TFModbusTCPRegisterMapEntry has unexpected size");
+
+struct TFModbusTCPRegisterMapHeader;
+
+// Register bank described by a register map file instead of code. The text
+// source has one entry per line:
+//
+//   <table> <address> <name> <type> [<value>] [rw]
+//
+// table is coil, discrete, input or holding. address is a number or + to
+// continue after the previous entry of the same table. type is bit, u16, i16,
+// u32, i32, f32 (two registers, high word first) or stringN (N registers, two
+// characters per register, zero padded). A value is a number or a quoted
+// string, rw allows clients to write the entry. # starts a comment.
+//
+// compile() turns the source into a binary index of entries sorted by table
+// and address. load() validates the binary once and then serves requests
+// from it by binary search, without parsing. On Linux the file is mapped
+// copy-on-write, so writes stay local to the process
+class TFModbusTCPRegisterMap final : public TFModbusTCPRegisterBank
+{
+public:
+    TFModbusTCPRegisterMap() {}
+    ~TFModbusTCPRegisterMap() { unload(); }
+
+    // The binary is allocated with new[], the error message names the line
+    static bool compile(const char *source, size_t source_length, uint8_t **binary, size_t *binary_length, char *error_message, size_t error_message_length);
+    static bool compile_file(const char *source_path, const char *binary_path, char *error_message, size_t error_message_length);
+
+    bool load(const char *path);
+    bool load(const uint8_t *binary, size_t binary_length); // copies the binary
+    void unload();
+
+    size_t get_entry_count() const { return entry_count; }
+    const TFModbusTCPRegisterMapEntry *get_entry(size_t index) const { return index < entry_count ? &entries[index] : nullptr; }
+    const char *get_entry_name(const TFModbusTCPRegisterMapEntry *entry) const { return names + entry->name_offset; }
+    const TFModbusTCPRegisterMapEntry *find_entry(const char *name) const; // linear, meant for startup
+
+    // read() and write() serve clients, write() only changes writable
+    // entries. set_values() lets the application update any entry
+    TFModbusTCPExceptionCode read(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, void *data_values) override;
+    TFModbusTCPExceptionCode write(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, const void *data_values) override;
+    TFModbusTCPExceptionCode set_values(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, const void *data_values);
+
+private:
+    bool attach(uint8_t *buffer_, size_t buffer_length_, bool mapped_);
+    size_t find_first_entry(TFModbusTCPDataType data_type, uint16_t address) const;
+    TFModbusTCPExceptionCode transfer(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, void *data_values, bool writing, bool check_writable);
+
+    uint8_t *buffer                            = nullptr;
+    size_t buffer_length                       = 0;
+    bool mapped                                = false;
+    const TFModbusTCPRegisterMapEntry *entries = nullptr;
+    size_t entry_count                         = 0;
+    uint16_t *words                            = nullptr;
+    const char *names                          = nullptr;
+};
@@ -26,6 +26,7 @@
 #include <algorithm>
 
 #include "TFNetwork.h"
+#include "TFModbusTCPRegisterBank.h"
 
 #define debugfln(fmt, ...) tf_network_debugfln("TFModbusTCPServer[%p]::" fmt, static_cast<void *>(this) __VA_OPT__(,) __VA_ARGS__)
 
@@ -77,6 +78,7 @@ bool TFModbusTCPServer::start(uint32_t bind_address, uint16_t port,
     }
 
     TFNetwork::NonReentrantScope scope(&non_reentrant);
+    tf_network_allocation_scope(ServerStart);
 
     debugfln("start(bind_address=%s port=%u)", bind_address_str, port);
 
@@ -192,6 +194,7 @@ bool TFModbusTCPServer::stop()
     }
 
     TFNetwork::NonReentrantScope scope(&non_reentrant);
+    tf_network_allocation_scope(ServerStop);
 
     if (server_fd < 0) {
         debugfln("stop() not running");
@@ -223,6 +226,26 @@ bool TFModbusTCPServer::stop()
     return true;
 }
 
+// Only requests that are passed to the request callback can be deferred
+static bool is_deferrable(TFModbusTCPFunctionCode function_code)
+{
+    switch (function_code) {
+    case TFModbusTCPFunctionCode::ReadCoils:
+    case TFModbusTCPFunctionCode::ReadDiscreteInputs:
+    case TFModbusTCPFunctionCode::ReadHoldingRegisters:
+    case TFModbusTCPFunctionCode::ReadInputRegisters:
+    case TFModbusTCPFunctionCode::WriteSingleCoil:
+    case TFModbusTCPFunctionCode::WriteSingleRegister:
+    case TFModbusTCPFunctionCode::WriteMultipleCoils:
+    case TFModbusTCPFunctionCode::WriteMultipleRegisters:
+    case TFModbusTCPFunctionCode::MaskWriteRegister:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
 // non-reentrant
 void TFModbusTCPServer::tick()
 {
@@ -232,6 +255,7 @@ void TFModbusTCPServer::tick()
     }
 
     TFNetwork::NonReentrantScope scope(&non_reentrant);
+    tf_network_allocation_scope(ServerTick);
 
     if (server_fd < 0) {
         return;
@@ -244,7 +268,12 @@ void TFModbusTCPServer::tick()
     FD_SET(server_fd, &fdset);
 
     for (TFModbusTCPServerClientNode *node = client_sentinel.next; node != nullptr; node = node->next) {
-        int socket_fd = static_cast<TFModbusTCPServerClient *>(node)->socket_fd;
+        TFModbusTCPServerClient *client = static_cast<TFModbusTCPServerClient *>(node);
+        int socket_fd                   = client->socket_fd;
+
+        if (client->deferred_request_id != 0) {
+            continue; // no further requests until the deferred response is finished
+        }
 
         FD_SET(socket_fd, &fdset);
 
@@ -267,9 +296,11 @@ void TFModbusTCPServer::tick()
     }
 
     if (readable_fd_count > 0 && FD_ISSET(server_fd, &fdset)) {
+        tf_network_allocation_scope(Accept);
+
         struct sockaddr_in addr_in;
         socklen_t addr_in_length = sizeof(addr_in);
-        int socket_fd            = accept(server_fd, reinterpret_cast<struct sockaddr *>(&addr_in), &addr_in_length);
+        int socket_fd            = tf_network_socket_accept(server_fd, reinterpret_cast<struct sockaddr *>(&addr_in), &addr_in_length);
 
         if (socket_fd < 0) {
             debugfln("tick() accept() failed: %s (%d)", strerror(errno), errno);
@@ -287,12 +318,10 @@ void TFModbusTCPServer::tick()
 
         TFModbusTCPServerClientNode *node_prev = nullptr;
         TFModbusTCPServerClientNode *node      = &client_sentinel;
-        size_t client_count                    = 0;
 
         while (node->next != nullptr) {
             node_prev = node;
             node      = node->next;
-            ++client_count;
         }
 
         if (client_count >= TF_MODBUS_TCP_SERVER_MAX_CLIENT_COUNT && node != &client_sentinel) {
@@ -302,7 +331,6 @@ void TFModbusTCPServer::tick()
                 debugfln("tick() disconnecting client due to displacement by another connection (client=%p)", static_cast<void *>(client));
 
                 node_prev->next = nullptr;
-                --client_count;
 
                 disconnect(client, TFModbusTCPServerDisconnectReason::Displaced, -1);
             }
@@ -312,7 +340,8 @@ void TFModbusTCPServer::tick()
             debugfln("tick() no free client for connection (socket_fd=%d peer_address=%s port=%u)", socket_fd, peer_address_str, port);
 
             shutdown(socket_fd, SHUT_RDWR);
-            close(socket_fd);
+            tf_network_socket_close(socket_fd);
+            ++statistics.rejected_connection_count;
             disconnect_callback(peer_address, port, TFModbusTCPServerDisconnectReason::NoFreeClient, -1);
         }
         else {
@@ -328,8 +357,12 @@ void TFModbusTCPServer::tick()
             client->pending_request_header_used    = 0;
             client->pending_request_header_checked = false;
             client->pending_request_payload_used   = 0;
+            client->deferred_request_id            = 0;
             client->next                           = client_sentinel.next;
             client_sentinel.next                   = client;
+
+            ++client_count;
+            ++statistics.accepted_connection_count;
         }
     }
 
@@ -356,9 +389,10 @@ void TFModbusTCPServer::tick()
             break;
         }
 
-        node         = pending_head;
-        pending_head = node->next;
-        node->next   = nullptr;
+        node           = pending_head;
+        pending_head   = node->next;
+        node->next     = nullptr;
+        current_client = nullptr;
 
         TFModbusTCPServerClient *client = static_cast<TFModbusTCPServerClient *>(node);
 
@@ -370,7 +404,7 @@ void TFModbusTCPServer::tick()
             continue;
         }
 
-        if (readable_fd_count == 0 || !FD_ISSET(client->socket_fd, &fdset)) {
+        if (readable_fd_count == 0 || client->deferred_request_id != 0 || !FD_ISSET(client->socket_fd, &fdset)) {
             if (finished_tail == nullptr) {
                 finished_head = node;
                 finished_tail = node;
@@ -389,10 +423,10 @@ void TFModbusTCPServer::tick()
         size_t pending_request_header_missing = sizeof(client->pending_request.header) - client->pending_request_header_used;
 
         if (pending_request_header_missing > 0) {
-            ssize_t result = recv(client->socket_fd,
-                                  client->pending_request.header.bytes + client->pending_request_header_used,
-                                  pending_request_header_missing,
-                                  0);
+            ssize_t result = tf_network_socket_recv(client->socket_fd,
+                                                    client->pending_request.header.bytes + client->pending_request_header_used,
+                                                    pending_request_header_missing,
+                                                    0);
 
             if (result < 0) {
                 if (errno != EAGAIN && errno != EWOULDBLOCK) {
@@ -464,10 +498,10 @@ void TFModbusTCPServer::tick()
                                                - client->pending_request_payload_used;
 
         if (pending_request_payload_missing > 0) {
-            ssize_t result = recv(client->socket_fd,
-                                  client->pending_request.payload.bytes + client->pending_request_payload_used,
-                                  pending_request_payload_missing,
-                                  0);
+            ssize_t result = tf_network_socket_recv(client->socket_fd,
+                                                    client->pending_request.payload.bytes + client->pending_request_payload_used,
+                                                    pending_request_payload_missing,
+                                                    0);
 
             if (result < 0) {
                 if (errno != EAGAIN && errno != EWOULDBLOCK) {
@@ -501,6 +535,8 @@ void TFModbusTCPServer::tick()
 
         TFModbusTCPExceptionCode exception_code = TFModbusTCPExceptionCode::Success;
 
+        current_client = client;
+
         switch (static_cast<TFModbusTCPFunctionCode>(client->pending_request.payload.function_code)) {
         case TFModbusTCPFunctionCode::ReadCoils:
         case TFModbusTCPFunctionCode::ReadDiscreteInputs:
@@ -529,13 +565,11 @@ void TFModbusTCPServer::tick()
                                                          + offsetof(TFModbusTCPResponsePayload, coil_values)
                                                          + client->response.payload.byte_count;
 
-                    exception_code = request_callback(client->pending_request.header.unit_id,
+                    exception_code = dispatch_request(client->pending_request.header.unit_id,
                                                       static_cast<TFModbusTCPFunctionCode>(client->pending_request.payload.function_code),
                                                       ntohs(client->pending_request.payload.start_address),
                                                       data_count,
                                                       client->response.payload.coil_values);
-
-                    client->response.payload.coil_values[client->response.payload.byte_count - 1] &= (1u << (data_count % 8)) - 1;
                 }
             }
 
@@ -568,17 +602,11 @@ void TFModbusTCPServer::tick()
                                                          + offsetof(TFModbusTCPResponsePayload, register_values)
                                                          + client->response.payload.byte_count;
 
-                    exception_code = request_callback(client->pending_request.header.unit_id,
+                    exception_code = dispatch_request(client->pending_request.header.unit_id,
                                                       static_cast<TFModbusTCPFunctionCode>(client->pending_request.payload.function_code),
                                                       ntohs(client->pending_request.payload.start_address),
                                                       data_count,
                                                       client->response.payload.register_values);
-
-                    if (register_byte_order == TFModbusTCPByteOrder::Host) {
-                        for (size_t i = 0; i < data_count; ++i) {
-                            client->response.payload.register_values[i] = htons(client->response.payload.register_values[i]);
-                        }
-                    }
                 }
             }
 
@@ -611,7 +639,7 @@ void TFModbusTCPServer::tick()
 
                     uint8_t coil_values[1] = {static_cast<uint8_t>(data_value == 0xFF00 ? 1 : 0)};
 
-                    exception_code = request_callback(client->pending_request.header.unit_id,
+                    exception_code = dispatch_request(client->pending_request.header.unit_id,
                                                       TFModbusTCPFunctionCode::WriteMultipleCoils,
                                                       ntohs(client->pending_request.payload.start_address),
                                                       1,
@@ -646,7 +674,7 @@ void TFModbusTCPServer::tick()
                     register_values[0] = ntohs(register_values[0]);
                 }
 
-                exception_code = request_callback(client->pending_request.header.unit_id,
+                exception_code = dispatch_request(client->pending_request.header.unit_id,
                                                   TFModbusTCPFunctionCode::WriteMultipleRegisters,
                                                   ntohs(client->pending_request.payload.start_address),
                                                   1,
@@ -700,7 +728,7 @@ void TFModbusTCPServer::tick()
                         client->pending_request.payload.coil_values[client->pending_request.payload.byte_count - 1] &= (1u << (data_count % 8)) - 1;
                     }
 
-                    exception_code = request_callback(client->pending_request.header.unit_id,
+                    exception_code = dispatch_request(client->pending_request.header.unit_id,
                                                       static_cast<TFModbusTCPFunctionCode>(client->pending_request.payload.function_code),
                                                       ntohs(client->pending_request.payload.start_address),
                                                       data_count,
@@ -757,7 +785,7 @@ void TFModbusTCPServer::tick()
                         }
                     }
 
-                    exception_code = request_callback(client->pending_request.header.unit_id,
+                    exception_code = dispatch_request(client->pending_request.header.unit_id,
                                                       static_cast<TFModbusTCPFunctionCode>(client->pending_request.payload.function_code),
                                                       ntohs(client->pending_request.payload.start_address),
                                                       data_count,
@@ -794,7 +822,7 @@ void TFModbusTCPServer::tick()
                     register_values[1] = ntohs(register_values[1]);
                 }
 
-                exception_code = request_callback(client->pending_request.header.unit_id,
+                exception_code = dispatch_request(client->pending_request.header.unit_id,
                                                   TFModbusTCPFunctionCode::MaskWriteRegister,
                                                   ntohs(client->pending_request.payload.start_address),
                                                   2,
@@ -803,36 +831,122 @@ void TFModbusTCPServer::tick()
 
             break;
 
-        default:
-            exception_code = TFModbusTCPExceptionCode::IllegalFunction;
+        case TFModbusTCPFunctionCode::ReadFileRecord:
+        case TFModbusTCPFunctionCode::WriteFileRecord:
+            {
+                uint16_t min_frame_length = TF_MODBUS_TCP_FRAME_IN_HEADER_LENGTH
+                                          + offsetof(TFModbusTCPRequestPayload, file_bytes);
+
+                if (frame_length < min_frame_length) {
+                    debugfln("tick() disconnecting client due to protocol error, frame length too short (client=%p frame_length=%u min_frame_length=%u)",
+                             static_cast<void *>(client), frame_length, min_frame_length);
+
+                    node = nullptr;
+                    disconnect(client, TFModbusTCPServerDisconnectReason::ProtocolError, -1);
+                    continue;
+                }
+
+                uint16_t expected_frame_length = min_frame_length + client->pending_request.payload.file_byte_count;
+
+                if (frame_length != expected_frame_length) {
+                    debugfln("tick() disconnecting client due to protocol error, frame length mismatch (client=%p frame_length=%u expected_frame_length=%u)",
+                             static_cast<void *>(client), frame_length, expected_frame_length);
+
+                    node = nullptr;
+                    disconnect(client, TFModbusTCPServerDisconnectReason::ProtocolError, -1);
+                    continue;
+                }
+
+                exception_code = handle_file_record_request(client);
+            }
+
             break;
-        }
 
-        if (exception_code != TFModbusTCPExceptionCode::ForceTimeout) {
-            client->response.payload.function_code  = client->pending_request.payload.function_code;
+        case TFModbusTCPFunctionCode::ReadFIFOQueue:
+            {
+                uint16_t expected_frame_length = TF_MODBUS_TCP_FRAME_IN_HEADER_LENGTH
+                                               + offsetof(TFModbusTCPRequestPayload, data_count);
+
+                if (frame_length != expected_frame_length) {
+                    debugfln("tick() disconnecting client due to protocol error, frame length mismatch (client=%p frame_length=%u expected_frame_length=%u)",
+                             static_cast<void *>(client), frame_length, expected_frame_length);
+
+                    node = nullptr;
+                    disconnect(client, TFModbusTCPServerDisconnectReason::ProtocolError, -1);
+                    continue;
+                }
+
+                if (!fifo_queue_callback || is_diagnostics_unit(client->pending_request.header.unit_id)) {
+                    exception_code = TFModbusTCPExceptionCode::IllegalFunction;
+                    break;
+                }
+
+                // The FIFO values are not 2-byte aligned in the response, use
+                // an aligned buffer for the callback
+                uint16_t fifo_values[TF_MODBUS_TCP_MAX_FIFO_COUNT];
+                uint16_t fifo_count = 0;
+
+                exception_code = fifo_queue_callback(client->pending_request.header.unit_id,
+                                                     ntohs(client->pending_request.payload.start_address),
+                                                     fifo_values,
+                                                     &fifo_count);
+
+                if (exception_code != TFModbusTCPExceptionCode::Success) {
+                    break;
+                }
+
+                if (fifo_count > TF_MODBUS_TCP_MAX_FIFO_COUNT) {
+                    exception_code = TFModbusTCPExceptionCode::IllegalDataValue;
+                    break;
+                }
 
-            if (exception_code != TFModbusTCPExceptionCode::Success) {
+                client->response.payload.fifo_byte_count = htons(2 + fifo_count * 2);
+                client->response.payload.fifo_count      = htons(fifo_count);
                 client->response.header.frame_length     = TF_MODBUS_TCP_FRAME_IN_HEADER_LENGTH
-                                                         + offsetof(TFModbusTCPResponsePayload, exception_sentinel);
-                client->response.payload.function_code  |= 0x80;
-                client->response.payload.exception_code  = static_cast<uint8_t>(exception_code);
+                                                         + offsetof(TFModbusTCPResponsePayload, fifo_values)
+                                                         + fifo_count * 2;
+
+                for (size_t i = 0; i < fifo_count; ++i) {
+                    if (register_byte_order == TFModbusTCPByteOrder::Host) {
+                        client->response.payload.fifo_values[i] = htons(fifo_values[i]);
+                    }
+                    else { // TFModbusTCPByteOrder::Network
+                        client->response.payload.fifo_values[i] = fifo_values[i];
+                    }
+                }
             }
 
-            client->response.header.transaction_id = client->pending_request.header.transaction_id;
-            client->response.header.protocol_id    = client->pending_request.header.protocol_id;
-            client->response.header.frame_length   = htons(client->response.header.frame_length);
-            client->response.header.unit_id        = client->pending_request.header.unit_id;
+            break;
 
-            if (!send_response(client)) {
-                int saved_errno = errno;
+        default:
+            exception_code = TFModbusTCPExceptionCode::IllegalFunction;
+            break;
+        }
 
-                debugfln("tick() disconnecting client due to send error (client=%p errno=%d)",
-                        static_cast<void *>(client), saved_errno);
+        current_client = nullptr;
 
-                node = nullptr;
-                disconnect(client, TFModbusTCPServerDisconnectReason::SocketSendFailed, saved_errno);
+        if (exception_code == TFModbusTCPExceptionCode::Deferred) {
+            if (client->deferred_request_id != 0 && is_deferrable(static_cast<TFModbusTCPFunctionCode>(client->pending_request.payload.function_code))) {
+                debugfln("tick() deferring response (client=%p deferred_request_id=%u)", static_cast<void *>(client), client->deferred_request_id);
+                ++statistics.deferred_response_count;
                 continue;
             }
+
+            // only the request callback can defer and only via defer_response
+            exception_code = TFModbusTCPExceptionCode::ServerDeviceFailure;
+        }
+
+        client->deferred_request_id = 0;
+
+        if (!finish_response(client, exception_code)) {
+            int saved_errno = errno;
+
+            debugfln("tick() disconnecting client due to send error (client=%p errno=%d)",
+                    static_cast<void *>(client), saved_errno);
+
+            node = nullptr;
+            disconnect(client, TFModbusTCPServerDisconnectReason::SocketSendFailed, saved_errno);
+            continue;
         }
 
         client->pending_request_header_used    = 0;
@@ -841,16 +955,323 @@ void TFModbusTCPServer::tick()
     }
 
     client_sentinel.next = finished_head;
+    current_client       = nullptr;
+}
+
+uint32_t TFModbusTCPServer::defer_response()
+{
+    if (current_client == nullptr) {
+        debugfln("defer_response() not in request callback");
+        return 0;
+    }
+
+    current_client->deferred_request_id = next_deferred_request_id;
+
+    if (++next_deferred_request_id == 0) {
+        next_deferred_request_id = 1;
+    }
+
+    return current_client->deferred_request_id;
+}
+
+// non-reentrant
+bool TFModbusTCPServer::finish_deferred_response(uint32_t request_id, TFModbusTCPExceptionCode exception_code,
+                                                 const void *data_values /*= nullptr*/, uint16_t data_count /*= 0*/)
+{
+    if (non_reentrant) {
+        debugfln("finish_deferred_response(request_id=%u) non-reentrant", request_id);
+
+        errno = EWOULDBLOCK;
+        return false;
+    }
+
+    TFNetwork::NonReentrantScope scope(&non_reentrant);
+
+    TFModbusTCPServerClientNode *node_prev = &client_sentinel;
+    TFModbusTCPServerClient *client        = nullptr;
+
+    while (request_id != 0 && node_prev->next != nullptr) {
+        TFModbusTCPServerClient *candidate = static_cast<TFModbusTCPServerClient *>(node_prev->next);
+
+        if (candidate->deferred_request_id == request_id) {
+            client = candidate;
+            break;
+        }
+
+        node_prev = node_prev->next;
+    }
+
+    if (client == nullptr) {
+        debugfln("finish_deferred_response(request_id=%u) unknown request, client might be disconnected", request_id);
+
+        errno = ESRCH;
+        return false;
+    }
+
+    debugfln("finish_deferred_response(request_id=%u exception_code=%s) (client=%p)",
+             request_id, get_tf_modbus_tcp_exception_code_name(exception_code), static_cast<void *>(client));
+
+    client->deferred_request_id = 0;
+
+    if (exception_code == TFModbusTCPExceptionCode::Deferred) {
+        exception_code = TFModbusTCPExceptionCode::ServerDeviceFailure;
+    }
+
+    if (exception_code == TFModbusTCPExceptionCode::Success) {
+        uint16_t request_data_count = ntohs(client->pending_request.payload.data_count);
+
+        switch (static_cast<TFModbusTCPFunctionCode>(client->pending_request.payload.function_code)) {
+        case TFModbusTCPFunctionCode::ReadCoils:
+        case TFModbusTCPFunctionCode::ReadDiscreteInputs:
+            if (data_values == nullptr || data_count != request_data_count) {
+                exception_code = TFModbusTCPExceptionCode::ServerDeviceFailure;
+                break;
+            }
+
+            memcpy(client->response.payload.coil_values, data_values, (data_count + 7u) / 8u);
+            break;
+
+        case TFModbusTCPFunctionCode::ReadHoldingRegisters:
+        case TFModbusTCPFunctionCode::ReadInputRegisters:
+            if (data_values == nullptr || data_count != request_data_count) {
+                exception_code = TFModbusTCPExceptionCode::ServerDeviceFailure;
+                break;
+            }
+
+            memcpy(client->response.payload.register_values, data_values, data_count * sizeof(uint16_t));
+            break;
+
+        default:
+            break;
+        }
+
+        if (exception_code != TFModbusTCPExceptionCode::Success) {
+            debugfln("finish_deferred_response(request_id=%u data_count=%u) read values missing (client=%p)",
+                     request_id, data_count, static_cast<void *>(client));
+        }
+    }
+
+    if (!finish_response(client, exception_code)) {
+        int saved_errno = errno;
+
+        debugfln("finish_deferred_response(request_id=%u) disconnecting client due to send error (client=%p errno=%d)",
+                 request_id, static_cast<void *>(client), saved_errno);
+
+        node_prev->next = client->next;
+
+        disconnect(client, TFModbusTCPServerDisconnectReason::SocketSendFailed, saved_errno);
+
+        errno = saved_errno;
+        return false;
+    }
+
+    client->pending_request_header_used    = 0;
+    client->pending_request_header_checked = false;
+    client->pending_request_payload_used   = 0;
+
+    return true;
 }
 
 void TFModbusTCPServer::disconnect(TFModbusTCPServerClient *client, TFModbusTCPServerDisconnectReason reason, int error_number)
 {
     shutdown(client->socket_fd, SHUT_RDWR);
-    close(client->socket_fd);
+    tf_network_socket_close(client->socket_fd);
+    --client_count;
+    ++statistics.disconnected_connection_count;
     disconnect_callback(client->peer_address, client->port, reason, error_number);
     delete client;
 }
 
+TFModbusTCPExceptionCode TFModbusTCPServer::dispatch_request(uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values)
+{
+    if (!is_diagnostics_unit(unit_id)) {
+        return request_callback(unit_id, function_code, start_address, data_count, data_values);
+    }
+
+    if (function_code != TFModbusTCPFunctionCode::ReadInputRegisters) {
+        return TFModbusTCPExceptionCode::IllegalFunction;
+    }
+
+    TFModbusTCPExceptionCode exception_code = diagnostics_bank->read(TFModbusTCPDataType::InputRegister, start_address, data_count, data_values);
+
+    // register banks use host byte order
+    if (exception_code == TFModbusTCPExceptionCode::Success && register_byte_order == TFModbusTCPByteOrder::Network) {
+        uint8_t *register_values = static_cast<uint8_t *>(data_values);
+
+        for (size_t i = 0; i < data_count; ++i) {
+            uint16_t register_value;
+
+            memcpy(&register_value, register_values + i * sizeof(register_value), sizeof(register_value));
+            register_value = htons(register_value);
+            memcpy(register_values + i * sizeof(register_value), &register_value, sizeof(register_value));
+        }
+    }
+
+    return exception_code;
+}
+
+// All sub-requests are validated before the first callback is called, so that
+// a malformed request doesn't result in a partial write
+TFModbusTCPExceptionCode TFModbusTCPServer::handle_file_record_request(TFModbusTCPServerClient *client)
+{
+    if (!file_record_callback || is_diagnostics_unit(client->pending_request.header.unit_id)) {
+        return TFModbusTCPExceptionCode::IllegalFunction;
+    }
+
+    TFModbusTCPFunctionCode function_code = static_cast<TFModbusTCPFunctionCode>(client->pending_request.payload.function_code);
+    bool write                            = function_code == TFModbusTCPFunctionCode::WriteFileRecord;
+    uint8_t byte_count                    = client->pending_request.payload.file_byte_count;
+    uint8_t *file_bytes                   = client->pending_request.payload.file_bytes;
+
+    if (byte_count < TF_MODBUS_TCP_MIN_FILE_RECORD_BYTE_COUNT
+     || byte_count > TF_MODBUS_TCP_MAX_FILE_RECORD_BYTE_COUNT
+     || (!write && (byte_count % TF_MODBUS_TCP_FILE_RECORD_SUB_REQUEST_LENGTH) != 0)) {
+        return TFModbusTCPExceptionCode::IllegalDataValue;
+    }
+
+    size_t response_byte_count = 0;
+
+    for (size_t offset = 0; offset < byte_count;) {
+        if (offset + TF_MODBUS_TCP_FILE_RECORD_SUB_REQUEST_LENGTH > byte_count) {
+            return TFModbusTCPExceptionCode::IllegalDataValue;
+        }
+
+        uint8_t reference_type = file_bytes[offset];
+        uint16_t file_number   = static_cast<uint16_t>((file_bytes[offset + 1] << 8) | file_bytes[offset + 2]);
+        uint16_t record_number = static_cast<uint16_t>((file_bytes[offset + 3] << 8) | file_bytes[offset + 4]);
+        uint16_t record_length = static_cast<uint16_t>((file_bytes[offset + 5] << 8) | file_bytes[offset + 6]);
+
+        if (reference_type != TF_MODBUS_TCP_FILE_RECORD_REFERENCE_TYPE
+         || file_number < TF_MODBUS_TCP_MIN_FILE_NUMBER
+         || record_number > TF_MODBUS_TCP_MAX_RECORD_NUMBER
+         || record_length < 1
+         || record_number + record_length - 1u > TF_MODBUS_TCP_MAX_RECORD_NUMBER) {
+            return TFModbusTCPExceptionCode::IllegalDataAddress;
+        }
+
+        offset += TF_MODBUS_TCP_FILE_RECORD_SUB_REQUEST_LENGTH;
+
+        if (write) {
+            offset += record_length * 2u;
+
+            if (offset > byte_count) {
+                return TFModbusTCPExceptionCode::IllegalDataValue;
+            }
+        }
+        else {
+            response_byte_count += TF_MODBUS_TCP_FILE_RECORD_SUB_RESPONSE_LENGTH + record_length * 2u;
+
+            if (response_byte_count > TF_MODBUS_TCP_MAX_FILE_RECORD_BYTE_COUNT) {
+                return TFModbusTCPExceptionCode::IllegalDataValue;
+            }
+        }
+    }
+
+    uint8_t *response_file_bytes = client->response.payload.file_bytes;
+    size_t response_offset       = 0;
+
+    for (size_t offset = 0; offset < byte_count;) {
+        uint16_t file_number   = static_cast<uint16_t>((file_bytes[offset + 1] << 8) | file_bytes[offset + 2]);
+        uint16_t record_number = static_cast<uint16_t>((file_bytes[offset + 3] << 8) | file_bytes[offset + 4]);
+        uint16_t record_length = static_cast<uint16_t>((file_bytes[offset + 5] << 8) | file_bytes[offset + 6]);
+        uint8_t *record_data;
+
+        offset += TF_MODBUS_TCP_FILE_RECORD_SUB_REQUEST_LENGTH;
+
+        if (write) {
+            record_data = file_bytes + offset;
+            offset     += record_length * 2u;
+        }
+        else {
+            response_file_bytes[response_offset]     = static_cast<uint8_t>(1 + record_length * 2);
+            response_file_bytes[response_offset + 1] = TF_MODBUS_TCP_FILE_RECORD_REFERENCE_TYPE;
+            record_data                              = response_file_bytes + response_offset + TF_MODBUS_TCP_FILE_RECORD_SUB_RESPONSE_LENGTH;
+            response_offset                         += TF_MODBUS_TCP_FILE_RECORD_SUB_RESPONSE_LENGTH + record_length * 2u;
+        }
+
+        TFModbusTCPExceptionCode exception_code = file_record_callback(client->pending_request.header.unit_id,
+                                                                       function_code,
+                                                                       file_number,
+                                                                       record_number,
+                                                                       record_length,
+                                                                       record_data);
+
+        if (exception_code != TFModbusTCPExceptionCode::Success) {
+            return exception_code;
+        }
+    }
+
+    if (write) {
+        memcpy(response_file_bytes, file_bytes, byte_count); // echo
+        response_offset = byte_count;
+    }
+
+    client->response.payload.byte_count  = static_cast<uint8_t>(response_offset);
+    client->response.header.frame_length = TF_MODBUS_TCP_FRAME_IN_HEADER_LENGTH
+                                         + offsetof(TFModbusTCPResponsePayload, file_bytes)
+                                         + response_offset;
+
+    return TFModbusTCPExceptionCode::Success;
+}
+
+// Completes the response to the pending request of the client and sends it
+bool TFModbusTCPServer::finish_response(TFModbusTCPServerClient *client, TFModbusTCPExceptionCode exception_code)
+{
+    if (exception_code == TFModbusTCPExceptionCode::ForceTimeout) {
+        ++statistics.unanswered_request_count;
+        return true;
+    }
+
+    ++statistics.response_count;
+
+    if (exception_code != TFModbusTCPExceptionCode::Success) {
+        ++statistics.exception_response_count;
+    }
+
+    if (exception_code == TFModbusTCPExceptionCode::Success) {
+        uint16_t data_count = ntohs(client->pending_request.payload.data_count);
+
+        switch (static_cast<TFModbusTCPFunctionCode>(client->pending_request.payload.function_code)) {
+        case TFModbusTCPFunctionCode::ReadCoils:
+        case TFModbusTCPFunctionCode::ReadDiscreteInputs:
+            if ((data_count % 8) != 0) {
+                client->response.payload.coil_values[client->response.payload.byte_count - 1] &= (1u << (data_count % 8)) - 1;
+            }
+
+            break;
+
+        case TFModbusTCPFunctionCode::ReadHoldingRegisters:
+        case TFModbusTCPFunctionCode::ReadInputRegisters:
+            if (register_byte_order == TFModbusTCPByteOrder::Host) {
+                for (size_t i = 0; i < data_count; ++i) {
+                    client->response.payload.register_values[i] = htons(client->response.payload.register_values[i]);
+                }
+            }
+
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    client->response.payload.function_code  = client->pending_request.payload.function_code;
+
+    if (exception_code != TFModbusTCPExceptionCode::Success) {
+        client->response.header.frame_length     = TF_MODBUS_TCP_FRAME_IN_HEADER_LENGTH
+                                                 + offsetof(TFModbusTCPResponsePayload, exception_sentinel);
+        client->response.payload.function_code  |= 0x80;
+        client->response.payload.exception_code  = static_cast<uint8_t>(exception_code);
+    }
+
+    client->response.header.transaction_id = client->pending_request.header.transaction_id;
+    client->response.header.protocol_id    = client->pending_request.header.protocol_id;
+    client->response.header.frame_length   = htons(client->response.header.frame_length);
+    client->response.header.unit_id        = client->pending_request.header.unit_id;
+
+    return send_response(client);
+}
+
 bool TFModbusTCPServer::send_response(TFModbusTCPServerClient *client)
 {
     uint8_t *buffer        = client->response.bytes;
@@ -861,7 +1282,7 @@ bool TFModbusTCPServer::send_response(TFModbusTCPServerClient *client)
     while (tries_remaining > 0 && buffer_send < length) {
         --tries_remaining;
 
-        ssize_t result = send(client->socket_fd, buffer + buffer_send, length - buffer_send, MSG_NOSIGNAL);
+        ssize_t result = tf_network_socket_send(client->socket_fd, buffer + buffer_send, length - buffer_send, MSG_NOSIGNAL);
 
         if (result < 0) {
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
@@ -25,6 +25,8 @@
 
 #include "TFModbusTCPCommon.h"
 
+class TFModbusTCPRegisterBank;
+
 // configuration
 #ifndef TF_MODBUS_TCP_SERVER_MAX_CLIENT_COUNT
 #define TF_MODBUS_TCP_SERVER_MAX_CLIENT_COUNT    8
@@ -70,6 +72,23 @@ typedef std::function<TFModbusTCPExceptionCode(uint8_t unit_id,
                                                uint16_t data_count,
                                                void *data_values)> TFModbusTCPServerRequestCallback;
 
+// Called once per record of a Read File Record (20) or Write File Record (21)
+// request. The record data is record_length * 2 bytes in network byte order.
+// For reads it points directly into the response, for writes into the request
+typedef std::function<TFModbusTCPExceptionCode(uint8_t unit_id,
+                                               TFModbusTCPFunctionCode function_code,
+                                               uint16_t file_number,
+                                               uint16_t record_number,
+                                               uint16_t record_length,
+                                               uint8_t *record_data)> TFModbusTCPServerFileRecordCallback;
+
+// Called for a Read FIFO Queue (24) request. Store up to TF_MODBUS_TCP_MAX_FIFO_COUNT
+// values in the configured register byte order and set fifo_count accordingly
+typedef std::function<TFModbusTCPExceptionCode(uint8_t unit_id,
+                                               uint16_t fifo_pointer_address,
+                                               uint16_t *fifo_values,
+                                               uint16_t *fifo_count)> TFModbusTCPServerFIFOQueueCallback;
+
 struct TFModbusTCPServerClientNode
 {
     TFModbusTCPServerClientNode *next = nullptr;
@@ -86,6 +105,18 @@ struct TFModbusTCPServerClient : public TFModbusTCPServerClientNode
     bool pending_request_header_checked;
     size_t pending_request_payload_used;
     TFModbusTCPResponse response;
+    uint32_t deferred_request_id;
+};
+
+struct TFModbusTCPServerStatistics
+{
+    uint64_t accepted_connection_count     = 0;
+    uint64_t rejected_connection_count     = 0; // no free client
+    uint64_t disconnected_connection_count = 0;
+    uint64_t response_count                = 0;
+    uint64_t exception_response_count      = 0;
+    uint64_t deferred_response_count       = 0;
+    uint64_t unanswered_request_count      = 0; // ForceTimeout
 };
 
 class TFModbusTCPServer final
@@ -103,16 +134,58 @@ public:
     bool stop(); // non-reentrant
     void tick(); // non-reentrant
 
+    // File record requests are answered with an Illegal Function exception if
+    // no file record callback is set
+    void set_file_record_callback(TFModbusTCPServerFileRecordCallback &&callback) { file_record_callback = std::move(callback); }
+
+    // FIFO queue requests are answered with an Illegal Function exception if
+    // no FIFO queue callback is set
+    void set_fifo_queue_callback(TFModbusTCPServerFIFOQueueCallback &&callback) { fifo_queue_callback = std::move(callback); }
+
+    // Requests to the diagnostics unit ID are not passed to the request
+    // callback. Input register reads are served directly by the register bank,
+    // e.g. a TFModbusTCPDiagnostics, all other functions are answered with an
+    // Illegal Function exception. Pass nullptr to disable
+    void set_diagnostics_unit(uint8_t unit_id, TFModbusTCPRegisterBank *bank) { diagnostics_unit_id = unit_id; diagnostics_bank = bank; }
+
+    size_t get_client_count() const { return client_count; } // also valid during the request callback
+    const TFModbusTCPServerStatistics *get_statistics() const { return &statistics; }
+
+    // Defers the response to the current request, e.g. for a gateway that has
+    // to forward the request first. Only valid from within the request callback,
+    // which then has to return TFModbusTCPExceptionCode::Deferred. The returned
+    // ID is passed to finish_deferred_response once the outcome is known.
+    // data_values of the request callback is only valid during the callback,
+    // the values of a successful read are passed to finish_deferred_response
+    // instead, in the same format, and are only copied if the client is still
+    // connected. Further requests of the same client wait until the deferred
+    // response is finished. Returns 0 outside of the request callback
+    uint32_t defer_response();
+    bool finish_deferred_response(uint32_t request_id, TFModbusTCPExceptionCode exception_code,
+                                  const void *data_values = nullptr, uint16_t data_count = 0); // non-reentrant
+
 private:
     void disconnect(TFModbusTCPServerClient *client, TFModbusTCPServerDisconnectReason reason, int error_number);
+    bool is_diagnostics_unit(uint8_t unit_id) const { return diagnostics_bank != nullptr && unit_id == diagnostics_unit_id; }
+    TFModbusTCPExceptionCode dispatch_request(uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values);
+    TFModbusTCPExceptionCode handle_file_record_request(TFModbusTCPServerClient *client);
+    bool finish_response(TFModbusTCPServerClient *client, TFModbusTCPExceptionCode exception_code);
     bool send_response(TFModbusTCPServerClient *client);
 
     TFModbusTCPByteOrder register_byte_order;
-    bool non_reentrant       = false;
-    int server_fd            = -1;
-    micros_t last_idle_check = 0_s;
+    bool non_reentrant                        = false;
+    int server_fd                             = -1;
+    size_t client_count                       = 0; // the client list is detached during tick()
+    micros_t last_idle_check                  = 0_s;
+    TFModbusTCPServerClient *current_client   = nullptr;
+    uint32_t next_deferred_request_id         = 1;
+    uint8_t diagnostics_unit_id               = 0;
+    TFModbusTCPRegisterBank *diagnostics_bank = nullptr;
     TFModbusTCPServerConnectCallback connect_callback;
     TFModbusTCPServerDisconnectCallback disconnect_callback;
     TFModbusTCPServerRequestCallback request_callback;
+    TFModbusTCPServerFileRecordCallback file_record_callback;
+    TFModbusTCPServerFIFOQueueCallback fifo_queue_callback;
     TFModbusTCPServerClientNode client_sentinel;
+    TFModbusTCPServerStatistics statistics;
 };
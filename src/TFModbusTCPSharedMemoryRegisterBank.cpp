@@ -0,0 +1,413 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include "TFModbusTCPSharedMemoryRegisterBank.h"
+
+#if defined(__linux__)
+
+#include <algorithm>
+#include <atomic>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "TFNetwork.h"
+
+#define debugfln(fmt, ...) tf_network_debugfln("TFModbusTCPSharedMemoryRegisterBank[%p]::" fmt, static_cast<void *>(this) __VA_OPT__(,) __VA_ARGS__)
+
+#define SEGMENT_MAGIC 0x42525446u // "TFRB"
+#define SEGMENT_VERSION 1
+#define DATA_TYPE_COUNT 4
+#define MAX_SNAPSHOT_RANGE_COUNT 4
+#define YIELD_INTERVAL 100
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared memory requires address-free atomics");
+
+// Placed at the start of the segment, followed by the sequence numbers and
+// the values of each table, all 8 byte aligned
+struct TFModbusTCPSharedMemoryHeader
+{
+    std::atomic<uint32_t> magic; // stored last by the creator
+    uint16_t version;
+    uint16_t range_length;
+    uint16_t counts[DATA_TYPE_COUNT];
+    uint32_t sequence_offsets[DATA_TYPE_COUNT];
+    uint32_t value_offsets[DATA_TYPE_COUNT];
+    uint32_t total_length;
+};
+
+static size_t align8(size_t offset)
+{
+    return (offset + 7u) & ~static_cast<size_t>(7u);
+}
+
+static bool is_bit_type(TFModbusTCPDataType data_type)
+{
+    return data_type == TFModbusTCPDataType::Coil || data_type == TFModbusTCPDataType::DiscreteInput;
+}
+
+static std::atomic<uint32_t> *get_sequences(TFModbusTCPSharedMemoryHeader *header, TFModbusTCPDataType data_type)
+{
+    return reinterpret_cast<std::atomic<uint32_t> *>(reinterpret_cast<uint8_t *>(header) + header->sequence_offsets[static_cast<size_t>(data_type)]);
+}
+
+static uint8_t *get_values(TFModbusTCPSharedMemoryHeader *header, TFModbusTCPDataType data_type)
+{
+    return reinterpret_cast<uint8_t *>(header) + header->value_offsets[static_cast<size_t>(data_type)];
+}
+
+void TFModbusTCPSharedMemoryRegisterBank::copy_values(TFModbusTCPDataType data_type, uint8_t *destination, uint32_t destination_offset, const uint8_t *source, uint32_t source_offset, uint32_t count)
+{
+    if (is_bit_type(data_type)) {
+        copy_bits(destination, destination_offset, source, source_offset, count);
+    }
+    else {
+        memcpy(destination + destination_offset * 2, source + source_offset * 2, count * 2);
+    }
+}
+
+bool TFModbusTCPSharedMemoryRegisterBank::create(const char *name, uint16_t coil_count, uint16_t discrete_input_count, uint16_t input_register_count, uint16_t holding_register_count)
+{
+    if (header != nullptr) {
+        debugfln("create(name=%s) already open", name);
+        return false;
+    }
+
+    uint16_t counts[DATA_TYPE_COUNT] = {coil_count, discrete_input_count, input_register_count, holding_register_count};
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0660);
+
+    if (fd < 0) {
+        if (errno != EEXIST) {
+            debugfln("create(name=%s) shm_open failed (errno=%d)", name, errno);
+            return false;
+        }
+
+        if (!open(name)) {
+            return false;
+        }
+
+        if (memcmp(header->counts, counts, sizeof(counts)) != 0) {
+            debugfln("create(name=%s) existing segment has a different layout", name);
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    uint32_t sequence_offsets[DATA_TYPE_COUNT];
+    uint32_t value_offsets[DATA_TYPE_COUNT];
+    size_t offset = align8(sizeof(TFModbusTCPSharedMemoryHeader));
+
+    for (size_t i = 0; i < DATA_TYPE_COUNT; ++i) {
+        bool bit_type         = is_bit_type(static_cast<TFModbusTCPDataType>(i));
+        uint32_t range_length = TF_MODBUS_TCP_SHARED_MEMORY_REGISTER_BANK_RANGE_LENGTH * (bit_type ? 16u : 1u);
+
+        sequence_offsets[i] = static_cast<uint32_t>(offset);
+        offset              = align8(offset + ((counts[i] + range_length - 1) / range_length) * sizeof(uint32_t));
+        value_offsets[i]    = static_cast<uint32_t>(offset);
+        offset              = align8(offset + (bit_type ? (counts[i] + 7u) / 8u : counts[i] * 2u));
+    }
+
+    // ftruncate() zero-fills, which also initializes all sequence numbers
+    if (ftruncate(fd, static_cast<off_t>(offset)) < 0) {
+        debugfln("create(name=%s) ftruncate failed (errno=%d)", name, errno);
+        ::close(fd);
+        shm_unlink(name);
+        return false;
+    }
+
+    if (!attach(fd, offset)) {
+        shm_unlink(name);
+        return false;
+    }
+
+    header->version      = SEGMENT_VERSION;
+    header->range_length = TF_MODBUS_TCP_SHARED_MEMORY_REGISTER_BANK_RANGE_LENGTH;
+    header->total_length = static_cast<uint32_t>(offset);
+
+    memcpy(header->counts, counts, sizeof(counts));
+    memcpy(header->sequence_offsets, sequence_offsets, sizeof(sequence_offsets));
+    memcpy(header->value_offsets, value_offsets, sizeof(value_offsets));
+
+    header->magic.store(SEGMENT_MAGIC, std::memory_order_release);
+
+    return true;
+}
+
+bool TFModbusTCPSharedMemoryRegisterBank::open(const char *name)
+{
+    if (header != nullptr) {
+        debugfln("open(name=%s) already open", name);
+        return false;
+    }
+
+    int fd = shm_open(name, O_RDWR, 0);
+
+    if (fd < 0) {
+        debugfln("open(name=%s) shm_open failed (errno=%d)", name, errno);
+        return false;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(TFModbusTCPSharedMemoryHeader)) {
+        debugfln("open(name=%s) segment is too short or not initialized yet", name);
+        ::close(fd);
+        return false;
+    }
+
+    if (!attach(fd, static_cast<size_t>(st.st_size))) {
+        return false;
+    }
+
+    if (header->magic.load(std::memory_order_acquire) != SEGMENT_MAGIC
+     || header->version != SEGMENT_VERSION
+     || header->range_length == 0
+     || header->total_length != mapping_length) {
+        debugfln("open(name=%s) segment is invalid or not initialized yet", name);
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool TFModbusTCPSharedMemoryRegisterBank::attach(int fd, size_t length)
+{
+    void *mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int saved_errno = errno;
+
+    ::close(fd);
+
+    if (mapping == MAP_FAILED) {
+        debugfln("attach(length=%zu) mmap failed (errno=%d)", length, saved_errno);
+
+        errno = saved_errno;
+        return false;
+    }
+
+    header         = static_cast<TFModbusTCPSharedMemoryHeader *>(mapping);
+    mapping_length = length;
+
+    return true;
+}
+
+void TFModbusTCPSharedMemoryRegisterBank::close()
+{
+    if (header == nullptr) {
+        return;
+    }
+
+    munmap(header, mapping_length);
+
+    header         = nullptr;
+    mapping_length = 0;
+}
+
+bool TFModbusTCPSharedMemoryRegisterBank::unlink(const char *name)
+{
+    return shm_unlink(name) == 0;
+}
+
+uint16_t TFModbusTCPSharedMemoryRegisterBank::get_count(TFModbusTCPDataType data_type) const
+{
+    if (header == nullptr) {
+        return 0;
+    }
+
+    return header->counts[static_cast<size_t>(data_type)];
+}
+
+uint32_t TFModbusTCPSharedMemoryRegisterBank::get_range_length(TFModbusTCPDataType data_type) const
+{
+    return header->range_length * (is_bit_type(data_type) ? 16u : 1u);
+}
+
+bool TFModbusTCPSharedMemoryRegisterBank::check_access(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count) const
+{
+    return header != nullptr
+        && static_cast<size_t>(data_type) < DATA_TYPE_COUNT
+        && data_count > 0
+        && static_cast<uint32_t>(start_address) + data_count <= header->counts[static_cast<size_t>(data_type)];
+}
+
+TFModbusTCPExceptionCode TFModbusTCPSharedMemoryRegisterBank::read(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, void *data_values)
+{
+    if (!check_access(data_type, start_address, data_count)) {
+        return header == nullptr ? TFModbusTCPExceptionCode::ServerDeviceFailure : TFModbusTCPExceptionCode::IllegalDataAddress;
+    }
+
+    std::atomic<uint32_t> *sequences = get_sequences(header, data_type);
+    const uint8_t *values            = get_values(header, data_type);
+    uint32_t range_length            = get_range_length(data_type);
+    uint32_t end_address             = static_cast<uint32_t>(start_address) + data_count;
+    uint32_t first_range             = start_address / range_length;
+    uint32_t last_range              = (end_address - 1) / range_length;
+
+    // Requests within the Modbus limits fit into one snapshot
+    for (uint32_t snapshot_first = first_range; snapshot_first <= last_range; snapshot_first += MAX_SNAPSHOT_RANGE_COUNT) {
+        uint32_t snapshot_count = std::min<uint32_t>(last_range - snapshot_first + 1, MAX_SNAPSHOT_RANGE_COUNT);
+        uint32_t portion_start  = std::max<uint32_t>(start_address, snapshot_first * range_length);
+        uint32_t portion_end    = std::min<uint32_t>(end_address, (snapshot_first + snapshot_count) * range_length);
+        uint32_t snapshot[MAX_SNAPSHOT_RANGE_COUNT];
+        bool consistent         = false;
+
+        for (uint32_t retry = 0; retry < TF_MODBUS_TCP_SHARED_MEMORY_REGISTER_BANK_MAX_RETRY_COUNT && !consistent; ++retry) {
+            if (retry > 0 && retry % YIELD_INTERVAL == 0) {
+                sched_yield(); // give a preempted writer a chance to finish
+            }
+
+            consistent = true;
+
+            for (uint32_t i = 0; i < snapshot_count; ++i) {
+                snapshot[i] = sequences[snapshot_first + i].load(std::memory_order_acquire);
+
+                if ((snapshot[i] & 1) != 0) {
+                    consistent = false;
+                    break;
+                }
+            }
+
+            if (!consistent) {
+                continue;
+            }
+
+            copy_values(data_type, static_cast<uint8_t *>(data_values), portion_start - start_address, values, portion_start, portion_end - portion_start);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            for (uint32_t i = 0; i < snapshot_count; ++i) {
+                if (sequences[snapshot_first + i].load(std::memory_order_relaxed) != snapshot[i]) {
+                    consistent = false;
+                    break;
+                }
+            }
+        }
+
+        if (!consistent) {
+            debugfln("read(data_type=%s start_address=%u data_count=%u) no consistent snapshot",
+                     get_tf_modbus_tcp_data_type_name(data_type), start_address, data_count);
+
+            return TFModbusTCPExceptionCode::ServerDeviceFailure;
+        }
+    }
+
+    return TFModbusTCPExceptionCode::Success;
+}
+
+TFModbusTCPExceptionCode TFModbusTCPSharedMemoryRegisterBank::write(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, const void *data_values)
+{
+    if (!check_access(data_type, start_address, data_count)) {
+        return header == nullptr ? TFModbusTCPExceptionCode::ServerDeviceFailure : TFModbusTCPExceptionCode::IllegalDataAddress;
+    }
+
+    uint8_t *values = static_cast<uint8_t *>(begin_write(data_type, start_address, data_count));
+
+    if (values == nullptr) {
+        return TFModbusTCPExceptionCode::ServerDeviceFailure;
+    }
+
+    copy_values(data_type, values, start_address, static_cast<const uint8_t *>(data_values), 0, data_count);
+    end_write(data_type, start_address, data_count);
+
+    return TFModbusTCPExceptionCode::Success;
+}
+
+void *TFModbusTCPSharedMemoryRegisterBank::begin_write(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count)
+{
+    if (!check_access(data_type, start_address, data_count)) {
+        return nullptr;
+    }
+
+    uint32_t range_length = get_range_length(data_type);
+
+    if (!lock_ranges(data_type, start_address / range_length, (start_address + data_count - 1u) / range_length)) {
+        debugfln("begin_write(data_type=%s start_address=%u data_count=%u) could not lock ranges",
+                 get_tf_modbus_tcp_data_type_name(data_type), start_address, data_count);
+
+        return nullptr;
+    }
+
+    return get_values(header, data_type);
+}
+
+void TFModbusTCPSharedMemoryRegisterBank::end_write(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count)
+{
+    if (!check_access(data_type, start_address, data_count)) {
+        return;
+    }
+
+    uint32_t range_length = get_range_length(data_type);
+
+    unlock_ranges(data_type, start_address / range_length, (start_address + data_count - 1u) / range_length);
+}
+
+bool TFModbusTCPSharedMemoryRegisterBank::lock_ranges(TFModbusTCPDataType data_type, uint32_t first_range, uint32_t last_range)
+{
+    std::atomic<uint32_t> *sequences = get_sequences(header, data_type);
+
+    // always lock in ascending order, so that two writers cannot deadlock
+    for (uint32_t range = first_range; range <= last_range; ++range) {
+        bool locked = false;
+
+        for (uint32_t retry = 0; retry < TF_MODBUS_TCP_SHARED_MEMORY_REGISTER_BANK_MAX_RETRY_COUNT && !locked; ++retry) {
+            if (retry > 0 && retry % YIELD_INTERVAL == 0) {
+                sched_yield();
+            }
+
+            uint32_t sequence = sequences[range].load(std::memory_order_relaxed);
+
+            if ((sequence & 1) != 0) {
+                continue;
+            }
+
+            locked = sequences[range].compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire, std::memory_order_relaxed);
+        }
+
+        if (!locked) {
+            if (range > first_range) {
+                unlock_ranges(data_type, first_range, range - 1);
+            }
+
+            return false;
+        }
+    }
+
+    // keep the value stores after the odd sequence numbers
+    std::atomic_thread_fence(std::memory_order_release);
+
+    return true;
+}
+
+void TFModbusTCPSharedMemoryRegisterBank::unlock_ranges(TFModbusTCPDataType data_type, uint32_t first_range, uint32_t last_range)
+{
+    std::atomic<uint32_t> *sequences = get_sequences(header, data_type);
+
+    for (uint32_t range = first_range; range <= last_range; ++range) {
+        sequences[range].fetch_add(1, std::memory_order_release);
+    }
+}
+
+#endif
@@ -0,0 +1,95 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#if defined(__linux__)
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "TFModbusTCPRegisterBank.h"
+
+// configuration
+#ifndef TF_MODBUS_TCP_SHARED_MEMORY_REGISTER_BANK_RANGE_LENGTH
+#define TF_MODBUS_TCP_SHARED_MEMORY_REGISTER_BANK_RANGE_LENGTH 64 // registers, coils use 16 times as many bits
+#endif
+
+#ifndef TF_MODBUS_TCP_SHARED_MEMORY_REGISTER_BANK_MAX_RETRY_COUNT
+#define TF_MODBUS_TCP_SHARED_MEMORY_REGISTER_BANK_MAX_RETRY_COUNT 10000
+#endif
+
+struct TFModbusTCPSharedMemoryHeader;
+
+// Register bank in a POSIX shared memory segment, so that producer processes
+// can update values that the server then reads without any syscall. Every
+// table is split into ranges, each protected by a seqlock. Readers never
+// block writers; they retry if a write overlapped their copy. A read that
+// spans up to four ranges is still one consistent snapshot, because all of
+// their sequence numbers are checked together. With the default range length
+// this covers every request within the Modbus limits. A read that spans more
+// ranges, e.g. with a smaller TF_MODBUS_TCP_SHARED_MEMORY_REGISTER_BANK_RANGE_LENGTH,
+// is only consistent per group of four ranges. Writers lock the ranges they
+// touch, so producers and the server may write the same table. A writer that
+// crashes while holding a range lock makes every later access to that range
+// fail with ServerDeviceFailure after TF_MODBUS_TCP_SHARED_MEMORY_REGISTER_BANK_MAX_RETRY_COUNT
+// attempts, instead of hanging the server
+class TFModbusTCPSharedMemoryRegisterBank final : public TFModbusTCPRegisterBank
+{
+public:
+    TFModbusTCPSharedMemoryRegisterBank() {}
+    ~TFModbusTCPSharedMemoryRegisterBank() { close(); }
+
+    // Creates the segment, or attaches to an existing segment with the same
+    // layout. New values are zero
+    bool create(const char *name, uint16_t coil_count, uint16_t discrete_input_count, uint16_t input_register_count, uint16_t holding_register_count);
+    bool open(const char *name); // attaches to an existing segment with its layout
+    void close();
+    static bool unlink(const char *name);
+
+    bool is_open() const { return header != nullptr; }
+    uint16_t get_count(TFModbusTCPDataType data_type) const;
+
+    // Returns ServerDeviceFailure if no consistent snapshot could be taken
+    // within TF_MODBUS_TCP_SHARED_MEMORY_REGISTER_BANK_MAX_RETRY_COUNT attempts
+    TFModbusTCPExceptionCode read(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, void *data_values) override;
+    TFModbusTCPExceptionCode write(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count, const void *data_values) override;
+
+    // Zero-copy update: locks the ranges covering the given values and returns
+    // the base of the table, uint16_t * for registers, packed uint8_t * for
+    // bits. Only the locked values may be modified, then call end_write() with
+    // the same arguments. Returns nullptr if the ranges could not be locked
+    void *begin_write(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count);
+    void end_write(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count);
+
+private:
+    static void copy_values(TFModbusTCPDataType data_type, uint8_t *destination, uint32_t destination_offset, const uint8_t *source, uint32_t source_offset, uint32_t count);
+
+    bool attach(int fd, size_t length);
+    bool check_access(TFModbusTCPDataType data_type, uint16_t start_address, uint16_t data_count) const;
+    uint32_t get_range_length(TFModbusTCPDataType data_type) const;
+    bool lock_ranges(TFModbusTCPDataType data_type, uint32_t first_range, uint32_t last_range);
+    void unlock_ranges(TFModbusTCPDataType data_type, uint32_t first_range, uint32_t last_range);
+
+    TFModbusTCPSharedMemoryHeader *header = nullptr;
+    size_t mapping_length                 = 0;
+};
+
+#endif
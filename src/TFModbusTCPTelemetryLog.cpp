@@ -0,0 +1,514 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include "TFModbusTCPTelemetryLog.h"
+
+#if defined(__linux__)
+
+#include <algorithm>
+#include <atomic>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "TFNetwork.h"
+
+#define debugfln(fmt, ...) tf_network_debugfln("TFModbusTCPTelemetryLog[%p]::" fmt, static_cast<void *>(this) __VA_OPT__(,) __VA_ARGS__)
+
+#define LOG_MAGIC 0x4C545446u // "TFTL"
+#define LOG_VERSION 1
+#define SLOT_VALUE_LENGTH 32
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "memory-mapped log requires address-free atomics");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "memory-mapped log requires address-free atomics");
+
+// Placed at the start of the file, followed by the slots
+struct TFModbusTCPTelemetryHeader
+{
+    std::atomic<uint32_t> magic; // stored last by the creator
+    uint16_t version;
+    uint16_t slot_length;
+    uint32_t slot_count;
+    uint32_t reserved;
+    std::atomic<uint64_t> next_sequence; // reserved by writers, not necessarily published yet
+    uint8_t padding[40];
+};
+
+struct TFModbusTCPTelemetrySlot
+{
+    std::atomic<uint64_t> sequence; // sequence + 1 once published, 0 while being written
+    int64_t timestamp_us;
+    uint8_t type;
+    uint8_t unit_id;
+    uint8_t function_code;
+    uint8_t result;
+    uint16_t start_address;
+    uint16_t data_count;
+    uint32_t latency_us;
+    uint32_t reserved;
+    uint8_t values[SLOT_VALUE_LENGTH];
+};
+
+static_assert(sizeof(TFModbusTCPTelemetryHeader) == 64, "Unexpected telemetry header length");
+static_assert(sizeof(TFModbusTCPTelemetrySlot) == 64, "Unexpected telemetry slot length");
+static_assert(TF_MODBUS_TCP_TELEMETRY_MAX_REGISTER_COUNT * 2 == SLOT_VALUE_LENGTH, "Unexpected telemetry value length");
+
+static TFModbusTCPTelemetrySlot *get_slots(TFModbusTCPTelemetryHeader *header)
+{
+    return reinterpret_cast<TFModbusTCPTelemetrySlot *>(header + 1);
+}
+
+static const TFModbusTCPTelemetrySlot *get_slots(const TFModbusTCPTelemetryHeader *header)
+{
+    return reinterpret_cast<const TFModbusTCPTelemetrySlot *>(header + 1);
+}
+
+static size_t get_file_length(uint32_t slot_count)
+{
+    return sizeof(TFModbusTCPTelemetryHeader) + static_cast<size_t>(slot_count) * sizeof(TFModbusTCPTelemetrySlot);
+}
+
+static bool is_valid(const TFModbusTCPTelemetryHeader *header, size_t length)
+{
+    return header->magic.load(std::memory_order_acquire) == LOG_MAGIC
+        && header->version == LOG_VERSION
+        && header->slot_length == sizeof(TFModbusTCPTelemetrySlot)
+        && header->slot_count > 0
+        && get_file_length(header->slot_count) == length;
+}
+
+static bool is_bit_access(TFModbusTCPFunctionCode function_code)
+{
+    return function_code == TFModbusTCPFunctionCode::ReadCoils
+        || function_code == TFModbusTCPFunctionCode::ReadDiscreteInputs
+        || function_code == TFModbusTCPFunctionCode::WriteSingleCoil
+        || function_code == TFModbusTCPFunctionCode::WriteMultipleCoils;
+}
+
+const char *get_tf_modbus_tcp_telemetry_record_type_name(TFModbusTCPTelemetryRecordType type)
+{
+    switch (type) {
+    case TFModbusTCPTelemetryRecordType::Transaction:
+        return "Transaction";
+
+    case TFModbusTCPTelemetryRecordType::RegisterValues:
+        return "RegisterValues";
+
+    case TFModbusTCPTelemetryRecordType::BitValues:
+        return "BitValues";
+    }
+
+    return "<Unknown>";
+}
+
+bool TFModbusTCPTelemetryLog::create(const char *path, uint32_t slot_count)
+{
+    if (header != nullptr) {
+        debugfln("create(path=%s) already open", path);
+        return false;
+    }
+
+    if (slot_count == 0) {
+        debugfln("create(path=%s) invalid argument", path);
+        return false;
+    }
+
+    int fd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+
+    if (fd < 0) {
+        debugfln("create(path=%s) open failed (errno=%d)", path, errno);
+        return false;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) < 0) {
+        debugfln("create(path=%s) fstat failed (errno=%d)", path, errno);
+        ::close(fd);
+        return false;
+    }
+
+    size_t length = get_file_length(slot_count);
+
+    if (static_cast<size_t>(st.st_size) >= sizeof(TFModbusTCPTelemetryHeader)) {
+        TFModbusTCPTelemetryHeader existing;
+
+        // continue an existing log, if it is complete and has the same layout
+        if (pread(fd, &existing, sizeof(existing), 0) == static_cast<ssize_t>(sizeof(existing)) && is_valid(&existing, static_cast<size_t>(st.st_size))) {
+            if (existing.slot_count != slot_count) {
+                debugfln("create(path=%s) existing log has a different slot count", path);
+                ::close(fd);
+                return false;
+            }
+
+            void *mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            int saved_errno = errno;
+
+            ::close(fd);
+
+            if (mapping == MAP_FAILED) {
+                debugfln("create(path=%s) mmap failed (errno=%d)", path, saved_errno);
+
+                errno = saved_errno;
+                return false;
+            }
+
+            header         = static_cast<TFModbusTCPTelemetryHeader *>(mapping);
+            mapping_length = length;
+
+            return true;
+        }
+    }
+
+    // a log that was not completely created is discarded. ftruncate() zero-fills,
+    // which also marks all slots as unpublished
+    if (ftruncate(fd, 0) < 0 || ftruncate(fd, static_cast<off_t>(length)) < 0) {
+        debugfln("create(path=%s) ftruncate failed (errno=%d)", path, errno);
+        ::close(fd);
+        return false;
+    }
+
+    void *mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int saved_errno = errno;
+
+    ::close(fd);
+
+    if (mapping == MAP_FAILED) {
+        debugfln("create(path=%s) mmap failed (errno=%d)", path, saved_errno);
+
+        errno = saved_errno;
+        return false;
+    }
+
+    header         = static_cast<TFModbusTCPTelemetryHeader *>(mapping);
+    mapping_length = length;
+
+    header->version     = LOG_VERSION;
+    header->slot_length = sizeof(TFModbusTCPTelemetrySlot);
+    header->slot_count  = slot_count;
+
+    header->next_sequence.store(0, std::memory_order_relaxed);
+    header->magic.store(LOG_MAGIC, std::memory_order_release);
+
+    return true;
+}
+
+void TFModbusTCPTelemetryLog::close()
+{
+    if (header == nullptr) {
+        return;
+    }
+
+    munmap(header, mapping_length);
+
+    header         = nullptr;
+    mapping_length = 0;
+}
+
+TFModbusTCPTelemetrySlot *TFModbusTCPTelemetryLog::begin_append(uint64_t *sequence)
+{
+    if (header == nullptr) {
+        return nullptr;
+    }
+
+    *sequence = header->next_sequence.fetch_add(1, std::memory_order_relaxed);
+
+    TFModbusTCPTelemetrySlot *slot = &get_slots(header)[*sequence % header->slot_count];
+    struct timespec ts;
+
+    slot->sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    slot->timestamp_us = static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+
+    return slot;
+}
+
+void TFModbusTCPTelemetryLog::end_append(TFModbusTCPTelemetrySlot *slot, uint64_t sequence)
+{
+    slot->sequence.store(sequence + 1, std::memory_order_release);
+}
+
+void TFModbusTCPTelemetryLog::append_transaction(uint8_t unit_id,
+                                                 TFModbusTCPFunctionCode function_code,
+                                                 uint16_t start_address,
+                                                 uint16_t data_count,
+                                                 TFModbusTCPClientTransactionResult result,
+                                                 micros_t latency)
+{
+    uint64_t sequence;
+    TFModbusTCPTelemetrySlot *slot = begin_append(&sequence);
+
+    if (slot == nullptr) {
+        return;
+    }
+
+    slot->type          = static_cast<uint8_t>(TFModbusTCPTelemetryRecordType::Transaction);
+    slot->unit_id       = unit_id;
+    slot->function_code = static_cast<uint8_t>(function_code);
+    slot->result        = static_cast<uint8_t>(result);
+    slot->start_address = start_address;
+    slot->data_count    = data_count;
+    slot->latency_us    = static_cast<uint32_t>(std::min<int64_t>(latency.as<int64_t>(), UINT32_MAX));
+
+    end_append(slot, sequence);
+}
+
+// split into several records if necessary
+void TFModbusTCPTelemetryLog::append_values(uint8_t unit_id,
+                                            TFModbusTCPFunctionCode function_code,
+                                            uint16_t start_address,
+                                            uint16_t data_count,
+                                            const void *values)
+{
+    bool bit_access    = is_bit_access(function_code);
+    uint32_t max_count = bit_access ? TF_MODBUS_TCP_TELEMETRY_MAX_BIT_COUNT : TF_MODBUS_TCP_TELEMETRY_MAX_REGISTER_COUNT;
+
+    for (uint32_t offset = 0; offset < data_count; offset += max_count) {
+        uint64_t sequence;
+        TFModbusTCPTelemetrySlot *slot = begin_append(&sequence);
+
+        if (slot == nullptr) {
+            return;
+        }
+
+        uint16_t count = static_cast<uint16_t>(std::min<uint32_t>(data_count - offset, max_count));
+
+        slot->type          = static_cast<uint8_t>(bit_access ? TFModbusTCPTelemetryRecordType::BitValues : TFModbusTCPTelemetryRecordType::RegisterValues);
+        slot->unit_id       = unit_id;
+        slot->function_code = static_cast<uint8_t>(function_code);
+        slot->result        = 0;
+        slot->start_address = static_cast<uint16_t>(start_address + offset);
+        slot->data_count    = count;
+        slot->latency_us    = 0;
+
+        // bit chunks start at a byte boundary, because the max bit count is a multiple of 8
+        if (bit_access) {
+            memcpy(slot->values, static_cast<const uint8_t *>(values) + offset / 8, (count + 7u) / 8u);
+        }
+        else {
+            memcpy(slot->values, static_cast<const uint16_t *>(values) + offset, count * sizeof(uint16_t));
+        }
+
+        end_append(slot, sequence);
+    }
+}
+
+void TFModbusTCPTelemetryLog::log_transaction(const TFModbusTCPClientTransaction *transaction, TFModbusTCPClientTransactionResult result, micros_t latency)
+{
+    uint16_t data_count = transaction->data_count;
+
+    if (transaction->function_code == TFModbusTCPFunctionCode::ReadFIFOQueue && result == TFModbusTCPClientTransactionResult::Success) {
+        data_count = *transaction->fifo_count;
+    }
+
+    append_transaction(transaction->unit_id, transaction->function_code, transaction->start_address, data_count, result, latency);
+
+    // read view transactions have no buffer
+    if (result != TFModbusTCPClientTransactionResult::Success || transaction->buffer == nullptr) {
+        return;
+    }
+
+    switch (transaction->function_code) {
+    case TFModbusTCPFunctionCode::ReadCoils:
+    case TFModbusTCPFunctionCode::ReadDiscreteInputs:
+    case TFModbusTCPFunctionCode::ReadHoldingRegisters:
+    case TFModbusTCPFunctionCode::ReadInputRegisters:
+    case TFModbusTCPFunctionCode::ReadFIFOQueue:
+        append_values(transaction->unit_id, transaction->function_code, transaction->start_address, data_count, transaction->buffer);
+        break;
+
+    default:
+        break;
+    }
+}
+
+#undef debugfln
+#define debugfln(fmt, ...) tf_network_debugfln("TFModbusTCPTelemetryReader[%p]::" fmt, static_cast<void *>(this) __VA_OPT__(,) __VA_ARGS__)
+
+bool TFModbusTCPTelemetryReader::open(const char *path)
+{
+    if (header != nullptr) {
+        debugfln("open(path=%s) already open", path);
+        return false;
+    }
+
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0) {
+        debugfln("open(path=%s) open failed (errno=%d)", path, errno);
+        return false;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(TFModbusTCPTelemetryHeader)) {
+        debugfln("open(path=%s) log is too short or not created yet", path);
+        ::close(fd);
+        return false;
+    }
+
+    void *mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    int saved_errno = errno;
+
+    ::close(fd);
+
+    if (mapping == MAP_FAILED) {
+        debugfln("open(path=%s) mmap failed (errno=%d)", path, saved_errno);
+
+        errno = saved_errno;
+        return false;
+    }
+
+    header         = static_cast<const TFModbusTCPTelemetryHeader *>(mapping);
+    mapping_length = static_cast<size_t>(st.st_size);
+
+    if (!is_valid(header, mapping_length)) {
+        debugfln("open(path=%s) log is invalid or not created yet", path);
+        close();
+        return false;
+    }
+
+    lost_record_count = 0;
+    stalled_sequence  = UINT64_MAX;
+
+    seek_to_oldest();
+
+    return true;
+}
+
+void TFModbusTCPTelemetryReader::close()
+{
+    if (header == nullptr) {
+        return;
+    }
+
+    munmap(const_cast<TFModbusTCPTelemetryHeader *>(header), mapping_length);
+
+    header         = nullptr;
+    mapping_length = 0;
+}
+
+void TFModbusTCPTelemetryReader::seek_to_oldest()
+{
+    if (header == nullptr) {
+        return;
+    }
+
+    uint64_t head = header->next_sequence.load(std::memory_order_acquire);
+
+    next_sequence = head > header->slot_count ? head - header->slot_count : 0;
+}
+
+void TFModbusTCPTelemetryReader::seek_to_newest()
+{
+    if (header == nullptr) {
+        return;
+    }
+
+    next_sequence = header->next_sequence.load(std::memory_order_acquire);
+}
+
+bool TFModbusTCPTelemetryReader::read(TFModbusTCPTelemetryRecord *record)
+{
+    if (header == nullptr) {
+        return false;
+    }
+
+    const TFModbusTCPTelemetrySlot *slots = get_slots(header);
+
+    while (true) {
+        uint64_t head = header->next_sequence.load(std::memory_order_acquire);
+
+        if (next_sequence >= head) {
+            return false;
+        }
+
+        if (head - next_sequence > header->slot_count) {
+            lost_record_count += head - header->slot_count - next_sequence;
+            next_sequence      = head - header->slot_count;
+        }
+
+        const TFModbusTCPTelemetrySlot *slot = &slots[next_sequence % header->slot_count];
+        uint64_t published_sequence          = slot->sequence.load(std::memory_order_acquire);
+
+        if (published_sequence == next_sequence + 1) {
+            TFModbusTCPTelemetrySlot copy;
+
+            // seqlock read, the slot might be overwritten while it is copied
+            memcpy(reinterpret_cast<uint8_t *>(&copy) + sizeof(copy.sequence),
+                   reinterpret_cast<const uint8_t *>(slot) + sizeof(slot->sequence),
+                   sizeof(copy) - sizeof(copy.sequence));
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (slot->sequence.load(std::memory_order_relaxed) != published_sequence) {
+                continue;
+            }
+
+            record->sequence      = next_sequence;
+            record->timestamp_us  = copy.timestamp_us;
+            record->type          = static_cast<TFModbusTCPTelemetryRecordType>(copy.type);
+            record->unit_id       = copy.unit_id;
+            record->function_code = static_cast<TFModbusTCPFunctionCode>(copy.function_code);
+            record->result        = static_cast<TFModbusTCPClientTransactionResult>(copy.result);
+            record->start_address = copy.start_address;
+            record->data_count    = copy.data_count;
+            record->latency_us    = copy.latency_us;
+
+            memcpy(record->register_values, copy.values, sizeof(copy.values));
+
+            ++next_sequence;
+
+            return true;
+        }
+
+        if (published_sequence > next_sequence + 1) {
+            // overwritten by a writer that lapped this reader
+            ++lost_record_count;
+            ++next_sequence;
+            continue;
+        }
+
+        // reserved, but not published yet
+        if (stalled_sequence != next_sequence) {
+            stalled_sequence = next_sequence;
+            stall_deadline   = calculate_deadline(TF_MODBUS_TCP_TELEMETRY_READER_STALL_TIMEOUT);
+            return false;
+        }
+
+        if (!deadline_elapsed(stall_deadline)) {
+            return false;
+        }
+
+        debugfln("read() skipping stalled record (sequence=%llu)", static_cast<unsigned long long>(next_sequence));
+
+        ++lost_record_count;
+        ++next_sequence;
+    }
+}
+
+#endif
@@ -0,0 +1,150 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#if defined(__linux__)
+
+#include <stdint.h>
+#include <stddef.h>
+#include <TFTools/Micros.h>
+
+#include "TFModbusTCPCommon.h"
+#include "TFModbusTCPClient.h"
+
+// configuration
+#ifndef TF_MODBUS_TCP_TELEMETRY_READER_STALL_TIMEOUT
+#define TF_MODBUS_TCP_TELEMETRY_READER_STALL_TIMEOUT 1_s
+#endif
+
+#define TF_MODBUS_TCP_TELEMETRY_MAX_REGISTER_COUNT 16 // per values record
+#define TF_MODBUS_TCP_TELEMETRY_MAX_BIT_COUNT      (TF_MODBUS_TCP_TELEMETRY_MAX_REGISTER_COUNT * 16)
+
+enum class TFModbusTCPTelemetryRecordType : uint8_t
+{
+    Transaction    = 1,
+    RegisterValues = 2,
+    BitValues      = 3,
+};
+
+const char *get_tf_modbus_tcp_telemetry_record_type_name(TFModbusTCPTelemetryRecordType type);
+
+struct TFModbusTCPTelemetryRecord
+{
+    uint64_t sequence;
+    int64_t timestamp_us; // unix time
+    TFModbusTCPTelemetryRecordType type;
+    uint8_t unit_id;
+    TFModbusTCPFunctionCode function_code;
+    TFModbusTCPClientTransactionResult result; // Transaction
+    uint16_t start_address;
+    uint16_t data_count;
+    uint32_t latency_us;                       // Transaction
+
+    union {
+        uint16_t register_values[TF_MODBUS_TCP_TELEMETRY_MAX_REGISTER_COUNT]; // RegisterValues
+        uint8_t bit_values[TF_MODBUS_TCP_TELEMETRY_MAX_BIT_COUNT / 8];        // BitValues, packed, LSB first
+    };
+};
+
+struct TFModbusTCPTelemetryHeader;
+struct TFModbusTCPTelemetrySlot;
+
+// Ring of fixed-size records in a memory-mapped file, for the Linux build.
+// Appending never blocks and never calls into the kernel: a slot is reserved
+// with an atomic counter and published with a per-slot sequence number, so
+// that several threads or processes may append to the same file. The oldest
+// records are overwritten. The header is only written at creation, with the
+// magic stored last, and the per-slot sequence numbers make incomplete
+// records detectable after a crash. Reopening an existing file continues
+// after its newest record.
+//
+// Use log_transaction() as transaction observer of a client or client pool to
+// log every transaction outcome and the values of all successful reads.
+// Register values are logged as passed to the client, in its register byte
+// order
+class TFModbusTCPTelemetryLog final
+{
+public:
+    TFModbusTCPTelemetryLog() {}
+    ~TFModbusTCPTelemetryLog() { close(); }
+
+    TFModbusTCPTelemetryLog(TFModbusTCPTelemetryLog const &other) = delete;
+    TFModbusTCPTelemetryLog &operator=(TFModbusTCPTelemetryLog const &other) = delete;
+
+    bool create(const char *path, uint32_t slot_count);
+    void close();
+    bool is_open() const { return header != nullptr; }
+
+    void append_transaction(uint8_t unit_id,
+                            TFModbusTCPFunctionCode function_code,
+                            uint16_t start_address,
+                            uint16_t data_count,
+                            TFModbusTCPClientTransactionResult result,
+                            micros_t latency);
+    void append_values(uint8_t unit_id,
+                       TFModbusTCPFunctionCode function_code,
+                       uint16_t start_address,
+                       uint16_t data_count,
+                       const void *values);
+    void log_transaction(const TFModbusTCPClientTransaction *transaction, TFModbusTCPClientTransactionResult result, micros_t latency);
+
+private:
+    TFModbusTCPTelemetrySlot *begin_append(uint64_t *sequence);
+    void end_append(TFModbusTCPTelemetrySlot *slot, uint64_t sequence);
+
+    TFModbusTCPTelemetryHeader *header = nullptr;
+    size_t mapping_length              = 0;
+};
+
+// Streams the records of a telemetry log, also while it is being written. A
+// reader that falls behind by more than the ring size skips the overwritten
+// records and counts them as lost. A slot that stays incomplete for longer
+// than TF_MODBUS_TCP_TELEMETRY_READER_STALL_TIMEOUT, e.g. because its writer
+// crashed, is skipped and counted as lost as well
+class TFModbusTCPTelemetryReader final
+{
+public:
+    TFModbusTCPTelemetryReader() {}
+    ~TFModbusTCPTelemetryReader() { close(); }
+
+    TFModbusTCPTelemetryReader(TFModbusTCPTelemetryReader const &other) = delete;
+    TFModbusTCPTelemetryReader &operator=(TFModbusTCPTelemetryReader const &other) = delete;
+
+    bool open(const char *path); // starts at the oldest record
+    void close();
+    bool is_open() const { return header != nullptr; }
+
+    void seek_to_oldest();
+    void seek_to_newest(); // only records appended from now on
+    bool read(TFModbusTCPTelemetryRecord *record); // false if there is no new record yet
+
+    uint64_t get_lost_record_count() const { return lost_record_count; }
+
+private:
+    const TFModbusTCPTelemetryHeader *header = nullptr;
+    size_t mapping_length                    = 0;
+    uint64_t next_sequence                   = 0;
+    uint64_t lost_record_count               = 0;
+    uint64_t stalled_sequence                = UINT64_MAX;
+    micros_t stall_deadline                  = 0_s;
+};
+
+#endif
@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <lwip/sockets.h>
+#include <algorithm>
 
 const char *TFNetwork::printf_safe(const char *string)
 {
@@ -62,6 +63,137 @@ static uint16_t get_random_uint16_dummy()
 
 TFNetworkGetRandomUint16Function TFNetwork::get_random_uint16 = get_random_uint16_dummy;
 
+#if defined(TF_NETWORK_SOCKET_HOOKS) && TF_NETWORK_SOCKET_HOOKS > 0
+static ssize_t socket_send_default(int fd, const void *buffer, size_t length, int flags)
+{
+    return ::send(fd, buffer, length, flags);
+}
+
+static ssize_t socket_recv_default(int fd, void *buffer, size_t length, int flags)
+{
+    return ::recv(fd, buffer, length, flags);
+}
+
+static int socket_connect_default(int fd, const struct sockaddr *address, socklen_t address_length)
+{
+    return ::connect(fd, address, address_length);
+}
+
+static int socket_accept_default(int fd, struct sockaddr *address, socklen_t *address_length)
+{
+    return ::accept(fd, address, address_length);
+}
+
+static int socket_close_default(int fd)
+{
+    return ::close(fd);
+}
+
+TFNetworkSocketSendFunction TFNetwork::socket_send       = socket_send_default;
+TFNetworkSocketRecvFunction TFNetwork::socket_recv       = socket_recv_default;
+TFNetworkSocketConnectFunction TFNetwork::socket_connect = socket_connect_default;
+TFNetworkSocketAcceptFunction TFNetwork::socket_accept   = socket_accept_default;
+TFNetworkSocketCloseFunction TFNetwork::socket_close     = socket_close_default;
+
+void TFNetwork::reset_socket_hooks()
+{
+    socket_send    = socket_send_default;
+    socket_recv    = socket_recv_default;
+    socket_connect = socket_connect_default;
+    socket_accept  = socket_accept_default;
+    socket_close   = socket_close_default;
+}
+#endif
+
+#if defined(TF_NETWORK_ALLOCATION_TRACKING) && TF_NETWORK_ALLOCATION_TRACKING > 0
+const char *get_tf_network_allocation_operation_name(TFNetworkAllocationOperation operation)
+{
+    switch (operation) {
+    case TFNetworkAllocationOperation::None:
+        return "None";
+
+    case TFNetworkAllocationOperation::Connect:
+        return "Connect";
+
+    case TFNetworkAllocationOperation::Disconnect:
+        return "Disconnect";
+
+    case TFNetworkAllocationOperation::ClientTick:
+        return "ClientTick";
+
+    case TFNetworkAllocationOperation::Transact:
+        return "Transact";
+
+    case TFNetworkAllocationOperation::Acquire:
+        return "Acquire";
+
+    case TFNetworkAllocationOperation::Release:
+        return "Release";
+
+    case TFNetworkAllocationOperation::PoolTick:
+        return "PoolTick";
+
+    case TFNetworkAllocationOperation::ServerStart:
+        return "ServerStart";
+
+    case TFNetworkAllocationOperation::ServerStop:
+        return "ServerStop";
+
+    case TFNetworkAllocationOperation::ServerTick:
+        return "ServerTick";
+
+    case TFNetworkAllocationOperation::Accept:
+        return "Accept";
+
+    case TFNetworkAllocationOperation::Count:
+        break;
+    }
+
+    return "<Unknown>";
+}
+
+TFNetworkAllocationOperation TFNetwork::allocation_operation = TFNetworkAllocationOperation::None;
+#endif
+
+const uint32_t TFNetworkLatencyHistogram::upper_bounds_us[TF_NETWORK_LATENCY_HISTOGRAM_BUCKET_COUNT] = {
+    500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000
+};
+
+void TFNetworkLatencyHistogram::add(int64_t latency_us)
+{
+    uint64_t latency = latency_us > 0 ? static_cast<uint64_t>(latency_us) : 0;
+    size_t i         = 0;
+
+    while (i < TF_NETWORK_LATENCY_HISTOGRAM_BUCKET_COUNT && latency > upper_bounds_us[i]) {
+        ++i;
+    }
+
+    ++bucket_counts[i];
+    ++count;
+    sum_us += latency;
+}
+
+uint32_t TFNetworkLatencyHistogram::get_percentile_us(uint32_t percent) const
+{
+    if (count == 0) {
+        return 0;
+    }
+
+    // rank of the percentile, rounded up
+    uint64_t rank       = (count * std::min<uint32_t>(percent, 100) + 99) / 100;
+    uint64_t cumulative = 0;
+
+    for (size_t i = 0; i < TF_NETWORK_LATENCY_HISTOGRAM_BUCKET_COUNT; ++i) {
+        cumulative += bucket_counts[i];
+
+        if (cumulative >= rank && cumulative > 0) {
+            return upper_bounds_us[i];
+        }
+    }
+
+    return UINT32_MAX;
+}
+
 char *TFNetwork::ipv4_ntoa(char *buffer, size_t buffer_length, uint32_t address)
 {
     if (buffer_length < 1) {
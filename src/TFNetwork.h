@@ -34,8 +34,82 @@
 #define tf_network_debugfln(fmt, ...) do {} while (0)
 #endif
 
+// TF_NETWORK_SOCKET_HOOKS 0 or undefined = socket calls go directly to the socket API
+// TF_NETWORK_SOCKET_HOOKS 1 = socket calls go through the replaceable TFNetwork::socket_* functions, e.g. for fault injection
+
+#if defined(TF_NETWORK_SOCKET_HOOKS) && TF_NETWORK_SOCKET_HOOKS > 0
+#include <lwip/sockets.h>
+
+#define tf_network_socket_send(fd, buffer, length, flags) TFNetwork::socket_send(fd, buffer, length, flags)
+#define tf_network_socket_recv(fd, buffer, length, flags) TFNetwork::socket_recv(fd, buffer, length, flags)
+#define tf_network_socket_connect(fd, address, address_length) TFNetwork::socket_connect(fd, address, address_length)
+#define tf_network_socket_accept(fd, address, address_length) TFNetwork::socket_accept(fd, address, address_length)
+#define tf_network_socket_close(fd) TFNetwork::socket_close(fd)
+
+typedef std::function<ssize_t(int fd, const void *buffer, size_t length, int flags)> TFNetworkSocketSendFunction;
+typedef std::function<ssize_t(int fd, void *buffer, size_t length, int flags)> TFNetworkSocketRecvFunction;
+typedef std::function<int(int fd, const struct sockaddr *address, socklen_t address_length)> TFNetworkSocketConnectFunction;
+typedef std::function<int(int fd, struct sockaddr *address, socklen_t *address_length)> TFNetworkSocketAcceptFunction;
+typedef std::function<int(int fd)> TFNetworkSocketCloseFunction;
+#else
+#define tf_network_socket_send(fd, buffer, length, flags) ::send(fd, buffer, length, flags)
+#define tf_network_socket_recv(fd, buffer, length, flags) ::recv(fd, buffer, length, flags)
+#define tf_network_socket_connect(fd, address, address_length) ::connect(fd, address, address_length)
+#define tf_network_socket_accept(fd, address, address_length) ::accept(fd, address, address_length)
+#define tf_network_socket_close(fd) ::close(fd)
+#endif
+
+// TF_NETWORK_ALLOCATION_TRACKING 0 or undefined = allocation tracking is off
+// TF_NETWORK_ALLOCATION_TRACKING 1 = library operations are marked, so that heap allocations can be attributed to them
+
+#if defined(TF_NETWORK_ALLOCATION_TRACKING) && TF_NETWORK_ALLOCATION_TRACKING > 0
+#define tf_network_allocation_scope_concat2(a, b) a##b
+#define tf_network_allocation_scope_concat(a, b) tf_network_allocation_scope_concat2(a, b)
+#define tf_network_allocation_scope(operation) TFNetwork::AllocationScope tf_network_allocation_scope_concat(allocation_scope_, __LINE__)(TFNetworkAllocationOperation::operation)
+
+enum class TFNetworkAllocationOperation : uint8_t
+{
+    None,
+    Connect,
+    Disconnect,
+    ClientTick,
+    Transact,
+    Acquire,
+    Release,
+    PoolTick,
+    ServerStart,
+    ServerStop,
+    ServerTick,
+    Accept,
+    Count,
+};
+
+const char *get_tf_network_allocation_operation_name(TFNetworkAllocationOperation operation);
+#else
+#define tf_network_allocation_scope(operation) do {} while (0)
+#endif
+
 #define TF_NETWORK_IPV4_NTOA_BUFFER_LENGTH 16
 
+#define TF_NETWORK_LATENCY_HISTOGRAM_BUCKET_COUNT 12
+
+// Bucket counts are not cumulative, the last bucket counts the latencies above
+// the last upper bound
+struct TFNetworkLatencyHistogram
+{
+    static const uint32_t upper_bounds_us[TF_NETWORK_LATENCY_HISTOGRAM_BUCKET_COUNT];
+
+    uint64_t bucket_counts[TF_NETWORK_LATENCY_HISTOGRAM_BUCKET_COUNT + 1] = {};
+    uint64_t count                                                       = 0;
+    uint64_t sum_us                                                      = 0;
+
+    void add(int64_t latency_us);
+
+    // Upper bound of the bucket that holds the given percentile, UINT32_MAX
+    // if that is the last bucket and 0 if the histogram is empty
+    uint32_t get_percentile_us(uint32_t percent) const;
+};
+
 typedef std::function<void(const char *fmt, va_list args)> TFNetworkVLogFLnFunction;
 typedef std::function<void(uint32_t address, int error_number)> TFNetworkResolveResultCallback;
 typedef std::function<void(const char *host, TFNetworkResolveResultCallback &&callback)> TFNetworkResolveFunction;
@@ -52,6 +126,32 @@ namespace TFNetwork
 
     extern TFNetworkGetRandomUint16Function get_random_uint16;
 
+#if defined(TF_NETWORK_SOCKET_HOOKS) && TF_NETWORK_SOCKET_HOOKS > 0
+    extern TFNetworkSocketSendFunction socket_send;
+    extern TFNetworkSocketRecvFunction socket_recv;
+    extern TFNetworkSocketConnectFunction socket_connect;
+    extern TFNetworkSocketAcceptFunction socket_accept;
+    extern TFNetworkSocketCloseFunction socket_close;
+
+    void reset_socket_hooks();
+#endif
+
+#if defined(TF_NETWORK_ALLOCATION_TRACKING) && TF_NETWORK_ALLOCATION_TRACKING > 0
+    // The operation that heap allocations are currently attributed to. Scopes
+    // nest, the innermost one wins
+    extern TFNetworkAllocationOperation allocation_operation;
+
+    class AllocationScope
+    {
+    public:
+        AllocationScope(TFNetworkAllocationOperation operation) : previous_operation(allocation_operation) { allocation_operation = operation; }
+        ~AllocationScope() { allocation_operation = previous_operation; }
+
+    private:
+        TFNetworkAllocationOperation previous_operation;
+    };
+#endif
+
     class NonReentrantScope
     {
     public:
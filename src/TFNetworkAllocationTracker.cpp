@@ -0,0 +1,350 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include "TFNetworkAllocationTracker.h"
+
+#if defined(__linux__) && defined(TF_NETWORK_ALLOCATION_TRACKING) && TF_NETWORK_ALLOCATION_TRACKING > 0
+
+#include <errno.h>
+#include <malloc.h>
+#include <atomic>
+
+// glibc entry points that the interposed functions forward to
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *pointer, size_t size);
+extern "C" void *__libc_memalign(size_t alignment, size_t size);
+extern "C" void __libc_free(void *pointer);
+
+struct TFNetworkAllocationTrackerCounters
+{
+    std::atomic<size_t> allocation_count;
+    std::atomic<size_t> free_count;
+    std::atomic<size_t> allocated_bytes;
+    std::atomic<size_t> freed_bytes;
+    std::atomic<int64_t> live_bytes;
+    std::atomic<int64_t> peak_live_bytes;
+};
+
+// Open addressing table of the live blocks and the operation that allocated
+// them, probes are bounded so that a full table only costs untracked blocks
+#define BLOCK_EMPTY 0u
+#define BLOCK_REMOVED 1u
+#define MAX_BLOCK_PROBE_COUNT 64
+
+static_assert((TF_NETWORK_ALLOCATION_TRACKER_MAX_BLOCK_COUNT & (TF_NETWORK_ALLOCATION_TRACKER_MAX_BLOCK_COUNT - 1)) == 0,
+              "TF_NETWORK_ALLOCATION_TRACKER_MAX_BLOCK_COUNT must be a power of two");
+
+struct TFNetworkAllocationTrackerBlock
+{
+    std::atomic<uintptr_t> pointer;
+    std::atomic<uint8_t> operation;
+};
+
+static std::atomic<bool> enabled{false};
+static std::atomic<int64_t> live_bytes{0};
+static std::atomic<int64_t> peak_live_bytes{0};
+static TFNetworkAllocationTrackerCounters operation_counters[static_cast<size_t>(TFNetworkAllocationOperation::Count)];
+static TFNetworkAllocationTrackerCounters total_counters;
+static TFNetworkAllocationTrackerBlock blocks[TF_NETWORK_ALLOCATION_TRACKER_MAX_BLOCK_COUNT];
+
+static size_t get_block_index(uintptr_t pointer)
+{
+    return static_cast<size_t>(((pointer >> 4) * 0x9E3779B97F4A7C15ull) >> 32) & (TF_NETWORK_ALLOCATION_TRACKER_MAX_BLOCK_COUNT - 1);
+}
+
+static void add_block(void *pointer, size_t operation_index)
+{
+    uintptr_t key = reinterpret_cast<uintptr_t>(pointer);
+    size_t index  = get_block_index(key);
+
+    for (size_t i = 0; i < MAX_BLOCK_PROBE_COUNT; ++i) {
+        TFNetworkAllocationTrackerBlock *block = &blocks[(index + i) & (TF_NETWORK_ALLOCATION_TRACKER_MAX_BLOCK_COUNT - 1)];
+        uintptr_t current                      = block->pointer.load(std::memory_order_relaxed);
+
+        if ((current == BLOCK_EMPTY || current == BLOCK_REMOVED)
+         && block->pointer.compare_exchange_strong(current, key, std::memory_order_relaxed)) {
+            block->operation.store(static_cast<uint8_t>(operation_index), std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+// Returns the index of the allocating operation, or -1 for an unknown block
+static int remove_block(void *pointer)
+{
+    uintptr_t key = reinterpret_cast<uintptr_t>(pointer);
+    size_t index  = get_block_index(key);
+
+    for (size_t i = 0; i < MAX_BLOCK_PROBE_COUNT; ++i) {
+        TFNetworkAllocationTrackerBlock *block = &blocks[(index + i) & (TF_NETWORK_ALLOCATION_TRACKER_MAX_BLOCK_COUNT - 1)];
+        uintptr_t current                      = block->pointer.load(std::memory_order_relaxed);
+
+        if (current == BLOCK_EMPTY) {
+            break;
+        }
+
+        if (current == key) {
+            int operation_index = block->operation.load(std::memory_order_relaxed);
+
+            block->pointer.store(BLOCK_REMOVED, std::memory_order_relaxed);
+
+            return operation_index;
+        }
+    }
+
+    return -1;
+}
+
+static void update_peak(std::atomic<int64_t> *peak, int64_t value)
+{
+    int64_t current = peak->load(std::memory_order_relaxed);
+
+    while (value > current && !peak->compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+static size_t get_operation_index()
+{
+    size_t index = static_cast<size_t>(TFNetwork::allocation_operation);
+
+    if (index >= static_cast<size_t>(TFNetworkAllocationOperation::Count)) {
+        index = static_cast<size_t>(TFNetworkAllocationOperation::None);
+    }
+
+    return index;
+}
+
+static void count_allocation(TFNetworkAllocationTrackerCounters *counters, size_t size)
+{
+    int64_t live = counters->live_bytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed) + static_cast<int64_t>(size);
+
+    counters->allocation_count.fetch_add(1, std::memory_order_relaxed);
+    counters->allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    update_peak(&counters->peak_live_bytes, live);
+}
+
+static void count_free(TFNetworkAllocationTrackerCounters *counters, size_t size)
+{
+    counters->free_count.fetch_add(1, std::memory_order_relaxed);
+    counters->freed_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+static void record_allocation(void *pointer)
+{
+    if (pointer == nullptr || !enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    size_t size            = malloc_usable_size(pointer);
+    size_t operation_index = get_operation_index();
+    int64_t live           = live_bytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed) + static_cast<int64_t>(size);
+
+    update_peak(&peak_live_bytes, live);
+    add_block(pointer, operation_index);
+    count_allocation(&operation_counters[operation_index], size);
+    count_allocation(&total_counters, size);
+}
+
+static void record_free(void *pointer, size_t size)
+{
+    if (pointer == nullptr || !enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    int allocating_operation_index = remove_block(pointer);
+
+    // blocks from before the last reset were never counted as live
+    if (allocating_operation_index >= 0) {
+        live_bytes.fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed);
+        operation_counters[allocating_operation_index].live_bytes.fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed);
+        total_counters.live_bytes.fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed);
+    }
+
+    count_free(&operation_counters[get_operation_index()], size);
+    count_free(&total_counters, size);
+}
+
+extern "C" void *malloc(size_t size)
+{
+    void *pointer = __libc_malloc(size);
+
+    record_allocation(pointer);
+
+    return pointer;
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    void *pointer = __libc_calloc(count, size);
+
+    record_allocation(pointer);
+
+    return pointer;
+}
+
+extern "C" void *realloc(void *pointer, size_t size)
+{
+    if (pointer == nullptr) {
+        return malloc(size);
+    }
+
+    if (size == 0) {
+        free(pointer);
+        return nullptr;
+    }
+
+    // a realloc is accounted as a free followed by an allocation, even if
+    // the block could be resized in place
+    size_t old_size = malloc_usable_size(pointer);
+    void *result    = __libc_realloc(pointer, size);
+
+    if (result != nullptr) {
+        record_free(pointer, old_size);
+        record_allocation(result);
+    }
+
+    return result;
+}
+
+extern "C" void free(void *pointer)
+{
+    if (pointer != nullptr) {
+        record_free(pointer, malloc_usable_size(pointer));
+    }
+
+    __libc_free(pointer);
+}
+
+extern "C" void *memalign(size_t alignment, size_t size)
+{
+    void *pointer = __libc_memalign(alignment, size);
+
+    record_allocation(pointer);
+
+    return pointer;
+}
+
+extern "C" void *aligned_alloc(size_t alignment, size_t size)
+{
+    return memalign(alignment, size);
+}
+
+extern "C" int posix_memalign(void **pointer_ptr, size_t alignment, size_t size)
+{
+    if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+
+    void *pointer = memalign(alignment, size);
+
+    if (pointer == nullptr) {
+        return ENOMEM;
+    }
+
+    *pointer_ptr = pointer;
+
+    return 0;
+}
+
+static void reset_counters(TFNetworkAllocationTrackerCounters *counters)
+{
+    counters->allocation_count.store(0, std::memory_order_relaxed);
+    counters->free_count.store(0, std::memory_order_relaxed);
+    counters->allocated_bytes.store(0, std::memory_order_relaxed);
+    counters->freed_bytes.store(0, std::memory_order_relaxed);
+    counters->live_bytes.store(0, std::memory_order_relaxed);
+    counters->peak_live_bytes.store(0, std::memory_order_relaxed);
+}
+
+static TFNetworkAllocationCounters load_counters(const TFNetworkAllocationTrackerCounters *counters)
+{
+    TFNetworkAllocationCounters result;
+
+    result.allocation_count = counters->allocation_count.load(std::memory_order_relaxed);
+    result.free_count       = counters->free_count.load(std::memory_order_relaxed);
+    result.allocated_bytes  = counters->allocated_bytes.load(std::memory_order_relaxed);
+    result.freed_bytes      = counters->freed_bytes.load(std::memory_order_relaxed);
+    result.live_bytes       = counters->live_bytes.load(std::memory_order_relaxed);
+    result.peak_live_bytes  = counters->peak_live_bytes.load(std::memory_order_relaxed);
+
+    return result;
+}
+
+void TFNetworkAllocationTracker::enable()
+{
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+void TFNetworkAllocationTracker::disable()
+{
+    enabled.store(false, std::memory_order_relaxed);
+}
+
+bool TFNetworkAllocationTracker::is_enabled()
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void TFNetworkAllocationTracker::reset()
+{
+    for (size_t i = 0; i < static_cast<size_t>(TFNetworkAllocationOperation::Count); ++i) {
+        reset_counters(&operation_counters[i]);
+    }
+
+    // forget all blocks, so that frees of older blocks cannot make live
+    // bytes negative
+    for (size_t i = 0; i < TF_NETWORK_ALLOCATION_TRACKER_MAX_BLOCK_COUNT; ++i) {
+        blocks[i].pointer.store(BLOCK_EMPTY, std::memory_order_relaxed);
+    }
+
+    reset_counters(&total_counters);
+    live_bytes.store(0, std::memory_order_relaxed);
+    peak_live_bytes.store(0, std::memory_order_relaxed);
+}
+
+int64_t TFNetworkAllocationTracker::get_live_bytes()
+{
+    return live_bytes.load(std::memory_order_relaxed);
+}
+
+int64_t TFNetworkAllocationTracker::get_peak_live_bytes()
+{
+    return peak_live_bytes.load(std::memory_order_relaxed);
+}
+
+TFNetworkAllocationCounters TFNetworkAllocationTracker::get_counters(TFNetworkAllocationOperation operation)
+{
+    size_t index = static_cast<size_t>(operation);
+
+    if (index >= static_cast<size_t>(TFNetworkAllocationOperation::Count)) {
+        return TFNetworkAllocationCounters();
+    }
+
+    return load_counters(&operation_counters[index]);
+}
+
+TFNetworkAllocationCounters TFNetworkAllocationTracker::get_total_counters()
+{
+    return load_counters(&total_counters);
+}
+
+#endif
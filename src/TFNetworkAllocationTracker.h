@@ -0,0 +1,73 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#if defined(__linux__) && defined(TF_NETWORK_ALLOCATION_TRACKING) && TF_NETWORK_ALLOCATION_TRACKING > 0
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "TFNetwork.h"
+
+// configuration
+#ifndef TF_NETWORK_ALLOCATION_TRACKER_MAX_BLOCK_COUNT
+#define TF_NETWORK_ALLOCATION_TRACKER_MAX_BLOCK_COUNT 16384 // power of two
+#endif
+
+// Linking TFNetworkAllocationTracker.cpp into a program interposes malloc,
+// calloc, realloc, free and the aligned variants. While enabled, every heap
+// operation is attributed to the library operation that is active at the
+// time (see tf_network_allocation_scope). This includes user callbacks that
+// the library calls from within an operation.
+//
+// Byte counts are usable sizes as reported by malloc_usable_size. Live bytes
+// count the blocks that were allocated since the last reset and are not freed
+// yet. Each operation counts the blocks it allocated as live, regardless of
+// which operation frees them later. Frees of blocks from before the last
+// reset are counted as frees, but do not change live bytes. At most
+// TF_NETWORK_ALLOCATION_TRACKER_MAX_BLOCK_COUNT live blocks can be told
+// apart, blocks beyond that stay live until the next reset.
+
+struct TFNetworkAllocationCounters
+{
+    size_t allocation_count = 0;
+    size_t free_count       = 0;
+    size_t allocated_bytes  = 0;
+    size_t freed_bytes      = 0;
+    int64_t live_bytes      = 0; // allocated minus freed by the operation
+    int64_t peak_live_bytes = 0; // high-water mark of live_bytes
+};
+
+namespace TFNetworkAllocationTracker
+{
+    void enable();
+    void disable();
+    bool is_enabled();
+    void reset();
+
+    int64_t get_live_bytes();
+    int64_t get_peak_live_bytes();
+
+    TFNetworkAllocationCounters get_counters(TFNetworkAllocationOperation operation);
+    TFNetworkAllocationCounters get_total_counters();
+};
+
+#endif
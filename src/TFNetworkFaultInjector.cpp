@@ -0,0 +1,303 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include "TFNetworkFaultInjector.h"
+
+#if defined(__linux__) && defined(TF_NETWORK_SOCKET_HOOKS) && TF_NETWORK_SOCKET_HOOKS > 0
+
+#include <errno.h>
+#include <string.h>
+
+#define debugfln(fmt, ...) tf_network_debugfln("TFNetworkFaultInjector[%p]::" fmt, static_cast<void *>(this) __VA_OPT__(,) __VA_ARGS__)
+
+#define RATE_SCALE 1000000u
+
+struct TFNetworkFaultInjectorDelay
+{
+    TFNetworkFaultInjectorDelay *next;
+    int fd;
+    micros_t release;
+};
+
+TFNetworkFaultProfile TFNetworkFaultInjector::get_clean_profile()
+{
+    TFNetworkFaultProfile result = {};
+
+    result.burst_factor = 1;
+
+    return result;
+}
+
+// Roughly a busy 2.4 GHz network: occasional retransmission stalls that show
+// up as delays, segments split across reads, rare resets
+TFNetworkFaultProfile TFNetworkFaultInjector::get_wifi_profile()
+{
+    TFNetworkFaultProfile result = get_clean_profile();
+
+    result.connect_failure_rate = 5000;
+    result.accept_drop_rate     = 2000;
+    result.connection_drop_rate = 100;
+    result.recv_delay_rate      = 20000;
+    result.max_recv_delay       = 200_ms;
+    result.recv_fragment_rate   = 50000;
+    result.send_fragment_rate   = 50000;
+    result.burst_start_rate     = 2000;
+    result.burst_end_rate       = 50000;
+    result.burst_factor         = 10;
+
+    return result;
+}
+
+// Everything the parsers have to survive, including corruption and
+// duplication that TCP would normally prevent
+TFNetworkFaultProfile TFNetworkFaultInjector::get_harsh_profile()
+{
+    TFNetworkFaultProfile result = get_wifi_profile();
+
+    result.connection_drop_rate = 1000;
+    result.recv_corrupt_rate    = 2000;
+    result.send_corrupt_rate    = 2000;
+    result.send_duplicate_rate  = 2000;
+    result.max_recv_delay       = 1_s;
+
+    return result;
+}
+
+void TFNetworkFaultInjector::install()
+{
+    if (installed) {
+        return;
+    }
+
+    TFNetwork::socket_send    = [this](int fd, const void *buffer, size_t length, int flags) { return send(fd, buffer, length, flags); };
+    TFNetwork::socket_recv    = [this](int fd, void *buffer, size_t length, int flags) { return recv(fd, buffer, length, flags); };
+    TFNetwork::socket_connect = [this](int fd, const struct sockaddr *address, socklen_t address_length) { return connect(fd, address, address_length); };
+    TFNetwork::socket_accept  = [this](int fd, struct sockaddr *address, socklen_t *address_length) { return accept(fd, address, address_length); };
+    TFNetwork::socket_close   = [this](int fd) { return close(fd); };
+
+    installed = true;
+}
+
+void TFNetworkFaultInjector::uninstall()
+{
+    if (!installed) {
+        return;
+    }
+
+    TFNetwork::reset_socket_hooks();
+
+    while (delay_head != nullptr) {
+        TFNetworkFaultInjectorDelay *delay = delay_head;
+
+        delay_head = delay->next;
+
+        delete delay;
+    }
+
+    installed = false;
+}
+
+// xorshift64*
+uint32_t TFNetworkFaultInjector::get_random(uint32_t bound)
+{
+    random_state ^= random_state >> 12;
+    random_state ^= random_state << 25;
+    random_state ^= random_state >> 27;
+
+    return static_cast<uint32_t>(((random_state * 0x2545F4914F6CDD1DULL) >> 32) % bound);
+}
+
+bool TFNetworkFaultInjector::roll(uint32_t rate)
+{
+    if (in_burst) {
+        if (get_random(RATE_SCALE) < profile.burst_end_rate) {
+            in_burst = false;
+        }
+    }
+    else if (get_random(RATE_SCALE) < profile.burst_start_rate) {
+        in_burst = true;
+        ++statistics.bursts;
+    }
+
+    if (rate == 0) {
+        return false;
+    }
+
+    uint64_t effective_rate = static_cast<uint64_t>(rate) * (in_burst ? profile.burst_factor : 1u);
+
+    return get_random(RATE_SCALE) < effective_rate;
+}
+
+void TFNetworkFaultInjector::drop_connection(int fd)
+{
+    debugfln("drop_connection(fd=%d)", fd);
+
+    ++statistics.connection_drops;
+    shutdown(fd, SHUT_RDWR);
+}
+
+ssize_t TFNetworkFaultInjector::send(int fd, const void *buffer, size_t length, int flags)
+{
+    if (roll(profile.connection_drop_rate)) {
+        drop_connection(fd);
+        errno = EPIPE;
+        return -1;
+    }
+
+    if (length > 1 && roll(profile.send_fragment_rate)) {
+        ++statistics.send_fragments;
+        length = 1 + get_random(static_cast<uint32_t>(length - 1));
+    }
+
+    ssize_t result;
+
+    if (length > 0 && roll(profile.send_corrupt_rate)) {
+        uint8_t *corrupted = new uint8_t[length];
+
+        memcpy(corrupted, buffer, length);
+        corrupted[get_random(static_cast<uint32_t>(length))] ^= static_cast<uint8_t>(1u << get_random(8));
+
+        ++statistics.send_corruptions;
+        result = ::send(fd, corrupted, length, flags);
+
+        delete[] corrupted;
+    }
+    else {
+        result = ::send(fd, buffer, length, flags);
+    }
+
+    if (result > 0 && roll(profile.send_duplicate_rate)) {
+        int saved_errno = errno;
+
+        ++statistics.send_duplicates;
+        ::send(fd, buffer, static_cast<size_t>(result), flags);
+
+        errno = saved_errno;
+    }
+
+    return result;
+}
+
+ssize_t TFNetworkFaultInjector::recv(int fd, void *buffer, size_t length, int flags)
+{
+    TFNetworkFaultInjectorDelay **delay_ptr = &delay_head;
+
+    while (*delay_ptr != nullptr && (*delay_ptr)->fd != fd) {
+        delay_ptr = &(*delay_ptr)->next;
+    }
+
+    if (*delay_ptr != nullptr) {
+        if (!deadline_elapsed((*delay_ptr)->release)) {
+            errno = EAGAIN;
+            return -1;
+        }
+
+        TFNetworkFaultInjectorDelay *delay = *delay_ptr;
+
+        *delay_ptr = delay->next;
+
+        delete delay;
+    }
+    else if (profile.max_recv_delay > 0_s && roll(profile.recv_delay_rate)) {
+        uint8_t byte;
+
+        // only delay if there is data, otherwise the delay would be
+        // invisible and only hide the next arrival
+        if (::recv(fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT) > 0) {
+            TFNetworkFaultInjectorDelay *delay = new TFNetworkFaultInjectorDelay;
+
+            delay->next    = delay_head;
+            delay->fd      = fd;
+            delay->release = calculate_deadline(micros_t{1 + get_random(static_cast<uint32_t>(profile.max_recv_delay.as<int64_t>()))});
+            delay_head     = delay;
+
+            ++statistics.recv_delays;
+            errno = EAGAIN;
+            return -1;
+        }
+    }
+
+    if (roll(profile.connection_drop_rate)) {
+        drop_connection(fd);
+        errno = ECONNRESET;
+        return -1;
+    }
+
+    if (length > 1 && roll(profile.recv_fragment_rate)) {
+        ++statistics.recv_fragments;
+        length = 1 + get_random(static_cast<uint32_t>(length - 1));
+    }
+
+    ssize_t result = ::recv(fd, buffer, length, flags);
+
+    if (result > 0 && roll(profile.recv_corrupt_rate)) {
+        ++statistics.recv_corruptions;
+        static_cast<uint8_t *>(buffer)[get_random(static_cast<uint32_t>(result))] ^= static_cast<uint8_t>(1u << get_random(8));
+    }
+
+    return result;
+}
+
+int TFNetworkFaultInjector::connect(int fd, const struct sockaddr *address, socklen_t address_length)
+{
+    if (roll(profile.connect_failure_rate)) {
+        ++statistics.connect_failures;
+        errno = ECONNREFUSED;
+        return -1;
+    }
+
+    return ::connect(fd, address, address_length);
+}
+
+int TFNetworkFaultInjector::accept(int fd, struct sockaddr *address, socklen_t *address_length)
+{
+    int result = ::accept(fd, address, address_length);
+
+    if (result >= 0 && roll(profile.accept_drop_rate)) {
+        ++statistics.accept_drops;
+        ::close(result);
+        errno = ECONNABORTED;
+        return -1;
+    }
+
+    return result;
+}
+
+int TFNetworkFaultInjector::close(int fd)
+{
+    TFNetworkFaultInjectorDelay **delay_ptr = &delay_head;
+
+    while (*delay_ptr != nullptr) {
+        if ((*delay_ptr)->fd == fd) {
+            TFNetworkFaultInjectorDelay *delay = *delay_ptr;
+
+            *delay_ptr = delay->next;
+
+            delete delay;
+            break;
+        }
+
+        delay_ptr = &(*delay_ptr)->next;
+    }
+
+    return ::close(fd);
+}
+
+#endif
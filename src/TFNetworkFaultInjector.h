@@ -0,0 +1,110 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#if defined(__linux__) && defined(TF_NETWORK_SOCKET_HOOKS) && TF_NETWORK_SOCKET_HOOKS > 0
+
+#include <stdint.h>
+#include <stddef.h>
+#include <TFTools/Micros.h>
+
+#include "TFNetwork.h"
+
+// All rates are per million socket operations
+struct TFNetworkFaultProfile
+{
+    uint32_t connect_failure_rate;
+    uint32_t accept_drop_rate;
+    uint32_t connection_drop_rate; // per send and recv
+    uint32_t recv_delay_rate;
+    micros_t max_recv_delay;
+    uint32_t recv_fragment_rate;
+    uint32_t recv_corrupt_rate;
+    uint32_t send_fragment_rate;
+    uint32_t send_corrupt_rate;
+    uint32_t send_duplicate_rate;
+
+    // Losses on WiFi come in bursts. Each operation can start a burst, during
+    // which all rates are multiplied by burst_factor, until it ends again
+    uint32_t burst_start_rate;
+    uint32_t burst_end_rate;
+    uint32_t burst_factor;
+};
+
+struct TFNetworkFaultStatistics
+{
+    size_t connect_failures;
+    size_t accept_drops;
+    size_t connection_drops;
+    size_t recv_delays;
+    size_t recv_fragments;
+    size_t recv_corruptions;
+    size_t send_fragments;
+    size_t send_corruptions;
+    size_t send_duplicates;
+    size_t bursts;
+};
+
+struct TFNetworkFaultInjectorDelay;
+
+// Replaces the TFNetwork::socket_* hooks with versions that inject faults.
+// The faults are drawn from a PRNG with the given seed, so the same seed and
+// the same sequence of socket operations give the same faults. A delayed recv
+// peeks at the socket and reports EAGAIN until the delay is over, so the data
+// stays in the kernel and select() keeps reporting the socket as readable
+class TFNetworkFaultInjector final
+{
+public:
+    TFNetworkFaultInjector(uint64_t seed, const TFNetworkFaultProfile &profile_) : random_state(seed != 0 ? seed : 1), profile(profile_) {}
+    ~TFNetworkFaultInjector() { uninstall(); }
+
+    TFNetworkFaultInjector(TFNetworkFaultInjector const &other) = delete;
+    TFNetworkFaultInjector &operator=(TFNetworkFaultInjector const &other) = delete;
+
+    static TFNetworkFaultProfile get_clean_profile();
+    static TFNetworkFaultProfile get_wifi_profile();
+    static TFNetworkFaultProfile get_harsh_profile();
+
+    void install();
+    void uninstall();
+    void set_profile(const TFNetworkFaultProfile &profile_) { profile = profile_; }
+    const TFNetworkFaultStatistics &get_statistics() const { return statistics; }
+
+private:
+    uint32_t get_random(uint32_t bound);
+    bool roll(uint32_t rate);
+    void drop_connection(int fd);
+
+    ssize_t send(int fd, const void *buffer, size_t length, int flags);
+    ssize_t recv(int fd, void *buffer, size_t length, int flags);
+    int connect(int fd, const struct sockaddr *address, socklen_t address_length);
+    int accept(int fd, struct sockaddr *address, socklen_t *address_length);
+    int close(int fd);
+
+    uint64_t random_state;
+    TFNetworkFaultProfile profile;
+    TFNetworkFaultStatistics statistics     = {};
+    bool in_burst                           = false;
+    bool installed                          = false;
+    TFNetworkFaultInjectorDelay *delay_head = nullptr;
+};
+
+#endif
@@ -0,0 +1,508 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include "TFNetworkOpenMetrics.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "TFNetwork.h"
+
+#define debugfln(fmt, ...) tf_network_debugfln("TFNetworkOpenMetricsRenderer[%p]::" fmt, static_cast<void *>(this) __VA_OPT__(,) __VA_ARGS__)
+
+enum class TFNetworkOpenMetricsStage : uint8_t
+{
+    Type,
+    Unit,
+    Help,
+    Samples,
+};
+
+struct TFNetworkOpenMetricsFamily
+{
+    const char *name;
+    const char *type;
+    const char *unit; // nullptr if none
+    const char *help;
+    bool per_client;  // clients and the clients of all pool slots
+    TFNetworkOpenMetricsSourceType source_type;
+    size_t sub_count; // samples per source
+};
+
+static const char *client_result_names[] = {"success", "exception", "timeout", "failure"};
+static const char *server_connection_event_names[] = {"accepted", "rejected", "disconnected"};
+static const char *server_response_result_names[] = {"success", "exception"};
+
+#define ARRAY_LENGTH(array) (sizeof(array) / sizeof((array)[0]))
+
+// histogram buckets, +Inf bucket, count and sum
+#define LATENCY_SUB_COUNT (TF_NETWORK_LATENCY_HISTOGRAM_BUCKET_COUNT + 3)
+
+static const TFNetworkOpenMetricsFamily families[] = {
+    {"tf_network_client_transactions", "counter", nullptr, "Finished transactions by result", true, TFNetworkOpenMetricsSourceType::Client, ARRAY_LENGTH(client_result_names)},
+    {"tf_network_client_transaction_latency_seconds", "histogram", "seconds", "Latency of sent transactions", true, TFNetworkOpenMetricsSourceType::Client, LATENCY_SUB_COUNT},
+    {"tf_network_client_pending_transactions", "gauge", nullptr, "Transactions waiting for a response", true, TFNetworkOpenMetricsSourceType::Client, 1},
+    {"tf_network_client_scheduled_transactions", "gauge", nullptr, "Transactions waiting to be sent", true, TFNetworkOpenMetricsSourceType::Client, 1},
+    {"tf_network_client_connected", "gauge", nullptr, "1 if the client is connected", true, TFNetworkOpenMetricsSourceType::Client, 1},
+    {"tf_network_pool_slots", "gauge", nullptr, "Pool slots with a client", false, TFNetworkOpenMetricsSourceType::Pool, 1},
+    {"tf_network_pool_shares", "gauge", nullptr, "Shares over all pool slots", false, TFNetworkOpenMetricsSourceType::Pool, 1},
+    {"tf_network_server_clients", "gauge", nullptr, "Connected server clients", false, TFNetworkOpenMetricsSourceType::Server, 1},
+    {"tf_network_server_connections", "counter", nullptr, "Server connections by event", false, TFNetworkOpenMetricsSourceType::Server, ARRAY_LENGTH(server_connection_event_names)},
+    {"tf_network_server_responses", "counter", nullptr, "Sent server responses by result", false, TFNetworkOpenMetricsSourceType::Server, ARRAY_LENGTH(server_response_result_names)},
+    {"tf_network_server_deferred_responses", "counter", nullptr, "Deferred server responses", false, TFNetworkOpenMetricsSourceType::Server, 1},
+    {"tf_network_server_unanswered_requests", "counter", nullptr, "Server requests that were deliberately not answered", false, TFNetworkOpenMetricsSourceType::Server, 1},
+    {"tf_network_gateway_downstream_reads", "counter", nullptr, "Reads sent downstream by the gateway", false, TFNetworkOpenMetricsSourceType::Gateway, 1},
+    {"tf_network_gateway_coalesced_reads", "counter", nullptr, "Reads answered by joining another downstream read", false, TFNetworkOpenMetricsSourceType::Gateway, 1},
+    {"tf_network_gateway_downstream_writes", "counter", nullptr, "Writes sent downstream by the gateway", false, TFNetworkOpenMetricsSourceType::Gateway, 1},
+    {"tf_network_mirror_polls", "counter", nullptr, "Polls of the remote device", false, TFNetworkOpenMetricsSourceType::Mirror, 1},
+    {"tf_network_mirror_poll_errors", "counter", nullptr, "Failed polls of the remote device", false, TFNetworkOpenMetricsSourceType::Mirror, 1},
+    {"tf_network_mirror_forwarded_writes", "counter", nullptr, "Writes forwarded to the remote device", false, TFNetworkOpenMetricsSourceType::Mirror, 1},
+};
+
+#define FAMILY_COUNT ARRAY_LENGTH(families)
+
+// Formats one line into the remaining output buffer, remembers if it did not fit
+class TFNetworkOpenMetricsLine
+{
+public:
+    TFNetworkOpenMetricsLine(char *buffer_, size_t buffer_length_) : buffer(buffer_), buffer_length(buffer_length_) {}
+
+    [[gnu::format(__printf__, 2, 3)]] void appendf(const char *fmt, ...)
+    {
+        if (overflow) {
+            return;
+        }
+
+        va_list args;
+
+        va_start(args, fmt);
+        int result = vsnprintf(buffer + length, buffer_length - length, fmt, args);
+        va_end(args);
+
+        if (result < 0 || static_cast<size_t>(result) >= buffer_length - length) {
+            overflow = true;
+            return;
+        }
+
+        length += static_cast<size_t>(result);
+    }
+
+    // label values escape backslash, double quote and line feed
+    void append_escaped(const char *string)
+    {
+        for (; string != nullptr && *string != '\0'; ++string) {
+            if (*string == '\\') {
+                appendf("\\\\");
+            }
+            else if (*string == '"') {
+                appendf("\\\"");
+            }
+            else if (*string == '\n') {
+                appendf("\\n");
+            }
+            else {
+                appendf("%c", *string);
+            }
+        }
+    }
+
+    char *buffer;
+    size_t buffer_length;
+    size_t length = 0;
+    bool overflow = false;
+};
+
+void TFNetworkOpenMetricsRenderer::clear()
+{
+    source_count = 0;
+    done         = true;
+}
+
+bool TFNetworkOpenMetricsRenderer::add_source(TFNetworkOpenMetricsSourceType type, const void *object, const char *name)
+{
+    if (object == nullptr || name == nullptr) {
+        debugfln("add_source(name=%s) invalid argument", TFNetwork::printf_safe(name));
+        return false;
+    }
+
+    if (source_count >= TF_NETWORK_OPEN_METRICS_MAX_SOURCE_COUNT) {
+        debugfln("add_source(name=%s) too many sources", name);
+        return false;
+    }
+
+    TFNetworkOpenMetricsSource *source = &sources[source_count++];
+
+    source->type   = type;
+    source->object = object;
+    source->name   = name;
+
+    return true;
+}
+
+void TFNetworkOpenMetricsRenderer::begin()
+{
+    done         = false;
+    family       = 0;
+    stage        = static_cast<uint8_t>(TFNetworkOpenMetricsStage::Type);
+    source_index = 0;
+    slot_index   = 0;
+    sub_index    = 0;
+    cumulative   = 0;
+}
+
+ssize_t TFNetworkOpenMetricsRenderer::render(char *buffer, size_t buffer_length)
+{
+    size_t used = 0;
+
+    while (!done) {
+        TFNetworkOpenMetricsLine line(buffer + used, buffer_length - used);
+        bool emitted = format_line(&line);
+
+        if (emitted && line.overflow) {
+            if (used > 0) {
+                break; // format again for the next chunk
+            }
+
+            debugfln("render(buffer_length=%zu) line does not fit into the buffer", buffer_length);
+
+            done  = true;
+            errno = ENOBUFS;
+
+            return -1;
+        }
+
+        if (emitted) {
+            used += line.length;
+        }
+
+        advance(emitted);
+    }
+
+    return static_cast<ssize_t>(used);
+}
+
+bool TFNetworkOpenMetricsRenderer::has_sources(size_t family_index) const
+{
+    const TFNetworkOpenMetricsFamily *info = &families[family_index];
+
+    for (size_t i = 0; i < source_count; ++i) {
+        if (sources[i].type == info->source_type || (info->per_client && sources[i].type == TFNetworkOpenMetricsSourceType::Pool)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// returns false if there is nothing to emit at the current position
+bool TFNetworkOpenMetricsRenderer::format_line(TFNetworkOpenMetricsLine *line) const
+{
+    if (family >= FAMILY_COUNT) {
+        line->appendf("# EOF\n");
+        return true;
+    }
+
+    const TFNetworkOpenMetricsFamily *info = &families[family];
+
+    switch (static_cast<TFNetworkOpenMetricsStage>(stage)) {
+    case TFNetworkOpenMetricsStage::Type:
+        if (!has_sources(family)) {
+            return false;
+        }
+
+        line->appendf("# TYPE %s %s\n", info->name, info->type);
+        return true;
+
+    case TFNetworkOpenMetricsStage::Unit:
+        if (info->unit == nullptr) {
+            return false;
+        }
+
+        line->appendf("# UNIT %s %s\n", info->name, info->unit);
+        return true;
+
+    case TFNetworkOpenMetricsStage::Help:
+        line->appendf("# HELP %s %s\n", info->name, info->help);
+        return true;
+
+    case TFNetworkOpenMetricsStage::Samples:
+        break;
+    }
+
+    if (source_index >= source_count) {
+        return false;
+    }
+
+    const TFNetworkOpenMetricsSource *source = &sources[source_index];
+
+    if (info->per_client) {
+        if (source->type == TFNetworkOpenMetricsSourceType::Client) {
+            format_sample(line, source, static_cast<const TFModbusTCPClient *>(source->object));
+            return true;
+        }
+
+        if (source->type == TFNetworkOpenMetricsSourceType::Pool) {
+            // the pool only creates TFModbusTCPClient instances
+            const TFModbusTCPClient *client = static_cast<const TFModbusTCPClient *>(static_cast<const TFModbusTCPClientPool *>(source->object)->get_slot_client(slot_index));
+
+            if (client == nullptr) {
+                return false;
+            }
+
+            format_sample(line, source, client);
+            return true;
+        }
+
+        return false;
+    }
+
+    if (source->type != info->source_type) {
+        return false;
+    }
+
+    format_sample(line, source, nullptr);
+    return true;
+}
+
+void TFNetworkOpenMetricsRenderer::format_sample(TFNetworkOpenMetricsLine *line, const TFNetworkOpenMetricsSource *source, const TFModbusTCPClient *client) const
+{
+    const TFNetworkOpenMetricsFamily *info = &families[family];
+    const char *suffix                     = "";
+
+    if (strcmp(info->type, "counter") == 0) {
+        suffix = "_total";
+    }
+    else if (strcmp(info->type, "histogram") == 0) {
+        suffix = sub_index <= TF_NETWORK_LATENCY_HISTOGRAM_BUCKET_COUNT ? "_bucket" : (sub_index == TF_NETWORK_LATENCY_HISTOGRAM_BUCKET_COUNT + 1 ? "_count" : "_sum");
+    }
+
+    line->appendf("%s%s{name=\"", info->name, suffix);
+    line->append_escaped(source->name);
+    line->appendf("\"");
+
+    if (client != nullptr) {
+        line->appendf(",host=\"");
+        line->append_escaped(client->get_host());
+        line->appendf("\",port=\"%u\"", client->get_port());
+    }
+
+    switch (family) {
+    case 0: // tf_network_client_transactions
+        {
+            const TFModbusTCPClientStatistics *statistics = client->get_statistics();
+            const uint64_t counts[]                       = {statistics->success_count, statistics->exception_count, statistics->timeout_count, statistics->failure_count};
+
+            line->appendf(",result=\"%s\"} %llu\n", client_result_names[sub_index], static_cast<unsigned long long>(counts[sub_index]));
+        }
+
+        break;
+
+    case 1: // tf_network_client_transaction_latency_seconds
+        {
+            const TFNetworkLatencyHistogram *latency = &client->get_statistics()->latency;
+
+            if (sub_index < TF_NETWORK_LATENCY_HISTOGRAM_BUCKET_COUNT) {
+                uint32_t upper_bound_us = TFNetworkLatencyHistogram::upper_bounds_us[sub_index];
+                char upper_bound[24];
+                size_t length = static_cast<size_t>(snprintf(upper_bound, sizeof(upper_bound), "%u.%06u", upper_bound_us / 1000000, upper_bound_us % 1000000));
+
+                // canonical float representation, e.g. 0.0025 and 1.0
+                while (length > 0 && upper_bound[length - 1] == '0' && upper_bound[length - 2] != '.') {
+                    upper_bound[--length] = '\0';
+                }
+
+                line->appendf(",le=\"%s\"} %llu\n", upper_bound, static_cast<unsigned long long>(cumulative + latency->bucket_counts[sub_index]));
+            }
+            else if (sub_index == TF_NETWORK_LATENCY_HISTOGRAM_BUCKET_COUNT) {
+                line->appendf(",le=\"+Inf\"} %llu\n", static_cast<unsigned long long>(latency->count));
+            }
+            else if (sub_index == TF_NETWORK_LATENCY_HISTOGRAM_BUCKET_COUNT + 1) {
+                line->appendf("} %llu\n", static_cast<unsigned long long>(latency->count));
+            }
+            else {
+                line->appendf("} %llu.%06llu\n", static_cast<unsigned long long>(latency->sum_us / 1000000), static_cast<unsigned long long>(latency->sum_us % 1000000));
+            }
+        }
+
+        break;
+
+    case 2: // tf_network_client_pending_transactions
+        line->appendf("} %zu\n", client->get_pending_transaction_count());
+        break;
+
+    case 3: // tf_network_client_scheduled_transactions
+        line->appendf("} %zu\n", client->get_scheduled_transaction_count());
+        break;
+
+    case 4: // tf_network_client_connected
+        line->appendf("} %d\n", client->get_connection_status() == TFGenericTCPClientConnectionStatus::Connected ? 1 : 0);
+        break;
+
+    case 5: // tf_network_pool_slots
+        line->appendf("} %zu\n", static_cast<const TFModbusTCPClientPool *>(source->object)->get_slot_count());
+        break;
+
+    case 6: // tf_network_pool_shares
+        line->appendf("} %zu\n", static_cast<const TFModbusTCPClientPool *>(source->object)->get_share_count());
+        break;
+
+    case 7: // tf_network_server_clients
+        line->appendf("} %zu\n", static_cast<const TFModbusTCPServer *>(source->object)->get_client_count());
+        break;
+
+    case 8: // tf_network_server_connections
+        {
+            const TFModbusTCPServerStatistics *statistics = static_cast<const TFModbusTCPServer *>(source->object)->get_statistics();
+            const uint64_t counts[]                       = {statistics->accepted_connection_count, statistics->rejected_connection_count, statistics->disconnected_connection_count};
+
+            line->appendf(",event=\"%s\"} %llu\n", server_connection_event_names[sub_index], static_cast<unsigned long long>(counts[sub_index]));
+        }
+
+        break;
+
+    case 9: // tf_network_server_responses
+        {
+            const TFModbusTCPServerStatistics *statistics = static_cast<const TFModbusTCPServer *>(source->object)->get_statistics();
+            const uint64_t counts[]                       = {statistics->response_count - statistics->exception_response_count, statistics->exception_response_count};
+
+            line->appendf(",result=\"%s\"} %llu\n", server_response_result_names[sub_index], static_cast<unsigned long long>(counts[sub_index]));
+        }
+
+        break;
+
+    case 10: // tf_network_server_deferred_responses
+        line->appendf("} %llu\n", static_cast<unsigned long long>(static_cast<const TFModbusTCPServer *>(source->object)->get_statistics()->deferred_response_count));
+        break;
+
+    case 11: // tf_network_server_unanswered_requests
+        line->appendf("} %llu\n", static_cast<unsigned long long>(static_cast<const TFModbusTCPServer *>(source->object)->get_statistics()->unanswered_request_count));
+        break;
+
+    case 12: // tf_network_gateway_downstream_reads
+        line->appendf("} %zu\n", static_cast<const TFModbusTCPGateway *>(source->object)->get_downstream_read_count());
+        break;
+
+    case 13: // tf_network_gateway_coalesced_reads
+        line->appendf("} %zu\n", static_cast<const TFModbusTCPGateway *>(source->object)->get_coalesced_read_count());
+        break;
+
+    case 14: // tf_network_gateway_downstream_writes
+        line->appendf("} %zu\n", static_cast<const TFModbusTCPGateway *>(source->object)->get_downstream_write_count());
+        break;
+
+    case 15: // tf_network_mirror_polls
+        line->appendf("} %zu\n", static_cast<const TFModbusTCPMirror *>(source->object)->get_poll_count());
+        break;
+
+    case 16: // tf_network_mirror_poll_errors
+        line->appendf("} %zu\n", static_cast<const TFModbusTCPMirror *>(source->object)->get_poll_error_count());
+        break;
+
+    case 17: // tf_network_mirror_forwarded_writes
+        line->appendf("} %zu\n", static_cast<const TFModbusTCPMirror *>(source->object)->get_forwarded_write_count());
+        break;
+
+    default:
+        line->overflow = true; // never emit a broken line
+        break;
+    }
+}
+
+void TFNetworkOpenMetricsRenderer::advance(bool emitted)
+{
+    if (family >= FAMILY_COUNT) {
+        done = true;
+        return;
+    }
+
+    switch (static_cast<TFNetworkOpenMetricsStage>(stage)) {
+    case TFNetworkOpenMetricsStage::Type:
+        if (emitted) {
+            stage = static_cast<uint8_t>(TFNetworkOpenMetricsStage::Unit);
+        }
+        else {
+            ++family; // no sources, skip the whole family
+        }
+
+        return;
+
+    case TFNetworkOpenMetricsStage::Unit:
+        stage = static_cast<uint8_t>(TFNetworkOpenMetricsStage::Help);
+        return;
+
+    case TFNetworkOpenMetricsStage::Help:
+        stage        = static_cast<uint8_t>(TFNetworkOpenMetricsStage::Samples);
+        source_index = 0;
+        slot_index   = 0;
+        sub_index    = 0;
+        cumulative   = 0;
+        return;
+
+    case TFNetworkOpenMetricsStage::Samples:
+        break;
+    }
+
+    if (source_index >= source_count) {
+        ++family;
+        stage = static_cast<uint8_t>(TFNetworkOpenMetricsStage::Type);
+        return;
+    }
+
+    const TFNetworkOpenMetricsFamily *info = &families[family];
+    bool pool_clients                      = info->per_client && sources[source_index].type == TFNetworkOpenMetricsSourceType::Pool;
+
+    if (emitted) {
+        if (family == 1 && sub_index < TF_NETWORK_LATENCY_HISTOGRAM_BUCKET_COUNT) {
+            const TFModbusTCPClient *client;
+
+            if (pool_clients) {
+                client = static_cast<const TFModbusTCPClient *>(static_cast<const TFModbusTCPClientPool *>(sources[source_index].object)->get_slot_client(slot_index));
+            }
+            else {
+                client = static_cast<const TFModbusTCPClient *>(sources[source_index].object);
+            }
+
+            cumulative += client->get_statistics()->latency.bucket_counts[sub_index];
+        }
+
+        if (++sub_index < info->sub_count) {
+            return;
+        }
+    }
+
+    sub_index  = 0;
+    cumulative = 0;
+
+    if (pool_clients && ++slot_index < TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT) {
+        return;
+    }
+
+    next_source();
+}
+
+void TFNetworkOpenMetricsRenderer::next_source()
+{
+    ++source_index;
+    slot_index = 0;
+    sub_index  = 0;
+    cumulative = 0;
+}
@@ -0,0 +1,105 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "TFModbusTCPClient.h"
+#include "TFModbusTCPClientPool.h"
+#include "TFModbusTCPServer.h"
+#include "TFModbusTCPGateway.h"
+#include "TFModbusTCPMirror.h"
+
+// configuration
+#ifndef TF_NETWORK_OPEN_METRICS_MAX_SOURCE_COUNT
+#define TF_NETWORK_OPEN_METRICS_MAX_SOURCE_COUNT 16
+#endif
+
+#define TF_NETWORK_OPEN_METRICS_CONTENT_TYPE "application/openmetrics-text; version=1.0.0; charset=utf-8"
+
+enum class TFNetworkOpenMetricsSourceType : uint8_t
+{
+    Client,
+    Pool,
+    Server,
+    Gateway,
+    Mirror,
+};
+
+struct TFNetworkOpenMetricsSource
+{
+    TFNetworkOpenMetricsSourceType type;
+    const void *object;
+    const char *name;
+};
+
+class TFNetworkOpenMetricsLine;
+
+// Renders the statistics of the added clients, pools, servers, gateways and
+// mirrors in the OpenMetrics text format, without any heap allocation. The
+// output is produced in chunks of complete lines into a caller-provided
+// buffer, so that an HTTP server can stream it: call begin(), then render()
+// until it returns 0. Lines are formatted directly into the buffer, which has
+// to hold the longest line plus a null byte. Otherwise render() returns -1 with
+// errno set to ENOBUFS and the pass ends, instead of emitting incomplete output.
+// Each pool contributes the client metrics of all its slots, labeled with the
+// pool name, host and port. Names are not copied, they and the sources have to
+// stay valid while the renderer uses them. The sources must not be ticked
+// between two render() calls of the same pass, or the output can be
+// inconsistent
+class TFNetworkOpenMetricsRenderer final
+{
+public:
+    TFNetworkOpenMetricsRenderer() {}
+
+    TFNetworkOpenMetricsRenderer(TFNetworkOpenMetricsRenderer const &other) = delete;
+    TFNetworkOpenMetricsRenderer &operator=(TFNetworkOpenMetricsRenderer const &other) = delete;
+
+    bool add_client(const TFModbusTCPClient *client, const char *name) { return add_source(TFNetworkOpenMetricsSourceType::Client, client, name); }
+    bool add_pool(const TFModbusTCPClientPool *pool, const char *name) { return add_source(TFNetworkOpenMetricsSourceType::Pool, pool, name); }
+    bool add_server(const TFModbusTCPServer *server, const char *name) { return add_source(TFNetworkOpenMetricsSourceType::Server, server, name); }
+    bool add_gateway(const TFModbusTCPGateway *gateway, const char *name) { return add_source(TFNetworkOpenMetricsSourceType::Gateway, gateway, name); }
+    bool add_mirror(const TFModbusTCPMirror *mirror, const char *name) { return add_source(TFNetworkOpenMetricsSourceType::Mirror, mirror, name); }
+    void clear();
+
+    void begin();
+    ssize_t render(char *buffer, size_t buffer_length); // returns 0 once the output is complete
+
+private:
+    bool add_source(TFNetworkOpenMetricsSourceType type, const void *object, const char *name);
+    bool has_sources(size_t family) const;
+    bool format_line(TFNetworkOpenMetricsLine *line) const;
+    void format_sample(TFNetworkOpenMetricsLine *line, const TFNetworkOpenMetricsSource *source, const TFModbusTCPClient *client) const;
+    void advance(bool emitted);
+    void next_source();
+
+    TFNetworkOpenMetricsSource sources[TF_NETWORK_OPEN_METRICS_MAX_SOURCE_COUNT];
+    size_t source_count = 0;
+    bool done           = true;
+    size_t family       = 0;
+    uint8_t stage       = 0;
+    size_t source_index = 0;
+    size_t slot_index   = 0;
+    size_t sub_index    = 0;
+    uint64_t cumulative = 0; // histogram buckets before the current one
+};
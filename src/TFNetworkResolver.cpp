@@ -0,0 +1,688 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include "TFNetworkResolver.h"
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#define debugfln(fmt, ...) tf_network_debugfln("TFNetworkResolver[%p]::" fmt, static_cast<void *>(this) __VA_OPT__(,) __VA_ARGS__)
+
+#define DNS_HEADER_LENGTH 12
+#define DNS_MAX_MESSAGE_LENGTH 512
+#define DNS_MAX_NAME_LENGTH 253
+#define DNS_MAX_LABEL_LENGTH 63
+#define DNS_MAX_POINTER_COUNT 16
+#define DNS_FLAG_RESPONSE 0x8000
+#define DNS_FLAG_RECURSION_DESIRED 0x0100
+#define DNS_RCODE_MASK 0x000F
+#define DNS_RCODE_NXDOMAIN 3
+#define DNS_TYPE_A 1
+#define DNS_CLASS_IN 1
+
+struct TFNetworkResolverHostsEntry
+{
+    TFNetworkResolverHostsEntry *next;
+    uint32_t address;
+    char *name;
+};
+
+struct TFNetworkResolverCacheEntry
+{
+    TFNetworkResolverCacheEntry *next;
+    char *host;
+    uint32_t address;
+    int error_number;
+    micros_t expiration;
+};
+
+struct TFNetworkResolverCallback
+{
+    TFNetworkResolverCallback *next;
+    TFNetworkResolveResultCallback callback;
+};
+
+struct TFNetworkResolverQuery
+{
+    TFNetworkResolverQuery *next;
+    char *host;
+    uint16_t id;
+    micros_t deadline;
+    int attempt_count;
+    TFNetworkResolverCallback *callback_head;
+    TFNetworkResolverCallback **callback_tail;
+};
+
+static char *duplicate_host(const char *host)
+{
+    size_t host_length = strlen(host);
+
+    // a trailing dot marks a fully qualified name, it does not change the name
+    if (host_length > 0 && host[host_length - 1] == '.') {
+        --host_length;
+    }
+
+    char *result = new char[host_length + 1];
+
+    memcpy(result, host, host_length);
+    result[host_length] = '\0';
+
+    return result;
+}
+
+static uint16_t read_uint16(const uint8_t *buffer)
+{
+    return static_cast<uint16_t>((buffer[0] << 8) | buffer[1]);
+}
+
+static uint32_t read_uint32(const uint8_t *buffer)
+{
+    return (static_cast<uint32_t>(buffer[0]) << 24) | (static_cast<uint32_t>(buffer[1]) << 16)
+         | (static_cast<uint32_t>(buffer[2]) << 8) | buffer[3];
+}
+
+// Decodes a possibly compressed name into dotted form. The offset is advanced
+// past the name as it appears at the original position
+static bool read_name(const uint8_t *message, size_t message_length, size_t *offset, char *name, size_t name_length)
+{
+    size_t position   = *offset;
+    size_t used       = 0;
+    int pointer_count = 0;
+    bool jumped       = false;
+
+    while (true) {
+        if (position >= message_length) {
+            return false;
+        }
+
+        uint8_t label_length = message[position];
+
+        if ((label_length & 0xC0) == 0xC0) {
+            if (position + 1 >= message_length || ++pointer_count > DNS_MAX_POINTER_COUNT) {
+                return false;
+            }
+
+            if (!jumped) {
+                *offset = position + 2;
+                jumped  = true;
+            }
+
+            position = ((label_length & 0x3F) << 8) | message[position + 1];
+            continue;
+        }
+
+        if ((label_length & 0xC0) != 0) {
+            return false;
+        }
+
+        if (label_length == 0) {
+            if (!jumped) {
+                *offset = position + 1;
+            }
+
+            if (used == 0) {
+                name[used++] = '\0';
+            }
+            else {
+                name[used - 1] = '\0'; // replace the trailing dot
+            }
+
+            return true;
+        }
+
+        if (position + 1 + label_length > message_length || used + label_length + 1 > name_length) {
+            return false;
+        }
+
+        memcpy(name + used, message + position + 1, label_length);
+
+        used        += label_length;
+        name[used++] = '.';
+        position    += 1 + label_length;
+    }
+}
+
+bool TFNetworkResolver::start(uint32_t server_address, uint16_t server_port, const char *hosts_path)
+{
+    if (socket_fd >= 0) {
+        debugfln("start() already started");
+        return false;
+    }
+
+    if (server_address == 0) {
+        FILE *file = fopen("/etc/resolv.conf", "r");
+        char line[256];
+
+        if (file != nullptr) {
+            while (server_address == 0 && fgets(line, sizeof(line), file) != nullptr) {
+                char address_str[64];
+                struct in_addr address;
+
+                if (sscanf(line, " nameserver %63s", address_str) == 1 && inet_pton(AF_INET, address_str, &address) == 1) {
+                    server_address = address.s_addr;
+                }
+            }
+
+            fclose(file);
+        }
+
+        if (server_address == 0) {
+            debugfln("start() no IPv4 nameserver in /etc/resolv.conf");
+            return false;
+        }
+    }
+
+    if (hosts_path != nullptr && !load_hosts(hosts_path)) {
+        return false;
+    }
+
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (fd < 0) {
+        debugfln("start() socket failed (errno=%d)", errno);
+        return false;
+    }
+
+    struct sockaddr_in addr;
+
+    memset(&addr, 0, sizeof(addr));
+
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = server_address;
+    addr.sin_port        = htons(server_port);
+
+    // a connected UDP socket only receives datagrams from the server
+    if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0) {
+        debugfln("start() connect failed (errno=%d)", errno);
+        close(fd);
+        return false;
+    }
+
+    socket_fd = fd;
+
+    return true;
+}
+
+bool TFNetworkResolver::load_hosts(const char *hosts_path)
+{
+    FILE *file = fopen(hosts_path, "r");
+
+    if (file == nullptr) {
+        if (errno == ENOENT) {
+            return true;
+        }
+
+        debugfln("load_hosts(hosts_path=%s) fopen failed (errno=%d)", hosts_path, errno);
+        return false;
+    }
+
+    TFNetworkResolverHostsEntry **hosts_tail = &hosts_head;
+    char line[512];
+
+    while (*hosts_tail != nullptr) {
+        hosts_tail = &(*hosts_tail)->next;
+    }
+
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        char *comment = strchr(line, '#');
+
+        if (comment != nullptr) {
+            *comment = '\0';
+        }
+
+        char *save_ptr;
+        char *token = strtok_r(line, " \t\r\n", &save_ptr);
+        struct in_addr address;
+
+        if (token == nullptr || inet_pton(AF_INET, token, &address) != 1) {
+            continue; // empty, comment or IPv6 line
+        }
+
+        while ((token = strtok_r(nullptr, " \t\r\n", &save_ptr)) != nullptr) {
+            TFNetworkResolverHostsEntry *entry = new TFNetworkResolverHostsEntry;
+
+            entry->next    = nullptr;
+            entry->address = address.s_addr;
+            entry->name    = duplicate_host(token);
+
+            // keep the file order, the first line naming a host wins
+            *hosts_tail = entry;
+            hosts_tail  = &entry->next;
+        }
+    }
+
+    fclose(file);
+
+    return true;
+}
+
+void TFNetworkResolver::stop()
+{
+    if (socket_fd >= 0) {
+        close(socket_fd);
+        socket_fd = -1;
+    }
+
+    while (pending_query_head != nullptr) {
+        finish_query(pending_query_head, 0, ECANCELED, 0_s);
+    }
+
+    clear_cache();
+
+    while (hosts_head != nullptr) {
+        TFNetworkResolverHostsEntry *entry = hosts_head;
+
+        hosts_head = entry->next;
+
+        delete[] entry->name;
+        delete entry;
+    }
+}
+
+void TFNetworkResolver::clear_cache()
+{
+    while (cache_head != nullptr) {
+        TFNetworkResolverCacheEntry *entry = cache_head;
+
+        cache_head = entry->next;
+
+        delete[] entry->host;
+        delete entry;
+    }
+
+    cache_count = 0;
+}
+
+void TFNetworkResolver::resolve(const char *host, TFNetworkResolveResultCallback &&callback)
+{
+    struct in_addr numeric_address;
+
+    if (host == nullptr || host[0] == '\0') {
+        callback(0, EINVAL);
+        return;
+    }
+
+    if (inet_pton(AF_INET, host, &numeric_address) == 1) {
+        callback(numeric_address.s_addr, 0);
+        return;
+    }
+
+    char *normalized_host = duplicate_host(host);
+    size_t host_length    = strlen(normalized_host);
+
+    if (host_length == 0 || host_length > DNS_MAX_NAME_LENGTH) {
+        delete[] normalized_host;
+        callback(0, EINVAL);
+        return;
+    }
+
+    for (TFNetworkResolverHostsEntry *entry = hosts_head; entry != nullptr; entry = entry->next) {
+        if (strcasecmp(entry->name, normalized_host) == 0) {
+            delete[] normalized_host;
+            callback(entry->address, 0);
+            return;
+        }
+    }
+
+    TFNetworkResolverCacheEntry *cache_entry = find_cache_entry(normalized_host);
+
+    if (cache_entry != nullptr) {
+        delete[] normalized_host;
+        callback(cache_entry->address, cache_entry->error_number);
+        return;
+    }
+
+    if (socket_fd < 0) {
+        delete[] normalized_host;
+        callback(0, ENOTCONN);
+        return;
+    }
+
+    TFNetworkResolverCallback *pending_callback = new TFNetworkResolverCallback;
+
+    pending_callback->next     = nullptr;
+    pending_callback->callback = std::move(callback);
+
+    for (TFNetworkResolverQuery *query = pending_query_head; query != nullptr; query = query->next) {
+        if (strcasecmp(query->host, normalized_host) == 0) {
+            delete[] normalized_host;
+
+            *query->callback_tail = pending_callback;
+            query->callback_tail  = &pending_callback->next;
+            return;
+        }
+    }
+
+    uint16_t id;
+
+    // a reused ID would let the answer of one query finish the other
+    do {
+        id = TFNetwork::get_random_uint16();
+    } while (find_pending_query(id) != nullptr);
+
+    TFNetworkResolverQuery *query = new TFNetworkResolverQuery;
+
+    query->next          = pending_query_head;
+    query->host          = normalized_host;
+    query->id            = id;
+    query->attempt_count = 0;
+    query->callback_head = pending_callback;
+    query->callback_tail = &pending_callback->next;
+    pending_query_head   = query;
+
+    ++pending_query_count;
+
+    if (!send_query(query)) {
+        finish_query(query, 0, EINVAL, 0_s);
+    }
+}
+
+bool TFNetworkResolver::send_query(TFNetworkResolverQuery *query)
+{
+    uint8_t message[DNS_HEADER_LENGTH + DNS_MAX_NAME_LENGTH + 2 + 4];
+    size_t message_length = DNS_HEADER_LENGTH;
+
+    memset(message, 0, DNS_HEADER_LENGTH);
+
+    message[0] = static_cast<uint8_t>(query->id >> 8);
+    message[1] = static_cast<uint8_t>(query->id);
+    message[2] = static_cast<uint8_t>(DNS_FLAG_RECURSION_DESIRED >> 8);
+    message[5] = 1; // question count
+
+    const char *label = query->host;
+
+    while (*label != '\0') {
+        const char *dot     = strchr(label, '.');
+        size_t label_length = dot != nullptr ? static_cast<size_t>(dot - label) : strlen(label);
+
+        if (label_length == 0 || label_length > DNS_MAX_LABEL_LENGTH) {
+            debugfln("send_query() invalid host (host=%s)", query->host);
+            return false;
+        }
+
+        message[message_length++] = static_cast<uint8_t>(label_length);
+
+        memcpy(message + message_length, label, label_length);
+
+        message_length += label_length;
+        label          += label_length + (dot != nullptr ? 1 : 0);
+    }
+
+    message[message_length++] = 0;
+    message[message_length++] = 0;
+    message[message_length++] = DNS_TYPE_A;
+    message[message_length++] = 0;
+    message[message_length++] = DNS_CLASS_IN;
+
+    ++query->attempt_count;
+    query->deadline = calculate_deadline(TF_NETWORK_RESOLVER_RETRY_INTERVAL);
+
+    // A failed send is retried like a lost datagram
+    if (send(socket_fd, message, message_length, 0) < 0) {
+        debugfln("send_query() send failed (host=%s errno=%d)", query->host, errno);
+    }
+
+    return true;
+}
+
+void TFNetworkResolver::tick()
+{
+    if (non_reentrant) {
+        return;
+    }
+
+    TFNetwork::NonReentrantScope scope(&non_reentrant);
+
+    if (socket_fd < 0) {
+        return;
+    }
+
+    uint8_t response[DNS_MAX_MESSAGE_LENGTH];
+    ssize_t result;
+
+    while ((result = recv(socket_fd, response, sizeof(response), 0)) >= 0) {
+        handle_response(response, static_cast<size_t>(result));
+    }
+
+    bool restart = true;
+
+    // finish_query() runs callbacks that can start new queries, so restart
+    // the scan after each one
+    while (restart) {
+        restart = false;
+
+        for (TFNetworkResolverQuery *query = pending_query_head; query != nullptr; query = query->next) {
+            if (!deadline_elapsed(query->deadline)) {
+                continue;
+            }
+
+            if (query->attempt_count < TF_NETWORK_RESOLVER_MAX_ATTEMPT_COUNT) {
+                send_query(query);
+                continue;
+            }
+
+            debugfln("tick() query timed out (host=%s)", query->host);
+
+            finish_query(query, 0, ETIMEDOUT, 0_s);
+            restart = true;
+            break;
+        }
+    }
+}
+
+void TFNetworkResolver::handle_response(const uint8_t *response, size_t response_length)
+{
+    if (response_length < DNS_HEADER_LENGTH) {
+        return;
+    }
+
+    uint16_t id                   = read_uint16(response);
+    uint16_t flags                = read_uint16(response + 2);
+    uint16_t question_count       = read_uint16(response + 4);
+    uint16_t answer_count         = read_uint16(response + 6);
+    TFNetworkResolverQuery *query = find_pending_query(id);
+
+    if (query == nullptr || (flags & DNS_FLAG_RESPONSE) == 0 || question_count != 1) {
+        return; // late, unexpected or malformed, ignore it
+    }
+
+    char name[DNS_MAX_NAME_LENGTH + 2];
+    size_t offset = DNS_HEADER_LENGTH;
+
+    // the question has to match, otherwise this might be a spoofed answer
+    if (!read_name(response, response_length, &offset, name, sizeof(name))
+     || offset + 4 > response_length
+     || strcasecmp(name, query->host) != 0
+     || read_uint16(response + offset) != DNS_TYPE_A
+     || read_uint16(response + offset + 2) != DNS_CLASS_IN) {
+        return;
+    }
+
+    offset += 4;
+
+    uint16_t rcode = flags & DNS_RCODE_MASK;
+
+    if (rcode == DNS_RCODE_NXDOMAIN) {
+        finish_query(query, 0, ENOENT, TF_NETWORK_RESOLVER_NEGATIVE_TTL);
+        return;
+    }
+
+    if (rcode != 0) {
+        debugfln("handle_response() server failure (host=%s rcode=%u)", query->host, rcode);
+        finish_query(query, 0, EIO, 0_s);
+        return;
+    }
+
+    // CNAME records come before the A record they lead to, so the first A
+    // record of the answer is the address
+    for (uint16_t i = 0; i < answer_count; ++i) {
+        if (!read_name(response, response_length, &offset, name, sizeof(name)) || offset + 10 > response_length) {
+            return;
+        }
+
+        uint16_t type        = read_uint16(response + offset);
+        uint16_t class_      = read_uint16(response + offset + 2);
+        uint32_t ttl         = read_uint32(response + offset + 4);
+        uint16_t data_length = read_uint16(response + offset + 8);
+
+        offset += 10;
+
+        if (offset + data_length > response_length) {
+            return;
+        }
+
+        if (type == DNS_TYPE_A && class_ == DNS_CLASS_IN && data_length == 4) {
+            uint32_t address;
+
+            memcpy(&address, response + offset, sizeof(address));
+
+            micros_t ttl_us = micros_t{static_cast<int64_t>(ttl) * 1000000};
+
+            if (ttl_us < TF_NETWORK_RESOLVER_MIN_TTL) {
+                ttl_us = TF_NETWORK_RESOLVER_MIN_TTL;
+            }
+            else if (ttl_us > TF_NETWORK_RESOLVER_MAX_TTL) {
+                ttl_us = TF_NETWORK_RESOLVER_MAX_TTL;
+            }
+
+            finish_query(query, address, 0, ttl_us);
+            return;
+        }
+
+        offset += data_length;
+    }
+
+    finish_query(query, 0, ENOENT, TF_NETWORK_RESOLVER_NEGATIVE_TTL); // name exists, but has no A record
+}
+
+void TFNetworkResolver::finish_query(TFNetworkResolverQuery *query, uint32_t address, int error_number, micros_t ttl)
+{
+    TFNetworkResolverQuery **query_ptr = &pending_query_head;
+
+    while (*query_ptr != query) {
+        query_ptr = &(*query_ptr)->next;
+    }
+
+    *query_ptr = query->next;
+    --pending_query_count;
+
+    if (ttl > 0_s) {
+        add_cache_entry(query->host, address, error_number, ttl);
+    }
+
+    TFNetworkResolverCallback *pending_callback = query->callback_head;
+
+    delete[] query->host;
+    delete query;
+
+    // the query is already unlinked, so callbacks can start new lookups
+    while (pending_callback != nullptr) {
+        TFNetworkResolverCallback *next = pending_callback->next;
+
+        pending_callback->callback(address, error_number);
+
+        delete pending_callback;
+        pending_callback = next;
+    }
+}
+
+TFNetworkResolverQuery *TFNetworkResolver::find_pending_query(uint16_t id)
+{
+    TFNetworkResolverQuery *query = pending_query_head;
+
+    while (query != nullptr && query->id != id) {
+        query = query->next;
+    }
+
+    return query;
+}
+
+TFNetworkResolverCacheEntry *TFNetworkResolver::find_cache_entry(const char *host)
+{
+    TFNetworkResolverCacheEntry **entry_ptr = &cache_head;
+
+    while (*entry_ptr != nullptr) {
+        TFNetworkResolverCacheEntry *entry = *entry_ptr;
+
+        if (deadline_elapsed(entry->expiration)) {
+            *entry_ptr = entry->next;
+            --cache_count;
+
+            delete[] entry->host;
+            delete entry;
+            continue;
+        }
+
+        if (strcasecmp(entry->host, host) == 0) {
+            return entry;
+        }
+
+        entry_ptr = &entry->next;
+    }
+
+    return nullptr;
+}
+
+void TFNetworkResolver::add_cache_entry(const char *host, uint32_t address, int error_number, micros_t ttl)
+{
+    TFNetworkResolverCacheEntry *entry = find_cache_entry(host);
+
+    if (entry == nullptr) {
+        if (cache_count >= TF_NETWORK_RESOLVER_MAX_CACHE_COUNT) {
+            // evict the entry that would expire first
+            TFNetworkResolverCacheEntry **oldest_ptr = &cache_head;
+
+            for (TFNetworkResolverCacheEntry **entry_ptr = &cache_head; *entry_ptr != nullptr; entry_ptr = &(*entry_ptr)->next) {
+                if ((*entry_ptr)->expiration < (*oldest_ptr)->expiration) {
+                    oldest_ptr = entry_ptr;
+                }
+            }
+
+            TFNetworkResolverCacheEntry *oldest = *oldest_ptr;
+
+            *oldest_ptr = oldest->next;
+            --cache_count;
+
+            delete[] oldest->host;
+            delete oldest;
+        }
+
+        entry       = new TFNetworkResolverCacheEntry;
+        entry->next = cache_head;
+        entry->host = duplicate_host(host);
+        cache_head  = entry;
+
+        ++cache_count;
+    }
+
+    entry->address      = address;
+    entry->error_number = error_number;
+    entry->expiration   = calculate_deadline(ttl);
+}
+
+#endif
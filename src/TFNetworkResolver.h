@@ -0,0 +1,108 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#if defined(__linux__)
+
+#include <stdint.h>
+#include <stddef.h>
+#include <TFTools/Micros.h>
+
+#include "TFNetwork.h"
+
+// configuration
+#ifndef TF_NETWORK_RESOLVER_RETRY_INTERVAL
+#define TF_NETWORK_RESOLVER_RETRY_INTERVAL 1_s
+#endif
+
+#ifndef TF_NETWORK_RESOLVER_MAX_ATTEMPT_COUNT
+#define TF_NETWORK_RESOLVER_MAX_ATTEMPT_COUNT 3
+#endif
+
+#ifndef TF_NETWORK_RESOLVER_MIN_TTL
+#define TF_NETWORK_RESOLVER_MIN_TTL 5_s
+#endif
+
+#ifndef TF_NETWORK_RESOLVER_MAX_TTL
+#define TF_NETWORK_RESOLVER_MAX_TTL 1_h
+#endif
+
+#ifndef TF_NETWORK_RESOLVER_NEGATIVE_TTL
+#define TF_NETWORK_RESOLVER_NEGATIVE_TTL 30_s
+#endif
+
+#ifndef TF_NETWORK_RESOLVER_MAX_CACHE_COUNT
+#define TF_NETWORK_RESOLVER_MAX_CACHE_COUNT 32
+#endif
+
+struct TFNetworkResolverHostsEntry;
+struct TFNetworkResolverCacheEntry;
+struct TFNetworkResolverQuery;
+
+// Non-blocking IPv4 resolver for the Linux build, driven by tick(). Numeric
+// addresses and names from the hosts file are answered immediately, all other
+// names are looked up with UDP DNS queries. Concurrent lookups of the same
+// name share one query, answers are cached for their TTL and failed lookups
+// for TF_NETWORK_RESOLVER_NEGATIVE_TTL. Cached results are reported from
+// resolve() directly, all others from tick(). Addresses are passed in network
+// byte order, like TFNetwork::resolve expects. Install it with
+//
+//   TFNetwork::resolve = [&resolver](const char *host, TFNetworkResolveResultCallback &&callback) {
+//       resolver.resolve(host, std::move(callback));
+//   };
+class TFNetworkResolver final
+{
+public:
+    TFNetworkResolver() {}
+    ~TFNetworkResolver() { stop(); }
+
+    TFNetworkResolver(TFNetworkResolver const &other) = delete;
+    TFNetworkResolver &operator=(TFNetworkResolver const &other) = delete;
+
+    // A server_address of 0 uses the first IPv4 nameserver from
+    // /etc/resolv.conf. server_address is in network byte order. A
+    // hosts_path of nullptr disables the hosts file
+    bool start(uint32_t server_address = 0, uint16_t server_port = 53, const char *hosts_path = "/etc/hosts");
+    void stop(); // reports ECANCELED to all pending lookups
+    void resolve(const char *host, TFNetworkResolveResultCallback &&callback);
+    void tick(); // non-reentrant
+    void clear_cache();
+    size_t get_pending_query_count() const { return pending_query_count; }
+
+private:
+    bool load_hosts(const char *hosts_path);
+    bool send_query(TFNetworkResolverQuery *query);
+    void handle_response(const uint8_t *response, size_t response_length);
+    void finish_query(TFNetworkResolverQuery *query, uint32_t address, int error_number, micros_t ttl);
+    TFNetworkResolverQuery *find_pending_query(uint16_t id);
+    TFNetworkResolverCacheEntry *find_cache_entry(const char *host);
+    void add_cache_entry(const char *host, uint32_t address, int error_number, micros_t ttl);
+
+    int socket_fd                              = -1;
+    TFNetworkResolverHostsEntry *hosts_head    = nullptr;
+    TFNetworkResolverCacheEntry *cache_head    = nullptr;
+    size_t cache_count                         = 0;
+    TFNetworkResolverQuery *pending_query_head = nullptr;
+    size_t pending_query_count                 = 0;
+    bool non_reentrant                         = false;
+};
+
+#endif
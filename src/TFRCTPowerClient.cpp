@@ -20,14 +20,36 @@
 #include "TFRCTPowerClient.h"
 
 #include <math.h>
-#include <errno.h>
 #include <lwip/sockets.h>
 
 #include "TFNetwork.h"
 
 #define debugfln(fmt, ...) tf_network_debugfln("TFRCTPowerClient[%p]::" fmt, static_cast<void *>(this) __VA_OPT__(,) __VA_ARGS__)
 
-static uint16_t crc16ccitt(uint8_t *buffer, size_t length)
+struct TFRCTPowerClientValueCacheEntry
+{
+    bool used;
+    uint32_t id;
+    float value;
+    micros_t received;
+};
+
+struct TFRCTPowerClientPoll
+{
+    uint32_t id;
+    micros_t period;
+    micros_t timeout;
+    float deadband;
+    TFRCTPowerClientPollCallback callback;
+    micros_t next_poll;
+    bool in_flight;
+    bool reported;
+    TFRCTPowerClientTransactionResult last_result;
+    float last_value;
+    TFRCTPowerClientPoll *next;
+};
+
+static uint16_t crc16ccitt(const uint8_t *buffer, size_t length)
 {
     uint32_t checksum = 0xFFFF;
 
@@ -86,6 +108,39 @@ const char *get_tf_rct_power_client_transaction_result_name(TFRCTPowerClientTran
     return "<Unknown>";
 }
 
+// Responses start with an unescaped '+', a '-' escapes the following byte.
+// After command and length byte follow length bytes of data and a checksum.
+// Only read responses with an ID and a float value are expected
+static const TFFramedTCPClientFraming rct_power_framing = {
+    .start_byte        = '+',
+    .escape_byte       = '-',
+    .frame_length      = TFFramedTCPClientFrameLength::LengthField,
+    .fixed_length      = 0,
+    .length_offset     = 1,
+    .length_size       = 1,
+    .length_big_endian = true,
+    .length_adjustment = 1 + 1 + 2,
+    .end_byte          = 0,
+    .max_frame_length  = 12,
+};
+
+TFRCTPowerClient::TFRCTPowerClient() : TFFramedTCPClient(&rct_power_framing)
+{
+}
+
+TFRCTPowerClient::~TFRCTPowerClient()
+{
+    delete[] value_cache;
+
+    while (poll_head != nullptr) {
+        TFRCTPowerClientPoll *poll = poll_head;
+
+        poll_head = poll->next;
+
+        delete poll;
+    }
+}
+
 void TFRCTPowerClient::read(uint32_t id, micros_t timeout, TFRCTPowerClientTransactionCallback &&callback)
 {
     if (!callback) {
@@ -103,14 +158,47 @@ void TFRCTPowerClient::read(uint32_t id, micros_t timeout, TFRCTPowerClientTrans
         return;
     }
 
-    TFRCTPowerClientTransaction **tail_ptr = &scheduled_transaction_head;
+    float cached_value;
+
+    if (read_value_cache(id, &cached_value)) {
+        callback(TFRCTPowerClientTransactionResult::Success, cached_value);
+        return;
+    }
+
+    schedule_transaction(id, timeout, std::move(callback));
+}
+
+void TFRCTPowerClient::schedule_transaction(uint32_t id, micros_t timeout, TFRCTPowerClientTransactionCallback &&callback)
+{
+    TFRCTPowerClientTransaction *joinable_transaction = nullptr;
     size_t scheduled_transaction_count = 0;
 
+    if (pending_transaction != nullptr) {
+        if (pending_transaction->id == id) {
+            joinable_transaction = pending_transaction;
+        }
+
+        for (TFRCTPowerClientTransaction *joined = pending_transaction->joined_head; joined != nullptr; joined = joined->next) {
+            ++scheduled_transaction_count;
+        }
+    }
+
+    TFRCTPowerClientTransaction **tail_ptr = &scheduled_transaction_head;
+
     while (*tail_ptr != nullptr) {
+        if (joinable_transaction == nullptr && (*tail_ptr)->id == id) {
+            joinable_transaction = *tail_ptr;
+        }
+
+        for (TFRCTPowerClientTransaction *joined = (*tail_ptr)->joined_head; joined != nullptr; joined = joined->next) {
+            ++scheduled_transaction_count;
+        }
+
         tail_ptr = &(*tail_ptr)->next;
         ++scheduled_transaction_count;
     }
 
+    // Joined reads count as scheduled, to keep the number of waiting callbacks bounded
     if (scheduled_transaction_count >= TF_RCT_POWER_CLIENT_MAX_SCHEDULED_TRANSACTION_COUNT) {
         callback(TFRCTPowerClientTransactionResult::NoTransactionAvailable, NAN);
         return;
@@ -118,27 +206,191 @@ void TFRCTPowerClient::read(uint32_t id, micros_t timeout, TFRCTPowerClientTrans
 
     TFRCTPowerClientTransaction *transaction = new TFRCTPowerClientTransaction;
 
-    transaction->id       = id;
-    transaction->timeout  = timeout;
-    transaction->callback = std::move(callback);
-    transaction->next     = nullptr;
+    transaction->id          = id;
+    transaction->timeout     = timeout;
+    transaction->callback    = std::move(callback);
+    transaction->joined_head = nullptr;
+    transaction->next        = nullptr;
+
+    if (joinable_transaction != nullptr) {
+        debugfln("schedule_transaction() joining request (id=0x%08x)", id);
+
+        TFRCTPowerClientTransaction **joined_tail_ptr = &joinable_transaction->joined_head;
+
+        while (*joined_tail_ptr != nullptr) {
+            joined_tail_ptr = &(*joined_tail_ptr)->next;
+        }
+
+        *joined_tail_ptr = transaction;
+        return;
+    }
 
     *tail_ptr = transaction;
 }
 
-void TFRCTPowerClient::close_hook()
+void TFRCTPowerClient::set_value_cache_ttl(micros_t ttl)
+{
+    if (ttl <= 0_s) {
+        delete[] value_cache;
+        value_cache     = nullptr;
+        value_cache_ttl = 0_s;
+        return;
+    }
+
+    if (value_cache == nullptr) {
+        value_cache = new TFRCTPowerClientValueCacheEntry[TF_RCT_POWER_CLIENT_VALUE_CACHE_SIZE];
+
+        for (size_t i = 0; i < TF_RCT_POWER_CLIENT_VALUE_CACHE_SIZE; ++i) {
+            value_cache[i].used = false;
+        }
+    }
+
+    value_cache_ttl = ttl;
+}
+
+bool TFRCTPowerClient::read_value_cache(uint32_t id, float *value)
+{
+    if (value_cache == nullptr) {
+        return false;
+    }
+
+    for (size_t i = 0; i < TF_RCT_POWER_CLIENT_VALUE_CACHE_SIZE; ++i) {
+        TFRCTPowerClientValueCacheEntry *entry = &value_cache[i];
+
+        if (entry->used && entry->id == id) {
+            if (deadline_elapsed(entry->received + value_cache_ttl)) {
+                entry->used = false;
+                return false;
+            }
+
+            *value = entry->value;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TFRCTPowerClient::update_value_cache(uint32_t id, float value)
+{
+    if (value_cache == nullptr) {
+        return;
+    }
+
+    TFRCTPowerClientValueCacheEntry *selected_entry = nullptr;
+
+    for (size_t i = 0; i < TF_RCT_POWER_CLIENT_VALUE_CACHE_SIZE; ++i) {
+        TFRCTPowerClientValueCacheEntry *entry = &value_cache[i];
+
+        if (entry->used && entry->id == id) {
+            selected_entry = entry;
+            break;
+        }
+
+        // Prefer a free entry, otherwise replace the oldest one
+        if (selected_entry == nullptr
+         || (selected_entry->used && (!entry->used || entry->received < selected_entry->received))) {
+            selected_entry = entry;
+        }
+    }
+
+    selected_entry->used     = true;
+    selected_entry->id       = id;
+    selected_entry->value    = value;
+    selected_entry->received = now_us();
+}
+
+void TFRCTPowerClient::set_idle_probe(micros_t idle_interval, uint32_t id, micros_t timeout /*= 2_s*/)
+{
+    idle_probe_interval = idle_interval;
+    idle_probe_id       = id;
+    idle_probe_timeout  = timeout;
+}
+
+bool TFRCTPowerClient::add_poll(uint32_t id, micros_t period, TFRCTPowerClientPollCallback &&callback, float deadband /*= 0.0f*/, micros_t timeout /*= 2_s*/)
+{
+    if (!callback || period <= 0_s || timeout < 0_s || !(deadband >= 0.0f)) {
+        return false;
+    }
+
+    TFRCTPowerClientPoll **poll_ptr = &poll_head;
+
+    while (*poll_ptr != nullptr) {
+        if ((*poll_ptr)->id == id) {
+            break;
+        }
+
+        poll_ptr = &(*poll_ptr)->next;
+    }
+
+    TFRCTPowerClientPoll *poll = *poll_ptr;
+
+    if (poll == nullptr) {
+        poll = new TFRCTPowerClientPoll;
+
+        poll->id        = id;
+        poll->next_poll = 0_s;
+        poll->in_flight = false;
+        poll->reported  = false;
+        poll->next      = nullptr;
+
+        *poll_ptr = poll;
+    }
+
+    poll->period   = period;
+    poll->timeout  = timeout;
+    poll->deadband = deadband;
+    poll->callback = std::move(callback);
+
+    return true;
+}
+
+bool TFRCTPowerClient::remove_poll(uint32_t id)
+{
+    for (TFRCTPowerClientPoll **poll_ptr = &poll_head; *poll_ptr != nullptr; poll_ptr = &(*poll_ptr)->next) {
+        TFRCTPowerClientPoll *poll = *poll_ptr;
+
+        if (poll->id == id) {
+            // An outstanding poll read finds no poll anymore and is ignored
+            if (poll->in_flight) {
+                poll_pending = false;
+            }
+
+            *poll_ptr = poll->next;
+
+            delete poll;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TFRCTPowerClient::framed_close_hook()
 {
-    last_received_byte = 0;
     bootloader_magic_number = 0;
     bootloader_last_detected = 0_s;
 
-    reset_pending_response();
     finish_all_transactions(TFRCTPowerClientTransactionResult::Aborted);
+
+    idle_probe_failed = false;
+
+    // Start over with all polls due after reconnecting
+    for (TFRCTPowerClientPoll *poll = poll_head; poll != nullptr; poll = poll->next) {
+        poll->next_poll = 0_s;
+    }
+
+    if (value_cache != nullptr) {
+        for (size_t i = 0; i < TF_RCT_POWER_CLIENT_VALUE_CACHE_SIZE; ++i) {
+            value_cache[i].used = false;
+        }
+    }
 }
 
-void TFRCTPowerClient::tick_hook()
+void TFRCTPowerClient::framed_tick_hook()
 {
     check_pending_transaction_timeout();
+    check_polls();
 
     if (pending_transaction == nullptr && scheduled_transaction_head != nullptr) {
         pending_transaction          = scheduled_transaction_head;
@@ -171,107 +423,187 @@ void TFRCTPowerClient::tick_hook()
             escaped_request[escaped_request_length++] = request[i];
         }
 
-        if (!send(escaped_request, escaped_request_length)) {
-            int saved_errno = errno;
-            finish_pending_transaction(TFRCTPowerClientTransactionResult::SendFailed, NAN);
-            disconnect(TFGenericTCPClientDisconnectReason::SocketSendFailed, saved_errno);
+        // sent after this hook returned, a send error disconnects and aborts
+        // all transactions, including the pending one
+        if (!queue_send(escaped_request, escaped_request_length)) {
+            return;
         }
     }
+
+    check_idle_probe();
 }
 
-bool TFRCTPowerClient::recv_hook()
+void TFRCTPowerClient::check_polls()
 {
-    micros_t deadline = calculate_deadline(10_ms);
+    if (socket_fd < 0
+     || poll_pending
+     || scheduled_transaction_head != nullptr
+     || (poll_spacing > 0_s && !deadline_elapsed(poll_last_sent + poll_spacing))) {
+        return;
+    }
 
-    while (sizeof(pending_response) - pending_response_used > 0) {
-        if (deadline_elapsed(deadline)) {
-            return true;
+    TFRCTPowerClientPoll *selected_poll = nullptr;
+
+    for (TFRCTPowerClientPoll *poll = poll_head; poll != nullptr; poll = poll->next) {
+        if (deadline_elapsed(poll->next_poll) && (selected_poll == nullptr || poll->next_poll < selected_poll->next_poll)) {
+            selected_poll = poll;
         }
+    }
 
-        uint8_t received_byte;
-        ssize_t result = recv(&received_byte, 1);
+    if (selected_poll == nullptr) {
+        return;
+    }
 
-        if (result < 0) {
-            if (errno != EAGAIN && errno != EWOULDBLOCK) {
-                disconnect(TFGenericTCPClientDisconnectReason::SocketReceiveFailed, errno);
-            }
+    // Keep the phase of the period, unless the poll fell behind by a whole period
+    selected_poll->next_poll += selected_poll->period;
 
-            return false;
-        }
+    if (deadline_elapsed(selected_poll->next_poll)) {
+        selected_poll->next_poll = calculate_deadline(selected_poll->period);
+    }
 
-        if (result == 0) {
-            disconnect(TFGenericTCPClientDisconnectReason::DisconnectedByPeer, -1);
-            return false;
-        }
+    selected_poll->in_flight = true;
+    poll_pending             = true;
+    poll_last_sent           = now_us();
 
-        bootloader_magic_number = (bootloader_magic_number << 8) | received_byte;
+    uint32_t id = selected_poll->id;
 
-        if (bootloader_magic_number == 0x50F705AB) {
-            bootloader_last_detected = now_us();
-        }
+    read(id, selected_poll->timeout, [this, id](TFRCTPowerClientTransactionResult result, float value) {
+        finish_poll(id, result, value);
+    });
+}
 
-        debugfln("received_byte %u 0x%02x %s| last_received_byte %u 0x%02x %s",
-                 received_byte, received_byte, received_byte == '+' ? "+ " : (received_byte == '-' ? "- " : ""),
-                 last_received_byte, last_received_byte, last_received_byte == '+' ? "+ " : (last_received_byte == '-' ? "- " : ""));
+void TFRCTPowerClient::finish_poll(uint32_t id, TFRCTPowerClientTransactionResult result, float value)
+{
+    TFRCTPowerClientPoll *poll = poll_head;
 
-        if (wait_for_start) {
-            if (received_byte == '+' && last_received_byte != '-') {
-                debugfln("Received expected start byte");
-                wait_for_start = false;
-            }
-        }
-        else if (received_byte == '+') {
-            if (last_received_byte == '-') {
-                pending_response[pending_response_used++] = received_byte;
-            }
-            else {
-                debugfln("Received unexpected start byte, starting new response");
-                pending_response_used = 0;
-            }
-        }
-        else if (received_byte == '-') {
-            if (last_received_byte == '-') {
-                pending_response[pending_response_used++] = received_byte;
-            }
-        }
-        else {
-            pending_response[pending_response_used++] = received_byte;
-        }
+    while (poll != nullptr && poll->id != id) {
+        poll = poll->next;
+    }
+
+    if (poll == nullptr || !poll->in_flight) {
+        return;
+    }
+
+    poll->in_flight = false;
+    poll_pending    = false;
+
+    // The connection got closed, polls start over after reconnecting
+    if (result == TFRCTPowerClientTransactionResult::Aborted) {
+        return;
+    }
+
+    bool changed;
+
+    if (!poll->reported) {
+        changed = true;
+    }
+    else if (result != TFRCTPowerClientTransactionResult::Success) {
+        changed = poll->last_result == TFRCTPowerClientTransactionResult::Success;
+    }
+    else if (poll->last_result != TFRCTPowerClientTransactionResult::Success) {
+        changed = true;
+    }
+    else if (isnan(value) || isnan(poll->last_value)) {
+        changed = isnan(value) != isnan(poll->last_value);
+    }
+    else {
+        changed = fabsf(value - poll->last_value) > poll->deadband;
+    }
+
+    if (!changed) {
+        return;
+    }
+
+    poll->reported    = true;
+    poll->last_result = result;
+
+    if (result == TFRCTPowerClientTransactionResult::Success) {
+        poll->last_value = value;
+    }
+
+    // Copy the callback, it might remove the poll
+    TFRCTPowerClientPollCallback callback = poll->callback;
+
+    callback(id, result, value);
+}
+
+void TFRCTPowerClient::check_idle_probe()
+{
+    if (socket_fd < 0) {
+        return;
+    }
+
+    if (idle_probe_failed) {
+        idle_probe_failed = false;
+        disconnect(TFGenericTCPClientDisconnectReason::IdleProbeFailed, -1);
+        return;
+    }
+
+    if (idle_probe_interval <= 0_s
+     || idle_probe_pending
+     || pending_transaction != nullptr
+     || scheduled_transaction_head != nullptr
+     || !deadline_elapsed(last_received + idle_probe_interval)) {
+        return;
+    }
+
+    debugfln("check_idle_probe() sending probe (id=0x%08x)", idle_probe_id);
+
+    idle_probe_pending = true;
 
-        last_received_byte = received_byte;
+    // Bypass the value cache, the probe has to go over the connection
+    schedule_transaction(idle_probe_id, idle_probe_timeout, [this](TFRCTPowerClientTransactionResult result, float value) {
+        (void)value;
 
-        if (pending_response_used == 1 && pending_response[0] != 5) {
-            debugfln("Received response with unexpected command %u, ignoring response", pending_response[0]);
-            reset_pending_response();
+        idle_probe_pending = false;
+
+        // Only a timeout indicates a dead connection, send and receive errors
+        // already disconnect on their own
+        if (result == TFRCTPowerClientTransactionResult::Timeout) {
+            debugfln("check_idle_probe() probe timed out");
+            idle_probe_failed = true;
         }
-        else if (pending_response_used == 2 && pending_response[1] != 8) {
-            debugfln("Received response with unexpected length %u, ignoring response", pending_response[1]);
-            reset_pending_response();
+    });
+}
+
+void TFRCTPowerClient::received_hook(const uint8_t *buffer, size_t length)
+{
+    for (size_t i = 0; i < length; ++i) {
+        bootloader_magic_number = (bootloader_magic_number << 8) | buffer[i];
+
+        if (bootloader_magic_number == 0x50F705AB) {
+            bootloader_last_detected = now_us();
         }
     }
+}
+
+void TFRCTPowerClient::frame_hook(const uint8_t *frame, size_t length)
+{
+    if (length != 12 || frame[0] != 5) {
+        debugfln("Received response with unexpected command %u or length %zu, ignoring response", frame[0], length);
+        return;
+    }
 
-    uint32_t id = ((uint32_t)pending_response[2] << 24) |
-                  ((uint32_t)pending_response[3] << 16) |
-                  ((uint32_t)pending_response[4] <<  8) |
-                  ((uint32_t)pending_response[5] <<  0);
+    uint32_t id = ((uint32_t)frame[2] << 24) |
+                  ((uint32_t)frame[3] << 16) |
+                  ((uint32_t)frame[4] <<  8) |
+                  ((uint32_t)frame[5] <<  0);
 
     if (pending_transaction == nullptr || pending_transaction->id != id) {
-        reset_pending_response();
-        return true;
+        return;
     }
 
-    uint16_t actual_checksum   = crc16ccitt(pending_response, pending_response_used - 2);
-    uint16_t expected_checksum = ((uint16_t)pending_response[pending_response_used - 2] << 8) | pending_response[pending_response_used - 1];
+    uint16_t actual_checksum   = crc16ccitt(frame, length - 2);
+    uint16_t expected_checksum = ((uint16_t)frame[length - 2] << 8) | frame[length - 1];
 
     if (actual_checksum != expected_checksum) {
         debugfln("Received response [%02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x] for ID 0x%08x with checksum mismatch (actual=0x%04x expected=0x%04x), ignoring response",
-                 pending_response[0], pending_response[1], pending_response[2], pending_response[3], pending_response[4], pending_response[5],
-                 pending_response[6], pending_response[7], pending_response[8], pending_response[9], pending_response[10], pending_response[11],
+                 frame[0], frame[1], frame[2], frame[3], frame[4], frame[5],
+                 frame[6], frame[7], frame[8], frame[9], frame[10], frame[11],
                  id, actual_checksum, expected_checksum);
 
-        reset_pending_response();
         finish_pending_transaction(TFRCTPowerClientTransactionResult::ChecksumMismatch, NAN);
-        return true;
+        return;
     }
 
     union {
@@ -279,29 +611,45 @@ bool TFRCTPowerClient::recv_hook()
         uint8_t bytes[4];
     } u;
 
-    u.bytes[0] = pending_response[6 + 3];
-    u.bytes[1] = pending_response[6 + 2];
-    u.bytes[2] = pending_response[6 + 1];
-    u.bytes[3] = pending_response[6 + 0];
+    u.bytes[0] = frame[6 + 3];
+    u.bytes[1] = frame[6 + 2];
+    u.bytes[2] = frame[6 + 1];
+    u.bytes[3] = frame[6 + 0];
 
     debugfln("Received response for ID 0x%08x with value %f", id, u.value);
 
-    reset_pending_response();
+    update_value_cache(id, u.value);
     finish_pending_transaction(TFRCTPowerClientTransactionResult::Success, u.value);
-    return true;
+}
+
+// Deletes the transaction and its joined transactions, then calls all their
+// callbacks. The transaction has to be unlinked already
+static void finish_transaction(TFRCTPowerClientTransaction *transaction, TFRCTPowerClientTransactionResult result, float value)
+{
+    transaction->next = transaction->joined_head;
+
+    while (transaction != nullptr) {
+        TFRCTPowerClientTransactionCallback callback = std::move(transaction->callback);
+        transaction->callback = nullptr;
+
+        TFRCTPowerClientTransaction *transaction_next = transaction->next;
+
+        delete transaction;
+        transaction = transaction_next;
+
+        callback(result, value);
+    }
 }
 
 void TFRCTPowerClient::finish_pending_transaction(TFRCTPowerClientTransactionResult result, float value)
 {
     if (pending_transaction != nullptr) {
-        TFRCTPowerClientTransactionCallback callback = std::move(pending_transaction->callback);
-        pending_transaction->callback = nullptr;
+        TFRCTPowerClientTransaction *transaction = pending_transaction;
 
-        delete pending_transaction;
         pending_transaction          = nullptr;
         pending_transaction_deadline = 0_s;
 
-        callback(result, value);
+        finish_transaction(transaction, result, value);
     }
 }
 
@@ -313,15 +661,10 @@ void TFRCTPowerClient::finish_all_transactions(TFRCTPowerClientTransactionResult
     scheduled_transaction_head = nullptr;
 
     while (scheduled_transaction != nullptr) {
-        TFRCTPowerClientTransactionCallback callback = std::move(scheduled_transaction->callback);
-        scheduled_transaction->callback = nullptr;
-
         TFRCTPowerClientTransaction *scheduled_transaction_next = scheduled_transaction->next;
 
-        delete scheduled_transaction;
+        finish_transaction(scheduled_transaction, result, NAN);
         scheduled_transaction = scheduled_transaction_next;
-
-        callback(result, NAN);
     }
 }
 
@@ -331,9 +674,3 @@ void TFRCTPowerClient::check_pending_transaction_timeout()
         finish_pending_transaction(TFRCTPowerClientTransactionResult::Timeout, NAN);
     }
 }
-
-void TFRCTPowerClient::reset_pending_response()
-{
-    wait_for_start        = true;
-    pending_response_used = 0;
-}
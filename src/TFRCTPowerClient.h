@@ -21,13 +21,17 @@
 
 #include <stdint.h>
 
-#include "TFGenericTCPClient.h"
+#include "TFFramedTCPClient.h"
 
 // configuration
 #ifndef TF_RCT_POWER_CLIENT_MAX_SCHEDULED_TRANSACTION_COUNT
 #define TF_RCT_POWER_CLIENT_MAX_SCHEDULED_TRANSACTION_COUNT 8
 #endif
 
+#ifndef TF_RCT_POWER_CLIENT_VALUE_CACHE_SIZE
+#define TF_RCT_POWER_CLIENT_VALUE_CACHE_SIZE 16
+#endif
+
 enum class TFRCTPowerClientTransactionResult
 {
     Success,
@@ -45,41 +49,85 @@ enum class TFRCTPowerClientTransactionResult
 const char *get_tf_rct_power_client_transaction_result_name(TFRCTPowerClientTransactionResult result);
 
 typedef std::function<void(TFRCTPowerClientTransactionResult result, float value)> TFRCTPowerClientTransactionCallback;
+typedef std::function<void(uint32_t id, TFRCTPowerClientTransactionResult result, float value)> TFRCTPowerClientPollCallback;
 
 struct TFRCTPowerClientTransaction
 {
     uint32_t id;
     micros_t timeout;
     TFRCTPowerClientTransactionCallback callback;
+    TFRCTPowerClientTransaction *joined_head; // reads of the same ID sharing this request
     TFRCTPowerClientTransaction *next;
 };
 
-class TFRCTPowerClient final : public TFGenericTCPClient
+struct TFRCTPowerClientValueCacheEntry;
+struct TFRCTPowerClientPoll;
+
+class TFRCTPowerClient final : public TFFramedTCPClient
 {
 public:
-    TFRCTPowerClient() {}
+    TFRCTPowerClient();
+    ~TFRCTPowerClient();
 
+    // A read of an ID that is already scheduled or pending joins that request
+    // instead of sending another one. The joined read shares the result and
+    // the timeout of the request it joined
     void read(uint32_t id, micros_t timeout, TFRCTPowerClientTransactionCallback &&callback);
 
+    // Successfully read values are kept for the TTL and reads of a cached ID
+    // are answered directly without a request. The cache holds the most
+    // recently received TF_RCT_POWER_CLIENT_VALUE_CACHE_SIZE IDs and is
+    // cleared on disconnect. A TTL of 0 disables the cache
+    void set_value_cache_ttl(micros_t ttl);
+
+    // Read the given ID if nothing was received for the idle interval. If the
+    // probe times out the client gets disconnected with the IdleProbeFailed
+    // reason. An idle interval of 0 disables the probe
+    void set_idle_probe(micros_t idle_interval, uint32_t id, micros_t timeout = 2_s);
+
+    // Poll plan: registered IDs are read every period from the tick while the
+    // client is connected. Only one poll read is outstanding at a time and only
+    // if no other read is scheduled, so polls fill the gaps between other reads
+    // instead of competing with them. The most overdue ID is read first. The
+    // callback is only called if the value changed by more than the deadband
+    // since the last call, and once for each run of failed reads. Adding an
+    // already added ID replaces its period, deadband and callback
+    bool add_poll(uint32_t id, micros_t period, TFRCTPowerClientPollCallback &&callback, float deadband = 0.0f, micros_t timeout = 2_s);
+    bool remove_poll(uint32_t id);
+    void set_poll_spacing(micros_t spacing) { poll_spacing = spacing; } // minimum time between two poll reads
+
 private:
-    void close_hook() override;
-    void tick_hook() override;
-    bool recv_hook() override;
+    void framed_close_hook() override;
+    void framed_tick_hook() override;
+    void frame_hook(const uint8_t *frame, size_t length) override;
+    void received_hook(const uint8_t *buffer, size_t length) override;
 
+    void schedule_transaction(uint32_t id, micros_t timeout, TFRCTPowerClientTransactionCallback &&callback);
     void finish_pending_transaction(TFRCTPowerClientTransactionResult result, float value);
     void finish_all_transactions(TFRCTPowerClientTransactionResult result);
     void check_pending_transaction_timeout();
-    void reset_pending_response();
+    void check_idle_probe();
+    bool read_value_cache(uint32_t id, float *value);
+    void update_value_cache(uint32_t id, float value);
+    void check_polls();
+    void finish_poll(uint32_t id, TFRCTPowerClientTransactionResult result, float value);
 
     TFRCTPowerClientTransaction *pending_transaction        = nullptr;
     micros_t pending_transaction_deadline                   = 0_s;
     TFRCTPowerClientTransaction *scheduled_transaction_head = nullptr;
-    bool wait_for_start                                     = true;
-    uint8_t last_received_byte                              = 0;
-    uint8_t pending_response[12];
-    size_t pending_response_used                            = 0;
     uint32_t bootloader_magic_number                        = 0;
     micros_t bootloader_last_detected                       = 0_s;
+    micros_t idle_probe_interval                            = 0_s;
+    uint32_t idle_probe_id                                  = 0;
+    micros_t idle_probe_timeout                             = 0_s;
+    bool idle_probe_pending                                 = false;
+    bool idle_probe_failed                                  = false;
+    TFRCTPowerClientValueCacheEntry *value_cache            = nullptr;
+    micros_t value_cache_ttl                                = 0_s;
+    TFRCTPowerClientPoll *poll_head                         = nullptr;
+    micros_t poll_spacing                                   = 0_s;
+    micros_t poll_last_sent                                 = 0_s;
+    bool poll_pending                                       = false;
 };
 
 class TFRCTPowerSharedClient final : public TFGenericTCPSharedClient
@@ -92,6 +140,18 @@ public:
         client->read(id, timeout, std::move(callback));
     }
 
+    // The poll plan belongs to the client and is shared by all its shared
+    // clients. Remove added polls before releasing the shared client
+    bool add_poll(uint32_t id, micros_t period, TFRCTPowerClientPollCallback &&callback, float deadband = 0.0f, micros_t timeout = 2_s)
+    {
+        return client->add_poll(id, period, std::move(callback), deadband, timeout);
+    }
+
+    bool remove_poll(uint32_t id)
+    {
+        return client->remove_poll(id);
+    }
+
 private:
     TFRCTPowerClient *client;
 };
@@ -21,6 +21,13 @@
 
 #include "TFRCTPowerClient.h"
 
+void TFRCTPowerClientPool::set_idle_probe(micros_t idle_interval, uint32_t id, micros_t timeout /*= 2_s*/)
+{
+    idle_probe_interval = idle_interval;
+    idle_probe_id       = id;
+    idle_probe_timeout  = timeout;
+}
+
 TFGenericTCPClient *TFRCTPowerClientPool::create_client()
 {
     return new TFRCTPowerClient;
@@ -30,3 +37,14 @@ TFGenericTCPSharedClient *TFRCTPowerClientPool::create_shared_client(TFGenericTC
 {
     return new TFRCTPowerSharedClient(static_cast<TFRCTPowerClient *>(client));
 }
+
+void TFRCTPowerClientPool::prepare_client(TFGenericTCPClient *client, const char *host, uint16_t port)
+{
+    (void)host;
+    (void)port;
+
+    TFRCTPowerClient *rct_client = static_cast<TFRCTPowerClient *>(client);
+
+    rct_client->set_idle_probe(idle_probe_interval, idle_probe_id, idle_probe_timeout);
+    rct_client->set_value_cache_ttl(value_cache_ttl);
+}
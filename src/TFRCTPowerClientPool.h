@@ -26,7 +26,22 @@ class TFRCTPowerClientPool : public TFGenericTCPClientPool
 public:
     TFRCTPowerClientPool() {}
 
+    // The idle probe is applied to every client before each connect. An idle
+    // interval of 0 disables the probe
+    void set_idle_probe(micros_t idle_interval, uint32_t id, micros_t timeout = 2_s);
+
+    // The value cache TTL is applied to every client before each connect. All
+    // shared clients of a host and port use the same cache
+    void set_value_cache_ttl(micros_t ttl) { value_cache_ttl = ttl; }
+
 protected:
     TFGenericTCPClient *create_client() override;
     TFGenericTCPSharedClient *create_shared_client(TFGenericTCPClient *client) override;
+    void prepare_client(TFGenericTCPClient *client, const char *host, uint16_t port) override;
+
+private:
+    micros_t idle_probe_interval = 0_s;
+    uint32_t idle_probe_id       = 0;
+    micros_t idle_probe_timeout  = 0_s;
+    micros_t value_cache_ttl     = 0_s;
 };
@@ -1,6 +1,30 @@
 #!/bin/sh
 COMPILE="g++ -O2 -ggdb -I . -Wall -Wextra -DTF_NETWORK_DEBUG_LOG=1 -I ../../tftools/src ../../tftools/src/TFTools/Micros.cpp ../src/TFNetwork.cpp"
-$COMPILE ../src/TFGenericTCPClient.cpp ../src/TFModbusTCPClient.cpp ../src/TFModbusTCPCommon.cpp test_client.cpp -o test_client
-$COMPILE ../src/TFGenericTCPClient.cpp ../src/TFModbusTCPClient.cpp ../src/TFModbusTCPCommon.cpp ../src/TFGenericTCPClientPool.cpp ../src/TFModbusTCPClientPool.cpp test_pool.cpp -o test_pool
+$COMPILE ../src/TFNetworkResolver.cpp ../src/TFGenericTCPClient.cpp ../src/TFModbusTCPClient.cpp ../src/TFModbusTCPCommon.cpp test_client.cpp -o test_client
+$COMPILE ../src/TFNetworkResolver.cpp ../src/TFGenericTCPClient.cpp ../src/TFModbusTCPClient.cpp ../src/TFModbusTCPCommon.cpp ../src/TFGenericTCPClientPool.cpp ../src/TFModbusTCPClientPool.cpp test_pool.cpp -o test_pool
 $COMPILE ../src/TFModbusTCPCommon.cpp ../src/TFModbusTCPServer.cpp test_server.cpp -o test_server
 $COMPILE ../src/TFModbusTCPCommon.cpp ../src/TFModbusTCPServer.cpp test_sun_spec.cpp -o test_sun_spec
+$COMPILE ../src/TFNetworkResolver.cpp ../src/TFGenericTCPClient.cpp ../src/TFModbusTCPClient.cpp ../src/TFModbusTCPCommon.cpp ../src/TFModbusTCPServer.cpp test_write_combining.cpp -o test_write_combining
+$COMPILE ../src/TFNetworkResolver.cpp ../src/TFGenericTCPClient.cpp ../src/TFModbusTCPClient.cpp ../src/TFModbusTCPCommon.cpp ../src/TFModbusTCPServer.cpp test_write_shadow.cpp -o test_write_shadow
+$COMPILE ../src/TFNetworkResolver.cpp ../src/TFGenericTCPClient.cpp ../src/TFModbusTCPClient.cpp ../src/TFModbusTCPCommon.cpp ../src/TFModbusTCPServer.cpp ../src/TFModbusTCPReadPlanner.cpp test_read_planner.cpp -o test_read_planner
+$COMPILE ../src/TFNetworkResolver.cpp ../src/TFGenericTCPClient.cpp ../src/TFModbusTCPClient.cpp ../src/TFModbusTCPCommon.cpp ../src/TFModbusTCPServer.cpp ../src/TFModbusTCPDeviceProfile.cpp ../src/TFModbusTCPDeviceProber.cpp test_device_prober.cpp -o test_device_prober
+$COMPILE ../src/TFNetworkResolver.cpp ../src/TFGenericTCPClient.cpp ../src/TFModbusTCPClient.cpp ../src/TFModbusTCPCommon.cpp ../src/TFModbusTCPServer.cpp test_bus_scheduling.cpp -o test_bus_scheduling
+$COMPILE ../src/TFNetworkResolver.cpp ../src/TFGenericTCPClient.cpp ../src/TFModbusTCPClient.cpp ../src/TFModbusTCPCommon.cpp ../src/TFModbusTCPServer.cpp ../src/TFModbusTCPFileTransfer.cpp ../src/TFModbusTCPFileRecordSource.cpp test_file_records.cpp -o test_file_records
+$COMPILE ../src/TFNetworkResolver.cpp ../src/TFGenericTCPClient.cpp ../src/TFModbusTCPClient.cpp ../src/TFModbusTCPCommon.cpp ../src/TFModbusTCPServer.cpp ../src/TFModbusTCPFIFOQueue.cpp test_fifo_queue.cpp -o test_fifo_queue
+$COMPILE ../src/TFModbusTCPCommon.cpp ../src/TFModbusTCPRegisterBank.cpp ../src/TFModbusTCPMemoryRegisterBank.cpp test_memory_register_bank.cpp -o test_memory_register_bank
+$COMPILE ../src/TFModbusTCPCommon.cpp ../src/TFModbusTCPRegisterBank.cpp ../src/TFModbusTCPSharedMemoryRegisterBank.cpp test_shared_memory_register_bank.cpp -o test_shared_memory_register_bank
+$COMPILE ../src/TFModbusTCPCommon.cpp ../src/TFModbusTCPRegisterBank.cpp ../src/TFModbusTCPRegisterMap.cpp test_register_map.cpp -o test_register_map
+$COMPILE ../src/TFNetworkResolver.cpp test_resolver.cpp -o test_resolver
+$COMPILE -DTF_NETWORK_SOCKET_HOOKS=1 ../src/TFNetworkFaultInjector.cpp ../src/TFGenericTCPClient.cpp ../src/TFModbusTCPClient.cpp ../src/TFModbusTCPCommon.cpp ../src/TFGenericTCPClientPool.cpp ../src/TFModbusTCPClientPool.cpp ../src/TFModbusTCPServer.cpp ../src/TFModbusTCPRegisterBank.cpp ../src/TFModbusTCPMemoryRegisterBank.cpp test_fault_injection.cpp -o test_fault_injection
+$COMPILE -DTF_NETWORK_ALLOCATION_TRACKING=1 ../src/TFNetworkAllocationTracker.cpp ../src/TFGenericTCPClient.cpp ../src/TFModbusTCPClient.cpp ../src/TFModbusTCPCommon.cpp ../src/TFGenericTCPClientPool.cpp ../src/TFModbusTCPClientPool.cpp ../src/TFModbusTCPServer.cpp ../src/TFModbusTCPRegisterBank.cpp ../src/TFModbusTCPMemoryRegisterBank.cpp test_allocation.cpp -o test_allocation
+$COMPILE ../src/TFGenericTCPClient.cpp ../src/TFModbusTCPClient.cpp ../src/TFModbusTCPCommon.cpp ../src/TFGenericTCPClientPool.cpp ../src/TFModbusTCPClientPool.cpp ../src/TFModbusTCPServer.cpp ../src/TFModbusTCPRegisterBank.cpp ../src/TFModbusTCPMemoryRegisterBank.cpp test_soak.cpp -o test_soak
+$COMPILE ../src/TFNetworkResolver.cpp ../src/TFGenericTCPClient.cpp ../src/TFModbusTCPClient.cpp ../src/TFModbusTCPCommon.cpp ../src/TFGenericTCPClientPool.cpp ../src/TFModbusTCPClientPool.cpp ../src/TFModbusTCPServer.cpp ../src/TFModbusTCPRegisterBank.cpp ../src/TFModbusTCPMemoryRegisterBank.cpp ../src/TFModbusTCPGateway.cpp test_gateway.cpp -o test_gateway
+$COMPILE ../src/TFNetworkResolver.cpp ../src/TFGenericTCPClient.cpp ../src/TFModbusTCPClient.cpp ../src/TFModbusTCPCommon.cpp ../src/TFGenericTCPClientPool.cpp ../src/TFModbusTCPClientPool.cpp ../src/TFModbusTCPServer.cpp ../src/TFModbusTCPRegisterBank.cpp ../src/TFModbusTCPMemoryRegisterBank.cpp ../src/TFModbusTCPReadPlanner.cpp ../src/TFModbusTCPHistory.cpp ../src/TFModbusTCPMirror.cpp test_mirror.cpp -o test_mirror
+$COMPILE ../src/TFModbusTCPCommon.cpp ../src/TFModbusTCPRegisterBank.cpp ../src/TFModbusTCPHistory.cpp test_history.cpp -o test_history
+$COMPILE ../src/TFGenericTCPClient.cpp ../src/TFModbusTCPClient.cpp ../src/TFModbusTCPCommon.cpp ../src/TFGenericTCPClientPool.cpp ../src/TFModbusTCPClientPool.cpp ../src/TFModbusTCPServer.cpp ../src/TFModbusTCPRegisterBank.cpp ../src/TFModbusTCPMemoryRegisterBank.cpp ../src/TFModbusTCPTelemetryLog.cpp test_telemetry.cpp -o test_telemetry
+$COMPILE -DTF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT=256 -DTF_MODBUS_TCP_SERVER_MAX_CLIENT_COUNT=256 ../src/TFGenericTCPClient.cpp ../src/TFModbusTCPClient.cpp ../src/TFModbusTCPCommon.cpp ../src/TFGenericTCPClientPool.cpp ../src/TFModbusTCPClientPool.cpp ../src/TFModbusTCPServer.cpp ../src/TFModbusTCPRegisterBank.cpp ../src/TFModbusTCPMemoryRegisterBank.cpp ../src/TFNetworkOpenMetrics.cpp test_open_metrics.cpp -o test_open_metrics
+$COMPILE ../src/TFNetworkResolver.cpp ../src/TFGenericTCPClient.cpp ../src/TFModbusTCPClient.cpp ../src/TFModbusTCPCommon.cpp ../src/TFGenericTCPClientPool.cpp ../src/TFModbusTCPClientPool.cpp ../src/TFModbusTCPServer.cpp ../src/TFModbusTCPRegisterBank.cpp ../src/TFModbusTCPDiagnostics.cpp test_diagnostics.cpp -o test_diagnostics
+$COMPILE ../src/TFNetworkResolver.cpp ../src/TFGenericTCPClient.cpp ../src/TFModbusTCPClient.cpp ../src/TFModbusTCPCommon.cpp ../src/TFModbusTCPServer.cpp test_read_view.cpp -o test_read_view
+$COMPILE ../src/TFNetworkResolver.cpp ../src/TFGenericTCPClient.cpp ../src/TFModbusTCPClient.cpp ../src/TFModbusTCPCommon.cpp ../src/TFModbusTCPServer.cpp test_idle_probe.cpp -o test_idle_probe
+$COMPILE ../src/TFNetworkResolver.cpp ../src/TFGenericTCPClient.cpp ../src/TFFramedTCPClient.cpp ../src/TFGenericTCPClientPool.cpp ../src/TFRCTPowerClient.cpp ../src/TFRCTPowerClientPool.cpp test_rct_power_client.cpp -o test_rct_power_client
+$COMPILE ../src/TFNetworkResolver.cpp ../src/TFGenericTCPClient.cpp ../src/TFFramedTCPClient.cpp test_framed_client.cpp -o test_framed_client
@@ -0,0 +1,303 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+// Heap allocation accounting for client, pool and server operations over a
+// loopback connection. Steady-state operations are checked against budgets,
+// the exit code is non-zero if a budget is exceeded:
+//
+//   test_allocation [transaction-count]
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <Arduino.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFNetworkAllocationTracker.h"
+#include "../src/TFModbusTCPServer.h"
+#include "../src/TFModbusTCPClient.h"
+#include "../src/TFModbusTCPClientPool.h"
+#include "../src/TFModbusTCPMemoryRegisterBank.h"
+
+#define PORT 15503
+#define READ_COUNT 10
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+static TFModbusTCPServer *server;
+static TFModbusTCPClientPool *pool;
+static int failed_budget_count = 0;
+
+static void tick()
+{
+    server->tick();
+    pool->tick();
+}
+
+static void print_counters(const char *phase, size_t repetitions)
+{
+    printf("%s (%zu repetitions):\n", phase, repetitions);
+
+    for (size_t i = 0; i < static_cast<size_t>(TFNetworkAllocationOperation::Count); ++i) {
+        TFNetworkAllocationOperation operation = static_cast<TFNetworkAllocationOperation>(i);
+        TFNetworkAllocationCounters counters   = TFNetworkAllocationTracker::get_counters(operation);
+
+        if (counters.allocation_count == 0 && counters.free_count == 0) {
+            continue;
+        }
+
+        printf("  %-12s allocations=%-8zu frees=%-8zu allocated_bytes=%-10zu per_repetition=%.2f/%.1fB live_bytes=%lld peak_live_bytes=%lld\n",
+               get_tf_network_allocation_operation_name(operation), counters.allocation_count, counters.free_count, counters.allocated_bytes,
+               static_cast<double>(counters.allocation_count) / static_cast<double>(repetitions),
+               static_cast<double>(counters.allocated_bytes) / static_cast<double>(repetitions),
+               static_cast<long long>(counters.live_bytes),
+               static_cast<long long>(counters.peak_live_bytes));
+    }
+
+    printf("  live_bytes=%lld peak_live_bytes=%lld\n",
+           static_cast<long long>(TFNetworkAllocationTracker::get_live_bytes()),
+           static_cast<long long>(TFNetworkAllocationTracker::get_peak_live_bytes()));
+}
+
+static void check_budget(const char *name, double actual, double budget)
+{
+    bool ok = actual <= budget;
+
+    printf("budget %-40s %8.2f <= %8.2f %s\n", name, actual, budget, ok ? "ok" : "EXCEEDED");
+
+    if (!ok) {
+        ++failed_budget_count;
+    }
+}
+
+static double per_repetition(size_t count, size_t repetitions)
+{
+    return static_cast<double>(count) / static_cast<double>(repetitions);
+}
+
+int main(int argc, char **argv)
+{
+    size_t transaction_count = argc > 1 ? strtoul(argv[1], nullptr, 0) : 10000;
+
+    TFNetwork::resolve =
+    [](const char *host, TFNetworkResolveResultCallback &&callback) {
+        callback(inet_addr(host), 0);
+    };
+
+    TFNetwork::get_random_uint16 =
+    []() {
+        return static_cast<uint16_t>(rand());
+    };
+
+    TFModbusTCPMemoryRegisterBank bank(0, 0, 0, 100);
+
+    for (uint16_t i = 0; i < 100; ++i) {
+        bank.write(TFModbusTCPDataType::HoldingRegister, i, 1, &i);
+    }
+
+    server = new TFModbusTCPServer(TFModbusTCPByteOrder::Host);
+    pool   = new TFModbusTCPClientPool(TFModbusTCPByteOrder::Host);
+
+    // server start
+    TFNetworkAllocationTracker::reset();
+    TFNetworkAllocationTracker::enable();
+
+    if (!server->start(htonl(INADDR_LOOPBACK), PORT,
+    [](uint32_t peer_address, uint16_t port) {
+        (void)peer_address;
+        (void)port;
+    },
+    [](uint32_t peer_address, uint16_t port, TFModbusTCPServerDisconnectReason reason, int error_number) {
+        (void)peer_address;
+        (void)port;
+        (void)reason;
+        (void)error_number;
+    },
+    [&bank](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values) {
+        (void)unit_id;
+
+        return bank.handle_request(function_code, start_address, data_count, data_values);
+    })) {
+        fprintf(stderr, "could not start server\n");
+        return 1;
+    }
+
+    TFNetworkAllocationTracker::disable();
+    print_counters("server start", 1);
+
+    // first acquire, including connect and accept
+    TFModbusTCPSharedClient *client = nullptr;
+    bool acquire_done               = false;
+
+    TFNetworkAllocationTracker::reset();
+    TFNetworkAllocationTracker::enable();
+
+    pool->acquire("127.0.0.1", PORT,
+    [&client, &acquire_done](TFGenericTCPClientConnectResult result, int error_number, TFGenericTCPSharedClient *shared_client, TFGenericTCPClientPoolShareLevel level) {
+        (void)error_number;
+        (void)level;
+
+        acquire_done = true;
+
+        if (result == TFGenericTCPClientConnectResult::Connected) {
+            client = static_cast<TFModbusTCPSharedClient *>(shared_client);
+        }
+    },
+    [&client](TFGenericTCPClientDisconnectReason reason, int error_number, TFGenericTCPSharedClient *shared_client, TFGenericTCPClientPoolShareLevel level) {
+        (void)reason;
+        (void)error_number;
+        (void)shared_client;
+        (void)level;
+
+        client = nullptr;
+    });
+
+    while (!acquire_done) {
+        tick();
+    }
+
+    // let the server accept the connection
+    for (int i = 0; i < 100; ++i) {
+        tick();
+    }
+
+    TFNetworkAllocationTracker::disable();
+
+    if (client == nullptr) {
+        fprintf(stderr, "could not acquire client\n");
+        return 1;
+    }
+
+    print_counters("first acquire", 1);
+
+    // steady-state transactions
+    uint16_t values[READ_COUNT];
+    size_t success_count = 0;
+    bool transaction_done;
+
+    for (size_t i = 0; i < transaction_count + 100; ++i) {
+        if (i == 100) {
+            TFNetworkAllocationTracker::reset();
+            TFNetworkAllocationTracker::enable();
+        }
+
+        transaction_done = false;
+
+        client->transact(1, TFModbusTCPFunctionCode::ReadHoldingRegisters, 10, READ_COUNT, values, 1_s,
+        [&transaction_done, &success_count](TFModbusTCPClientTransactionResult result, const char *error_message) {
+            (void)error_message;
+
+            transaction_done = true;
+
+            if (result == TFModbusTCPClientTransactionResult::Success) {
+                ++success_count;
+            }
+        });
+
+        while (!transaction_done) {
+            tick();
+        }
+    }
+
+    TFNetworkAllocationTracker::disable();
+    print_counters("steady-state transactions", transaction_count);
+
+    TFNetworkAllocationCounters transact    = TFNetworkAllocationTracker::get_counters(TFNetworkAllocationOperation::Transact);
+    TFNetworkAllocationCounters server_tick = TFNetworkAllocationTracker::get_counters(TFNetworkAllocationOperation::ServerTick);
+    TFNetworkAllocationCounters total       = TFNetworkAllocationTracker::get_total_counters();
+
+    check_budget("allocations per transaction", per_repetition(total.allocation_count, transaction_count), 1);
+    check_budget("transact allocations per transaction", per_repetition(transact.allocation_count, transaction_count), 1);
+    check_budget("server allocations per request", per_repetition(server_tick.allocation_count, transaction_count), 0);
+    check_budget("leaked allocations per transaction", per_repetition(total.allocation_count - total.free_count, transaction_count), 0);
+    check_budget("live bytes after all transactions", static_cast<double>(total.live_bytes), 0);
+    check_budget("transact peak live bytes", static_cast<double>(transact.peak_live_bytes), 256);
+
+    // steady-state polls without pending work
+    size_t poll_count = transaction_count * 10;
+
+    TFNetworkAllocationTracker::reset();
+    TFNetworkAllocationTracker::enable();
+
+    for (size_t i = 0; i < poll_count; ++i) {
+        tick();
+    }
+
+    TFNetworkAllocationTracker::disable();
+    print_counters("steady-state polls", poll_count);
+
+    total = TFNetworkAllocationTracker::get_total_counters();
+
+    check_budget("allocations per steady-state poll", per_repetition(total.allocation_count, poll_count), 0);
+
+    // release and re-acquire of an idle connection
+    TFNetworkAllocationTracker::reset();
+    TFNetworkAllocationTracker::enable();
+
+    pool->release(client);
+
+    client       = nullptr;
+    acquire_done = false;
+
+    pool->acquire("127.0.0.1", PORT,
+    [&client, &acquire_done](TFGenericTCPClientConnectResult result, int error_number, TFGenericTCPSharedClient *shared_client, TFGenericTCPClientPoolShareLevel level) {
+        (void)error_number;
+        (void)level;
+
+        acquire_done = true;
+
+        if (result == TFGenericTCPClientConnectResult::Connected) {
+            client = static_cast<TFModbusTCPSharedClient *>(shared_client);
+        }
+    },
+    [&client](TFGenericTCPClientDisconnectReason reason, int error_number, TFGenericTCPSharedClient *shared_client, TFGenericTCPClientPoolShareLevel level) {
+        (void)reason;
+        (void)error_number;
+        (void)shared_client;
+        (void)level;
+
+        client = nullptr;
+    });
+
+    while (!acquire_done) {
+        tick();
+    }
+
+    TFNetworkAllocationTracker::disable();
+    print_counters("release and re-acquire", 1);
+
+    printf("transactions: %zu of %zu succeeded\n", success_count, transaction_count + 100);
+    printf("%d budget(s) exceeded\n", failed_budget_count);
+
+    return failed_budget_count > 0 ? 1 : 0;
+}
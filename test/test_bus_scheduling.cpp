@@ -0,0 +1,258 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+// Bus scheduling: units take turns, the order per unit is kept and neither a
+// unit nor a bus exceeds its pending transaction limit. The client and the
+// server are ticked in alternating phases, so that all requests the server
+// handles during one phase were pending at the same time
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <Arduino.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFModbusTCPServer.h"
+#include "../src/TFModbusTCPClient.h"
+
+#define PORT 15520
+#define TRANSACTION_COUNT 11
+#define SLOW_UNIT_ID 2
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    TFNetwork::logfln("%s: %s", condition ? "PASS" : "FAIL", description);
+
+    if (!condition) {
+        ++failures;
+    }
+}
+
+struct Request
+{
+    size_t phase;
+    uint8_t unit_id;
+    uint16_t start_address;
+};
+
+static TFModbusTCPServer server(TFModbusTCPByteOrder::Host);
+static TFModbusTCPClient *client;
+static Request requests[TRANSACTION_COUNT];
+static size_t request_count = 0;
+static size_t phase = 0;
+
+static void tick_phase()
+{
+    for (size_t i = 0; i < 10; ++i) {
+        client->tick();
+    }
+
+    ++phase;
+
+    for (size_t i = 0; i < 10; ++i) {
+        server.tick();
+    }
+}
+
+int main()
+{
+    TFNetwork::vlogfln =
+    [](const char *format, va_list args) {
+        printf("%li | ", static_cast<int64_t>(now_us()));
+        vprintf(format, args);
+        puts("");
+    };
+
+    TFNetwork::resolve =
+    [](const char *host, TFNetworkResolveResultCallback &&callback) {
+        callback(inet_addr(host), 0);
+    };
+
+    TFNetwork::get_random_uint16 =
+    []() {
+        return static_cast<uint16_t>(rand());
+    };
+
+    check(server.start(htonl(INADDR_LOOPBACK), PORT,
+    [](uint32_t peer_address, uint16_t port) {
+        (void)peer_address;
+        (void)port;
+    },
+    [](uint32_t peer_address, uint16_t port, TFModbusTCPServerDisconnectReason reason, int error_number) {
+        (void)peer_address;
+        (void)port;
+        (void)reason;
+        (void)error_number;
+    },
+    [](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values) {
+        if (function_code != TFModbusTCPFunctionCode::ReadHoldingRegisters) {
+            return TFModbusTCPExceptionCode::IllegalFunction;
+        }
+
+        if (request_count < TRANSACTION_COUNT) {
+            requests[request_count++] = Request{phase, unit_id, start_address};
+        }
+
+        if (unit_id == SLOW_UNIT_ID) {
+            usleep(20000);
+        }
+
+        memset(data_values, 0, data_count * 2);
+
+        return TFModbusTCPExceptionCode::Success;
+    }), "start server");
+
+    client = new TFModbusTCPClient(TFModbusTCPByteOrder::Host);
+
+    TFModbusTCPDeviceProfile profile;
+
+    profile.max_pending_transaction_count = 4;
+
+    client->set_device_profile(&profile);
+    client->set_bus_scheduling_enabled(true);
+    client->set_unit_max_pending_transaction_count(2);
+    client->set_bus_max_pending_transaction_count(0, 3);
+    client->set_unit_bus(3, 1);
+    client->set_bus_max_pending_transaction_count(1, 1);
+
+    bool connected = false;
+
+    client->connect("127.0.0.1", PORT,
+    [&connected](TFGenericTCPClientConnectResult result, int error_number) {
+        (void)error_number;
+
+        connected = result == TFGenericTCPClientConnectResult::Connected;
+    },
+    [&connected](TFGenericTCPClientDisconnectReason reason, int error_number) {
+        (void)reason;
+        (void)error_number;
+
+        connected = false;
+    });
+
+    micros_t deadline = calculate_deadline(3_s);
+
+    while (!connected && !deadline_elapsed(deadline)) {
+        tick_phase();
+    }
+
+    check(connected, "client connected");
+
+    // unit 1 has six transactions at the head of the schedule, units 2 and 3
+    // must not wait for all of them
+    uint8_t unit_ids[TRANSACTION_COUNT] = {1, 1, 1, 1, 1, 1, 2, 2, 3, 3, 3};
+    static uint16_t values[TRANSACTION_COUNT][2];
+    size_t done_count  = 0;
+    bool all_succeeded = true;
+
+    for (size_t i = 0; i < TRANSACTION_COUNT; ++i) {
+        client->transact(unit_ids[i], TFModbusTCPFunctionCode::ReadHoldingRegisters, i, 2, values[i], 1_s,
+        [&done_count, &all_succeeded](TFModbusTCPClientTransactionResult result, const char *error_message) {
+            (void)error_message;
+
+            if (result != TFModbusTCPClientTransactionResult::Success) {
+                all_succeeded = false;
+            }
+
+            ++done_count;
+        });
+    }
+
+    size_t first_phase = phase + 1;
+
+    deadline = calculate_deadline(3_s);
+
+    while (done_count < TRANSACTION_COUNT && !deadline_elapsed(deadline)) {
+        tick_phase();
+    }
+
+    check(done_count == TRANSACTION_COUNT && all_succeeded, "all transactions succeeded");
+    check(request_count == TRANSACTION_COUNT, "server handled all requests");
+
+    bool within_limits = true;
+    bool in_unit_order = true;
+    int32_t last_start_address[4] = {-1, -1, -1, -1};
+
+    for (size_t i = 0; i < request_count; ++i) {
+        size_t unit_counts[4] = {0, 0, 0, 0};
+        size_t phase_count    = 0;
+
+        for (size_t k = 0; k < request_count; ++k) {
+            if (requests[k].phase == requests[i].phase) {
+                ++unit_counts[requests[k].unit_id];
+                ++phase_count;
+            }
+        }
+
+        within_limits = within_limits && phase_count <= 4 && unit_counts[1] <= 2 && unit_counts[2] <= 2
+                     && unit_counts[1] + unit_counts[2] <= 3 && unit_counts[3] <= 1;
+
+        in_unit_order = in_unit_order && requests[i].start_address > last_start_address[requests[i].unit_id];
+        last_start_address[requests[i].unit_id] = requests[i].start_address;
+    }
+
+    check(within_limits, "no unit, bus or connection exceeds its pending transaction limit");
+    check(in_unit_order, "order per unit is kept");
+
+    size_t first_phase_count = 0;
+    bool first_phase_units[4] = {false, false, false, false};
+
+    for (size_t i = 0; i < request_count; ++i) {
+        if (requests[i].phase == first_phase) {
+            first_phase_units[requests[i].unit_id] = true;
+            ++first_phase_count;
+        }
+    }
+
+    check(first_phase_count == 4 && first_phase_units[1] && first_phase_units[2] && first_phase_units[3],
+          "all units are served in the first phase");
+
+    check(client->get_unit_response_latency(1) > 0_s, "latency of unit 1 is tracked");
+    check(client->get_unit_response_latency(SLOW_UNIT_ID) >= 20_ms, "latency of the slow unit is tracked");
+    check(client->get_unit_response_latency(9) == 0_s, "latency of an unused unit is unknown");
+
+    client->disconnect();
+    server.stop();
+
+    delete client;
+
+    TFNetwork::logfln("%d failure(s)", failures);
+
+    return failures > 0 ? 1 : 0;
+}
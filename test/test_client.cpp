@@ -21,7 +21,6 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <time.h>
-#include <netdb.h>
 #include <unistd.h>
 #include <signal.h>
 #include <sys/random.h>
@@ -29,6 +28,7 @@
 #include "../src/TFNetwork.h"
 #include "../src/TFModbusTCPClient.h"
 #include "../src/TFModbusTCPClientPool.h"
+#include "../src/TFNetworkResolver.h"
 
 micros_t now_us()
 {
@@ -81,16 +81,19 @@ int main()
     uint16_t write_register_buffer;
     uint8_t read_coil_buffer[2] = {0, 0};
     uint8_t write_coil_buffer;
-    char *resolve_host = nullptr;
-    std::function<void(uint32_t host_address, int error_number)> resolve_callback;
+    TFNetworkResolver resolver;
     TFModbusTCPClient client(TFModbusTCPByteOrder::Host);
     micros_t next_read_time = -1_s;
     micros_t next_reconnect;
 
+    if (!resolver.start()) {
+        TFNetwork::logfln("could not start resolver");
+        return 1;
+    }
+
     TFNetwork::resolve =
-    [&resolve_host, &resolve_callback](const char *host, std::function<void(uint32_t host_address, int error_number)> &&callback) {
-        resolve_host = strdup(host);
-        resolve_callback = std::move(callback);
+    [&resolver](const char *host, std::function<void(uint32_t host_address, int error_number)> &&callback) {
+        resolver.resolve(host, std::move(callback));
     };
 
     TFNetwork::logfln(" connect...");
@@ -120,21 +123,7 @@ int main()
     next_reconnect = calculate_deadline(5_s);
 
     while (running) {
-        if (resolve_host != nullptr && resolve_callback) {
-            hostent *result = gethostbyname(resolve_host);
-
-            free(resolve_host);
-            resolve_host = nullptr;
-
-            if (result == nullptr) {
-                resolve_callback(0, h_errno);
-                resolve_callback = nullptr;
-                continue;
-            }
-
-            resolve_callback(((struct in_addr *)result->h_addr)->s_addr, 0);
-            resolve_callback = nullptr;
-        }
+        resolver.tick();
 
         if (next_read_time >= 0_s && deadline_elapsed(next_read_time)) {
             next_read_time = -1_s;
@@ -0,0 +1,260 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+// Device prober and device profile: the prober finds the read limit and the
+// pipeline depth of a server, the profile survives a serialize round trip and
+// damaged or foreign blobs are rejected
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <Arduino.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFModbusTCPServer.h"
+#include "../src/TFModbusTCPClient.h"
+#include "../src/TFModbusTCPDeviceProber.h"
+#include "../src/TFModbusTCPDeviceProfile.h"
+
+#define PORT 15519
+#define MAX_READ_REGISTER_COUNT 50
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    TFNetwork::logfln("%s: %s", condition ? "PASS" : "FAIL", description);
+
+    if (!condition) {
+        ++failures;
+    }
+}
+
+static TFModbusTCPServer server(TFModbusTCPByteOrder::Host);
+static TFModbusTCPClient *client;
+
+static bool tick_until(bool *condition)
+{
+    micros_t deadline = calculate_deadline(10_s);
+
+    while (!*condition) {
+        if (deadline_elapsed(deadline)) {
+            return false;
+        }
+
+        server.tick();
+        client->tick();
+    }
+
+    return true;
+}
+
+// same CRC-8 as used by the profile, to build blobs with a valid checksum
+static uint8_t crc8(const uint8_t *buffer, size_t length)
+{
+    uint8_t checksum = 0;
+
+    for (size_t i = 0; i < length; ++i) {
+        checksum ^= buffer[i];
+
+        for (size_t k = 0; k < 8; ++k) {
+            checksum = (checksum & 0x80) != 0 ? static_cast<uint8_t>((checksum << 1) ^ 0x07) : static_cast<uint8_t>(checksum << 1);
+        }
+    }
+
+    return checksum;
+}
+
+static void check_profile_serialization()
+{
+    TFModbusTCPDeviceProfile profile;
+    uint8_t blob[TF_MODBUS_TCP_DEVICE_PROFILE_SERIALIZED_LENGTH];
+
+    profile.max_read_register_count       = 50;
+    profile.max_write_register_count      = 20;
+    profile.max_pending_transaction_count = 4;
+    profile.transaction_id_mask           = 0x00FF;
+    profile.typical_response_latency      = 12345_us;
+
+    check(profile.serialize(blob, sizeof(blob) - 1) == 0, "serialize into a short buffer fails");
+    check(profile.serialize(blob, sizeof(blob)) == 11, "serialized profile is 11 bytes long");
+
+    TFModbusTCPDeviceProfile loaded;
+
+    check(loaded.deserialize(blob, sizeof(blob)), "deserialize round trip");
+    check(loaded.max_read_register_count == 50
+       && loaded.max_write_register_count == 20
+       && loaded.max_pending_transaction_count == 4
+       && loaded.transaction_id_mask == 0x00FF
+       && loaded.typical_response_latency == 12345_us, "round trip keeps all fields");
+
+    check(!loaded.deserialize(blob, sizeof(blob) - 1), "short blob is rejected");
+
+    uint8_t damaged[TF_MODBUS_TCP_DEVICE_PROFILE_SERIALIZED_LENGTH];
+
+    memcpy(damaged, blob, sizeof(blob));
+    damaged[3] ^= 0x01;
+
+    check(!loaded.deserialize(damaged, sizeof(damaged)), "blob with a CRC mismatch is rejected");
+
+    memcpy(damaged, blob, sizeof(blob));
+    damaged[0] += 1;
+    damaged[10] = crc8(damaged, 10);
+
+    check(!loaded.deserialize(damaged, sizeof(damaged)), "blob with an unknown version is rejected");
+
+    memcpy(damaged, blob, sizeof(blob));
+    damaged[1]  = TF_MODBUS_TCP_MAX_READ_REGISTER_COUNT + 1;
+    damaged[10] = crc8(damaged, 10);
+
+    check(!loaded.deserialize(damaged, sizeof(damaged)), "blob with an out-of-range read count is rejected");
+
+    check(loaded.max_read_register_count == 50 && loaded.transaction_id_mask == 0x00FF, "rejected blobs leave the profile unchanged");
+}
+
+int main()
+{
+    TFNetwork::vlogfln =
+    [](const char *format, va_list args) {
+        printf("%li | ", static_cast<int64_t>(now_us()));
+        vprintf(format, args);
+        puts("");
+    };
+
+    TFNetwork::resolve =
+    [](const char *host, TFNetworkResolveResultCallback &&callback) {
+        callback(inet_addr(host), 0);
+    };
+
+    TFNetwork::get_random_uint16 =
+    []() {
+        return static_cast<uint16_t>(rand());
+    };
+
+    check_profile_serialization();
+
+    check(server.start(htonl(INADDR_LOOPBACK), PORT,
+    [](uint32_t peer_address, uint16_t port) {
+        (void)peer_address;
+        (void)port;
+    },
+    [](uint32_t peer_address, uint16_t port, TFModbusTCPServerDisconnectReason reason, int error_number) {
+        (void)peer_address;
+        (void)port;
+        (void)reason;
+        (void)error_number;
+    },
+    [](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values) {
+        (void)unit_id;
+
+        if (function_code != TFModbusTCPFunctionCode::ReadHoldingRegisters) {
+            return TFModbusTCPExceptionCode::IllegalFunction;
+        }
+
+        if (data_count > MAX_READ_REGISTER_COUNT) {
+            return TFModbusTCPExceptionCode::IllegalDataValue;
+        }
+
+        for (uint16_t i = 0; i < data_count; ++i) {
+            uint16_t value = start_address + i;
+
+            memcpy(static_cast<uint8_t *>(data_values) + i * 2, &value, 2); // register values are packed
+        }
+
+        return TFModbusTCPExceptionCode::Success;
+    }), "start server");
+
+    client = new TFModbusTCPClient(TFModbusTCPByteOrder::Host);
+
+    bool connected = false;
+
+    client->connect("127.0.0.1", PORT,
+    [&connected](TFGenericTCPClientConnectResult result, int error_number) {
+        (void)error_number;
+
+        connected = result == TFGenericTCPClientConnectResult::Connected;
+    },
+    [&connected](TFGenericTCPClientDisconnectReason reason, int error_number) {
+        (void)reason;
+        (void)error_number;
+
+        connected = false;
+    });
+
+    check(tick_until(&connected), "client connected");
+
+    TFModbusTCPDeviceProber prober;
+    TFModbusTCPDeviceProfile probed;
+    TFModbusTCPClientTransactionResult probe_result = TFModbusTCPClientTransactionResult::Timeout;
+    bool done = false;
+
+    prober.probe(client, 1, TFModbusTCPFunctionCode::ReadHoldingRegisters, 1000, 500_ms,
+    [&probed, &probe_result, &done](TFModbusTCPClientTransactionResult result, const TFModbusTCPDeviceProfile *profile) {
+        if (profile != nullptr) {
+            probed = *profile;
+        }
+
+        probe_result = result;
+        done         = true;
+    });
+
+    check(prober.is_probing(), "prober is probing");
+    check(tick_until(&done) && probe_result == TFModbusTCPClientTransactionResult::Success, "probe succeeds");
+    check(!prober.is_probing(), "prober is idle again");
+    check(probed.transaction_id_mask == UINT16_MAX, "full transaction ID mask is probed");
+    check(probed.max_read_register_count == MAX_READ_REGISTER_COUNT, "read register limit is probed");
+    check(probed.max_pending_transaction_count == 4, "pipeline depth is probed");
+    check(probed.typical_response_latency > 0_s, "response latency is probed");
+    check(client->get_device_profile()->max_read_register_count == MAX_READ_REGISTER_COUNT
+       && client->get_device_profile()->max_pending_transaction_count == 4, "probed profile is applied to the client");
+
+    uint8_t blob[TF_MODBUS_TCP_DEVICE_PROFILE_SERIALIZED_LENGTH];
+    TFModbusTCPDeviceProfile loaded;
+
+    check(probed.serialize(blob, sizeof(blob)) == sizeof(blob) && loaded.deserialize(blob, sizeof(blob))
+       && loaded.max_read_register_count == probed.max_read_register_count
+       && loaded.max_pending_transaction_count == probed.max_pending_transaction_count
+       && loaded.typical_response_latency == probed.typical_response_latency, "probed profile survives a round trip");
+
+    client->disconnect();
+    server.stop();
+
+    delete client;
+
+    TFNetwork::logfln("%d failure(s)", failures);
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,261 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+// Diagnostics register layout, served by a server that uses network byte
+// order for its request callback
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <Arduino.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFModbusTCPServer.h"
+#include "../src/TFModbusTCPClient.h"
+#include "../src/TFModbusTCPClientPool.h"
+#include "../src/TFModbusTCPDiagnostics.h"
+
+#define PORT 15514
+#define DIAGNOSTICS_UNIT_ID 247
+
+#define DEVICE_ADDRESS(index, offset) (TF_MODBUS_TCP_DIAGNOSTICS_SERVER_REGISTER_COUNT + (index) * TF_MODBUS_TCP_DIAGNOSTICS_DEVICE_REGISTER_COUNT + (offset))
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    TFNetwork::logfln("%s: %s", condition ? "PASS" : "FAIL", description);
+
+    if (!condition) {
+        ++failures;
+    }
+}
+
+static TFModbusTCPServer *server;
+static TFModbusTCPClient *client;
+static TFModbusTCPClientPool *pool;
+
+static void tick()
+{
+    server->tick();
+    client->tick();
+    pool->tick();
+}
+
+static TFModbusTCPClientTransactionResult transact(uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, uint16_t *values)
+{
+    bool done                                 = false;
+    TFModbusTCPClientTransactionResult result = TFModbusTCPClientTransactionResult::Timeout;
+
+    client->transact(unit_id, function_code, start_address, data_count, values, 1_s,
+    [&done, &result](TFModbusTCPClientTransactionResult transaction_result, const char *error_message) {
+        (void)error_message;
+
+        done   = true;
+        result = transaction_result;
+    });
+
+    while (!done) {
+        tick();
+    }
+
+    return result;
+}
+
+static TFModbusTCPClientTransactionResult read_diagnostics(uint16_t start_address, uint16_t data_count, uint16_t *values)
+{
+    return transact(DIAGNOSTICS_UNIT_ID, TFModbusTCPFunctionCode::ReadInputRegisters, start_address, data_count, values);
+}
+
+int main()
+{
+    TFNetwork::vlogfln =
+    [](const char *format, va_list args) {
+        printf("%li | ", static_cast<int64_t>(now_us()));
+        vprintf(format, args);
+        puts("");
+    };
+
+    TFNetwork::resolve =
+    [](const char *host, TFNetworkResolveResultCallback &&callback) {
+        callback(inet_addr(host), 0);
+    };
+
+    TFNetwork::get_random_uint16 =
+    []() {
+        return static_cast<uint16_t>(rand());
+    };
+
+    server = new TFModbusTCPServer(TFModbusTCPByteOrder::Network);
+    client = new TFModbusTCPClient(TFModbusTCPByteOrder::Host);
+    pool   = new TFModbusTCPClientPool(TFModbusTCPByteOrder::Host);
+
+    TFModbusTCPDiagnostics diagnostics(server);
+
+    check(diagnostics.add_client(client) && diagnostics.add_pool(pool), "add sources");
+
+    server->set_diagnostics_unit(DIAGNOSTICS_UNIT_ID, &diagnostics);
+
+    check(server->start(htonl(INADDR_LOOPBACK), PORT,
+    [](uint32_t peer_address, uint16_t port) {
+        (void)peer_address;
+        (void)port;
+    },
+    [](uint32_t peer_address, uint16_t port, TFModbusTCPServerDisconnectReason reason, int error_number) {
+        (void)peer_address;
+        (void)port;
+        (void)reason;
+        (void)error_number;
+    },
+    [](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values) {
+        (void)unit_id;
+        (void)function_code;
+        (void)start_address;
+        (void)data_count;
+        (void)data_values;
+
+        return TFModbusTCPExceptionCode::IllegalFunction;
+    }), "start server");
+
+    bool connected = false;
+
+    client->connect("127.0.0.1", PORT,
+    [&connected](TFGenericTCPClientConnectResult result, int error_number) {
+        (void)error_number;
+
+        connected = result == TFGenericTCPClientConnectResult::Connected;
+    },
+    [](TFGenericTCPClientDisconnectReason reason, int error_number) {
+        (void)reason;
+        (void)error_number;
+    });
+
+    // one pool slot is used, all others stay empty
+    TFGenericTCPSharedClient *shared_client = nullptr;
+
+    pool->acquire("127.0.0.1", PORT,
+    [&shared_client](TFGenericTCPClientConnectResult result, int error_number, TFGenericTCPSharedClient *client, TFGenericTCPClientPoolShareLevel share_level) {
+        (void)result;
+        (void)error_number;
+        (void)share_level;
+
+        shared_client = client;
+    },
+    [](TFGenericTCPClientDisconnectReason reason, int error_number, TFGenericTCPSharedClient *client, TFGenericTCPClientPoolShareLevel share_level) {
+        (void)reason;
+        (void)error_number;
+        (void)client;
+        (void)share_level;
+    });
+
+    while (!connected || shared_client == nullptr || server->get_client_count() < 2) {
+        tick();
+    }
+
+    uint32_t register_count = diagnostics.get_register_count();
+    size_t device_count     = 1 + TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT;
+    uint16_t values[TF_MODBUS_TCP_MAX_READ_REGISTER_COUNT];
+
+    check(diagnostics.get_device_count() == device_count
+       && register_count == TF_MODBUS_TCP_DIAGNOSTICS_SERVER_REGISTER_COUNT + device_count * TF_MODBUS_TCP_DIAGNOSTICS_DEVICE_REGISTER_COUNT,
+          "register count covers all pool slots");
+
+    // the server converts the host byte order of the bank to network byte
+    // order, the client converts it back
+    check(read_diagnostics(0, 3, values) == TFModbusTCPClientTransactionResult::Success
+       && values[0] == TF_MODBUS_TCP_DIAGNOSTICS_LAYOUT_VERSION && values[1] == device_count && values[2] == 2,
+          "server block is in the byte order of the server");
+
+    // address bounds
+    check(read_diagnostics(static_cast<uint16_t>(register_count - 1), 1, values) == TFModbusTCPClientTransactionResult::Success, "last register is readable");
+    check(read_diagnostics(static_cast<uint16_t>(register_count - 1), 2, values) == TFModbusTCPClientTransactionResult::ModbusIllegalDataAddress,
+          "read beyond the last register is an illegal data address");
+    check(read_diagnostics(static_cast<uint16_t>(register_count), 1, values) == TFModbusTCPClientTransactionResult::ModbusIllegalDataAddress,
+          "read after the last register is an illegal data address");
+    check(transact(DIAGNOSTICS_UNIT_ID, TFModbusTCPFunctionCode::ReadHoldingRegisters, 0, 1, values) == TFModbusTCPClientTransactionResult::ModbusIllegalFunction,
+          "holding register read is an illegal function");
+    check(diagnostics.read(TFModbusTCPDataType::Coil, 0, 1, values) == TFModbusTCPExceptionCode::IllegalDataAddress
+       && diagnostics.write(TFModbusTCPDataType::InputRegister, 0, 1, values) == TFModbusTCPExceptionCode::IllegalFunction,
+          "diagnostics bank is read-only input registers");
+
+    // the client has finished a known number of successful transactions
+    // before each read, the read itself is still pending
+    size_t success_count = client->get_statistics()->success_count;
+
+    // crossing from the server block into the client block, and from the
+    // client block into the first pool slot
+    check(read_diagnostics(DEVICE_ADDRESS(0, 0) - 4, TF_MODBUS_TCP_DIAGNOSTICS_DEVICE_REGISTER_COUNT + 8, values) == TFModbusTCPClientTransactionResult::Success
+       && values[4] == 3 && values[5] == PORT && values[6] == 1 && values[7] == 0
+       && values[8] == static_cast<uint16_t>(success_count >> 16) && values[9] == static_cast<uint16_t>(success_count)
+       && values[4 + TF_MODBUS_TCP_DIAGNOSTICS_DEVICE_REGISTER_COUNT] == 3 && values[5 + TF_MODBUS_TCP_DIAGNOSTICS_DEVICE_REGISTER_COUNT] == PORT,
+          "read across block boundaries");
+
+    success_count = client->get_statistics()->success_count;
+
+    check(read_diagnostics(DEVICE_ADDRESS(0, 4), 2, values) == TFModbusTCPClientTransactionResult::Success
+       && values[0] == static_cast<uint16_t>(success_count >> 16) && values[1] == static_cast<uint16_t>(success_count),
+          "32 bit counter is high word first");
+
+    // pool slots without a client read as 0
+    bool empty_slots = true;
+
+    for (size_t i = 2; i < device_count; ++i) {
+        empty_slots &= read_diagnostics(DEVICE_ADDRESS(i, 0), TF_MODBUS_TCP_DIAGNOSTICS_DEVICE_REGISTER_COUNT, values) == TFModbusTCPClientTransactionResult::Success;
+
+        for (size_t k = 0; k < TF_MODBUS_TCP_DIAGNOSTICS_DEVICE_REGISTER_COUNT; ++k) {
+            empty_slots &= values[k] == 0;
+        }
+    }
+
+    check(empty_slots, "pool slots without a client read as 0");
+
+    pool->release(shared_client);
+    client->disconnect();
+
+    while (pool->get_slot_count() > 0) {
+        tick();
+    }
+
+    server->stop();
+
+    delete pool;
+    delete client;
+    delete server;
+
+    TFNetwork::logfln("%d failure(s)", failures);
+
+    return failures > 0 ? 1 : 0;
+}
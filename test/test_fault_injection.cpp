@@ -0,0 +1,290 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+// Benchmark of client pipelining, pool reconnects and server parsing over a
+// loopback connection with injected faults:
+//
+//   test_fault_injection [clean|wifi|harsh] [seed] [seconds]
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <Arduino.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFNetworkFaultInjector.h"
+#include "../src/TFModbusTCPServer.h"
+#include "../src/TFModbusTCPClient.h"
+#include "../src/TFModbusTCPClientPool.h"
+#include "../src/TFModbusTCPMemoryRegisterBank.h"
+
+#define PORT 15502
+#define PIPELINE_DEPTH 4
+#define READ_COUNT 10
+#define MAX_LATENCY_COUNT 1000000
+#define RESULT_COUNT 300
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+struct Slot
+{
+    bool busy;
+    micros_t start;
+    uint16_t values[READ_COUNT];
+};
+
+static int64_t percentile(const uint32_t *sorted, size_t count, double fraction)
+{
+    if (count == 0) {
+        return 0;
+    }
+
+    size_t index = static_cast<size_t>(fraction * static_cast<double>(count - 1) + 0.5);
+
+    return sorted[index];
+}
+
+int main(int argc, char **argv)
+{
+    const char *profile_name = argc > 1 ? argv[1] : "wifi";
+    uint64_t seed            = argc > 2 ? strtoull(argv[2], nullptr, 0) : 1;
+    int seconds              = argc > 3 ? atoi(argv[3]) : 10;
+    TFNetworkFaultProfile profile;
+
+    if (strcmp(profile_name, "clean") == 0) {
+        profile = TFNetworkFaultInjector::get_clean_profile();
+    }
+    else if (strcmp(profile_name, "wifi") == 0) {
+        profile = TFNetworkFaultInjector::get_wifi_profile();
+    }
+    else if (strcmp(profile_name, "harsh") == 0) {
+        profile = TFNetworkFaultInjector::get_harsh_profile();
+    }
+    else {
+        fprintf(stderr, "usage: %s [clean|wifi|harsh] [seed] [seconds]\n", argv[0]);
+        return 1;
+    }
+
+    TFNetwork::resolve =
+    [](const char *host, TFNetworkResolveResultCallback &&callback) {
+        callback(inet_addr(host), 0);
+    };
+
+    TFNetwork::get_random_uint16 =
+    []() {
+        return static_cast<uint16_t>(rand());
+    };
+
+    srand(static_cast<unsigned int>(seed));
+
+    TFModbusTCPMemoryRegisterBank bank(0, 0, 0, 100);
+
+    for (uint16_t i = 0; i < 100; ++i) {
+        bank.write(TFModbusTCPDataType::HoldingRegister, i, 1, &i);
+    }
+
+    TFModbusTCPServer server(TFModbusTCPByteOrder::Host);
+    size_t server_disconnects = 0;
+
+    if (!server.start(htonl(INADDR_LOOPBACK), PORT,
+    [](uint32_t peer_address, uint16_t port) {
+        (void)peer_address;
+        (void)port;
+    },
+    [&server_disconnects](uint32_t peer_address, uint16_t port, TFModbusTCPServerDisconnectReason reason, int error_number) {
+        (void)peer_address;
+        (void)port;
+        (void)reason;
+        (void)error_number;
+
+        ++server_disconnects;
+    },
+    [&bank](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values) {
+        (void)unit_id;
+
+        return bank.handle_request(function_code, start_address, data_count, data_values);
+    })) {
+        fprintf(stderr, "could not start server\n");
+        return 1;
+    }
+
+    TFModbusTCPClientPool pool(TFModbusTCPByteOrder::Host);
+    TFModbusTCPDeviceProfile device_profile;
+
+    device_profile.max_pending_transaction_count = PIPELINE_DEPTH;
+
+    pool.set_device_profile("127.0.0.1", PORT, &device_profile);
+
+    TFNetworkFaultInjector injector(seed, profile);
+
+    injector.install();
+
+    Slot slots[PIPELINE_DEPTH] = {};
+    uint32_t *latencies                = new uint32_t[MAX_LATENCY_COUNT];
+    size_t latency_count               = 0;
+    size_t result_counts[RESULT_COUNT] = {};
+    size_t value_mismatches            = 0;
+    size_t connect_failures            = 0;
+    size_t disconnects                 = 0;
+    size_t reconnects                  = 0;
+    int64_t reconnect_total_us         = 0;
+    int64_t reconnect_max_us           = 0;
+    TFModbusTCPSharedClient *client    = nullptr;
+    bool acquiring                     = false;
+    micros_t disconnected_since        = -1_s;
+
+    micros_t start    = now_us();
+    micros_t deadline = calculate_deadline(micros_t{static_cast<int64_t>(seconds) * 1000000});
+
+    while (!deadline_elapsed(deadline)) {
+        server.tick();
+        pool.tick();
+
+        if (client == nullptr && !acquiring) {
+            acquiring = true;
+
+            pool.acquire("127.0.0.1", PORT,
+            [&](TFGenericTCPClientConnectResult result, int error_number, TFGenericTCPSharedClient *shared_client, TFGenericTCPClientPoolShareLevel level) {
+                (void)error_number;
+                (void)level;
+
+                acquiring = false;
+
+                if (result != TFGenericTCPClientConnectResult::Connected) {
+                    ++connect_failures;
+                    return;
+                }
+
+                client = static_cast<TFModbusTCPSharedClient *>(shared_client);
+
+                if (disconnected_since >= 0_s) {
+                    int64_t reconnect_us = static_cast<int64_t>(now_us() - disconnected_since);
+
+                    ++reconnects;
+                    reconnect_total_us += reconnect_us;
+                    reconnect_max_us    = std::max(reconnect_max_us, reconnect_us);
+                    disconnected_since  = -1_s;
+                }
+            },
+            [&](TFGenericTCPClientDisconnectReason reason, int error_number, TFGenericTCPSharedClient *shared_client, TFGenericTCPClientPoolShareLevel level) {
+                (void)reason;
+                (void)error_number;
+                (void)shared_client;
+                (void)level;
+
+                ++disconnects;
+                client             = nullptr;
+                disconnected_since = now_us();
+            });
+        }
+
+        for (size_t i = 0; client != nullptr && i < PIPELINE_DEPTH; ++i) {
+            Slot *slot = &slots[i];
+
+            if (slot->busy) {
+                continue;
+            }
+
+            slot->busy  = true;
+            slot->start = now_us();
+
+            client->transact(1, TFModbusTCPFunctionCode::ReadHoldingRegisters, 10, READ_COUNT, slot->values, 1_s,
+            [&, slot](TFModbusTCPClientTransactionResult result, const char *error_message) {
+                (void)error_message;
+
+                slot->busy = false;
+
+                ++result_counts[std::min(static_cast<size_t>(result), static_cast<size_t>(RESULT_COUNT - 1))];
+
+                if (result != TFModbusTCPClientTransactionResult::Success) {
+                    return;
+                }
+
+                for (uint16_t k = 0; k < READ_COUNT; ++k) {
+                    if (slot->values[k] != 10 + k) {
+                        ++value_mismatches; // corruption that no check caught
+                        break;
+                    }
+                }
+
+                if (latency_count < MAX_LATENCY_COUNT) {
+                    latencies[latency_count++] = static_cast<uint32_t>(static_cast<int64_t>(now_us() - slot->start));
+                }
+            });
+        }
+    }
+
+    double elapsed_s = static_cast<double>(static_cast<int64_t>(now_us() - start)) / 1000000.0;
+
+    injector.uninstall();
+    server.stop();
+
+    std::sort(latencies, latencies + latency_count);
+
+    const TFNetworkFaultStatistics &statistics = injector.get_statistics();
+
+    printf("profile=%s seed=%llu duration=%.1fs pipeline_depth=%d\n", profile_name, static_cast<unsigned long long>(seed), elapsed_s, PIPELINE_DEPTH);
+    printf("throughput: %zu transactions, %.0f/s\n", latency_count, static_cast<double>(latency_count) / elapsed_s);
+    printf("latency us: p50=%lld p90=%lld p99=%lld p99.9=%lld max=%lld\n",
+           static_cast<long long>(percentile(latencies, latency_count, 0.5)),
+           static_cast<long long>(percentile(latencies, latency_count, 0.9)),
+           static_cast<long long>(percentile(latencies, latency_count, 0.99)),
+           static_cast<long long>(percentile(latencies, latency_count, 0.999)),
+           static_cast<long long>(latency_count > 0 ? latencies[latency_count - 1] : 0));
+    printf("connection: connect_failures=%zu disconnects=%zu server_disconnects=%zu reconnects=%zu reconnect_mean_ms=%.1f reconnect_max_ms=%.1f\n",
+           connect_failures, disconnects, server_disconnects, reconnects,
+           reconnects > 0 ? static_cast<double>(reconnect_total_us) / static_cast<double>(reconnects) / 1000.0 : 0.0,
+           static_cast<double>(reconnect_max_us) / 1000.0);
+    printf("undetected value mismatches: %zu\n", value_mismatches);
+    printf("results:");
+
+    for (size_t i = 0; i < RESULT_COUNT; ++i) {
+        if (result_counts[i] > 0) {
+            printf(" %s=%zu", get_tf_modbus_tcp_client_transaction_result_name(static_cast<TFModbusTCPClientTransactionResult>(i)), result_counts[i]);
+        }
+    }
+
+    printf("\nfaults: connect_failures=%zu accept_drops=%zu connection_drops=%zu recv_delays=%zu recv_fragments=%zu recv_corruptions=%zu"
+           " send_fragments=%zu send_corruptions=%zu send_duplicates=%zu bursts=%zu\n",
+           statistics.connect_failures, statistics.accept_drops, statistics.connection_drops, statistics.recv_delays,
+           statistics.recv_fragments, statistics.recv_corruptions, statistics.send_fragments, statistics.send_corruptions,
+           statistics.send_duplicates, statistics.bursts);
+
+    delete[] latencies;
+
+    return 0;
+}
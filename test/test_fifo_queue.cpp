@@ -0,0 +1,264 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+// Read FIFO Queue (24): a ring buffer with more values than fit into one
+// response is drained by several requests, a full ring drops values and the
+// ring wraps around its storage
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <Arduino.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFModbusTCPServer.h"
+#include "../src/TFModbusTCPClient.h"
+#include "../src/TFModbusTCPFIFOQueue.h"
+
+#define PORT 15522
+#define FIFO_POINTER_ADDRESS 7
+#define STORAGE_LENGTH 40 // holds 39 values
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    TFNetwork::logfln("%s: %s", condition ? "PASS" : "FAIL", description);
+
+    if (!condition) {
+        ++failures;
+    }
+}
+
+static uint16_t storage[STORAGE_LENGTH];
+static TFModbusTCPFIFOQueue queue(storage, STORAGE_LENGTH);
+static TFModbusTCPServer server(TFModbusTCPByteOrder::Host);
+static TFModbusTCPClient *client;
+static uint16_t next_pushed_value = 1000;
+static uint16_t next_drained_value = 1000;
+
+static bool tick_until(bool *condition)
+{
+    micros_t deadline = calculate_deadline(3_s);
+
+    while (!*condition) {
+        if (deadline_elapsed(deadline)) {
+            return false;
+        }
+
+        server.tick();
+        client->tick();
+    }
+
+    return true;
+}
+
+static TFModbusTCPClientTransactionResult read_fifo_queue(uint16_t fifo_pointer_address, uint16_t *fifo_values, uint16_t *fifo_count)
+{
+    bool done                                 = false;
+    TFModbusTCPClientTransactionResult result = TFModbusTCPClientTransactionResult::Timeout;
+
+    client->read_fifo_queue(1, fifo_pointer_address, fifo_values, fifo_count, 1_s,
+    [&done, &result](TFModbusTCPClientTransactionResult transaction_result, const char *error_message) {
+        (void)error_message;
+
+        done   = true;
+        result = transaction_result;
+    });
+
+    tick_until(&done);
+
+    return result;
+}
+
+static size_t push(size_t count)
+{
+    size_t pushed_count = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (queue.push(next_pushed_value)) {
+            ++next_pushed_value;
+            ++pushed_count;
+        }
+    }
+
+    return pushed_count;
+}
+
+// Returns the drained count or SIZE_MAX if a request failed or a value is wrong
+static size_t drain(size_t *request_count)
+{
+    size_t drained_count = 0;
+
+    *request_count = 0;
+
+    while (true) {
+        uint16_t fifo_values[TF_MODBUS_TCP_MAX_FIFO_COUNT];
+        uint16_t fifo_count = UINT16_MAX;
+
+        if (read_fifo_queue(FIFO_POINTER_ADDRESS, fifo_values, &fifo_count) != TFModbusTCPClientTransactionResult::Success
+         || fifo_count > TF_MODBUS_TCP_MAX_FIFO_COUNT) {
+            return SIZE_MAX;
+        }
+
+        ++*request_count;
+
+        if (fifo_count == 0) {
+            return drained_count;
+        }
+
+        for (uint16_t i = 0; i < fifo_count; ++i) {
+            if (fifo_values[i] != next_drained_value++) {
+                return SIZE_MAX;
+            }
+        }
+
+        drained_count += fifo_count;
+    }
+}
+
+int main()
+{
+    TFNetwork::vlogfln =
+    [](const char *format, va_list args) {
+        printf("%li | ", static_cast<int64_t>(now_us()));
+        vprintf(format, args);
+        puts("");
+    };
+
+    TFNetwork::resolve =
+    [](const char *host, TFNetworkResolveResultCallback &&callback) {
+        callback(inet_addr(host), 0);
+    };
+
+    TFNetwork::get_random_uint16 =
+    []() {
+        return static_cast<uint16_t>(rand());
+    };
+
+    server.set_fifo_queue_callback(
+    [](uint8_t unit_id, uint16_t fifo_pointer_address, uint16_t *fifo_values, uint16_t *fifo_count) {
+        (void)unit_id;
+
+        if (fifo_pointer_address != FIFO_POINTER_ADDRESS) {
+            return TFModbusTCPExceptionCode::IllegalDataAddress;
+        }
+
+        return queue.handle(fifo_values, fifo_count);
+    });
+
+    check(server.start(htonl(INADDR_LOOPBACK), PORT,
+    [](uint32_t peer_address, uint16_t port) {
+        (void)peer_address;
+        (void)port;
+    },
+    [](uint32_t peer_address, uint16_t port, TFModbusTCPServerDisconnectReason reason, int error_number) {
+        (void)peer_address;
+        (void)port;
+        (void)reason;
+        (void)error_number;
+    },
+    [](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values) {
+        (void)unit_id;
+        (void)function_code;
+        (void)start_address;
+        (void)data_count;
+        (void)data_values;
+
+        return TFModbusTCPExceptionCode::IllegalFunction;
+    }), "start server");
+
+    client = new TFModbusTCPClient(TFModbusTCPByteOrder::Host);
+
+    bool connected = false;
+
+    client->connect("127.0.0.1", PORT,
+    [&connected](TFGenericTCPClientConnectResult result, int error_number) {
+        (void)error_number;
+
+        connected = result == TFGenericTCPClientConnectResult::Connected;
+    },
+    [&connected](TFGenericTCPClientDisconnectReason reason, int error_number) {
+        (void)reason;
+        (void)error_number;
+
+        connected = false;
+    });
+
+    check(tick_until(&connected), "client connected");
+
+    size_t request_count;
+
+    check(drain(&request_count) == 0 && request_count == 1, "empty queue returns no values");
+
+    // one slot of the storage stays unused
+    check(push(STORAGE_LENGTH + 5) == STORAGE_LENGTH - 1, "full queue refuses further values");
+    check(queue.get_count() == STORAGE_LENGTH - 1, "full queue count");
+    check(queue.get_dropped_count() == 6, "refused values are counted as dropped");
+
+    check(drain(&request_count) == STORAGE_LENGTH - 1 && request_count == 3, "full queue is drained by two requests plus an empty one");
+    check(queue.get_count() == 0, "drained queue is empty");
+
+    // head and tail are near the end of the storage now, the next values wrap
+    // around to the start of the storage
+    check(push(35) == 35, "values wrap around the storage end");
+    check(queue.get_count() == 35, "count across the storage end");
+    check(drain(&request_count) == 35 && request_count == 3, "wrapped values are drained in order by two requests plus an empty one");
+
+    // alternate pushing and draining to wrap around several times
+    bool interleaved = true;
+
+    for (size_t i = 0; i < 10; ++i) {
+        interleaved = interleaved && push(17 + i) == 17 + i && drain(&request_count) == 17 + i;
+    }
+
+    check(interleaved && queue.get_dropped_count() == 6, "repeated wrap-around keeps the order");
+
+    uint16_t fifo_values[TF_MODBUS_TCP_MAX_FIFO_COUNT];
+    uint16_t fifo_count;
+
+    check(read_fifo_queue(FIFO_POINTER_ADDRESS + 1, fifo_values, &fifo_count) == TFModbusTCPClientTransactionResult::ModbusIllegalDataAddress,
+          "unknown FIFO pointer address is an illegal data address");
+
+    client->disconnect();
+    server.stop();
+
+    delete client;
+
+    TFNetwork::logfln("%d failure(s)", failures);
+
+    return failures > 0 ? 1 : 0;
+}
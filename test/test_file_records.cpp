@@ -0,0 +1,498 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+// Read File Record (20) and Write File Record (21): requests of the client,
+// validation of malformed requests by the server using a plain socket peer,
+// windowed transfers across a file number boundary and the record sources
+
+#include <algorithm>
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <Arduino.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFModbusTCPServer.h"
+#include "../src/TFModbusTCPClient.h"
+#include "../src/TFModbusTCPFileTransfer.h"
+#include "../src/TFModbusTCPFileRecordSource.h"
+
+#define PORT 15521
+#define FILE_LENGTH 20000 // records 0 to 9999
+#define MAX_RECORD_CALL_COUNT 64
+#define TRANSFER_LENGTH 4000
+#define REGISTERS_PER_READ ((TF_MODBUS_TCP_MAX_FILE_RECORD_BYTE_COUNT - TF_MODBUS_TCP_FILE_RECORD_SUB_RESPONSE_LENGTH) / 2)
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    TFNetwork::logfln("%s: %s", condition ? "PASS" : "FAIL", description);
+
+    if (!condition) {
+        ++failures;
+    }
+}
+
+struct RecordCall
+{
+    size_t phase;
+    uint16_t file_number;
+    uint16_t record_number;
+    uint16_t record_length;
+};
+
+static TFModbusTCPServer server(TFModbusTCPByteOrder::Host);
+static TFModbusTCPClient *client;
+static uint8_t file_1[FILE_LENGTH];
+static uint8_t file_2[FILE_LENGTH];
+static uint8_t file_3[200];
+static TFModbusTCPFileRecordBufferSource source_1(file_1, sizeof(file_1), true);
+static TFModbusTCPFileRecordBufferSource source_2(file_2, sizeof(file_2), true);
+static TFModbusTCPFileRecordBufferSource source_3(file_3, sizeof(file_3), false);
+static TFModbusTCPFileRecordFileSource *source_9;
+static RecordCall record_calls[MAX_RECORD_CALL_COUNT];
+static size_t record_call_count = 0;
+static size_t phase = 0;
+static int peer_fd = -1;
+
+static bool tick_until(bool *condition)
+{
+    micros_t deadline = calculate_deadline(3_s);
+
+    while (!*condition) {
+        if (deadline_elapsed(deadline)) {
+            return false;
+        }
+
+        server.tick();
+        client->tick();
+    }
+
+    return true;
+}
+
+static TFModbusTCPClientTransactionResult transact_file_records(TFModbusTCPFunctionCode function_code, TFModbusTCPFileRecord *records, uint16_t record_count)
+{
+    bool done                                 = false;
+    TFModbusTCPClientTransactionResult result = TFModbusTCPClientTransactionResult::Timeout;
+
+    client->transact_file_records(1, function_code, records, record_count, 1_s,
+    [&done, &result](TFModbusTCPClientTransactionResult transaction_result, const char *error_message) {
+        (void)error_message;
+
+        done   = true;
+        result = transaction_result;
+    });
+
+    tick_until(&done);
+
+    return result;
+}
+
+static TFModbusTCPClientTransactionResult transfer(TFModbusTCPFileTransfer *file_transfer, TFModbusTCPFunctionCode function_code, uint16_t file_number, uint16_t record_number, uint8_t *data, size_t length)
+{
+    bool done                                 = false;
+    TFModbusTCPClientTransactionResult result = TFModbusTCPClientTransactionResult::Timeout;
+
+    file_transfer->start(client, 1, function_code, file_number, record_number, data, length, 1_s,
+    [&done, &result](TFModbusTCPClientTransactionResult transaction_result, const char *error_message) {
+        (void)error_message;
+
+        done   = true;
+        result = transaction_result;
+    });
+
+    // the client and the server are ticked in alternating phases, so that all
+    // requests the server handles during one phase were in flight together
+    micros_t deadline = calculate_deadline(3_s);
+
+    while (!done && !deadline_elapsed(deadline)) {
+        for (size_t i = 0; i < 10; ++i) {
+            client->tick();
+        }
+
+        ++phase;
+
+        for (size_t i = 0; i < 10; ++i) {
+            server.tick();
+        }
+    }
+
+    return result;
+}
+
+// Sends the PDU as unit 1 and returns the PDU of the response, or 0 on error
+static size_t raw_transact(const uint8_t *request_pdu, size_t request_pdu_length, uint8_t *response_pdu, size_t response_pdu_capacity)
+{
+    uint8_t frame[7 + 256];
+
+    frame[0] = 0x12; // transaction ID
+    frame[1] = 0x34;
+    frame[2] = 0x00; // protocol ID
+    frame[3] = 0x00;
+    frame[4] = static_cast<uint8_t>((1 + request_pdu_length) >> 8);
+    frame[5] = static_cast<uint8_t>((1 + request_pdu_length) & 0xFF);
+    frame[6] = 1; // unit ID
+
+    memcpy(frame + 7, request_pdu, request_pdu_length);
+
+    if (send(peer_fd, frame, 7 + request_pdu_length, 0) != static_cast<ssize_t>(7 + request_pdu_length)) {
+        return 0;
+    }
+
+    size_t received_length = 0;
+    micros_t deadline      = calculate_deadline(1_s);
+
+    while (!deadline_elapsed(deadline)) {
+        server.tick();
+
+        ssize_t result = recv(peer_fd, frame + received_length, sizeof(frame) - received_length, MSG_DONTWAIT);
+
+        if (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            return 0;
+        }
+
+        if (result == 0) {
+            return 0;
+        }
+
+        if (result > 0) {
+            received_length += static_cast<size_t>(result);
+        }
+
+        if (received_length >= 7) {
+            size_t frame_length = static_cast<size_t>((frame[4] << 8) | frame[5]);
+
+            if (received_length >= 6 + frame_length) {
+                size_t response_pdu_length = std::min(frame_length - 1, response_pdu_capacity);
+
+                memcpy(response_pdu, frame + 7, response_pdu_length);
+
+                return response_pdu_length;
+            }
+        }
+    }
+
+    return 0;
+}
+
+// Returns the exception code of the response or 0 for a regular response
+static uint8_t raw_exception_code(const uint8_t *request_pdu, size_t request_pdu_length)
+{
+    uint8_t response_pdu[256];
+    size_t response_pdu_length = raw_transact(request_pdu, request_pdu_length, response_pdu, sizeof(response_pdu));
+
+    if (response_pdu_length == 0) {
+        return 0xFF;
+    }
+
+    if ((response_pdu[0] & 0x80) == 0) {
+        return 0;
+    }
+
+    return response_pdu_length >= 2 ? response_pdu[1] : 0xFF;
+}
+
+static void check_server_validation()
+{
+    sockaddr_in address;
+
+    memset(&address, 0, sizeof(address));
+
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port        = htons(PORT);
+
+    peer_fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    check(connect(peer_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0, "plain socket peer connected");
+
+    const uint8_t read_valid[]            = {0x14, 7,  6, 0, 1, 0, 5, 0, 2};
+    const uint8_t read_file_zero[]        = {0x14, 7,  6, 0, 0, 0, 0, 0, 1};
+    const uint8_t read_reference_type[]   = {0x14, 7,  5, 0, 1, 0, 0, 0, 1};
+    const uint8_t read_beyond_9999[]      = {0x14, 7,  6, 0, 1, 0x27, 0x0F, 0, 2};
+    const uint8_t read_zero_length[]      = {0x14, 7,  6, 0, 1, 0, 0, 0, 0};
+    const uint8_t read_partial[]          = {0x14, 8,  6, 0, 1, 0, 0, 0, 1, 0};
+    const uint8_t read_too_long[]         = {0x14, 14, 6, 0, 1, 0, 0, 0, 120, 6, 0, 2, 0, 0, 0, 120};
+    const uint8_t write_short_data[]      = {0x15, 9,  6, 0, 1, 0, 0, 0, 2, 0xAA, 0xBB};
+    const uint8_t write_second_invalid[]  = {0x15, 18, 6, 0, 1, 0, 0, 0, 1, 0xDE, 0xAD, 6, 0, 0, 0, 0, 0, 1, 0xBE, 0xEF};
+
+    uint8_t response_pdu[256];
+    size_t response_pdu_length = raw_transact(read_valid, sizeof(read_valid), response_pdu, sizeof(response_pdu));
+
+    check(response_pdu_length == 8
+       && response_pdu[0] == 0x14 && response_pdu[1] == 6 && response_pdu[2] == 5 && response_pdu[3] == 6
+       && memcmp(response_pdu + 4, file_1 + 10, 4) == 0, "server: valid read");
+
+    check(raw_exception_code(read_file_zero, sizeof(read_file_zero)) == 0x02, "server: file number 0 is an illegal data address");
+    check(raw_exception_code(read_reference_type, sizeof(read_reference_type)) == 0x02, "server: wrong reference type is an illegal data address");
+    check(raw_exception_code(read_beyond_9999, sizeof(read_beyond_9999)) == 0x02, "server: records beyond 9999 are an illegal data address");
+    check(raw_exception_code(read_zero_length, sizeof(read_zero_length)) == 0x02, "server: zero record length is an illegal data address");
+    check(raw_exception_code(read_partial, sizeof(read_partial)) == 0x03, "server: partial read sub-request is an illegal data value");
+    check(raw_exception_code(read_too_long, sizeof(read_too_long)) == 0x03, "server: read response beyond the frame is an illegal data value");
+    check(raw_exception_code(write_short_data, sizeof(write_short_data)) == 0x03, "server: write with missing record data is an illegal data value");
+
+    uint8_t file_1_head[2] = {file_1[0], file_1[1]};
+
+    check(raw_exception_code(write_second_invalid, sizeof(write_second_invalid)) == 0x02, "server: write with an invalid second sub-request is rejected");
+    check(file_1[0] == file_1_head[0] && file_1[1] == file_1_head[1], "server: rejected write is not applied partially");
+
+    close(peer_fd);
+    peer_fd = -1;
+}
+
+int main()
+{
+    TFNetwork::vlogfln =
+    [](const char *format, va_list args) {
+        printf("%li | ", static_cast<int64_t>(now_us()));
+        vprintf(format, args);
+        puts("");
+    };
+
+    TFNetwork::resolve =
+    [](const char *host, TFNetworkResolveResultCallback &&callback) {
+        callback(inet_addr(host), 0);
+    };
+
+    TFNetwork::get_random_uint16 =
+    []() {
+        return static_cast<uint16_t>(rand());
+    };
+
+    for (size_t i = 0; i < FILE_LENGTH; ++i) {
+        file_1[i] = static_cast<uint8_t>(i * 7);
+        file_2[i] = static_cast<uint8_t>(31 + i * 7);
+    }
+
+    FILE *file_9 = tmpfile();
+
+    for (size_t i = 0; i < 1000; ++i) {
+        fputc(static_cast<int>(i & 0xFF), file_9);
+    }
+
+    fflush(file_9);
+
+    source_9 = new TFModbusTCPFileRecordFileSource(file_9, false);
+
+    server.set_file_record_callback(
+    [](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t file_number, uint16_t record_number, uint16_t record_length, uint8_t *record_data) {
+        (void)unit_id;
+
+        if (record_call_count < MAX_RECORD_CALL_COUNT) {
+            record_calls[record_call_count++] = RecordCall{phase, file_number, record_number, record_length};
+        }
+
+        switch (file_number) {
+        case 1:
+            return source_1.handle(function_code, record_number, record_length, record_data);
+
+        case 2:
+            return source_2.handle(function_code, record_number, record_length, record_data);
+
+        case 3:
+            return source_3.handle(function_code, record_number, record_length, record_data);
+
+        case 9:
+            return source_9->handle(function_code, record_number, record_length, record_data);
+
+        default:
+            return TFModbusTCPExceptionCode::IllegalDataAddress;
+        }
+    });
+
+    check(server.start(htonl(INADDR_LOOPBACK), PORT,
+    [](uint32_t peer_address, uint16_t port) {
+        (void)peer_address;
+        (void)port;
+    },
+    [](uint32_t peer_address, uint16_t port, TFModbusTCPServerDisconnectReason reason, int error_number) {
+        (void)peer_address;
+        (void)port;
+        (void)reason;
+        (void)error_number;
+    },
+    [](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values) {
+        (void)unit_id;
+        (void)function_code;
+        (void)start_address;
+        (void)data_count;
+        (void)data_values;
+
+        return TFModbusTCPExceptionCode::IllegalFunction;
+    }), "start server");
+
+    check_server_validation();
+
+    client = new TFModbusTCPClient(TFModbusTCPByteOrder::Host);
+
+    TFModbusTCPDeviceProfile profile;
+
+    profile.max_pending_transaction_count = TF_MODBUS_TCP_FILE_TRANSFER_MAX_WINDOW_SIZE;
+
+    client->set_device_profile(&profile);
+
+    bool connected = false;
+
+    client->connect("127.0.0.1", PORT,
+    [&connected](TFGenericTCPClientConnectResult result, int error_number) {
+        (void)error_number;
+
+        connected = result == TFGenericTCPClientConnectResult::Connected;
+    },
+    [&connected](TFGenericTCPClientDisconnectReason reason, int error_number) {
+        (void)reason;
+        (void)error_number;
+
+        connected = false;
+    });
+
+    check(tick_until(&connected), "client connected");
+
+    // one request with records of two files
+    uint8_t record_a[10];
+    uint8_t record_b[20];
+    TFModbusTCPFileRecord records[2] = {{1, 3, 5, record_a}, {2, 0, 10, record_b}};
+
+    check(transact_file_records(TFModbusTCPFunctionCode::ReadFileRecord, records, 2) == TFModbusTCPClientTransactionResult::Success
+       && memcmp(record_a, file_1 + 6, 10) == 0 && memcmp(record_b, file_2, 20) == 0, "read of two records");
+
+    uint8_t write_data[4] = {0x01, 0x02, 0x03, 0x04};
+    TFModbusTCPFileRecord write_record[1] = {{2, 100, 2, write_data}};
+
+    check(transact_file_records(TFModbusTCPFunctionCode::WriteFileRecord, write_record, 1) == TFModbusTCPClientTransactionResult::Success
+       && memcmp(file_2 + 200, write_data, 4) == 0, "write of one record");
+
+    static uint8_t large_data[TRANSFER_LENGTH];
+    TFModbusTCPFileRecord large_record[1] = {{1, 0, REGISTERS_PER_READ + 1, large_data}};
+
+    check(transact_file_records(TFModbusTCPFunctionCode::ReadFileRecord, large_record, 1) == TFModbusTCPClientTransactionResult::InvalidArgument,
+          "read beyond the frame is refused by the client");
+
+    large_record[0].record_length = REGISTERS_PER_READ;
+
+    check(transact_file_records(TFModbusTCPFunctionCode::ReadFileRecord, large_record, 1) == TFModbusTCPClientTransactionResult::Success
+       && memcmp(large_data, file_1, REGISTERS_PER_READ * 2) == 0, "read of the largest record");
+
+    TFModbusTCPFileRecord read_only_record[1] = {{3, 0, 2, write_data}};
+
+    check(transact_file_records(TFModbusTCPFunctionCode::WriteFileRecord, read_only_record, 1) == TFModbusTCPClientTransactionResult::ModbusIllegalFunction,
+          "write to a read-only source is an illegal function");
+
+    // a transfer from record 9000 of file 1 continues with record 0 of file 2
+    TFModbusTCPFileTransfer file_transfer;
+
+    record_call_count = 0;
+
+    size_t first_phase = phase + 1;
+
+    check(transfer(&file_transfer, TFModbusTCPFunctionCode::ReadFileRecord, 1, 9000, large_data, TRANSFER_LENGTH) == TFModbusTCPClientTransactionResult::Success,
+          "transfer read succeeds");
+    check(file_transfer.get_transferred_length() == TRANSFER_LENGTH, "transfer read length");
+    check(memcmp(large_data, file_1 + 18000, 2000) == 0 && memcmp(large_data + 2000, file_2, 2000) == 0, "transfer read data across the file boundary");
+
+    bool rollover       = false;
+    size_t max_count    = 0;
+    size_t first_count  = 0;
+
+    for (size_t i = 0; i < record_call_count; ++i) {
+        size_t phase_count = 0;
+
+        for (size_t k = 0; k < record_call_count; ++k) {
+            if (record_calls[k].phase == record_calls[i].phase) {
+                phase_count += record_calls[k].record_length;
+            }
+        }
+
+        max_count = std::max(max_count, phase_count);
+
+        if (record_calls[i].phase == first_phase) {
+            first_count = phase_count;
+        }
+
+        if (i > 0
+         && record_calls[i - 1].file_number == 1 && record_calls[i - 1].record_number + record_calls[i - 1].record_length == 10000u
+         && record_calls[i].file_number == 2 && record_calls[i].record_number == 0
+         && record_calls[i - 1].phase == record_calls[i].phase) {
+            rollover = true;
+        }
+    }
+
+    check(rollover, "record 9999 of file 1 is followed by record 0 of file 2");
+    check(first_count == TF_MODBUS_TCP_FILE_TRANSFER_MAX_WINDOW_SIZE * REGISTERS_PER_READ, "first window is filled completely");
+    check(max_count <= TF_MODBUS_TCP_FILE_TRANSFER_MAX_WINDOW_SIZE * REGISTERS_PER_READ, "window is never exceeded");
+
+    for (size_t i = 0; i < TRANSFER_LENGTH; ++i) {
+        large_data[i] = static_cast<uint8_t>(i * 13);
+    }
+
+    check(transfer(&file_transfer, TFModbusTCPFunctionCode::WriteFileRecord, 1, 9500, large_data, TRANSFER_LENGTH) == TFModbusTCPClientTransactionResult::Success
+       && memcmp(file_1 + 19000, large_data, 1000) == 0 && memcmp(file_2, large_data + 1000, 3000) == 0, "transfer write across the file boundary");
+
+    check(transfer(&file_transfer, TFModbusTCPFunctionCode::WriteFileRecord, 3, 0, large_data, 100) == TFModbusTCPClientTransactionResult::ModbusIllegalFunction,
+          "transfer write to a read-only source fails");
+
+    // the file source serves the current content of the file
+    check(transfer(&file_transfer, TFModbusTCPFunctionCode::ReadFileRecord, 9, 0, large_data, 1000) == TFModbusTCPClientTransactionResult::Success,
+          "transfer read from a file source");
+
+    bool file_matches = true;
+
+    for (size_t i = 0; i < 1000; ++i) {
+        file_matches = file_matches && large_data[i] == (i & 0xFF);
+    }
+
+    check(file_matches, "file source data");
+    check(transfer(&file_transfer, TFModbusTCPFunctionCode::ReadFileRecord, 9, 400, large_data, 400) == TFModbusTCPClientTransactionResult::ModbusIllegalDataAddress,
+          "read past the end of a file source is an illegal data address");
+
+    client->disconnect();
+    server.stop();
+
+    delete client;
+    delete source_9;
+
+    fclose(file_9);
+
+    TFNetwork::logfln("%d failure(s)", failures);
+
+    return failures > 0 ? 1 : 0;
+}
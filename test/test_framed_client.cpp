@@ -0,0 +1,352 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+// Framing of the framed TCP client base class over a loopback connection to a
+// plain socket peer. The peer can send byte by byte, so that frames are split
+// over many recv calls
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <Arduino.h>
+#include <TFTools/Micros.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFFramedTCPClient.h"
+
+#define PORT 15515
+#define MAX_FRAME_COUNT 8
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    TFNetwork::logfln("%s: %s", condition ? "PASS" : "FAIL", description);
+
+    if (!condition) {
+        ++failures;
+    }
+}
+
+struct Frame
+{
+    size_t length;
+    uint8_t data[TF_FRAMED_TCP_CLIENT_MAX_FRAME_LENGTH];
+};
+
+// Records all frames. With the Custom frame length the first byte of a frame
+// is the number of bytes that follow it
+class TestClient final : public TFFramedTCPClient
+{
+public:
+    TestClient(const TFFramedTCPClientFraming *framing_) : TFFramedTCPClient(framing_) {}
+
+    bool has_frame(size_t index, const char *data, size_t length) const
+    {
+        return index < frame_count && frames[index].length == length && memcmp(frames[index].data, data, length) == 0;
+    }
+
+    size_t frame_count    = 0;
+    Frame frames[MAX_FRAME_COUNT];
+    size_t received_count = 0;
+    size_t recv_count     = 0;
+    const char *tick_send = nullptr; // queued twice by the next tick
+
+private:
+    void framed_close_hook() override {}
+
+    void framed_tick_hook() override
+    {
+        if (tick_send != nullptr) {
+            queue_send(reinterpret_cast<const uint8_t *>(tick_send), strlen(tick_send));
+            queue_send(reinterpret_cast<const uint8_t *>(tick_send), strlen(tick_send));
+
+            tick_send = nullptr;
+        }
+    }
+
+    void frame_hook(const uint8_t *frame, size_t length) override
+    {
+        if (frame_count < MAX_FRAME_COUNT) {
+            frames[frame_count].length = length;
+
+            memcpy(frames[frame_count].data, frame, length);
+        }
+
+        ++frame_count;
+    }
+
+    size_t frame_length_hook(const uint8_t *frame, size_t length) override
+    {
+        (void)length;
+
+        return 1u + frame[0];
+    }
+
+    void received_hook(const uint8_t *buffer, size_t length) override
+    {
+        (void)buffer;
+
+        received_count += length;
+        ++recv_count;
+    }
+};
+
+static int listen_fd = -1;
+static TestClient *client;
+static int peer_fd = -1;
+static bool disconnected;
+static TFGenericTCPClientDisconnectReason disconnect_reason;
+
+static void tick_until(std::function<bool(void)> &&condition)
+{
+    micros_t deadline = calculate_deadline(2_s);
+
+    while (!condition() && !deadline_elapsed(deadline)) {
+        client->tick();
+    }
+}
+
+static bool open_client(const TFFramedTCPClientFraming *framing)
+{
+    bool connected = false;
+
+    client       = new TestClient(framing);
+    disconnected = false;
+
+    client->connect("127.0.0.1", PORT,
+    [&connected](TFGenericTCPClientConnectResult result, int error_number) {
+        (void)error_number;
+
+        connected = result == TFGenericTCPClientConnectResult::Connected;
+    },
+    [](TFGenericTCPClientDisconnectReason reason, int error_number) {
+        (void)error_number;
+
+        disconnected      = true;
+        disconnect_reason = reason;
+    });
+
+    tick_until([&connected]() {
+        if (peer_fd < 0) {
+            peer_fd = accept(listen_fd, nullptr, nullptr);
+        }
+
+        return connected && peer_fd >= 0;
+    });
+
+    int flag = 1;
+
+    setsockopt(peer_fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+
+    return connected && peer_fd >= 0;
+}
+
+static void close_client()
+{
+    if (!disconnected) {
+        client->disconnect();
+    }
+
+    delete client;
+    close(peer_fd);
+
+    peer_fd = -1;
+}
+
+// with split every byte is received by its own recv call
+static void deliver(const void *data, size_t length, bool split)
+{
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+
+    for (size_t offset = 0; offset < length; ) {
+        size_t chunk_length   = split ? 1 : length;
+        size_t received_count = client->received_count + chunk_length;
+
+        if (write(peer_fd, bytes + offset, chunk_length) != static_cast<ssize_t>(chunk_length)) {
+            return;
+        }
+
+        offset += chunk_length;
+
+        tick_until([received_count]() { return disconnected || client->received_count >= received_count; });
+    }
+}
+
+int main()
+{
+    TFNetwork::vlogfln =
+    [](const char *format, va_list args) {
+        printf("%li | ", static_cast<int64_t>(now_us()));
+        vprintf(format, args);
+        puts("");
+    };
+
+    TFNetwork::resolve =
+    [](const char *host, TFNetworkResolveResultCallback &&callback) {
+        callback(inet_addr(host), 0);
+    };
+
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    int flag = 1;
+    struct sockaddr_in address;
+
+    memset(&address, 0, sizeof(address));
+
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(PORT);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+
+    if (bind(listen_fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) < 0 || listen(listen_fd, 4) < 0) {
+        TFNetwork::logfln("could not listen: %s (%d)", strerror(errno), errno);
+        return 1;
+    }
+
+    fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL, 0) | O_NONBLOCK);
+
+    // fixed length, in one recv and split over many
+    TFFramedTCPClientFraming fixed;
+
+    fixed.frame_length = TFFramedTCPClientFrameLength::Fixed;
+    fixed.fixed_length = 4;
+
+    check(open_client(&fixed), "fixed: connect");
+    deliver("ABCDEFGH", 8, false);
+    check(client->frame_count == 2 && client->has_frame(0, "ABCD", 4) && client->has_frame(1, "EFGH", 4), "fixed: two frames in one recv");
+
+    size_t recv_count = client->recv_count;
+
+    deliver("IJKLM", 5, true);
+    check(client->recv_count - recv_count == 5 && client->frame_count == 3 && client->has_frame(2, "IJKL", 4), "fixed: frame split over recvs");
+
+    // queued data of one tick goes out with one send call
+    client->tick_send = "ping";
+    client->tick();
+
+    char sent[16];
+    ssize_t sent_length = recv(peer_fd, sent, sizeof(sent), 0);
+
+    check(sent_length == 8 && memcmp(sent, "pingping", 8) == 0, "fixed: queued data is sent after the tick hook");
+    close_client();
+
+    // length field, big endian after a type byte, counting the payload only
+    TFFramedTCPClientFraming length_field;
+
+    length_field.frame_length      = TFFramedTCPClientFrameLength::LengthField;
+    length_field.length_offset     = 1;
+    length_field.length_size       = 2;
+    length_field.length_adjustment = 3;
+    length_field.max_frame_length  = 16;
+
+    check(open_client(&length_field), "length field: connect");
+    deliver("T\x00\x02xyT\x00\x00T\x00\x01z", 13, true);
+    check(client->frame_count == 3 && client->has_frame(0, "T\x00\x02xy", 5) && client->has_frame(1, "T\x00\x00", 3) && client->has_frame(2, "T\x00\x01z", 4),
+          "length field: frames split inside the length field");
+    deliver("T\x00\x20", 3, false);
+    check(disconnected && disconnect_reason == TFGenericTCPClientDisconnectReason::ProtocolError && client->frame_count == 3,
+          "length field: broken frame without start byte disconnects");
+    close_client();
+
+    // a length field beyond the maximum frame length is moved into the frame
+    TFFramedTCPClientFraming far_length_field;
+    uint8_t far_frame[TF_FRAMED_TCP_CLIENT_MAX_FRAME_LENGTH];
+
+    far_length_field.frame_length  = TFFramedTCPClientFrameLength::LengthField;
+    far_length_field.length_offset = TF_FRAMED_TCP_CLIENT_MAX_FRAME_LENGTH + 40;
+    far_length_field.length_size   = 2;
+
+    memset(far_frame, 'f', sizeof(far_frame));
+
+    far_frame[sizeof(far_frame) - 2] = static_cast<uint8_t>(sizeof(far_frame) >> 8);
+    far_frame[sizeof(far_frame) - 1] = static_cast<uint8_t>(sizeof(far_frame));
+
+    check(open_client(&far_length_field), "length field beyond maximum: connect");
+    deliver(far_frame, sizeof(far_frame), false);
+    check(client->frame_count == 1 && client->frames[0].length == sizeof(far_frame), "length field beyond maximum: clamped into the frame");
+    close_client();
+
+    // end byte, with an escaped end byte inside the frame
+    TFFramedTCPClientFraming end_byte;
+
+    end_byte.frame_length = TFFramedTCPClientFrameLength::EndByte;
+    end_byte.end_byte     = '\n';
+
+    check(open_client(&end_byte), "end byte: connect");
+    deliver("hello\nwor", 9, false);
+    deliver("ld\n", 3, true);
+    check(client->frame_count == 2 && client->has_frame(0, "hello\n", 6) && client->has_frame(1, "world\n", 6), "end byte: frames across recvs");
+    close_client();
+
+    end_byte.escape_byte = '\\';
+
+    check(open_client(&end_byte), "end byte with escape: connect");
+    deliver("a\\\nb\\\\\n", 7, true);
+    check(client->frame_count == 1 && client->has_frame(0, "a\nb\\\n", 5), "end byte with escape: escaped bytes are literal");
+    close_client();
+
+    // custom length with start and escape byte, resynchronizing after a
+    // broken frame
+    TFFramedTCPClientFraming custom;
+
+    custom.start_byte       = 0x02;
+    custom.escape_byte      = 0x10;
+    custom.frame_length     = TFFramedTCPClientFrameLength::Custom;
+    custom.max_frame_length = 8;
+
+    check(open_client(&custom), "custom: connect");
+    deliver("junk\x02\x03" "a\x10\x02" "b", 10, true);
+    check(client->frame_count == 1 && client->has_frame(0, "\x03" "a\x02" "b", 4), "custom: garbage before the start byte is skipped, escaped start byte is data");
+    deliver("\x02\x05" "ab\x02\x01" "k", 7, false);
+    check(client->frame_count == 2 && client->has_frame(1, "\x01" "k", 2), "custom: start byte inside a frame resynchronizes");
+    deliver("\x02\x20" "toolong" "\x02\x01" "!", 12, true);
+    check(!disconnected && client->frame_count == 3 && client->has_frame(2, "\x01" "!", 2), "custom: out-of-range frame is dropped with a start byte");
+    close_client();
+
+    close(listen_fd);
+
+    TFNetwork::logfln("%d failure(s)", failures);
+
+    return failures > 0 ? 1 : 0;
+}
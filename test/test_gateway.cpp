@@ -0,0 +1,461 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+// Deferred server responses and the gateway on top of them, over loopback
+// connections. The downstream server can hold its responses to keep gateway
+// reads in flight
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <functional>
+#include <Arduino.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFModbusTCPServer.h"
+#include "../src/TFModbusTCPClient.h"
+#include "../src/TFModbusTCPClientPool.h"
+#include "../src/TFModbusTCPGateway.h"
+#include "../src/TFModbusTCPMemoryRegisterBank.h"
+
+#define DOWNSTREAM_PORT 15510
+#define GATEWAY_PORT 15511
+#define UPSTREAM_COUNT 2
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    TFNetwork::logfln("%s: %s", condition ? "PASS" : "FAIL", description);
+
+    if (!condition) {
+        ++failures;
+    }
+}
+
+struct HeldRequest
+{
+    uint32_t request_id;
+    TFModbusTCPFunctionCode function_code;
+    uint16_t start_address;
+    uint16_t data_count;
+};
+
+static TFModbusTCPMemoryRegisterBank bank(100, 0, 0, 200);
+static TFModbusTCPServer downstream_server(TFModbusTCPByteOrder::Host);
+static TFModbusTCPServer gateway_server(TFModbusTCPByteOrder::Host);
+static TFModbusTCPClientPool pool(TFModbusTCPByteOrder::Host);
+static TFModbusTCPGateway gateway(&gateway_server, &pool);
+static TFModbusTCPClient *upstream_clients[UPSTREAM_COUNT];
+static bool upstream_connected[UPSTREAM_COUNT];
+
+static bool hold_downstream = false;
+static HeldRequest downstream_held;
+static size_t downstream_request_count = 0;
+
+static bool hold_gateway = false; // answer from the test instead of the gateway
+static HeldRequest gateway_held;
+
+static void tick()
+{
+    gateway_server.tick();
+    gateway.tick();
+    pool.tick();
+    downstream_server.tick();
+
+    for (size_t i = 0; i < UPSTREAM_COUNT; ++i) {
+        upstream_clients[i]->tick();
+    }
+}
+
+static bool tick_until(std::function<bool(void)> &&condition)
+{
+    micros_t deadline = calculate_deadline(3_s);
+
+    while (!condition()) {
+        if (deadline_elapsed(deadline)) {
+            return false;
+        }
+
+        tick();
+    }
+
+    return true;
+}
+
+static HeldRequest hold(TFModbusTCPServer *server, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count)
+{
+    HeldRequest held;
+
+    held.request_id    = server->defer_response();
+    held.function_code = function_code;
+    held.start_address = start_address;
+    held.data_count    = data_count;
+
+    return held;
+}
+
+// Answers a held read from the bank, through finish_deferred_response
+static bool release(TFModbusTCPServer *server, HeldRequest *held)
+{
+    uint16_t values[TF_MODBUS_TCP_MAX_READ_REGISTER_COUNT];
+    TFModbusTCPExceptionCode exception_code = bank.handle_request(held->function_code, held->start_address, held->data_count, values);
+    uint32_t request_id                     = held->request_id;
+
+    held->request_id = 0;
+
+    return server->finish_deferred_response(request_id, exception_code, values, held->data_count);
+}
+
+static void connect_upstream(size_t index)
+{
+    upstream_connected[index] = false;
+
+    upstream_clients[index]->connect("127.0.0.1", GATEWAY_PORT,
+    [index](TFGenericTCPClientConnectResult result, int error_number) {
+        (void)error_number;
+
+        upstream_connected[index] = result == TFGenericTCPClientConnectResult::Connected;
+    },
+    [index](TFGenericTCPClientDisconnectReason reason, int error_number) {
+        (void)reason;
+        (void)error_number;
+
+        upstream_connected[index] = false;
+    });
+
+    tick_until([index]() { return upstream_connected[index]; });
+}
+
+struct Read
+{
+    bool done;
+    TFModbusTCPClientTransactionResult result;
+    uint16_t values[TF_MODBUS_TCP_MAX_READ_REGISTER_COUNT];
+};
+
+static void start_read(size_t index, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, Read *read, micros_t timeout = 1_s)
+{
+    read->done = false;
+
+    memset(read->values, 0xAA, sizeof(read->values));
+
+    upstream_clients[index]->transact(1, function_code, start_address, data_count, read->values, timeout,
+    [read](TFModbusTCPClientTransactionResult result, const char *error_message) {
+        (void)error_message;
+
+        read->done   = true;
+        read->result = result;
+    });
+}
+
+static bool check_registers(const Read *read, uint16_t start_address, uint16_t data_count)
+{
+    if (!read->done || read->result != TFModbusTCPClientTransactionResult::Success) {
+        return false;
+    }
+
+    for (uint16_t i = 0; i < data_count; ++i) {
+        if (read->values[i] != start_address + i) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main()
+{
+    TFNetwork::vlogfln =
+    [](const char *format, va_list args) {
+        printf("%li | ", static_cast<int64_t>(now_us()));
+        vprintf(format, args);
+        puts("");
+    };
+
+    TFNetwork::resolve =
+    [](const char *host, TFNetworkResolveResultCallback &&callback) {
+        callback(inet_addr(host), 0);
+    };
+
+    TFNetwork::get_random_uint16 =
+    []() {
+        return static_cast<uint16_t>(rand());
+    };
+
+    for (uint16_t i = 0; i < 200; ++i) {
+        bank.write(TFModbusTCPDataType::HoldingRegister, i, 1, &i);
+    }
+
+    for (uint16_t i = 0; i < 100; ++i) {
+        uint8_t bit = (i % 3) == 0 ? 1 : 0;
+
+        bank.write(TFModbusTCPDataType::Coil, i, 1, &bit);
+    }
+
+    auto connect_callback = [](uint32_t peer_address, uint16_t port) {
+        (void)peer_address;
+        (void)port;
+    };
+
+    auto disconnect_callback = [](uint32_t peer_address, uint16_t port, TFModbusTCPServerDisconnectReason reason, int error_number) {
+        (void)peer_address;
+        (void)port;
+        (void)reason;
+        (void)error_number;
+    };
+
+    check(downstream_server.start(htonl(INADDR_LOOPBACK), DOWNSTREAM_PORT, connect_callback, disconnect_callback,
+    [](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values) {
+        (void)unit_id;
+
+        ++downstream_request_count;
+
+        if (hold_downstream) {
+            downstream_held = hold(&downstream_server, function_code, start_address, data_count);
+            return TFModbusTCPExceptionCode::Deferred;
+        }
+
+        return bank.handle_request(function_code, start_address, data_count, data_values);
+    }), "start downstream server");
+
+    check(gateway_server.start(htonl(INADDR_LOOPBACK), GATEWAY_PORT, connect_callback, disconnect_callback,
+    [](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values) {
+        if (hold_gateway) {
+            gateway_held = hold(&gateway_server, function_code, start_address, data_count);
+            return TFModbusTCPExceptionCode::Deferred;
+        }
+
+        return gateway.handle_request(unit_id, function_code, start_address, data_count, data_values);
+    }), "start gateway server");
+
+    check(gateway.start("127.0.0.1", DOWNSTREAM_PORT, 300_ms), "start gateway");
+
+    for (size_t i = 0; i < UPSTREAM_COUNT; ++i) {
+        upstream_clients[i] = new TFModbusTCPClient(TFModbusTCPByteOrder::Host);
+    }
+
+    for (size_t i = 0; i < UPSTREAM_COUNT; ++i) {
+        connect_upstream(i);
+    }
+
+    check(upstream_connected[0] && upstream_connected[1], "upstream clients connected");
+
+    // Deferred responses
+    Read reads[UPSTREAM_COUNT];
+
+    check(gateway_server.defer_response() == 0, "defer_response outside of the request callback returns 0");
+
+    hold_gateway            = true;
+    gateway_held.request_id = 0;
+
+    start_read(0, TFModbusTCPFunctionCode::ReadHoldingRegisters, 20, 5, &reads[0]);
+    tick_until([]() { return gateway_held.request_id != 0; });
+
+    errno = 0;
+
+    check(!gateway_server.finish_deferred_response(gateway_held.request_id + 1, TFModbusTCPExceptionCode::Success) && errno == ESRCH,
+          "unknown request ID is rejected");
+
+    uint32_t finished_request_id = gateway_held.request_id;
+
+    check(release(&gateway_server, &gateway_held) && tick_until([&reads]() { return reads[0].done; }) && check_registers(&reads[0], 20, 5),
+          "request ID is found and the read values are copied");
+    check(!gateway_server.finish_deferred_response(finished_request_id, TFModbusTCPExceptionCode::Success), "finished request ID expires");
+
+    gateway_held.request_id = 0;
+
+    start_read(0, TFModbusTCPFunctionCode::ReadHoldingRegisters, 20, 5, &reads[0]);
+    tick_until([]() { return gateway_held.request_id != 0; });
+    gateway_server.finish_deferred_response(gateway_held.request_id, TFModbusTCPExceptionCode::Success);
+    tick_until([&reads]() { return reads[0].done; });
+    check(reads[0].result == TFModbusTCPClientTransactionResult::ModbusServerDeviceFailure, "successful read without values is a server device failure");
+
+    gateway_held.request_id = 0;
+
+    start_read(0, TFModbusTCPFunctionCode::ReadHoldingRegisters, 20, 5, &reads[0]);
+    tick_until([]() { return gateway_held.request_id != 0; });
+    gateway_server.finish_deferred_response(gateway_held.request_id, TFModbusTCPExceptionCode::IllegalDataAddress);
+    tick_until([&reads]() { return reads[0].done; });
+    check(reads[0].result == TFModbusTCPClientTransactionResult::ModbusIllegalDataAddress, "exception code is sent as exception response");
+
+    // The client of a deferred read disconnects before the response is known
+    gateway_held.request_id = 0;
+
+    start_read(0, TFModbusTCPFunctionCode::ReadHoldingRegisters, 20, 5, &reads[0]);
+    tick_until([]() { return gateway_held.request_id != 0; });
+    upstream_clients[0]->disconnect();
+
+    for (int i = 0; i < 100; ++i) {
+        tick();
+    }
+
+    // A client with a deferred response is not read from, the disconnect is noticed after the response
+    check(gateway_server.get_client_count() == UPSTREAM_COUNT, "client with a deferred response is kept");
+
+    finished_request_id = gateway_held.request_id;
+
+    release(&gateway_server, &gateway_held);
+    check(tick_until([]() { return gateway_server.get_client_count() == UPSTREAM_COUNT - 1; }), "disconnected client is removed after its deferred response");
+    check(!gateway_server.finish_deferred_response(finished_request_id, TFModbusTCPExceptionCode::Success), "request ID of a disconnected client expires");
+
+    connect_upstream(0);
+    hold_gateway = false;
+
+    // Gateway, wait for the downstream connection
+    tick_until([]() {
+        Read probe;
+
+        start_read(1, TFModbusTCPFunctionCode::ReadHoldingRegisters, 0, 1, &probe);
+        tick_until([&probe]() { return probe.done; });
+
+        return probe.result == TFModbusTCPClientTransactionResult::Success;
+    });
+
+    // Two overlapping reads of different clients, one downstream read
+    size_t downstream_read_count = gateway.get_downstream_read_count();
+
+    hold_downstream            = true;
+    downstream_held.request_id = 0;
+
+    start_read(0, TFModbusTCPFunctionCode::ReadHoldingRegisters, 10, 20, &reads[0]);
+    start_read(1, TFModbusTCPFunctionCode::ReadHoldingRegisters, 15, 10, &reads[1]);
+    tick_until([]() { return downstream_held.request_id != 0; });
+
+    for (int i = 0; i < 100; ++i) {
+        tick();
+    }
+
+    check(gateway.get_downstream_read_count() == downstream_read_count + 1 && gateway.get_coalesced_read_count() == 1, "overlapping reads are coalesced");
+
+    release(&downstream_server, &downstream_held);
+    tick_until([&reads]() { return reads[0].done && reads[1].done; });
+    check(check_registers(&reads[0], 10, 20) && check_registers(&reads[1], 15, 10), "coalesced reads get their part of the values");
+
+    hold_downstream = false;
+
+    uint8_t coils[2][4];
+    int coil_done = 0;
+
+    for (size_t i = 0; i < UPSTREAM_COUNT; ++i) {
+        upstream_clients[i]->transact(1, TFModbusTCPFunctionCode::ReadCoils, i == 0 ? 3 : 7, i == 0 ? 27 : 11, coils[i], 1_s,
+        [&coil_done](TFModbusTCPClientTransactionResult result, const char *error_message) {
+            (void)error_message;
+
+            if (result == TFModbusTCPClientTransactionResult::Success) {
+                ++coil_done;
+            }
+        });
+    }
+
+    tick_until([&coil_done]() { return coil_done == 2; });
+
+    bool coils_match = coil_done == 2;
+
+    for (uint16_t i = 0; i < 27; ++i) {
+        coils_match &= ((coils[0][i / 8] >> (i % 8)) & 1) == ((3 + i) % 3 == 0 ? 1 : 0);
+    }
+
+    for (uint16_t i = 0; i < 11; ++i) {
+        coils_match &= ((coils[1][i / 8] >> (i % 8)) & 1) == ((7 + i) % 3 == 0 ? 1 : 0);
+    }
+
+    check(coils_match, "coil reads keep their bit offset");
+
+    // Downstream exceptions and timeouts are passed on
+    start_read(0, TFModbusTCPFunctionCode::ReadHoldingRegisters, 500, 5, &reads[0]);
+    tick_until([&reads]() { return reads[0].done; });
+    check(reads[0].result == TFModbusTCPClientTransactionResult::ModbusIllegalDataAddress, "downstream exception is passed on");
+
+    hold_downstream            = true;
+    downstream_held.request_id = 0;
+
+    start_read(0, TFModbusTCPFunctionCode::ReadHoldingRegisters, 40, 5, &reads[0]);
+    tick_until([&reads]() { return reads[0].done; });
+    check(reads[0].result == TFModbusTCPClientTransactionResult::ModbusGatewayTargetDeviceFailedToRespond, "downstream timeout is a target device failure");
+
+    release(&downstream_server, &downstream_held);
+
+    // The gateway finishes a read after its server client disconnected
+    downstream_held.request_id = 0;
+
+    start_read(0, TFModbusTCPFunctionCode::ReadHoldingRegisters, 60, 5, &reads[0]);
+    tick_until([]() { return downstream_held.request_id != 0; });
+    upstream_clients[0]->disconnect();
+
+    for (int i = 0; i < 100; ++i) {
+        tick();
+    }
+
+    release(&downstream_server, &downstream_held);
+    tick_until([]() { return gateway_server.get_client_count() == UPSTREAM_COUNT - 1; });
+
+    hold_downstream = false;
+
+    start_read(1, TFModbusTCPFunctionCode::ReadHoldingRegisters, 60, 5, &reads[1]);
+    tick_until([&reads]() { return reads[1].done; });
+    check(check_registers(&reads[1], 60, 5), "read of a disconnected client is dropped");
+
+    // The gateway finishes a read after its server was stopped
+    hold_downstream            = true;
+    downstream_held.request_id = 0;
+
+    start_read(1, TFModbusTCPFunctionCode::ReadHoldingRegisters, 70, 5, &reads[1]);
+    tick_until([]() { return downstream_held.request_id != 0; });
+    gateway_server.stop();
+    release(&downstream_server, &downstream_held);
+
+    for (int i = 0; i < 100; ++i) {
+        tick();
+    }
+
+    check(gateway_server.get_client_count() == 0 && !(reads[1].done && reads[1].result == TFModbusTCPClientTransactionResult::Success),
+          "read of a stopped server is dropped");
+
+    gateway.stop();
+
+    for (size_t i = 0; i < UPSTREAM_COUNT; ++i) {
+        upstream_clients[i]->disconnect();
+        delete upstream_clients[i];
+    }
+
+    downstream_server.stop();
+
+    TFNetwork::logfln("%d failure(s)", failures);
+
+    return failures > 0 ? 1 : 0;
+}
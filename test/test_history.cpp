@@ -0,0 +1,241 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+// Round trip of edge values through the history encoding and the compression
+// of a typical energy counter
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+#include <Arduino.h>
+#include <TFTools/Micros.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFModbusTCPHistory.h"
+
+#define MAX_SAMPLE_COUNT 16
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    TFNetwork::logfln("%s: %s", condition ? "PASS" : "FAIL", description);
+
+    if (!condition) {
+        ++failures;
+    }
+}
+
+struct Samples
+{
+    size_t count;
+    micros_t timestamps[MAX_SAMPLE_COUNT];
+    double values[MAX_SAMPLE_COUNT];
+};
+
+static void query_all(TFModbusTCPHistory *history, TFModbusTCPHistorySeries *series, Samples *samples)
+{
+    samples->count = 0;
+
+    history->query(series, 0_us, micros_t{INT64_MAX / 2}, [samples](micros_t timestamp, double value) {
+        if (samples->count < MAX_SAMPLE_COUNT) {
+            samples->timestamps[samples->count] = timestamp;
+            samples->values[samples->count]     = value;
+        }
+
+        ++samples->count;
+    });
+}
+
+static void feed_u32(TFModbusTCPHistory *history, uint16_t address, uint32_t value, micros_t timestamp)
+{
+    uint16_t registers[2] = {static_cast<uint16_t>(value >> 16), static_cast<uint16_t>(value)};
+
+    history->feed(TFModbusTCPDataType::InputRegister, address, 2, registers, timestamp);
+}
+
+static uint32_t get_float_bits(double value)
+{
+    float float_value = static_cast<float>(value);
+    uint32_t bits;
+
+    memcpy(&bits, &float_value, sizeof(bits));
+
+    return bits;
+}
+
+int main()
+{
+    TFNetwork::vlogfln =
+    [](const char *format, va_list args) {
+        printf("%li | ", static_cast<int64_t>(now_us()));
+        vprintf(format, args);
+        puts("");
+    };
+
+    TFModbusTCPHistory history(64 * 1024, 1_ms);
+    Samples samples;
+
+    // float bit patterns, including a NaN with payload, both zeros and a
+    // denormal, fed as registers to skip the double to float conversion
+    static const uint32_t float_bits[] = {
+        0x3F800000u, // 1.0
+        0x7FC00000u, // NaN
+        0x7FC12345u, // NaN with payload
+        0x00000000u, // +0
+        0x80000000u, // -0
+        0x00000001u, // smallest denormal
+        0x7F800000u, // +Inf
+        0xFF800000u, // -Inf
+        0x7F7FFFFFu, // largest finite
+        0xBF800000u, // -1.0
+    };
+
+    size_t float_count                     = sizeof(float_bits) / sizeof(float_bits[0]);
+    TFModbusTCPHistorySeries *float_series = history.add_series(TFModbusTCPDataType::InputRegister, 10, TFModbusTCPHistoryValueType::Float32);
+
+    for (size_t i = 0; i < float_count; ++i) {
+        feed_u32(&history, 10, float_bits[i], micros_t{static_cast<int64_t>(i) * 1000});
+    }
+
+    query_all(&history, float_series, &samples);
+
+    bool floats_match = samples.count == float_count;
+
+    for (size_t i = 0; i < float_count && floats_match; ++i) {
+        if ((float_bits[i] & 0x7F800000u) == 0x7F800000u && (float_bits[i] & 0x007FFFFFu) != 0) {
+            floats_match &= isnan(samples.values[i]) != 0;
+        }
+        else {
+            floats_match &= get_float_bits(samples.values[i]) == float_bits[i];
+        }
+    }
+
+    check(floats_match, "float NaN, +0, -0, denormal and infinity round trip");
+    check(samples.count == float_count && signbit(samples.values[4]) != 0 && signbit(samples.values[3]) == 0, "sign of zero is kept");
+
+    // counter wrap in both directions needs the full width delta
+    static const uint32_t counter_values[] = {0xFFFFFFFDu, 0xFFFFFFFFu, 0u, 1u, 0xFFFFFFFFu, 0x80000000u, 0x7FFFFFFFu};
+
+    size_t counter_count                     = sizeof(counter_values) / sizeof(counter_values[0]);
+    TFModbusTCPHistorySeries *counter_series = history.add_series(TFModbusTCPDataType::InputRegister, 20, TFModbusTCPHistoryValueType::U32);
+    TFModbusTCPHistorySeries *signed_series  = history.add_series(TFModbusTCPDataType::InputRegister, 20, TFModbusTCPHistoryValueType::S32);
+
+    for (size_t i = 0; i < counter_count; ++i) {
+        feed_u32(&history, 20, counter_values[i], micros_t{static_cast<int64_t>(i) * 1000});
+    }
+
+    query_all(&history, counter_series, &samples);
+
+    bool counters_match = samples.count == counter_count;
+
+    for (size_t i = 0; i < counter_count && counters_match; ++i) {
+        counters_match &= samples.values[i] == static_cast<double>(counter_values[i]);
+    }
+
+    check(counters_match, "U32 counter wrap round trips");
+
+    query_all(&history, signed_series, &samples);
+
+    bool signed_match = samples.count == counter_count;
+
+    for (size_t i = 0; i < counter_count && signed_match; ++i) {
+        signed_match &= samples.values[i] == static_cast<double>(static_cast<int32_t>(counter_values[i]));
+    }
+
+    check(signed_match, "S32 sign flip round trips");
+
+    // irregular timestamps: repeated, tiny, huge and shrinking intervals
+    static const int64_t timestamps[] = {5000, 5000, 6000, 3600000000ll, 3600001000ll, 262800000000ll, 262800002000ll, 262800003000ll};
+
+    size_t timestamp_count                = sizeof(timestamps) / sizeof(timestamps[0]);
+    TFModbusTCPHistorySeries *time_series = history.add_series(TFModbusTCPDataType::HoldingRegister, 30, TFModbusTCPHistoryValueType::S16);
+
+    for (size_t i = 0; i < timestamp_count; ++i) {
+        history.append(time_series, micros_t{timestamps[i]}, i % 2 == 0 ? -32768 : 32767);
+    }
+
+    check(!history.append(time_series, micros_t{timestamps[timestamp_count - 1] - 1000}, 0), "sample older than the newest one is dropped");
+
+    query_all(&history, time_series, &samples);
+
+    bool timestamps_match = samples.count == timestamp_count;
+
+    for (size_t i = 0; i < timestamp_count && timestamps_match; ++i) {
+        timestamps_match &= samples.timestamps[i] == micros_t{timestamps[i]} && samples.values[i] == (i % 2 == 0 ? -32768 : 32767);
+    }
+
+    check(timestamps_match, "irregular timestamps round trip");
+
+    // three days of a slowly rising 1 Hz energy counter, changing in 10% of
+    // the samples. the memory usage includes the block headers
+    TFModbusTCPHistory counter_history(1024 * 1024, 100_ms);
+    TFModbusTCPHistorySeries *energy_series = counter_history.add_series(TFModbusTCPDataType::InputRegister, 0, TFModbusTCPHistoryValueType::U32);
+    uint32_t random_state                   = 1;
+    uint32_t energy                         = 123456;
+    size_t day_sample_count                 = 24 * 60 * 60;
+
+    for (size_t i = 0; i < 3 * day_sample_count; ++i) {
+        random_state = random_state * 1103515245u + 12345u;
+
+        if ((random_state >> 16) % 10 == 0) {
+            energy += 1 + (random_state >> 8) % 3;
+        }
+
+        feed_u32(&counter_history, 0, energy, micros_t{static_cast<int64_t>(i) * 1000000});
+    }
+
+    size_t sample_count           = counter_history.get_sample_count(energy_series);
+    double stream_bits_per_sample = static_cast<double>(counter_history.get_block_count() * TF_MODBUS_TCP_HISTORY_BLOCK_BYTE_COUNT) * 8.0 / static_cast<double>(sample_count);
+    double bits_per_sample        = static_cast<double>(counter_history.get_memory_usage()) * 8.0 / static_cast<double>(sample_count);
+    double bytes_per_day          = static_cast<double>(counter_history.get_memory_usage()) / 3.0;
+
+    TFModbusTCPHistoryBucket last;
+
+    counter_history.downsample(energy_series, micros_t{static_cast<int64_t>(3 * day_sample_count - 1) * 1000000}, micros_t{static_cast<int64_t>(3 * day_sample_count) * 1000000}, 1_s, &last, 1);
+
+    TFNetwork::logfln("energy counter: %zu samples, %zu blocks, %zu bytes, %.2f stream bits/sample, %.2f bits/sample, %.1f kB/day",
+                      sample_count, counter_history.get_block_count(), counter_history.get_memory_usage(),
+                      stream_bits_per_sample, bits_per_sample, bytes_per_day / 1000.0);
+
+    check(sample_count == 3 * day_sample_count && counter_history.get_evicted_block_count() == 0, "energy counter is kept completely");
+    check(last.count == 1 && last.max == static_cast<double>(energy), "energy counter round trips");
+    check(stream_bits_per_sample < 2.7, "energy counter bit streams take less than 2.7 bits/sample");
+    check(bits_per_sample < 3.4 && bytes_per_day < 37000.0, "energy counter takes less than 3.4 bits/sample and 37 kB/day of memory");
+
+    TFNetwork::logfln("%d failure(s)", failures);
+
+    return failures > 0 ? 1 : 0;
+}
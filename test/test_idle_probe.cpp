@@ -0,0 +1,187 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+// Idle probes: an idle connection is probed, exception responses count as
+// alive and a probe without response disconnects the client
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <Arduino.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFModbusTCPServer.h"
+#include "../src/TFModbusTCPClient.h"
+
+#define PORT 15525
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    TFNetwork::logfln("%s: %s", condition ? "PASS" : "FAIL", description);
+
+    if (!condition) {
+        ++failures;
+    }
+}
+
+static TFModbusTCPServer server(TFModbusTCPByteOrder::Host);
+static TFModbusTCPClient *client;
+static TFModbusTCPExceptionCode probe_response = TFModbusTCPExceptionCode::Success;
+static size_t probe_count = 0;
+static bool disconnected = false;
+static TFGenericTCPClientDisconnectReason disconnect_reason;
+
+static void tick_for(micros_t duration)
+{
+    micros_t deadline = calculate_deadline(duration);
+
+    while (!disconnected && !deadline_elapsed(deadline)) {
+        server.tick();
+        client->tick();
+    }
+}
+
+int main()
+{
+    TFNetwork::vlogfln =
+    [](const char *format, va_list args) {
+        printf("%li | ", static_cast<int64_t>(now_us()));
+        vprintf(format, args);
+        puts("");
+    };
+
+    TFNetwork::resolve =
+    [](const char *host, TFNetworkResolveResultCallback &&callback) {
+        callback(inet_addr(host), 0);
+    };
+
+    TFNetwork::get_random_uint16 =
+    []() {
+        return static_cast<uint16_t>(rand());
+    };
+
+    check(server.start(htonl(INADDR_LOOPBACK), PORT,
+    [](uint32_t peer_address, uint16_t port) {
+        (void)peer_address;
+        (void)port;
+    },
+    [](uint32_t peer_address, uint16_t port, TFModbusTCPServerDisconnectReason reason, int error_number) {
+        (void)peer_address;
+        (void)port;
+        (void)reason;
+        (void)error_number;
+    },
+    [](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values) {
+        (void)unit_id;
+        (void)start_address;
+
+        if (function_code != TFModbusTCPFunctionCode::ReadInputRegisters) {
+            return TFModbusTCPExceptionCode::IllegalFunction;
+        }
+
+        ++probe_count;
+
+        memset(data_values, 0, data_count * 2);
+
+        return probe_response;
+    }), "start server");
+
+    client = new TFModbusTCPClient(TFModbusTCPByteOrder::Host);
+
+    TFModbusTCPClientIdleProbe probe;
+
+    probe.idle_interval = 200_ms;
+    probe.function_code = TFModbusTCPFunctionCode::ReadInputRegisters;
+    probe.timeout       = 300_ms;
+
+    client->set_idle_probe(&probe);
+
+    bool connected = false;
+
+    client->connect("127.0.0.1", PORT,
+    [&connected](TFGenericTCPClientConnectResult result, int error_number) {
+        (void)error_number;
+
+        connected = result == TFGenericTCPClientConnectResult::Connected;
+    },
+    [](TFGenericTCPClientDisconnectReason reason, int error_number) {
+        (void)error_number;
+
+        disconnected      = true;
+        disconnect_reason = reason;
+    });
+
+    micros_t deadline = calculate_deadline(3_s);
+
+    while (!connected && !deadline_elapsed(deadline)) {
+        server.tick();
+        client->tick();
+    }
+
+    check(connected, "client connected");
+
+    // one probe every 200 ms after the last response
+    tick_for(100_ms);
+    check(probe_count == 0, "no probe before the idle interval");
+
+    tick_for(1_s);
+    check(!disconnected && probe_count >= 4 && probe_count <= 6, "idle connection is probed");
+
+    probe_response = TFModbusTCPExceptionCode::IllegalDataAddress;
+    probe_count    = 0;
+
+    tick_for(1_s);
+    check(!disconnected && probe_count >= 4, "exception response keeps the connection");
+
+    // the server does not answer, the probe times out
+    probe_response = TFModbusTCPExceptionCode::ForceTimeout;
+
+    micros_t silent_since = now_us();
+
+    tick_for(2_s);
+    check(disconnected && disconnect_reason == TFGenericTCPClientDisconnectReason::IdleProbeFailed, "failed probe disconnects");
+    check(now_us() - silent_since < 800_ms, "disconnect after idle interval and probe timeout");
+
+    server.stop();
+
+    delete client;
+
+    TFNetwork::logfln("%d failure(s)", failures);
+
+    return failures > 0 ? 1 : 0;
+}
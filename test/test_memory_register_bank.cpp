@@ -0,0 +1,205 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <Arduino.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFModbusTCPMemoryRegisterBank.h"
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    TFNetwork::logfln("%s: %s", condition ? "PASS" : "FAIL", description);
+
+    if (!condition) {
+        ++failures;
+    }
+}
+
+#define BANK_PATH "test_memory_register_bank_image"
+#define JOURNAL_PATH BANK_PATH ".journal"
+
+static size_t read_file(const char *path, uint8_t *buffer, size_t buffer_length)
+{
+    FILE *file = fopen(path, "rb");
+
+    if (file == nullptr) {
+        return 0;
+    }
+
+    size_t length = fread(buffer, 1, buffer_length, file);
+
+    fclose(file);
+
+    return length;
+}
+
+static void write_file(const char *path, const uint8_t *buffer, size_t length)
+{
+    FILE *file = fopen(path, "wb");
+
+    fwrite(buffer, 1, length, file);
+    fclose(file);
+}
+
+static uint16_t read_register(TFModbusTCPMemoryRegisterBank *bank, uint16_t address)
+{
+    uint16_t value = 0xFFFF;
+
+    bank->read(TFModbusTCPDataType::HoldingRegister, address, 1, &value);
+
+    return value;
+}
+
+int main()
+{
+    TFNetwork::vlogfln =
+    [](const char *format, va_list args) {
+        printf("%li | ", static_cast<int64_t>(now_us()));
+        vprintf(format, args);
+        puts("");
+    };
+
+    unlink(BANK_PATH);
+    unlink(JOURNAL_PATH);
+
+    // Image with register 0 set, then one journal record per register 1 to 3
+    uint8_t journal[256];
+    size_t journal_length;
+
+    {
+        TFModbusTCPMemoryRegisterBank bank(16, 0, 0, 16);
+        uint16_t value = 10;
+
+        check(bank.enable_persistence(BANK_PATH, 0_s) && bank.load(), "first load without image");
+
+        bank.write(TFModbusTCPDataType::HoldingRegister, 0, 1, &value);
+        check(bank.flush() && bank.get_journal_length() == 0, "first flush writes the image");
+
+        for (uint16_t address = 1; address <= 3; ++address) {
+            value = static_cast<uint16_t>(address * 11);
+
+            bank.write(TFModbusTCPDataType::HoldingRegister, address, 1, &value);
+            bank.flush();
+        }
+
+        journal_length = read_file(JOURNAL_PATH, journal, sizeof(journal));
+        check(journal_length > 0 && journal_length == bank.get_journal_length(), "later flushes append to the journal");
+    }
+
+    size_t record_length = journal_length / 3;
+    bool replay_matches  = true;
+    bool compact_matches = true;
+
+    // Cut the journal at every length, only complete records may be replayed
+    for (size_t length = 0; length <= journal_length; ++length) {
+        write_file(JOURNAL_PATH, journal, length);
+
+        TFModbusTCPMemoryRegisterBank bank(16, 0, 0, 16);
+
+        bank.enable_persistence(BANK_PATH, 0_s);
+
+        bool loaded = bank.load();
+
+        for (uint16_t address = 1; address <= 3; ++address) {
+            uint16_t expected = length >= address * record_length ? static_cast<uint16_t>(address * 11) : 0;
+
+            if (read_register(&bank, address) != expected) {
+                replay_matches = false;
+            }
+        }
+
+        if (!loaded || read_register(&bank, 0) != 10) {
+            replay_matches = false;
+        }
+
+        // A torn tail is compacted away, so records written afterwards are
+        // not hidden behind it on the next load
+        if (length % record_length != 0) {
+            uint16_t value = 99;
+
+            bank.write(TFModbusTCPDataType::HoldingRegister, 4, 1, &value);
+            bank.flush();
+
+            TFModbusTCPMemoryRegisterBank reloaded_bank(16, 0, 0, 16);
+
+            reloaded_bank.enable_persistence(BANK_PATH, 0_s);
+
+            if (!reloaded_bank.load()
+             || read_register(&reloaded_bank, 4) != 99
+             || read_register(&reloaded_bank, 3) != read_register(&bank, 3)) {
+                compact_matches = false;
+            }
+
+            // restore the image, the next iteration starts from the original
+            value = 0;
+            bank.write(TFModbusTCPDataType::HoldingRegister, 4, 1, &value);
+
+            for (uint16_t address = 1; address <= 3; ++address) {
+                bank.write(TFModbusTCPDataType::HoldingRegister, address, 1, &value);
+            }
+
+            bank.compact();
+        }
+    }
+
+    check(replay_matches, "truncated journal replays exactly the complete records");
+    check(compact_matches, "writes after a torn journal survive the next load");
+
+    // A corrupt image must not clobber the initial values
+    FILE *file = fopen(BANK_PATH, "r+b");
+
+    fseek(file, 10, SEEK_SET);
+    fputc(0x55, file);
+    fclose(file);
+
+    {
+        TFModbusTCPMemoryRegisterBank bank(16, 0, 0, 16);
+
+        bank.enable_persistence(BANK_PATH, 0_s);
+        check(!bank.load() && read_register(&bank, 0) == 0, "corrupt image is rejected");
+    }
+
+    unlink(BANK_PATH);
+    unlink(JOURNAL_PATH);
+
+    TFNetwork::logfln("%d failure(s)", failures);
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,280 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+// Mirror of a remote device over loopback connections. The remote device has
+// a hole in the mirrored block, that has to stay a hole for the mirror clients
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <functional>
+#include <Arduino.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFModbusTCPServer.h"
+#include "../src/TFModbusTCPClient.h"
+#include "../src/TFModbusTCPClientPool.h"
+#include "../src/TFModbusTCPMirror.h"
+#include "../src/TFModbusTCPMemoryRegisterBank.h"
+
+#define REMOTE_PORT 15512
+#define MIRROR_PORT 15513
+
+#define BLOCK_START_ADDRESS 40
+#define BLOCK_DATA_COUNT 30
+#define HOLE_START_ADDRESS 50
+#define HOLE_END_ADDRESS 53 // exclusive
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    TFNetwork::logfln("%s: %s", condition ? "PASS" : "FAIL", description);
+
+    if (!condition) {
+        ++failures;
+    }
+}
+
+static TFModbusTCPMemoryRegisterBank remote_bank(0, 0, 0, 100);
+static TFModbusTCPMemoryRegisterBank mirror_bank(0, 0, 0, 100);
+static TFModbusTCPServer remote_server(TFModbusTCPByteOrder::Host);
+static TFModbusTCPServer mirror_server(TFModbusTCPByteOrder::Host);
+static TFModbusTCPClientPool pool(TFModbusTCPByteOrder::Host);
+static TFModbusTCPMirror mirror(&mirror_server, &pool, &mirror_bank);
+static TFModbusTCPClient *client;
+static size_t remote_write_count = 0;
+
+static void tick()
+{
+    mirror_server.tick();
+    mirror.tick();
+    pool.tick();
+    remote_server.tick();
+    client->tick();
+}
+
+static bool tick_until(std::function<bool(void)> &&condition)
+{
+    micros_t deadline = calculate_deadline(3_s);
+
+    while (!condition()) {
+        if (deadline_elapsed(deadline)) {
+            return false;
+        }
+
+        tick();
+    }
+
+    return true;
+}
+
+static TFModbusTCPClientTransactionResult transact(TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, uint16_t *values)
+{
+    bool done                                 = false;
+    TFModbusTCPClientTransactionResult result = TFModbusTCPClientTransactionResult::Timeout;
+
+    client->transact(1, function_code, start_address, data_count, values, 1_s,
+    [&done, &result](TFModbusTCPClientTransactionResult transaction_result, const char *error_message) {
+        (void)error_message;
+
+        done   = true;
+        result = transaction_result;
+    });
+
+    tick_until([&done]() { return done; });
+
+    return result;
+}
+
+static bool check_read(uint16_t start_address, uint16_t data_count)
+{
+    uint16_t values[BLOCK_DATA_COUNT];
+
+    if (transact(TFModbusTCPFunctionCode::ReadHoldingRegisters, start_address, data_count, values) != TFModbusTCPClientTransactionResult::Success) {
+        return false;
+    }
+
+    for (uint16_t i = 0; i < data_count; ++i) {
+        if (values[i] != 1000 + start_address + i) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main()
+{
+    TFNetwork::vlogfln =
+    [](const char *format, va_list args) {
+        printf("%li | ", static_cast<int64_t>(now_us()));
+        vprintf(format, args);
+        puts("");
+    };
+
+    TFNetwork::resolve =
+    [](const char *host, TFNetworkResolveResultCallback &&callback) {
+        callback(inet_addr(host), 0);
+    };
+
+    TFNetwork::get_random_uint16 =
+    []() {
+        return static_cast<uint16_t>(rand());
+    };
+
+    for (uint16_t i = 0; i < 100; ++i) {
+        uint16_t value = 1000 + i;
+
+        remote_bank.write(TFModbusTCPDataType::HoldingRegister, i, 1, &value);
+    }
+
+    auto connect_callback = [](uint32_t peer_address, uint16_t port) {
+        (void)peer_address;
+        (void)port;
+    };
+
+    auto disconnect_callback = [](uint32_t peer_address, uint16_t port, TFModbusTCPServerDisconnectReason reason, int error_number) {
+        (void)peer_address;
+        (void)port;
+        (void)reason;
+        (void)error_number;
+    };
+
+    check(remote_server.start(htonl(INADDR_LOOPBACK), REMOTE_PORT, connect_callback, disconnect_callback,
+    [](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values) {
+        (void)unit_id;
+
+        if (start_address < HOLE_END_ADDRESS && start_address + data_count > HOLE_START_ADDRESS) {
+            return TFModbusTCPExceptionCode::IllegalDataAddress;
+        }
+
+        if (function_code == TFModbusTCPFunctionCode::WriteMultipleRegisters) {
+            ++remote_write_count;
+        }
+
+        return remote_bank.handle_request(function_code, start_address, data_count, data_values);
+    }), "start remote server");
+
+    check(mirror_server.start(htonl(INADDR_LOOPBACK), MIRROR_PORT, connect_callback, disconnect_callback,
+    [](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values) {
+        return mirror.handle_request(unit_id, function_code, start_address, data_count, data_values);
+    }), "start mirror server");
+
+    check(mirror.add_block(TFModbusTCPDataType::HoldingRegister, BLOCK_START_ADDRESS, BLOCK_DATA_COUNT, 100_ms), "add block");
+    check(mirror.start("127.0.0.1", REMOTE_PORT, 1), "start mirror");
+
+    bool connected = false;
+
+    client = new TFModbusTCPClient(TFModbusTCPByteOrder::Host);
+
+    client->connect("127.0.0.1", MIRROR_PORT,
+    [&connected](TFGenericTCPClientConnectResult result, int error_number) {
+        (void)error_number;
+
+        connected = result == TFGenericTCPClientConnectResult::Connected;
+    },
+    [&connected](TFGenericTCPClientDisconnectReason reason, int error_number) {
+        (void)reason;
+        (void)error_number;
+
+        connected = false;
+    });
+
+    check(tick_until([&connected]() { return connected; }), "client connected");
+
+    uint16_t values[BLOCK_DATA_COUNT];
+
+    // the block is polled by the first mirror tick, which happens before the
+    // request is handled. the poll is answered after the request
+    check(transact(TFModbusTCPFunctionCode::ReadHoldingRegisters, BLOCK_START_ADDRESS, 1, values) == TFModbusTCPClientTransactionResult::ModbusGatewayTargetDeviceFailedToRespond,
+          "read before the first poll is a target device failure");
+
+    micros_t deadline = calculate_deadline(3_s);
+    bool polled       = false;
+
+    while (!polled && !deadline_elapsed(deadline)) {
+        polled = transact(TFModbusTCPFunctionCode::ReadHoldingRegisters, BLOCK_START_ADDRESS, 1, values) == TFModbusTCPClientTransactionResult::Success;
+    }
+
+    check(polled && mirror.get_poll_error_count() == 0, "block with hole is polled without error");
+
+    check(check_read(BLOCK_START_ADDRESS, HOLE_START_ADDRESS - BLOCK_START_ADDRESS), "read below the hole");
+    check(check_read(HOLE_END_ADDRESS, BLOCK_START_ADDRESS + BLOCK_DATA_COUNT - HOLE_END_ADDRESS), "read above the hole");
+    check(transact(TFModbusTCPFunctionCode::ReadHoldingRegisters, HOLE_START_ADDRESS + 1, 1, values) == TFModbusTCPClientTransactionResult::ModbusIllegalDataAddress,
+          "read of the hole is an illegal data address");
+    check(transact(TFModbusTCPFunctionCode::ReadHoldingRegisters, BLOCK_START_ADDRESS, BLOCK_DATA_COUNT, values) == TFModbusTCPClientTransactionResult::ModbusIllegalDataAddress,
+          "read across the hole is an illegal data address");
+    check(transact(TFModbusTCPFunctionCode::ReadHoldingRegisters, BLOCK_START_ADDRESS + BLOCK_DATA_COUNT - 2, 4, values) == TFModbusTCPClientTransactionResult::ModbusIllegalDataAddress,
+          "read beyond the block is an illegal data address");
+
+    // writes are forwarded and visible to the next read
+    uint16_t write_value = 4321;
+
+    check(transact(TFModbusTCPFunctionCode::WriteMultipleRegisters, 60, 1, &write_value) == TFModbusTCPClientTransactionResult::Success && remote_write_count == 1,
+          "write is forwarded");
+
+    uint16_t remote_value = 0;
+
+    remote_bank.read(TFModbusTCPDataType::HoldingRegister, 60, 1, &remote_value);
+
+    check(transact(TFModbusTCPFunctionCode::ReadHoldingRegisters, 60, 1, values) == TFModbusTCPClientTransactionResult::Success && values[0] == 4321 && remote_value == 4321,
+          "written value is mirrored");
+
+    check(transact(TFModbusTCPFunctionCode::WriteMultipleRegisters, HOLE_START_ADDRESS, 1, &write_value) == TFModbusTCPClientTransactionResult::ModbusIllegalDataAddress,
+          "write exception of the remote device is passed on");
+
+    // polled values expire after the remote device stopped answering
+    mirror.set_max_age(300_ms);
+    remote_server.stop();
+
+    micros_t expired = calculate_deadline(500_ms);
+
+    tick_until([expired]() { return deadline_elapsed(expired); });
+
+    check(transact(TFModbusTCPFunctionCode::ReadHoldingRegisters, BLOCK_START_ADDRESS, 1, values) == TFModbusTCPClientTransactionResult::ModbusGatewayTargetDeviceFailedToRespond,
+          "expired values are a target device failure");
+
+    mirror.stop();
+    client->disconnect();
+    mirror_server.stop();
+
+    delete client;
+
+    TFNetwork::logfln("%d failure(s)", failures);
+
+    return failures > 0 ? 1 : 0;
+}
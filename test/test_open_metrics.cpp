@@ -0,0 +1,360 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+// Benchmark for the OpenMetrics renderer. Fills a client pool with
+// TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT connections to a local server,
+// runs some transactions over each of them and then measures the cost of
+// rendering all metrics in chunks. The output format is checked first, the
+// heap is checked to stay unchanged during rendering. Build with a large pool
+// and server, as in make.sh:
+//
+//   test_open_metrics [render-count] [chunk-size] [print]
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <Arduino.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFModbusTCPServer.h"
+#include "../src/TFModbusTCPClient.h"
+#include "../src/TFModbusTCPClientPool.h"
+#include "../src/TFModbusTCPMemoryRegisterBank.h"
+#include "../src/TFNetworkOpenMetrics.h"
+
+#define PORT 15505
+#define TRANSACTIONS_PER_SLOT 10
+#define MAX_CHUNK_SIZE 65536
+#define MAX_OUTPUT_SIZE (4 * 1024 * 1024)
+
+static int64_t real_now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return (static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec;
+}
+
+micros_t now_us()
+{
+    return micros_t{real_now_us()};
+}
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    printf("%s: %s\n", condition ? "PASS" : "FAIL", description);
+
+    if (!condition) {
+        ++failures;
+    }
+}
+
+static size_t count_occurrences(const char *haystack, const char *needle)
+{
+    size_t count = 0;
+
+    for (const char *p = strstr(haystack, needle); p != nullptr; p = strstr(p + 1, needle)) {
+        ++count;
+    }
+
+    return count;
+}
+
+// the lines have to appear in the given order, directly after each other
+static bool has_lines(const char *output, const char *lines)
+{
+    const char *p = strstr(output, lines);
+
+    return p != nullptr && (p == output || p[-1] == '\n');
+}
+
+static bool check_format(const char *output)
+{
+    int failures_before = failures;
+
+    check(count_occurrences(output, "# EOF\n") == 1 && strcmp(output + strlen(output) - 6, "# EOF\n") == 0, "output ends with a single # EOF line");
+
+    check(has_lines(output, "# TYPE tf_network_client_transactions counter\n"
+                            "# HELP tf_network_client_transactions Finished transactions by result\n"
+                            "tf_network_client_transactions_total{name=\"benchmark\",host=\"127.0.0.1\",port=\"15505\",result=\"success\"} 9\n"
+                            "tf_network_client_transactions_total{name=\"benchmark\",host=\"127.0.0.1\",port=\"15505\",result=\"exception\"} 1\n"),
+          "counter has TYPE and HELP lines and _total samples");
+
+    check(strstr(output, "\ntf_network_client_transactions{") == nullptr && strstr(output, "\ntf_network_server_connections{") == nullptr,
+          "counter samples never lack the _total suffix");
+
+    check(has_lines(output, "# TYPE tf_network_client_transaction_latency_seconds histogram\n"
+                            "# UNIT tf_network_client_transaction_latency_seconds seconds\n"
+                            "# HELP tf_network_client_transaction_latency_seconds Latency of sent transactions\n"),
+          "histogram has TYPE, UNIT and HELP lines");
+
+    char expected[128];
+
+    snprintf(expected, sizeof(expected), "tf_network_server_responses_total{name=\"benchmark\",result=\"exception\"} %d\n", TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT);
+    check(has_lines(output, expected), "server counter sums all slots");
+
+    // buckets are cumulative and end with +Inf, which equals the count
+    const char *bucket_prefix = "tf_network_client_transaction_latency_seconds_bucket{name=\"benchmark\",host=\"127.0.0.1\",port=\"15505\",le=\"";
+    size_t bucket_count       = 0;
+    unsigned long long last   = 0;
+    bool cumulative           = true;
+    bool inf_last             = false;
+
+    for (const char *p = strstr(output, bucket_prefix); p != nullptr; p = strstr(p + 1, bucket_prefix)) {
+        const char *le           = p + strlen(bucket_prefix);
+        const char *value        = strstr(le, "} ");
+        unsigned long long count = value != nullptr ? strtoull(value + 2, nullptr, 10) : 0;
+
+        cumulative &= count >= last;
+        inf_last    = strncmp(le, "+Inf\"", 5) == 0;
+        last        = count;
+
+        ++bucket_count;
+    }
+
+    check(bucket_count == TF_NETWORK_LATENCY_HISTOGRAM_BUCKET_COUNT + 1 && cumulative && inf_last && last == TRANSACTIONS_PER_SLOT,
+          "histogram buckets are cumulative and end with +Inf");
+    check(has_lines(output, "tf_network_client_transaction_latency_seconds_count{name=\"benchmark\",host=\"127.0.0.1\",port=\"15505\"} 10\n"),
+          "histogram count matches the +Inf bucket");
+
+    return failures == failures_before;
+}
+
+int main(int argc, char **argv)
+{
+    size_t render_count = argc > 1 ? strtoul(argv[1], nullptr, 0) : 1000;
+    size_t chunk_size   = argc > 2 ? strtoul(argv[2], nullptr, 0) : 4096;
+    bool print          = argc > 3 && strcmp(argv[3], "print") == 0;
+
+    if (chunk_size == 0 || chunk_size > MAX_CHUNK_SIZE) {
+        fprintf(stderr, "chunk size must be between 1 and %d\n", MAX_CHUNK_SIZE);
+        return 1;
+    }
+
+    TFNetwork::resolve =
+    [](const char *host, TFNetworkResolveResultCallback &&callback) {
+        callback(inet_addr(host), 0);
+    };
+
+    TFNetwork::get_random_uint16 =
+    []() {
+        return static_cast<uint16_t>(rand());
+    };
+
+    TFModbusTCPMemoryRegisterBank bank(0, 0, 0, 100);
+    TFModbusTCPServer server(TFModbusTCPByteOrder::Host);
+
+    // listen on all addresses, so that each 127.0.0.x host gets its own pool slot
+    if (!server.start(htonl(INADDR_ANY), PORT,
+    [](uint32_t peer_address, uint16_t port) {
+        (void)peer_address;
+        (void)port;
+    },
+    [](uint32_t peer_address, uint16_t port, TFModbusTCPServerDisconnectReason reason, int error_number) {
+        (void)peer_address;
+        (void)port;
+        (void)reason;
+        (void)error_number;
+    },
+    [&bank](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values) {
+        (void)unit_id;
+
+        return bank.handle_request(function_code, start_address, data_count, data_values);
+    })) {
+        fprintf(stderr, "could not start server\n");
+        return 1;
+    }
+
+    TFModbusTCPClientPool pool(TFModbusTCPByteOrder::Host);
+    static char hosts[TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT][16];
+    static TFModbusTCPSharedClient *clients[TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT];
+    static uint16_t values[TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT][10];
+    size_t connected_count = 0;
+    size_t failed_count    = 0;
+
+    // connect one after the other, so that the listen backlog of the server
+    // does not overflow
+    for (size_t i = 0; i < TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT; ++i) {
+        snprintf(hosts[i], sizeof(hosts[i]), "127.0.%u.%u", static_cast<unsigned>((i + 1) / 256), static_cast<unsigned>((i + 1) % 256));
+
+        pool.acquire(hosts[i], PORT,
+        [i, &connected_count, &failed_count](TFGenericTCPClientConnectResult result, int error_number, TFGenericTCPSharedClient *shared_client, TFGenericTCPClientPoolShareLevel level) {
+            (void)error_number;
+            (void)level;
+
+            if (result == TFGenericTCPClientConnectResult::Connected) {
+                clients[i] = static_cast<TFModbusTCPSharedClient *>(shared_client);
+                ++connected_count;
+            }
+            else {
+                ++failed_count;
+            }
+        },
+        [](TFGenericTCPClientDisconnectReason reason, int error_number, TFGenericTCPSharedClient *shared_client, TFGenericTCPClientPoolShareLevel level) {
+            (void)reason;
+            (void)error_number;
+            (void)shared_client;
+            (void)level;
+        });
+
+        while (failed_count == 0 && (connected_count < i + 1 || server.get_client_count() < i + 1)) {
+            server.tick();
+            pool.tick();
+        }
+
+        if (failed_count > 0) {
+            fprintf(stderr, "could not connect to %s\n", hosts[i]);
+            return 1;
+        }
+    }
+
+    // fill the counters and latency histograms, including some exceptions
+    size_t finished_count = 0;
+
+    for (size_t round = 0; round < TRANSACTIONS_PER_SLOT; ++round) {
+        for (size_t i = 0; i < TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT; ++i) {
+            uint16_t start_address = round == 0 ? 1000 : 0;
+
+            clients[i]->transact(1, TFModbusTCPFunctionCode::ReadHoldingRegisters, start_address, 10, values[i], 1_s,
+            [&finished_count](TFModbusTCPClientTransactionResult result, const char *error_message) {
+                (void)result;
+                (void)error_message;
+
+                ++finished_count;
+            });
+        }
+
+        while (finished_count < (round + 1) * TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT) {
+            server.tick();
+            pool.tick();
+        }
+    }
+
+    TFNetworkOpenMetricsRenderer renderer;
+
+    renderer.add_pool(&pool, "benchmark");
+    renderer.add_server(&server, "benchmark");
+
+    static char chunk[MAX_CHUNK_SIZE];
+    static char output[MAX_OUTPUT_SIZE];
+    size_t output_length = 0;
+
+    renderer.begin();
+
+    for (;;) {
+        ssize_t length = renderer.render(chunk, chunk_size);
+
+        if (length <= 0 || output_length + static_cast<size_t>(length) >= sizeof(output)) {
+            check(length == 0, "output fits into the chunks");
+            break;
+        }
+
+        memcpy(output + output_length, chunk, static_cast<size_t>(length));
+        output_length += static_cast<size_t>(length);
+    }
+
+    output[output_length] = '\0';
+
+    if (!check_format(output)) {
+        return 1;
+    }
+
+    // a line that does not fit into an empty chunk fails the pass
+    TFNetworkOpenMetricsRenderer long_renderer;
+    static char long_name[MAX_CHUNK_SIZE + 1];
+
+    memset(long_name, 'x', sizeof(long_name) - 1);
+    long_renderer.add_server(&server, long_name);
+    long_renderer.begin();
+
+    ssize_t long_length = 0;
+
+    do {
+        long_length = long_renderer.render(chunk, chunk_size);
+    } while (long_length > 0);
+
+    check(long_length < 0 && errno == ENOBUFS && long_renderer.render(chunk, chunk_size) == 0, "line longer than the chunk fails the render");
+
+    if (failures > 0) {
+        return 1;
+    }
+
+    printf("slots: %zu, renders: %zu, chunk size: %zu\n", pool.get_slot_count(), render_count, chunk_size); // allocates the stdout buffer
+
+    size_t chunk_count = 0;
+    size_t heap_before = mallinfo2().uordblks;
+    int64_t start_us   = real_now_us();
+
+    for (size_t i = 0; i < render_count; ++i) {
+        renderer.begin();
+
+        output_length = 0;
+        chunk_count   = 0;
+
+        for (;;) {
+            ssize_t length = renderer.render(chunk, chunk_size);
+
+            if (length <= 0) {
+                break;
+            }
+
+            if (print && i == 0) {
+                fwrite(chunk, 1, static_cast<size_t>(length), stdout);
+            }
+
+            output_length += static_cast<size_t>(length);
+            ++chunk_count;
+        }
+    }
+
+    int64_t elapsed_us = real_now_us() - start_us;
+    size_t heap_after  = mallinfo2().uordblks;
+
+    printf("output: %zu bytes in %zu chunks\n", output_length, chunk_count);
+    printf("render: %.1f us, %.1f ns per byte\n",
+           static_cast<double>(elapsed_us) / static_cast<double>(render_count),
+           static_cast<double>(elapsed_us) * 1000.0 / static_cast<double>(render_count * output_length));
+    printf("heap: %zu bytes before, %zu bytes after\n", heap_before, heap_after);
+
+    for (size_t i = 0; i < TF_GENERIC_TCP_CLIENT_POOL_MAX_SLOT_COUNT; ++i) {
+        pool.release(clients[i]);
+    }
+
+    server.stop();
+
+    if (heap_after != heap_before) {
+        printf("heap changed during rendering\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -21,7 +21,6 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <time.h>
-#include <netdb.h>
 #include <unistd.h>
 #include <signal.h>
 #include <sys/random.h>
@@ -29,6 +28,7 @@
 #include "../src/TFNetwork.h"
 #include "../src/TFModbusTCPClient.h"
 #include "../src/TFModbusTCPClientPool.h"
+#include "../src/TFNetworkResolver.h"
 
 micros_t now_us()
 {
@@ -64,16 +64,16 @@ int main()
         puts("");
     };
 
-    TFNetwork::resolve =
-    [](const char *host, std::function<void(uint32_t host_address, int error_number)> &&callback) {
-        hostent *result = gethostbyname(host);
+    TFNetworkResolver resolver;
 
-        if (result == nullptr) {
-            callback(0, h_errno);
-        }
-        else {
-            callback(((struct in_addr *)result->h_addr)->s_addr, 0);
-        }
+    if (!resolver.start()) {
+        TFNetwork::logfln("could not start resolver");
+        return 1;
+    }
+
+    TFNetwork::resolve =
+    [&resolver](const char *host, std::function<void(uint32_t host_address, int error_number)> &&callback) {
+        resolver.resolve(host, std::move(callback));
     };
 
     TFNetwork::get_random_uint16 =
@@ -199,6 +199,8 @@ int main()
     next_reconnect = calculate_deadline(5_s);
 
     while (running > 0) {
+        resolver.tick();
+
         if (client_ptr1 != nullptr && next_reconnect >= 0_s && deadline_elapsed(next_reconnect)) {
             next_reconnect = -1_s;
 
@@ -0,0 +1,649 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+// Reads of the RCT power client over a loopback connection to a plain socket
+// peer that answers every request like an inverter would. The peer answers
+// from the main loop, either directly, after a delay or not at all
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <Arduino.h>
+#include <TFTools/Micros.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFRCTPowerClient.h"
+
+#define PORT 15526
+#define MAX_PEER_RESPONSE_COUNT 16
+#define MAX_PEER_REQUEST_COUNT 256
+
+#define ID_CONSTANT 0x2B2D0001 // contains the start and escape byte
+#define ID_COUNTER  0x10000002 // answers the number of requests for this ID
+#define ID_SLOW     0x10000003 // answered after the slow delay
+#define ID_NOISY    0x10000004 // noise within the deadband, unless stepped
+#define ID_FLAKY    0x10000005 // no answer while silent
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    TFNetwork::logfln("%s: %s", condition ? "PASS" : "FAIL", description);
+
+    if (!condition) {
+        ++failures;
+    }
+}
+
+static uint16_t crc16ccitt(const uint8_t *buffer, size_t length)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (size_t i = 0; i < length; ++i) {
+        crc ^= static_cast<uint16_t>(buffer[i] << 8);
+
+        for (int k = 0; k < 8; ++k) {
+            crc = (crc & 0x8000) != 0 ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+struct PeerRequest
+{
+    uint32_t id;
+    micros_t received;
+};
+
+struct PeerResponse
+{
+    uint32_t id;
+    float value;
+    micros_t due;
+};
+
+static int listen_fd = -1;
+static int peer_fd   = -1;
+static uint8_t peer_frame[16];
+static size_t peer_frame_length;
+static bool peer_in_frame;
+static bool peer_escaped;
+static PeerRequest peer_requests[MAX_PEER_REQUEST_COUNT];
+static size_t peer_request_count;
+static PeerResponse peer_responses[MAX_PEER_RESPONSE_COUNT];
+static size_t peer_response_count;
+static micros_t peer_slow_delay;
+static bool peer_silent;
+static bool peer_stepped;
+
+static size_t count_requests(uint32_t id, size_t first = 0)
+{
+    size_t count = 0;
+
+    for (size_t i = first; i < peer_request_count && i < MAX_PEER_REQUEST_COUNT; ++i) {
+        if (peer_requests[i].id == id) {
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+static void peer_send_response(uint32_t id, float value)
+{
+    uint8_t frame[12];
+    uint32_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+
+    frame[0] = 5;
+    frame[1] = 8;
+    frame[2] = static_cast<uint8_t>(id >> 24);
+    frame[3] = static_cast<uint8_t>(id >> 16);
+    frame[4] = static_cast<uint8_t>(id >> 8);
+    frame[5] = static_cast<uint8_t>(id);
+    frame[6] = static_cast<uint8_t>(bits >> 24);
+    frame[7] = static_cast<uint8_t>(bits >> 16);
+    frame[8] = static_cast<uint8_t>(bits >> 8);
+    frame[9] = static_cast<uint8_t>(bits);
+
+    uint16_t crc = crc16ccitt(frame, 10);
+
+    frame[10] = static_cast<uint8_t>(crc >> 8);
+    frame[11] = static_cast<uint8_t>(crc);
+
+    uint8_t escaped[1 + 2 * sizeof(frame)];
+    size_t escaped_length = 0;
+
+    escaped[escaped_length++] = '+';
+
+    for (size_t i = 0; i < sizeof(frame); ++i) {
+        if (frame[i] == '+' || frame[i] == '-') {
+            escaped[escaped_length++] = '-';
+        }
+
+        escaped[escaped_length++] = frame[i];
+    }
+
+    if (send(peer_fd, escaped, escaped_length, 0) != static_cast<ssize_t>(escaped_length)) {
+        TFNetwork::logfln("peer could not send response: %s (%d)", strerror(errno), errno);
+    }
+}
+
+static void peer_handle_request()
+{
+    if (peer_frame[0] != 1 || peer_frame[1] != 4 || crc16ccitt(peer_frame, 6) != ((peer_frame[6] << 8) | peer_frame[7])) {
+        TFNetwork::logfln("peer received malformed request");
+        return;
+    }
+
+    uint32_t id = (static_cast<uint32_t>(peer_frame[2]) << 24)
+                | (static_cast<uint32_t>(peer_frame[3]) << 16)
+                | (static_cast<uint32_t>(peer_frame[4]) << 8)
+                |  static_cast<uint32_t>(peer_frame[5]);
+
+    if (peer_request_count < MAX_PEER_REQUEST_COUNT) {
+        peer_requests[peer_request_count].id       = id;
+        peer_requests[peer_request_count].received = now_us();
+    }
+
+    ++peer_request_count;
+
+    if (id == ID_FLAKY && peer_silent) {
+        return;
+    }
+
+    float value;
+    micros_t delay = 0_s;
+
+    switch (id) {
+    case ID_COUNTER:
+        value = static_cast<float>(count_requests(ID_COUNTER));
+        break;
+
+    case ID_NOISY:
+        value = (peer_stepped ? 20.0f : 10.0f) + static_cast<float>(peer_request_count % 2) * 0.01f;
+        break;
+
+    case ID_SLOW:
+        value = 5.0f;
+        delay = peer_slow_delay;
+        break;
+
+    default:
+        value = 1.0f;
+        break;
+    }
+
+    if (peer_response_count >= MAX_PEER_RESPONSE_COUNT) {
+        TFNetwork::logfln("peer has too many delayed responses");
+        return;
+    }
+
+    peer_responses[peer_response_count].id    = id;
+    peer_responses[peer_response_count].value = value;
+    peer_responses[peer_response_count].due   = now_us() + delay;
+
+    ++peer_response_count;
+}
+
+// Accepts the connection, reads requests and sends due responses
+static void peer_tick()
+{
+    if (peer_fd < 0) {
+        peer_fd = accept(listen_fd, nullptr, nullptr);
+
+        if (peer_fd < 0) {
+            return;
+        }
+
+        int flag = 1;
+
+        setsockopt(peer_fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+        fcntl(peer_fd, F_SETFL, fcntl(peer_fd, F_GETFL, 0) | O_NONBLOCK);
+
+        peer_in_frame       = false;
+        peer_escaped        = false;
+        peer_response_count = 0;
+    }
+
+    uint8_t buffer[64];
+    ssize_t length = recv(peer_fd, buffer, sizeof(buffer), 0);
+
+    for (ssize_t i = 0; i < length; ++i) {
+        uint8_t byte = buffer[i];
+
+        if (!peer_escaped && byte == '+') {
+            peer_in_frame     = true;
+            peer_frame_length = 0;
+            continue;
+        }
+
+        if (!peer_in_frame) {
+            continue;
+        }
+
+        if (!peer_escaped && byte == '-') {
+            peer_escaped = true;
+            continue;
+        }
+
+        peer_escaped                    = false;
+        peer_frame[peer_frame_length++] = byte;
+
+        if (peer_frame_length == 8) {
+            peer_in_frame = false;
+
+            peer_handle_request();
+        }
+    }
+
+    for (size_t i = 0; i < peer_response_count; ) {
+        if (now_us() >= peer_responses[i].due) {
+            peer_send_response(peer_responses[i].id, peer_responses[i].value);
+
+            peer_responses[i] = peer_responses[--peer_response_count];
+        }
+        else {
+            ++i;
+        }
+    }
+}
+
+static TFRCTPowerClient *client;
+
+static void tick(micros_t duration)
+{
+    micros_t deadline = calculate_deadline(duration);
+
+    while (!deadline_elapsed(deadline)) {
+        client->tick();
+        peer_tick();
+    }
+}
+
+static void tick_until(std::function<bool(void)> &&condition)
+{
+    micros_t deadline = calculate_deadline(2_s);
+
+    while (!condition() && !deadline_elapsed(deadline)) {
+        client->tick();
+        peer_tick();
+    }
+}
+
+static bool connect_client()
+{
+    bool connected = false;
+
+    client->connect("127.0.0.1", PORT,
+    [&connected](TFGenericTCPClientConnectResult result, int error_number) {
+        (void)error_number;
+
+        connected = result == TFGenericTCPClientConnectResult::Connected;
+    },
+    [](TFGenericTCPClientDisconnectReason reason, int error_number) {
+        (void)reason;
+        (void)error_number;
+    });
+
+    tick_until([&connected]() { return connected && peer_fd >= 0; });
+
+    return connected && peer_fd >= 0;
+}
+
+static void disconnect_client()
+{
+    client->disconnect();
+    close(peer_fd);
+
+    peer_fd = -1;
+}
+
+struct PollRecord
+{
+    size_t count;
+    TFRCTPowerClientTransactionResult result;
+    float value;
+    size_t failure_count;
+};
+
+static TFRCTPowerClientPollCallback record_poll(PollRecord *record)
+{
+    *record = PollRecord{};
+
+    return [record](uint32_t id, TFRCTPowerClientTransactionResult result, float value) {
+        (void)id;
+
+        ++record->count;
+        record->result = result;
+        record->value  = value;
+
+        if (result != TFRCTPowerClientTransactionResult::Success) {
+            ++record->failure_count;
+        }
+    };
+}
+
+int main()
+{
+    TFNetwork::vlogfln =
+    [](const char *format, va_list args) {
+        printf("%li | ", static_cast<int64_t>(now_us()));
+        vprintf(format, args);
+        puts("");
+    };
+
+    TFNetwork::resolve =
+    [](const char *host, TFNetworkResolveResultCallback &&callback) {
+        callback(inet_addr(host), 0);
+    };
+
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    int flag = 1;
+    struct sockaddr_in address;
+
+    memset(&address, 0, sizeof(address));
+
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(PORT);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+
+    if (bind(listen_fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) < 0 || listen(listen_fd, 4) < 0) {
+        TFNetwork::logfln("could not listen: %s (%d)", strerror(errno), errno);
+        return 1;
+    }
+
+    fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL, 0) | O_NONBLOCK);
+
+    client = new TFRCTPowerClient();
+
+    check(connect_client(), "connect");
+
+    // reads of the same ID scheduled together share one request
+    size_t done = 0;
+    size_t success_count = 0;
+    float values[4];
+
+    for (size_t i = 0; i < 4; ++i) {
+        client->read(i < 3 ? ID_CONSTANT : ID_COUNTER, 1_s, [&done, &success_count, &values, i](TFRCTPowerClientTransactionResult result, float value) {
+            success_count += result == TFRCTPowerClientTransactionResult::Success ? 1 : 0;
+            values[i] = value;
+            ++done;
+        });
+    }
+
+    tick_until([&done]() { return done == 4; });
+    check(success_count == 4 && values[0] == 1.0f && values[2] == 1.0f && values[3] == 1.0f, "dedup: all reads succeed, escaped ID is answered");
+    check(peer_request_count == 2, "dedup: scheduled reads of the same ID send one request");
+
+    // a read of the ID of the pending request joins it
+    size_t first_request = peer_request_count;
+
+    peer_slow_delay = 50_ms;
+    done            = 0;
+    success_count   = 0;
+
+    client->read(ID_SLOW, 1_s, [&done, &success_count](TFRCTPowerClientTransactionResult result, float value) {
+        success_count += result == TFRCTPowerClientTransactionResult::Success && value == 5.0f ? 1 : 0;
+        ++done;
+    });
+
+    tick_until([first_request]() { return peer_request_count > first_request; });
+
+    client->read(ID_SLOW, 1_s, [&done, &success_count](TFRCTPowerClientTransactionResult result, float value) {
+        success_count += result == TFRCTPowerClientTransactionResult::Success && value == 5.0f ? 1 : 0;
+        ++done;
+    });
+
+    check(done == 0, "dedup: read joining the pending request waits for its response");
+    tick_until([&done]() { return done == 2; });
+    check(success_count == 2 && count_requests(ID_SLOW, first_request) == 1, "dedup: read joining the pending request shares its response");
+
+    // joined reads count toward the scheduled transaction limit
+    size_t rejected_count = 0;
+
+    first_request = peer_request_count;
+    done          = 0;
+    success_count = 0;
+
+    for (size_t i = 0; i < TF_RCT_POWER_CLIENT_MAX_SCHEDULED_TRANSACTION_COUNT + 2; ++i) {
+        client->read(ID_SLOW, 1_s, [&done, &success_count, &rejected_count](TFRCTPowerClientTransactionResult result, float value) {
+            (void)value;
+
+            success_count  += result == TFRCTPowerClientTransactionResult::Success ? 1 : 0;
+            rejected_count += result == TFRCTPowerClientTransactionResult::NoTransactionAvailable ? 1 : 0;
+            ++done;
+        });
+    }
+
+    check(done == 2 && rejected_count == 2, "limit: reads beyond the limit are rejected directly");
+    tick_until([&done]() { return done == TF_RCT_POWER_CLIENT_MAX_SCHEDULED_TRANSACTION_COUNT + 2; });
+    check(success_count == TF_RCT_POWER_CLIENT_MAX_SCHEDULED_TRANSACTION_COUNT && count_requests(ID_SLOW, first_request) == 1,
+          "limit: joined reads within the limit share one request");
+
+    // cached values are answered without a request until the TTL expires
+    float value = NAN;
+
+    client->set_value_cache_ttl(300_ms);
+
+    done = 0;
+
+    client->read(ID_COUNTER, 1_s, [&done, &value](TFRCTPowerClientTransactionResult result, float value_) {
+        (void)result;
+
+        value = value_;
+        ++done;
+    });
+
+    tick_until([&done]() { return done == 1; });
+
+    size_t request_count = peer_request_count;
+
+    client->read(ID_COUNTER, 1_s, [&done, &value](TFRCTPowerClientTransactionResult result, float value_) {
+        ++done;
+
+        if (result != TFRCTPowerClientTransactionResult::Success || value_ != value) {
+            value = NAN;
+        }
+    });
+
+    check(done == 2 && value == 2.0f && peer_request_count == request_count, "cache: read within the TTL is answered directly");
+
+    tick(350_ms);
+
+    client->read(ID_COUNTER, 1_s, [&done, &value](TFRCTPowerClientTransactionResult result, float value_) {
+        (void)result;
+
+        value = value_;
+        ++done;
+    });
+
+    check(done == 2, "cache: read after the TTL is not answered directly");
+    tick_until([&done]() { return done == 3; });
+    check(value == 3.0f && peer_request_count == request_count + 1, "cache: read after the TTL sends a request");
+
+    // the cache is cleared on disconnect
+    disconnect_client();
+    check(connect_client(), "cache: reconnect");
+
+    request_count = peer_request_count;
+
+    client->read(ID_COUNTER, 1_s, [&done, &value](TFRCTPowerClientTransactionResult result, float value_) {
+        (void)result;
+
+        value = value_;
+        ++done;
+    });
+
+    check(done == 3, "cache: read after reconnecting is not answered directly");
+    tick_until([&done]() { return done == 4; });
+    check(value == 4.0f && peer_request_count == request_count + 1, "cache: read after reconnecting sends a request");
+
+    // poll plan, each ID is read at its own period
+    PollRecord constant_record;
+    PollRecord counter_record;
+
+    client->set_value_cache_ttl(0_s);
+
+    first_request = peer_request_count;
+
+    check(!client->add_poll(ID_CONSTANT, 0_s, record_poll(&constant_record)), "poll plan: poll without period is rejected");
+    check(client->add_poll(ID_CONSTANT, 50_ms, record_poll(&constant_record)) && client->add_poll(ID_COUNTER, 100_ms, record_poll(&counter_record)), "poll plan: add polls");
+    tick(1_s);
+    check(client->remove_poll(ID_CONSTANT) && client->remove_poll(ID_COUNTER) && !client->remove_poll(ID_COUNTER), "poll plan: remove polls");
+
+    size_t constant_count = count_requests(ID_CONSTANT, first_request);
+    size_t counter_count  = count_requests(ID_COUNTER, first_request);
+
+    check(constant_count >= 18 && constant_count <= 21 && counter_count >= 9 && counter_count <= 11, "poll plan: IDs are read at their period");
+
+    // a poll read that was outstanding during its removal has no callback
+    check(constant_record.count == 1 && counter_record.count + 1 >= counter_count && counter_record.count <= counter_count,
+          "poll plan: callback for every changed value only");
+
+    request_count = peer_request_count;
+
+    tick(200_ms);
+    check(peer_request_count == request_count, "poll plan: removed polls are not read anymore");
+
+    // changes within the deadband are not reported
+    PollRecord noisy_record;
+
+    first_request = peer_request_count;
+
+    client->add_poll(ID_NOISY, 50_ms, record_poll(&noisy_record), 0.5f);
+    tick(500_ms);
+    check(count_requests(ID_NOISY, first_request) >= 8 && noisy_record.count == 1 && noisy_record.value < 11.0f, "deadband: noise within the deadband is not reported");
+
+    peer_stepped = true;
+
+    tick(200_ms);
+    check(noisy_record.count == 2 && noisy_record.value >= 20.0f, "deadband: change beyond the deadband is reported");
+    client->remove_poll(ID_NOISY);
+
+    // a run of failed reads is reported once
+    PollRecord flaky_record;
+
+    client->add_poll(ID_FLAKY, 50_ms, record_poll(&flaky_record), 0.0f, 30_ms);
+    tick(200_ms);
+    check(flaky_record.count == 1 && flaky_record.result == TFRCTPowerClientTransactionResult::Success, "failure run: first value is reported");
+
+    first_request = peer_request_count;
+    peer_silent   = true;
+
+    tick(500_ms);
+    check(count_requests(ID_FLAKY, first_request) >= 5 && flaky_record.count == 2 && flaky_record.result == TFRCTPowerClientTransactionResult::Timeout,
+          "failure run: run of timeouts is reported once");
+
+    peer_silent = false;
+
+    tick(200_ms);
+    check(flaky_record.count == 3 && flaky_record.result == TFRCTPowerClientTransactionResult::Success, "failure run: recovery is reported");
+
+    peer_silent = true;
+
+    tick(300_ms);
+    check(flaky_record.count == 4 && flaky_record.failure_count == 2, "failure run: next run of timeouts is reported once");
+
+    peer_silent = false;
+
+    client->remove_poll(ID_FLAKY);
+    tick(50_ms);
+
+    // a poll delayed by the slow response of another poll keeps its phase.
+    // Without the phase every delay would shift all following reads
+    PollRecord slow_record;
+
+    first_request   = peer_request_count;
+    peer_slow_delay = 0_s;
+
+    client->add_poll(ID_SLOW, 300_ms, record_poll(&slow_record));
+    client->add_poll(ID_CONSTANT, 100_ms, record_poll(&constant_record));
+    tick_until([first_request]() { return count_requests(ID_SLOW, first_request) > 0; });
+
+    peer_slow_delay = 40_ms;
+
+    tick(1_s);
+    client->remove_poll(ID_SLOW);
+    client->remove_poll(ID_CONSTANT);
+
+    micros_t first_read = -1_s;
+    size_t in_phase_count = 0;
+    size_t delayed_count  = 0;
+
+    for (size_t i = first_request; i < peer_request_count && i < MAX_PEER_REQUEST_COUNT; ++i) {
+        if (peer_requests[i].id != ID_CONSTANT) {
+            continue;
+        }
+
+        if (first_read < 0_s) {
+            first_read = peer_requests[i].received;
+            continue;
+        }
+
+        int64_t offset = static_cast<int64_t>(peer_requests[i].received - first_read) % 100000;
+
+        if (offset < 10000 || offset > 90000) {
+            ++in_phase_count;
+        }
+        else if (offset > 30000 && offset < 50000) {
+            ++delayed_count;
+        }
+    }
+
+    check(delayed_count >= 2, "phase: slow poll delays the other poll");
+    check(in_phase_count >= 5, "phase: delayed poll returns to its phase");
+
+    disconnect_client();
+    delete client;
+    close(listen_fd);
+
+    TFNetwork::logfln("%d failure(s)", failures);
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,243 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+// Read planner: holes are found by bisection, adjacent holes are merged, the
+// oldest hole is forgotten if the table is full and known holes are skipped
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <Arduino.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFModbusTCPServer.h"
+#include "../src/TFModbusTCPClient.h"
+#include "../src/TFModbusTCPReadPlanner.h"
+
+#define PORT 15518
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    TFNetwork::logfln("%s: %s", condition ? "PASS" : "FAIL", description);
+
+    if (!condition) {
+        ++failures;
+    }
+}
+
+static TFModbusTCPServer server(TFModbusTCPByteOrder::Host);
+static TFModbusTCPClient *client;
+static TFModbusTCPReadPlanner planner;
+static size_t request_count = 0;
+
+// the device rejects single addresses inside of otherwise readable blocks
+static bool is_device_hole(uint32_t address)
+{
+    return address == 105 || address == 106 || address == 120 || (address >= 1000 && address < 1200 && address % 4 == 0);
+}
+
+static bool tick_until(bool *condition)
+{
+    micros_t deadline = calculate_deadline(3_s);
+
+    while (!*condition) {
+        if (deadline_elapsed(deadline)) {
+            return false;
+        }
+
+        server.tick();
+        client->tick();
+    }
+
+    return true;
+}
+
+static bool read(uint16_t start_address, uint16_t data_count, uint16_t *values, uint8_t *hole_mask)
+{
+    bool done                                 = false;
+    TFModbusTCPClientTransactionResult result = TFModbusTCPClientTransactionResult::Timeout;
+
+    request_count = 0;
+
+    planner.read(client, 1, TFModbusTCPFunctionCode::ReadHoldingRegisters, start_address, data_count, values, 1_s,
+    [&done, &result](TFModbusTCPClientTransactionResult transaction_result, const char *error_message) {
+        (void)error_message;
+
+        done   = true;
+        result = transaction_result;
+    },
+    hole_mask);
+
+    return tick_until(&done) && result == TFModbusTCPClientTransactionResult::Success;
+}
+
+static bool check_values(uint16_t start_address, uint16_t data_count, const uint16_t *values, const uint8_t *hole_mask)
+{
+    for (uint16_t i = 0; i < data_count; ++i) {
+        bool hole = is_device_hole(start_address + i);
+
+        if (values[i] != (hole ? 0 : start_address + i) || (((hole_mask[i / 8] >> (i % 8)) & 1) != 0) != hole) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool check_hole(size_t index, uint16_t start_address, uint16_t data_count)
+{
+    const TFModbusTCPReadPlannerHole *hole = planner.get_hole(index);
+
+    return hole != nullptr
+        && hole->unit_id == 1
+        && hole->function_code == TFModbusTCPFunctionCode::ReadHoldingRegisters
+        && hole->start_address == start_address
+        && hole->data_count == data_count;
+}
+
+int main()
+{
+    TFNetwork::vlogfln =
+    [](const char *format, va_list args) {
+        printf("%li | ", static_cast<int64_t>(now_us()));
+        vprintf(format, args);
+        puts("");
+    };
+
+    TFNetwork::resolve =
+    [](const char *host, TFNetworkResolveResultCallback &&callback) {
+        callback(inet_addr(host), 0);
+    };
+
+    TFNetwork::get_random_uint16 =
+    []() {
+        return static_cast<uint16_t>(rand());
+    };
+
+    check(server.start(htonl(INADDR_LOOPBACK), PORT,
+    [](uint32_t peer_address, uint16_t port) {
+        (void)peer_address;
+        (void)port;
+    },
+    [](uint32_t peer_address, uint16_t port, TFModbusTCPServerDisconnectReason reason, int error_number) {
+        (void)peer_address;
+        (void)port;
+        (void)reason;
+        (void)error_number;
+    },
+    [](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values) {
+        (void)unit_id;
+
+        ++request_count;
+
+        if (function_code != TFModbusTCPFunctionCode::ReadHoldingRegisters) {
+            return TFModbusTCPExceptionCode::IllegalFunction;
+        }
+
+        for (uint16_t i = 0; i < data_count; ++i) {
+            if (is_device_hole(start_address + i)) {
+                return TFModbusTCPExceptionCode::IllegalDataAddress;
+            }
+
+            uint16_t value = start_address + i;
+
+            memcpy(static_cast<uint8_t *>(data_values) + i * 2, &value, 2); // register values are packed
+        }
+
+        return TFModbusTCPExceptionCode::Success;
+    }), "start server");
+
+    client = new TFModbusTCPClient(TFModbusTCPByteOrder::Host);
+
+    bool connected = false;
+
+    client->connect("127.0.0.1", PORT,
+    [&connected](TFGenericTCPClientConnectResult result, int error_number) {
+        (void)error_number;
+
+        connected = result == TFGenericTCPClientConnectResult::Connected;
+    },
+    [&connected](TFGenericTCPClientDisconnectReason reason, int error_number) {
+        (void)reason;
+        (void)error_number;
+
+        connected = false;
+    });
+
+    check(tick_until(&connected), "client connected");
+
+    static uint16_t values[200];
+    static uint8_t hole_mask[25];
+
+    memset(hole_mask, 0xAA, sizeof(hole_mask));
+
+    check(read(100, 64, values, hole_mask), "first read succeeds");
+    check(check_values(100, 64, values, hole_mask), "first read values and hole mask");
+    check(request_count > 3, "first read bisects the block");
+    check(planner.get_hole_count() == 2, "two holes known after the first read");
+    check(check_hole(0, 105, 2), "adjacent holes are merged");
+    check(check_hole(1, 120, 1), "single hole");
+    check(planner.get_hole(2) == nullptr, "no third hole");
+
+    memset(values, 0xAA, sizeof(values));
+    memset(hole_mask, 0xAA, sizeof(hole_mask));
+
+    check(read(100, 64, values, hole_mask), "second read succeeds");
+    check(check_values(100, 64, values, hole_mask), "second read values and hole mask");
+    check(request_count == 3, "second read skips the known holes");
+    check(planner.get_hole_count() == 2, "still two holes known after the second read");
+
+    // 50 holes do not fit into the table, the oldest ones are forgotten
+    memset(hole_mask, 0xAA, sizeof(hole_mask));
+
+    check(read(1000, 200, values, hole_mask), "read with many holes succeeds");
+    check(check_values(1000, 200, values, hole_mask), "values and hole mask with many holes");
+    check(planner.get_hole_count() == TF_MODBUS_TCP_READ_PLANNER_MAX_HOLE_COUNT, "hole table is full");
+    check(!planner.is_hole(1, TFModbusTCPFunctionCode::ReadHoldingRegisters, 105), "oldest hole is forgotten");
+    check(planner.is_hole(1, TFModbusTCPFunctionCode::ReadHoldingRegisters, 1196), "newest hole is known");
+    check(!planner.is_hole(2, TFModbusTCPFunctionCode::ReadHoldingRegisters, 1196), "holes are per unit");
+
+    client->disconnect();
+    server.stop();
+
+    delete client;
+
+    TFNetwork::logfln("%d failure(s)", failures);
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,407 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+// Read views: the decode helpers, in-place clearing of coil padding bits sent
+// by a sloppy device and dropping of write shadow entries by view reads
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <Arduino.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFModbusTCPServer.h"
+#include "../src/TFModbusTCPClient.h"
+
+#define PORT 15523
+#define PEER_PORT 15524
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    TFNetwork::logfln("%s: %s", condition ? "PASS" : "FAIL", description);
+
+    if (!condition) {
+        ++failures;
+    }
+}
+
+static TFModbusTCPServer server(TFModbusTCPByteOrder::Host);
+static TFModbusTCPClient *client;
+static uint16_t registers[100];
+static bool coils[100];
+static size_t write_count = 0;
+
+static bool tick_until(std::function<bool(void)> &&condition)
+{
+    micros_t deadline = calculate_deadline(3_s);
+
+    while (!condition()) {
+        if (deadline_elapsed(deadline)) {
+            return false;
+        }
+
+        server.tick();
+        client->tick();
+    }
+
+    return true;
+}
+
+static bool connect(uint16_t port)
+{
+    bool connected = false;
+
+    client->connect("127.0.0.1", port,
+    [&connected](TFGenericTCPClientConnectResult result, int error_number) {
+        (void)error_number;
+
+        connected = result == TFGenericTCPClientConnectResult::Connected;
+    },
+    [](TFGenericTCPClientDisconnectReason reason, int error_number) {
+        (void)reason;
+        (void)error_number;
+    });
+
+    return tick_until([&connected]() { return connected; });
+}
+
+static TFModbusTCPClientTransactionResult write_register(uint16_t address, uint16_t value)
+{
+    bool done                                 = false;
+    TFModbusTCPClientTransactionResult result = TFModbusTCPClientTransactionResult::Timeout;
+
+    client->transact(1, TFModbusTCPFunctionCode::WriteSingleRegister, address, 1, &value, 1_s,
+    [&done, &result](TFModbusTCPClientTransactionResult transaction_result, const char *error_message) {
+        (void)error_message;
+
+        done   = true;
+        result = transaction_result;
+    });
+
+    tick_until([&done]() { return done; });
+
+    return result;
+}
+
+static TFModbusTCPClientTransactionResult read_view(TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count,
+                                                    std::function<void(const TFModbusTCPReadView *view)> &&inspect)
+{
+    bool done                                 = false;
+    TFModbusTCPClientTransactionResult result = TFModbusTCPClientTransactionResult::Timeout;
+
+    client->read_view(1, function_code, start_address, data_count, 1_s,
+    [&done, &result, &inspect](TFModbusTCPClientTransactionResult transaction_result, const char *error_message, const TFModbusTCPReadView *view) {
+        (void)error_message;
+
+        inspect(view);
+
+        done   = true;
+        result = transaction_result;
+    });
+
+    tick_until([&done]() { return done; });
+
+    return result;
+}
+
+static void check_decode_helpers()
+{
+    registers[0] = 0x1234;
+    registers[1] = 0xFEDC;
+    registers[2] = 0x89AB;
+    registers[3] = 0xCDEF;
+
+    float float_value = 3.5f;
+    uint32_t float_bits;
+
+    memcpy(&float_bits, &float_value, sizeof(float_bits));
+
+    registers[4] = static_cast<uint16_t>(float_bits >> 16);
+    registers[5] = static_cast<uint16_t>(float_bits & 0xFFFF);
+
+    for (size_t i = 0; i < 100; ++i) {
+        coils[i] = i % 3 == 0;
+    }
+
+    check(read_view(TFModbusTCPFunctionCode::ReadHoldingRegisters, 0, 6,
+    [](const TFModbusTCPReadView *view) {
+        check(view != nullptr && !view->is_bits() && view->get_start_address() == 0 && view->get_data_count() == 6 && view->get_byte_count() == 12,
+              "register view layout");
+
+        if (view == nullptr) {
+            return;
+        }
+
+        check(view->get_bytes()[0] == 0x12 && view->get_bytes()[1] == 0x34, "register bytes are in network byte order");
+        check(view->get_u16(0) == 0x1234, "u16");
+        check(view->get_i16(1) == -292, "negative i16");
+        check(view->get_u32(2) == 0x89ABCDEF, "u32 is high word first");
+        check(view->get_i32(2) == static_cast<int32_t>(0x89ABCDEF), "negative i32");
+        check(view->get_f32(4) == 3.5f, "f32");
+        check(view->get_u16(6) == 0 && view->get_u32(5) == 0 && view->get_f32(6) == 0.0f, "out-of-range indices decode as 0");
+    }) == TFModbusTCPClientTransactionResult::Success, "register view read");
+
+    check(read_view(TFModbusTCPFunctionCode::ReadCoils, 0, 13,
+    [](const TFModbusTCPReadView *view) {
+        check(view != nullptr && view->is_bits() && view->get_data_count() == 13 && view->get_byte_count() == 2, "coil view layout");
+
+        if (view == nullptr) {
+            return;
+        }
+
+        bool bits_match = true;
+
+        for (size_t i = 0; i < 13; ++i) {
+            bits_match = bits_match && view->get_bit(i) == (i % 3 == 0);
+        }
+
+        check(bits_match, "coil bits");
+        check(!view->get_bit(13), "out-of-range bit decodes as false");
+    }) == TFModbusTCPClientTransactionResult::Success, "coil view read");
+
+    check(read_view(TFModbusTCPFunctionCode::ReadHoldingRegisters, 98, 5,
+    [](const TFModbusTCPReadView *view) {
+        check(view == nullptr, "failed read has no view");
+    }) == TFModbusTCPClientTransactionResult::ModbusIllegalDataAddress, "read beyond the registers fails");
+
+    check(read_view(TFModbusTCPFunctionCode::WriteMultipleRegisters, 0, 5,
+    [](const TFModbusTCPReadView *view) {
+        check(view == nullptr, "refused read has no view");
+    }) == TFModbusTCPClientTransactionResult::InvalidArgument, "write function code is refused");
+}
+
+static void check_write_shadow()
+{
+    client->set_write_shadow_enabled(true);
+
+    check(write_register(20, 5) == TFModbusTCPClientTransactionResult::Success
+       && write_register(30, 7) == TFModbusTCPClientTransactionResult::Success
+       && write_count == 2, "writes are sent");
+
+    check(write_register(20, 5) == TFModbusTCPClientTransactionResult::Success && write_count == 2, "unchanged write is suppressed");
+
+    // the view has no buffer to compare with, its range is dropped from the shadow
+    check(read_view(TFModbusTCPFunctionCode::ReadHoldingRegisters, 20, 2,
+    [](const TFModbusTCPReadView *view) {
+        (void)view;
+    }) == TFModbusTCPClientTransactionResult::Success, "view read of a shadowed register");
+
+    check(write_register(20, 5) == TFModbusTCPClientTransactionResult::Success && write_count == 3, "write after a view read is sent");
+    check(write_register(30, 7) == TFModbusTCPClientTransactionResult::Success && write_count == 3, "write outside of the view range is still suppressed");
+
+    client->set_write_shadow_enabled(false);
+}
+
+// A sloppy device that sets the padding bits of a coil response
+static void check_coil_padding()
+{
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    int flag      = 1;
+    struct sockaddr_in address;
+
+    memset(&address, 0, sizeof(address));
+
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(PEER_PORT);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+
+    if (bind(listen_fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) < 0 || listen(listen_fd, 1) < 0) {
+        check(false, "peer listening");
+        close(listen_fd);
+        return;
+    }
+
+    fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL, 0) | O_NONBLOCK);
+
+    client->disconnect();
+
+    int peer_fd = -1;
+    bool connected = false;
+
+    client->connect("127.0.0.1", PEER_PORT,
+    [&connected](TFGenericTCPClientConnectResult result, int error_number) {
+        (void)error_number;
+
+        connected = result == TFGenericTCPClientConnectResult::Connected;
+    },
+    [](TFGenericTCPClientDisconnectReason reason, int error_number) {
+        (void)reason;
+        (void)error_number;
+    });
+
+    check(tick_until([&connected, &peer_fd, listen_fd]() {
+        if (peer_fd < 0) {
+            peer_fd = accept(listen_fd, nullptr, nullptr);
+        }
+
+        return connected && peer_fd >= 0;
+    }), "client connected to peer");
+
+    bool done      = false;
+    bool padded    = false;
+    bool bits_set  = false;
+
+    client->read_view(1, TFModbusTCPFunctionCode::ReadCoils, 0, 13, 1_s,
+    [&done, &padded, &bits_set](TFModbusTCPClientTransactionResult result, const char *error_message, const TFModbusTCPReadView *view) {
+        (void)error_message;
+
+        if (result == TFModbusTCPClientTransactionResult::Success && view != nullptr) {
+            padded   = view->get_bytes()[1] == 0x1F;
+            bits_set = true;
+
+            for (size_t i = 0; i < 13; ++i) {
+                bits_set = bits_set && view->get_bit(i);
+            }
+        }
+
+        done = true;
+    });
+
+    uint8_t request[12];
+    size_t request_length = 0;
+
+    check(tick_until([&request, &request_length, peer_fd]() {
+        ssize_t result = recv(peer_fd, request + request_length, sizeof(request) - request_length, MSG_DONTWAIT);
+
+        if (result > 0) {
+            request_length += static_cast<size_t>(result);
+        }
+
+        return request_length == sizeof(request);
+    }), "peer received the request");
+
+    // 13 coils, all set, and the 3 padding bits set as well
+    uint8_t response[11] = {request[0], request[1], 0x00, 0x00, 0x00, 0x05, request[6], 0x01, 0x02, 0xFF, 0xFF};
+
+    check(send(peer_fd, response, sizeof(response), 0) == sizeof(response), "peer sent the response");
+    check(tick_until([&done]() { return done; }) && bits_set, "coil view of the padded response");
+    check(padded, "padding bits are cleared in place");
+
+    client->disconnect();
+
+    close(peer_fd);
+    close(listen_fd);
+}
+
+int main()
+{
+    TFNetwork::vlogfln =
+    [](const char *format, va_list args) {
+        printf("%li | ", static_cast<int64_t>(now_us()));
+        vprintf(format, args);
+        puts("");
+    };
+
+    TFNetwork::resolve =
+    [](const char *host, TFNetworkResolveResultCallback &&callback) {
+        callback(inet_addr(host), 0);
+    };
+
+    TFNetwork::get_random_uint16 =
+    []() {
+        return static_cast<uint16_t>(rand());
+    };
+
+    check(server.start(htonl(INADDR_LOOPBACK), PORT,
+    [](uint32_t peer_address, uint16_t port) {
+        (void)peer_address;
+        (void)port;
+    },
+    [](uint32_t peer_address, uint16_t port, TFModbusTCPServerDisconnectReason reason, int error_number) {
+        (void)peer_address;
+        (void)port;
+        (void)reason;
+        (void)error_number;
+    },
+    [](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values) {
+        (void)unit_id;
+
+        if (start_address + data_count > 100) {
+            return TFModbusTCPExceptionCode::IllegalDataAddress;
+        }
+
+        switch (function_code) {
+        case TFModbusTCPFunctionCode::ReadHoldingRegisters:
+            memcpy(data_values, registers + start_address, data_count * 2);
+            break;
+
+        case TFModbusTCPFunctionCode::WriteMultipleRegisters:
+            memcpy(registers + start_address, data_values, data_count * 2);
+            ++write_count;
+            break;
+
+        case TFModbusTCPFunctionCode::ReadCoils:
+            memset(data_values, 0, (data_count + 7) / 8);
+
+            for (uint16_t i = 0; i < data_count; ++i) {
+                if (coils[start_address + i]) {
+                    static_cast<uint8_t *>(data_values)[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+                }
+            }
+
+            break;
+
+        default:
+            return TFModbusTCPExceptionCode::IllegalFunction;
+        }
+
+        return TFModbusTCPExceptionCode::Success;
+    }), "start server");
+
+    client = new TFModbusTCPClient(TFModbusTCPByteOrder::Host);
+
+    check(connect(PORT), "client connected");
+
+    check_decode_helpers();
+    check_write_shadow();
+    check_coil_padding();
+
+    server.stop();
+
+    delete client;
+
+    TFNetwork::logfln("%d failure(s)", failures);
+
+    return failures > 0 ? 1 : 0;
+}
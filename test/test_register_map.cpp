@@ -0,0 +1,193 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <Arduino.h>
+#include <TFTools/Micros.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFModbusTCPRegisterMap.h"
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    TFNetwork::logfln("%s: %s", condition ? "PASS" : "FAIL", description);
+
+    if (!condition) {
+        ++failures;
+    }
+}
+
+static const char *source =
+    "# common block\n"
+    "holding 40000 SunSpecID u32 0x53756E53\n"
+    "holding + CommonID u16 1\n"
+    "holding + Mn string4 \"Tinker\" # manufacturer\n"
+    "\n"
+    "holding 40100 Limit u16 100 rw\n"
+    "holding + Scale i16 -2\n"
+    "holding + Power f32 1.5\n"
+    "input 0 Energy u32 rw\n"
+    "coil 10 Relay bit 1 rw\n"
+    "coil + Lamp bit 0\n"
+    "discrete 0 Door bit 1\n";
+
+static bool compile_error(const char *bad_source, const char *expected_error)
+{
+    uint8_t *binary = nullptr;
+    size_t binary_length;
+    char error_message[128] = "";
+
+    if (TFModbusTCPRegisterMap::compile(bad_source, strlen(bad_source), &binary, &binary_length, error_message, sizeof(error_message))) {
+        delete[] binary;
+        return false;
+    }
+
+    TFNetwork::logfln("compile error: %s", error_message);
+
+    return strcmp(error_message, expected_error) == 0;
+}
+
+int main()
+{
+    TFNetwork::vlogfln =
+    [](const char *format, va_list args) {
+        printf("%li | ", static_cast<int64_t>(now_us()));
+        vprintf(format, args);
+        puts("");
+    };
+
+    uint8_t *binary = nullptr;
+    size_t binary_length;
+    char error_message[128] = "";
+
+    check(TFModbusTCPRegisterMap::compile(source, strlen(source), &binary, &binary_length, error_message, sizeof(error_message)), "compile");
+
+    TFModbusTCPRegisterMap map;
+
+    check(map.load(binary, binary_length) && map.get_entry_count() == 10, "load compiled binary");
+
+    const TFModbusTCPRegisterMapEntry *entry = map.find_entry("Power");
+
+    check(entry != nullptr && entry->start_address == 40102 && entry->register_count == 2, "+ continues after the previous entry of the table");
+
+    // Reads may span several entries, but not a gap between them
+    uint16_t registers[8];
+
+    check(map.read(TFModbusTCPDataType::HoldingRegister, 40000, 7, registers) == TFModbusTCPExceptionCode::Success
+       && registers[0] == 0x5375 && registers[1] == 0x6E53 && registers[2] == 1
+       && registers[3] == (('T' << 8) | 'i') && registers[5] == (('e' << 8) | 'r') && registers[6] == 0, "read across entries");
+    check(map.read(TFModbusTCPDataType::HoldingRegister, 40100, 4, registers) == TFModbusTCPExceptionCode::Success
+       && registers[0] == 100 && registers[1] == static_cast<uint16_t>(-2) && registers[2] == 0x3FC0 && registers[3] == 0, "signed and float values");
+    check(map.read(TFModbusTCPDataType::HoldingRegister, 40006, 2, registers) == TFModbusTCPExceptionCode::IllegalDataAddress, "read past an entry is rejected");
+    check(map.read(TFModbusTCPDataType::HoldingRegister, 39999, 1, registers) == TFModbusTCPExceptionCode::IllegalDataAddress, "read before the first entry is rejected");
+    check(map.read(TFModbusTCPDataType::InputRegister, 40000, 1, registers) == TFModbusTCPExceptionCode::IllegalDataAddress, "tables are separate");
+
+    uint8_t bits = 0xFC;
+
+    check(map.read(TFModbusTCPDataType::Coil, 10, 2, &bits) == TFModbusTCPExceptionCode::Success && bits == 0xFD, "bits are packed and other bits are kept");
+
+    // A write that touches a read-only entry changes nothing
+    uint16_t values[2] = {50, 7};
+
+    check(map.write(TFModbusTCPDataType::HoldingRegister, 40100, 2, values) == TFModbusTCPExceptionCode::IllegalDataAddress
+       && map.read(TFModbusTCPDataType::HoldingRegister, 40100, 1, registers) == TFModbusTCPExceptionCode::Success && registers[0] == 100, "rejected write changes nothing");
+    check(map.write(TFModbusTCPDataType::HoldingRegister, 40100, 1, values) == TFModbusTCPExceptionCode::Success
+       && map.read(TFModbusTCPDataType::HoldingRegister, 40100, 1, registers) == TFModbusTCPExceptionCode::Success && registers[0] == 50, "write of a writable entry");
+    check(map.set_values(TFModbusTCPDataType::HoldingRegister, 40101, 1, values + 1) == TFModbusTCPExceptionCode::Success
+       && map.read(TFModbusTCPDataType::HoldingRegister, 40101, 1, registers) == TFModbusTCPExceptionCode::Success && registers[0] == 7, "set_values ignores the writable flag");
+
+    bits = 0x02;
+
+    check(map.write(TFModbusTCPDataType::Coil, 10, 1, &bits) == TFModbusTCPExceptionCode::Success
+       && map.read(TFModbusTCPDataType::Coil, 10, 2, &bits) == TFModbusTCPExceptionCode::Success && (bits & 3) == 0, "write of a bit");
+
+    // Round trip through files, a loaded map keeps writes in memory
+    FILE *file = fopen("test_register_map_source", "w");
+
+    fputs(source, file);
+    fclose(file);
+
+    check(TFModbusTCPRegisterMap::compile_file("test_register_map_source", "test_register_map_binary", error_message, sizeof(error_message)), "compile_file");
+
+    TFModbusTCPRegisterMap file_map;
+    uint8_t *file_binary = new uint8_t[binary_length + 1];
+
+    file = fopen("test_register_map_binary", "rb");
+
+    check(fread(file_binary, 1, binary_length + 1, file) == binary_length && memcmp(file_binary, binary, binary_length) == 0, "compile_file writes the same binary");
+    fclose(file);
+    delete[] file_binary;
+
+    check(file_map.load("test_register_map_binary")
+       && file_map.write(TFModbusTCPDataType::HoldingRegister, 40100, 1, values) == TFModbusTCPExceptionCode::Success, "load file");
+
+    TFModbusTCPRegisterMap other_file_map;
+
+    check(other_file_map.load("test_register_map_binary")
+       && other_file_map.read(TFModbusTCPDataType::HoldingRegister, 40100, 1, registers) == TFModbusTCPExceptionCode::Success && registers[0] == 100, "writes do not reach the file");
+
+    error_message[0] = '\0';
+
+    check(!TFModbusTCPRegisterMap::compile_file("test_register_map_missing", "test_register_map_binary", error_message, sizeof(error_message))
+       && strncmp(error_message, "could not open 'test_register_map_missing'", 42) == 0, "file errors have no line prefix");
+
+    unlink("test_register_map_source");
+    unlink("test_register_map_binary");
+
+    // Errors name the line
+    check(compile_error("holding 0 a u16\nholding 0 b u16\n", "line 2: entry overlaps with line 1"), "overlapping entries");
+    check(compile_error("holding 0 a u16 70000\n", "line 1: invalid u16 value '70000'"), "value out of range");
+    check(compile_error("\nholding 65535 a u32\n", "line 2: entry exceeds the address space"), "entry past the address space");
+    check(compile_error("coil 0 a u16\n", "line 1: type 'u16' does not fit table 'coil'"), "register type in a bit table");
+    check(compile_error("holding 0 a u16\nholding + a u16\n", "line 2: duplicate name 'a'"), "duplicate name");
+    check(compile_error("holding 0 a u16 1 ro\n", "line 1: unexpected 'ro'"), "unknown flag");
+    check(compile_error("table 0 a u16\n", "line 1: unknown table 'table'"), "unknown table");
+
+    // A corrupt binary is rejected as a whole
+    TFModbusTCPRegisterMap corrupt_map;
+
+    check(!corrupt_map.load(binary, binary_length - 1), "truncated binary is rejected");
+    check(corrupt_map.read(TFModbusTCPDataType::HoldingRegister, 40000, 1, registers) == TFModbusTCPExceptionCode::ServerDeviceFailure, "unloaded map fails reads");
+
+    delete[] binary;
+
+    TFNetwork::logfln("%d failure(s)", failures);
+
+    return failures > 0 ? 1 : 0;
+}
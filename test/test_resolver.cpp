@@ -0,0 +1,264 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <Arduino.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFNetworkResolver.h"
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+// Stub DNS server on a local UDP port, answering a fixed set of names
+static int stub_fd = -1;
+static int stub_query_count[4] = {0, 0, 0, 0};
+
+enum { STUB_EXAMPLE, STUB_MISSING, STUB_SLOW, STUB_LATE };
+
+static void stub_tick()
+{
+    uint8_t query[512];
+    struct sockaddr_in peer;
+    socklen_t peer_length = sizeof(peer);
+    ssize_t query_length;
+
+    while ((query_length = recvfrom(stub_fd, query, sizeof(query), MSG_DONTWAIT, reinterpret_cast<struct sockaddr *>(&peer), &peer_length)) > 0) {
+        char name[256];
+        size_t offset = 12;
+        size_t used = 0;
+
+        while (offset < static_cast<size_t>(query_length) && query[offset] != 0) {
+            memcpy(name + used, query + offset + 1, query[offset]);
+            used += query[offset];
+            name[used++] = '.';
+            offset += 1 + query[offset];
+        }
+
+        name[used > 0 ? used - 1 : 0] = '\0';
+        offset += 1 + 4; // end of question
+
+        uint8_t response[512];
+
+        memcpy(response, query, offset);
+        response[2] = 0x81;
+        response[3] = 0x80;
+
+        if (strcmp(name, "example.test") == 0) {
+            ++stub_query_count[STUB_EXAMPLE];
+
+            // CNAME example.test -> www.example.test, then its A record,
+            // both using name compression
+            static const uint8_t answer[] = {
+                0xC0, 0x0C, 0x00, 0x05, 0x00, 0x01, 0x00, 0x00, 0x00, 0x3C, 0x00, 0x06,
+                0x03, 'w', 'w', 'w', 0xC0, 0x0C,
+                0xC0, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x3C, 0x00, 0x04,
+                10, 0, 0, 1,
+            };
+
+            memcpy(response + offset, answer, sizeof(answer));
+            response[offset + 18 + 1] = static_cast<uint8_t>(offset + 12); // points to www
+            response[7] = 2;
+            offset += sizeof(answer);
+        }
+        else if (strcmp(name, "missing.test") == 0) {
+            ++stub_query_count[STUB_MISSING];
+            response[3] = 0x83; // NXDOMAIN
+        }
+        else if (strcmp(name, "slow.test") == 0) {
+            ++stub_query_count[STUB_SLOW];
+            continue;
+        }
+        else if (strcmp(name, "late.test") == 0) {
+            if (++stub_query_count[STUB_LATE] == 1) {
+                continue; // drop the first attempt
+            }
+
+            static const uint8_t answer[] = {0xC0, 0x0C, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x3C, 0x00, 0x04, 10, 0, 0, 2};
+
+            memcpy(response + offset, answer, sizeof(answer));
+            response[7] = 1;
+            offset += sizeof(answer);
+        }
+        else {
+            continue;
+        }
+
+        sendto(stub_fd, response, offset, 0, reinterpret_cast<struct sockaddr *>(&peer), peer_length);
+    }
+}
+
+static int forced_id_count = 0;
+static const uint16_t forced_ids[3] = {7, 7, 8};
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    TFNetwork::logfln("%s: %s", condition ? "PASS" : "FAIL", description);
+
+    if (!condition) {
+        ++failures;
+    }
+}
+
+int main()
+{
+    TFNetwork::vlogfln =
+    [](const char *format, va_list args) {
+        printf("%li | ", static_cast<int64_t>(now_us()));
+        vprintf(format, args);
+        puts("");
+    };
+
+    TFNetwork::get_random_uint16 =
+    []() {
+        if (forced_id_count > 0) {
+            return forced_ids[3 - forced_id_count--];
+        }
+
+        return static_cast<uint16_t>(rand());
+    };
+
+    stub_fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    struct sockaddr_in addr;
+    socklen_t addr_length = sizeof(addr);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    bind(stub_fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+    getsockname(stub_fd, reinterpret_cast<struct sockaddr *>(&addr), &addr_length);
+
+    FILE *hosts = fopen("test_resolver_hosts", "w");
+
+    fputs("# test hosts\n127.0.0.5 printer printer.local # comment\n::1 localhost6\n127.0.0.6 printer\n", hosts);
+    fclose(hosts);
+
+    TFNetworkResolver resolver;
+
+    check(resolver.start(htonl(INADDR_LOOPBACK), ntohs(addr.sin_port), "test_resolver_hosts"), "start");
+
+    uint32_t results[8] = {};
+    int errors[8];
+    int done = 0;
+
+    for (int i = 0; i < 8; ++i) {
+        errors[i] = -1;
+    }
+
+    auto lookup = [&](int index, const char *host) {
+        resolver.resolve(host, [&, index](uint32_t address, int error_number) {
+            results[index] = address;
+            errors[index]  = error_number;
+            ++done;
+        });
+    };
+
+    lookup(0, "192.168.0.1");
+    check(errors[0] == 0 && results[0] == inet_addr("192.168.0.1"), "numeric address is reported immediately");
+
+    lookup(1, "PRINTER.local");
+    check(errors[1] == 0 && results[1] == inet_addr("127.0.0.5"), "hosts file entry is reported immediately, the first line wins");
+
+    lookup(2, "example.test");
+    lookup(3, "example.test.");
+    lookup(4, "missing.test");
+    lookup(5, "slow.test");
+    lookup(6, "late.test");
+
+    check(resolver.get_pending_query_count() == 4, "lookups of the same name share one query");
+
+    micros_t deadline = calculate_deadline(5_s);
+
+    while (done < 7 && !deadline_elapsed(deadline)) {
+        stub_tick();
+        resolver.tick();
+        usleep(1000);
+    }
+
+    check(errors[2] == 0 && results[2] == inet_addr("10.0.0.1") && errors[3] == 0 && results[3] == results[2], "CNAME answer is followed to the address");
+    check(stub_query_count[STUB_EXAMPLE] == 1, "coalesced lookups sent one query");
+    check(errors[4] == ENOENT, "NXDOMAIN is reported as ENOENT");
+    check(errors[5] == ETIMEDOUT && stub_query_count[STUB_SLOW] == TF_NETWORK_RESOLVER_MAX_ATTEMPT_COUNT, "unanswered query times out after all attempts");
+    check(errors[6] == 0 && results[6] == inet_addr("10.0.0.2") && stub_query_count[STUB_LATE] == 2, "lost query is retransmitted");
+
+    lookup(7, "example.test");
+    check(errors[7] == 0 && results[7] == results[2] && stub_query_count[STUB_EXAMPLE] == 1, "cached answer is reported without a query");
+
+    errors[4] = -1;
+    lookup(4, "missing.test");
+    check(errors[4] == ENOENT && stub_query_count[STUB_MISSING] == 1, "negative answer is cached");
+
+    // The second query draws the ID of the first one, it has to draw again
+    resolver.clear_cache();
+
+    done            = 0;
+    errors[2]       = -1;
+    errors[6]       = -1;
+    forced_id_count = 3;
+
+    lookup(2, "example.test");
+    lookup(6, "late.test");
+
+    deadline = calculate_deadline(5_s);
+
+    while (done < 2 && !deadline_elapsed(deadline)) {
+        stub_tick();
+        resolver.tick();
+        usleep(1000);
+    }
+
+    check(forced_id_count == 0 && errors[2] == 0 && results[2] == inet_addr("10.0.0.1") && errors[6] == 0 && results[6] == inet_addr("10.0.0.2"),
+          "colliding query ID is drawn again");
+
+    errors[5] = -1;
+    lookup(5, "slow.test");
+    resolver.stop();
+    check(errors[5] == ECANCELED, "stop cancels pending lookups");
+
+    unlink("test_resolver_hosts");
+    close(stub_fd);
+
+    TFNetwork::logfln("%d failure(s)", failures);
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,169 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <Arduino.h>
+#include <TFTools/Micros.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFModbusTCPSharedMemoryRegisterBank.h"
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    TFNetwork::logfln("%s: %s", condition ? "PASS" : "FAIL", description);
+
+    if (!condition) {
+        ++failures;
+    }
+}
+
+#define SEGMENT_NAME "/test_shared_memory_register_bank"
+
+int main()
+{
+    TFNetwork::vlogfln =
+    [](const char *format, va_list args) {
+        printf("%li | ", static_cast<int64_t>(now_us()));
+        vprintf(format, args);
+        puts("");
+    };
+
+    TFModbusTCPSharedMemoryRegisterBank::unlink(SEGMENT_NAME);
+
+    TFModbusTCPSharedMemoryRegisterBank bank;
+
+    check(bank.create(SEGMENT_NAME, 4096, 0, 0, 1024), "create");
+
+    uint16_t values[125];
+
+    check(bank.read(TFModbusTCPDataType::HoldingRegister, 1000, 25, values) == TFModbusTCPExceptionCode::IllegalDataAddress, "read past the end is rejected");
+
+    // A producer process keeps every register of a 125 register request
+    // spanning three ranges at the same value, the server must never see a
+    // mix of two writes
+    pid_t producer = fork();
+
+    if (producer == 0) {
+        TFModbusTCPSharedMemoryRegisterBank producer_bank;
+
+        if (!producer_bank.open(SEGMENT_NAME)) {
+            _exit(1);
+        }
+
+        for (uint16_t round = 1; ; ++round) {
+            uint16_t *registers = static_cast<uint16_t *>(producer_bank.begin_write(TFModbusTCPDataType::HoldingRegister, 60, 125));
+
+            if (registers == nullptr) {
+                continue;
+            }
+
+            for (uint16_t i = 0; i < 125; ++i) {
+                registers[60 + i] = round;
+            }
+
+            producer_bank.end_write(TFModbusTCPDataType::HoldingRegister, 60, 125);
+        }
+    }
+
+    bool consistent = true;
+    bool changed    = false;
+    uint16_t first  = 0;
+
+    for (int i = 0; i < 100000; ++i) {
+        if (bank.read(TFModbusTCPDataType::HoldingRegister, 60, 125, values) != TFModbusTCPExceptionCode::Success) {
+            consistent = false;
+            break;
+        }
+
+        for (uint16_t k = 1; k < 125; ++k) {
+            if (values[k] != values[0]) {
+                consistent = false;
+            }
+        }
+
+        if (i == 0) {
+            first = values[0];
+        }
+        else if (values[0] != first) {
+            changed = true;
+        }
+    }
+
+    kill(producer, SIGKILL);
+    waitpid(producer, nullptr, 0);
+
+    check(consistent && changed, "read across range boundaries is one snapshot");
+
+    // A producer that dies while holding a range lock leaves an odd sequence
+    // number behind, accesses to that range must give up instead of hanging
+    producer = fork();
+
+    if (producer == 0) {
+        TFModbusTCPSharedMemoryRegisterBank producer_bank;
+
+        if (!producer_bank.open(SEGMENT_NAME) || producer_bank.begin_write(TFModbusTCPDataType::Coil, 2000, 10) == nullptr) {
+            _exit(1);
+        }
+
+        _exit(0);
+    }
+
+    int status = -1;
+
+    waitpid(producer, &status, 0);
+
+    uint8_t bits[2] = {0xFF, 0x03};
+    micros_t start  = now_us();
+
+    check(WIFEXITED(status) && WEXITSTATUS(status) == 0, "producer died with a range locked");
+    check(bank.read(TFModbusTCPDataType::Coil, 2040, 10, bits) == TFModbusTCPExceptionCode::ServerDeviceFailure, "read of the locked range fails");
+    check(bank.write(TFModbusTCPDataType::Coil, 2040, 10, bits) == TFModbusTCPExceptionCode::ServerDeviceFailure, "write of the locked range fails");
+    check(now_us() - start < 1_s, "retries are bounded");
+    check(bank.write(TFModbusTCPDataType::Coil, 10, 10, bits) == TFModbusTCPExceptionCode::Success
+       && bank.read(TFModbusTCPDataType::Coil, 10, 10, bits) == TFModbusTCPExceptionCode::Success, "other ranges are still accessible");
+
+    bank.close();
+    TFModbusTCPSharedMemoryRegisterBank::unlink(SEGMENT_NAME);
+
+    TFNetwork::logfln("%d failure(s)", failures);
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,436 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+// Soak benchmark for slow leaks and degradation of the client pool and the
+// server. Runs pipelined transactions, forced reconnects and secondary share
+// acquire/release cycles over a loopback connection on an accelerated clock.
+// Latency percentiles, heap usage and fragmentation, queue high-water marks
+// and file descriptor counts are tracked per window and the exit code is
+// non-zero if they drift:
+//
+//   test_soak [transaction-count] [clock-acceleration]
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <dirent.h>
+#include <malloc.h>
+#include <algorithm>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <Arduino.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFModbusTCPServer.h"
+#include "../src/TFModbusTCPClient.h"
+#include "../src/TFModbusTCPClientPool.h"
+#include "../src/TFModbusTCPMemoryRegisterBank.h"
+
+#define PORT 15504
+#define PIPELINE_DEPTH 4
+#define READ_COUNT 10
+#define WINDOW_COUNT 100
+#define MIN_WINDOW_LENGTH 10000
+#define RECONNECT_INTERVAL 10000    // transactions between forced reconnects
+#define SHARE_CYCLE_INTERVAL 1000   // transactions between secondary share acquire/release cycles
+#define HEAP_DRIFT_TOLERANCE 65536  // bytes
+#define LATENCY_DRIFT_FACTOR 3
+#define LATENCY_DRIFT_TOLERANCE 200 // microseconds
+
+static int64_t acceleration = 1000;
+
+static int64_t real_now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return (static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec;
+}
+
+// accelerated clock, so that timeouts, idle checks and reconnect delays of
+// weeks of uptime happen within the run
+micros_t now_us()
+{
+    return micros_t{real_now_us() * acceleration};
+}
+
+struct Slot
+{
+    bool busy;
+    int64_t start_us;
+    uint16_t values[READ_COUNT];
+};
+
+struct Window
+{
+    uint32_t p50_us;
+    uint32_t p99_us;
+    uint32_t p999_us;
+    uint32_t max_us;
+    size_t failure_count;
+    size_t heap_in_use;
+    size_t heap_free;
+    size_t heap_size;
+    size_t fd_count;
+    size_t queue_high_water;
+    size_t server_client_high_water;
+    size_t pool_slot_high_water;
+    size_t pool_share_high_water;
+};
+
+static size_t get_fd_count()
+{
+    DIR *dir = opendir("/proc/self/fd");
+
+    if (dir == nullptr) {
+        return 0;
+    }
+
+    size_t count = 0;
+
+    while (readdir(dir) != nullptr) {
+        ++count;
+    }
+
+    closedir(dir);
+
+    return count > 3 ? count - 3 : 0; // ., .. and the directory itself
+}
+
+static uint32_t percentile(const uint32_t *sorted, size_t count, double fraction)
+{
+    if (count == 0) {
+        return 0;
+    }
+
+    return sorted[static_cast<size_t>(fraction * static_cast<double>(count - 1) + 0.5)];
+}
+
+static int failed_check_count = 0;
+
+static void check(bool ok, const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    printf("drift check: ");
+    vprintf(fmt, args);
+    printf(" %s\n", ok ? "ok" : "FAILED");
+    va_end(args);
+
+    if (!ok) {
+        ++failed_check_count;
+    }
+}
+
+static uint32_t median_p99(const Window *windows, size_t first, size_t last)
+{
+    uint32_t values[WINDOW_COUNT];
+    size_t count = 0;
+
+    for (size_t i = first; i < last; ++i) {
+        values[count++] = windows[i].p99_us;
+    }
+
+    std::sort(values, values + count);
+
+    return values[count / 2];
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t transaction_count = argc > 1 ? strtoull(argv[1], nullptr, 0) : 100000000;
+    acceleration               = argc > 2 ? strtoll(argv[2], nullptr, 0) : 1000;
+    uint64_t window_length     = std::max<uint64_t>(transaction_count / WINDOW_COUNT, MIN_WINDOW_LENGTH);
+    size_t window_count        = static_cast<size_t>((transaction_count + window_length - 1) / window_length);
+
+    if (window_count > WINDOW_COUNT || window_count < 4) {
+        fprintf(stderr, "transaction count must be between %d and %llu\n", 4 * MIN_WINDOW_LENGTH,
+                static_cast<unsigned long long>(WINDOW_COUNT) * window_length);
+        return 1;
+    }
+
+    TFNetwork::resolve =
+    [](const char *host, TFNetworkResolveResultCallback &&callback) {
+        callback(inet_addr(host), 0);
+    };
+
+    TFNetwork::get_random_uint16 =
+    []() {
+        return static_cast<uint16_t>(rand());
+    };
+
+    TFModbusTCPMemoryRegisterBank bank(0, 0, 0, 100);
+
+    for (uint16_t i = 0; i < 100; ++i) {
+        bank.write(TFModbusTCPDataType::HoldingRegister, i, 1, &i);
+    }
+
+    TFModbusTCPServer server(TFModbusTCPByteOrder::Host);
+
+    if (!server.start(htonl(INADDR_LOOPBACK), PORT,
+    [](uint32_t peer_address, uint16_t port) {
+        (void)peer_address;
+        (void)port;
+    },
+    [](uint32_t peer_address, uint16_t port, TFModbusTCPServerDisconnectReason reason, int error_number) {
+        (void)peer_address;
+        (void)port;
+        (void)reason;
+        (void)error_number;
+    },
+    [&bank](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values) {
+        (void)unit_id;
+
+        return bank.handle_request(function_code, start_address, data_count, data_values);
+    })) {
+        fprintf(stderr, "could not start server\n");
+        return 1;
+    }
+
+    TFModbusTCPClientPool pool(TFModbusTCPByteOrder::Host);
+    TFModbusTCPDeviceProfile device_profile;
+
+    device_profile.max_pending_transaction_count = PIPELINE_DEPTH;
+
+    pool.set_device_profile("127.0.0.1", PORT, &device_profile);
+
+    Slot slots[PIPELINE_DEPTH]         = {};
+    Window *windows                    = new Window[window_count]();
+    uint32_t *latencies                = new uint32_t[window_length];
+    size_t latency_count               = 0;
+    size_t window_index                = 0;
+    uint64_t started_count             = 0;
+    uint64_t finished_count            = 0;
+    uint64_t reconnect_count           = 0;
+    uint64_t share_cycle_count         = 0;
+    uint64_t next_reconnect            = RECONNECT_INTERVAL;
+    uint64_t next_share_cycle          = SHARE_CYCLE_INTERVAL;
+    TFModbusTCPSharedClient *client    = nullptr;
+    TFModbusTCPSharedClient *secondary = nullptr;
+    bool acquiring                     = false;
+    bool acquiring_secondary           = false;
+    int64_t start_us                   = real_now_us();
+
+    auto disconnect_callback =
+    [&client, &secondary](TFGenericTCPClientDisconnectReason reason, int error_number, TFGenericTCPSharedClient *shared_client, TFGenericTCPClientPoolShareLevel level) {
+        (void)reason;
+        (void)error_number;
+        (void)level;
+
+        if (shared_client == client) {
+            client = nullptr;
+        }
+
+        if (shared_client == secondary) {
+            secondary = nullptr;
+        }
+    };
+
+    while (window_index < window_count) {
+        server.tick();
+        pool.tick();
+
+        Window *window = &windows[window_index];
+
+        if (client == nullptr && !acquiring) {
+            acquiring = true;
+
+            pool.acquire("127.0.0.1", PORT,
+            [&client, &acquiring](TFGenericTCPClientConnectResult result, int error_number, TFGenericTCPSharedClient *shared_client, TFGenericTCPClientPoolShareLevel level) {
+                (void)error_number;
+                (void)level;
+
+                acquiring = false;
+
+                if (result == TFGenericTCPClientConnectResult::Connected) {
+                    client = static_cast<TFModbusTCPSharedClient *>(shared_client);
+                }
+            },
+            TFGenericTCPClientPoolDisconnectCallback(disconnect_callback));
+
+            continue;
+        }
+
+        if (client == nullptr) {
+            continue;
+        }
+
+        // connection churn: force a reconnect once the pipeline is drained
+        if (finished_count >= next_reconnect && client->get_pending_transaction_count() == 0 && client->get_scheduled_transaction_count() == 0) {
+            next_reconnect += RECONNECT_INTERVAL;
+            ++reconnect_count;
+
+            if (secondary != nullptr) {
+                pool.release(secondary);
+                secondary = nullptr;
+            }
+
+            TFModbusTCPSharedClient *released = client;
+
+            client = nullptr;
+
+            pool.release(released, true);
+            continue;
+        }
+
+        // pool churn: acquire and release a secondary share of the same connection
+        if (secondary != nullptr) {
+            pool.release(secondary);
+            secondary = nullptr;
+        }
+        else if (finished_count >= next_share_cycle && !acquiring_secondary) {
+            next_share_cycle += SHARE_CYCLE_INTERVAL;
+            ++share_cycle_count;
+            acquiring_secondary = true;
+
+            pool.acquire("127.0.0.1", PORT,
+            [&secondary, &acquiring_secondary](TFGenericTCPClientConnectResult result, int error_number, TFGenericTCPSharedClient *shared_client, TFGenericTCPClientPoolShareLevel level) {
+                (void)error_number;
+                (void)level;
+
+                acquiring_secondary = false;
+
+                if (result == TFGenericTCPClientConnectResult::Connected) {
+                    secondary = static_cast<TFModbusTCPSharedClient *>(shared_client);
+                }
+            },
+            TFGenericTCPClientPoolDisconnectCallback(disconnect_callback));
+        }
+
+        for (size_t i = 0; i < PIPELINE_DEPTH && started_count < transaction_count && finished_count < next_reconnect; ++i) {
+            Slot *slot = &slots[i];
+
+            if (slot->busy) {
+                continue;
+            }
+
+            slot->busy     = true;
+            slot->start_us = real_now_us();
+            ++started_count;
+
+            client->transact(1, TFModbusTCPFunctionCode::ReadHoldingRegisters, 10, READ_COUNT, slot->values, 60_s,
+            [&, slot](TFModbusTCPClientTransactionResult result, const char *error_message) {
+                (void)error_message;
+
+                slot->busy = false;
+                ++finished_count;
+
+                Window *current = &windows[window_index];
+
+                if (result != TFModbusTCPClientTransactionResult::Success) {
+                    ++current->failure_count;
+                }
+                else if (latency_count < window_length) {
+                    latencies[latency_count++] = static_cast<uint32_t>(real_now_us() - slot->start_us);
+                }
+            });
+        }
+
+        window->queue_high_water         = std::max(window->queue_high_water, client->get_pending_transaction_count() + client->get_scheduled_transaction_count());
+        window->server_client_high_water = std::max(window->server_client_high_water, server.get_client_count());
+        window->pool_slot_high_water     = std::max(window->pool_slot_high_water, pool.get_slot_count());
+        window->pool_share_high_water    = std::max(window->pool_share_high_water, pool.get_share_count());
+
+        if (finished_count < (window_index + 1) * window_length && finished_count < transaction_count) {
+            continue;
+        }
+
+        std::sort(latencies, latencies + latency_count);
+
+        struct mallinfo2 heap = mallinfo2();
+
+        window->p50_us      = percentile(latencies, latency_count, 0.5);
+        window->p99_us      = percentile(latencies, latency_count, 0.99);
+        window->p999_us     = percentile(latencies, latency_count, 0.999);
+        window->max_us      = latency_count > 0 ? latencies[latency_count - 1] : 0;
+        window->heap_in_use = heap.uordblks + heap.hblkhd;
+        window->heap_free   = heap.fordblks;
+        window->heap_size   = heap.arena + heap.hblkhd;
+        window->fd_count    = get_fd_count();
+
+        printf("window %3zu: uptime=%6.1fh p50=%4uus p99=%5uus p99.9=%5uus max=%6uus failures=%zu heap=%zu/%zu (%.1f%% free) fds=%zu queue=%zu clients=%zu slots=%zu shares=%zu\n",
+               window_index, static_cast<double>(static_cast<int64_t>(now_us())) / 3600e6,
+               window->p50_us, window->p99_us, window->p999_us, window->max_us, window->failure_count,
+               window->heap_in_use, window->heap_size, window->heap_size > 0 ? 100.0 * static_cast<double>(window->heap_free) / static_cast<double>(window->heap_size) : 0.0,
+               window->fd_count, window->queue_high_water, window->server_client_high_water, window->pool_slot_high_water, window->pool_share_high_water);
+
+        fflush(stdout);
+
+        latency_count = 0;
+        ++window_index;
+    }
+
+    double elapsed_s = static_cast<double>(real_now_us() - start_us) / 1e6;
+
+    printf("%llu transactions, %llu reconnects, %llu share cycles in %.1fs (%.0f transactions/s, %.1f simulated hours)\n",
+           static_cast<unsigned long long>(finished_count), static_cast<unsigned long long>(reconnect_count),
+           static_cast<unsigned long long>(share_cycle_count), elapsed_s, static_cast<double>(finished_count) / elapsed_s,
+           static_cast<double>(static_cast<int64_t>(now_us())) / 3600e6);
+
+    // the first window is warm-up, the baseline is the first quarter after it
+    size_t quarter         = std::max<size_t>((window_count - 1) / 4, 1);
+    const Window *baseline = &windows[1];
+    const Window *last     = &windows[window_count - 1];
+    uint32_t baseline_p99  = median_p99(windows, 1, 1 + quarter);
+    uint32_t last_p99      = median_p99(windows, window_count - quarter, window_count);
+    size_t max_queue       = 0;
+    size_t max_clients     = 0;
+    size_t max_slots       = 0;
+    size_t max_shares      = 0;
+    size_t failure_count   = 0;
+
+    for (size_t i = 0; i < window_count; ++i) {
+        max_queue      = std::max(max_queue, windows[i].queue_high_water);
+        max_clients    = std::max(max_clients, windows[i].server_client_high_water);
+        max_slots      = std::max(max_slots, windows[i].pool_slot_high_water);
+        max_shares     = std::max(max_shares, windows[i].pool_share_high_water);
+        failure_count += windows[i].failure_count;
+    }
+
+    check(last_p99 <= baseline_p99 * LATENCY_DRIFT_FACTOR + LATENCY_DRIFT_TOLERANCE,
+          "p99 latency %uus -> %uus", baseline_p99, last_p99);
+    check(last->heap_in_use <= baseline->heap_in_use + HEAP_DRIFT_TOLERANCE,
+          "heap in use %zu -> %zu bytes", baseline->heap_in_use, last->heap_in_use);
+    check(last->heap_size <= baseline->heap_size + HEAP_DRIFT_TOLERANCE,
+          "heap size %zu -> %zu bytes", baseline->heap_size, last->heap_size);
+    check(last->fd_count <= baseline->fd_count,
+          "file descriptors %zu -> %zu", baseline->fd_count, last->fd_count);
+    check(max_queue <= PIPELINE_DEPTH, "queue high-water %zu <= %d", max_queue, PIPELINE_DEPTH);
+    check(max_clients <= 2, "server client high-water %zu <= 2", max_clients);
+    check(max_slots <= 1, "pool slot high-water %zu <= 1", max_slots);
+    check(max_shares <= 2, "pool share high-water %zu <= 2", max_shares);
+    check(failure_count == 0, "%zu failed transactions", failure_count);
+
+    server.stop();
+
+    delete[] latencies;
+    delete[] windows;
+
+    printf("%d drift check(s) failed\n", failed_check_count);
+
+    return failed_check_count > 0 ? 1 : 0;
+}
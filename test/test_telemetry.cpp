@@ -0,0 +1,354 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+// Writes and reads a memory-mapped telemetry log. The writer runs pipelined
+// reads and writes against an in-process server through a client pool whose
+// transaction observer appends to the log. The reader streams and decodes the
+// log, with follow it keeps waiting for new records, so it can run in another
+// terminal while the writer is running:
+//
+//   test_telemetry write <path> [transaction-count] [slot-count]
+//   test_telemetry read <path> [follow]
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <Arduino.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFModbusTCPServer.h"
+#include "../src/TFModbusTCPClient.h"
+#include "../src/TFModbusTCPClientPool.h"
+#include "../src/TFModbusTCPMemoryRegisterBank.h"
+#include "../src/TFModbusTCPTelemetryLog.h"
+
+#define PORT 15505
+#define PIPELINE_DEPTH 4
+#define REGISTER_COUNT 20
+#define COIL_COUNT 30
+#define WRITE_INTERVAL 10 // transactions between writes
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+static int64_t get_thread_cpu_ns()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+struct Slot
+{
+    bool busy;
+    uint16_t values[REGISTER_COUNT];
+};
+
+static int write_log(const char *path, uint64_t transaction_count, uint32_t slot_count)
+{
+    TFModbusTCPTelemetryLog log;
+
+    if (!log.create(path, slot_count)) {
+        fprintf(stderr, "could not create log %s\n", path);
+        return 1;
+    }
+
+    TFNetwork::resolve =
+    [](const char *host, TFNetworkResolveResultCallback &&callback) {
+        callback(inet_addr(host), 0);
+    };
+
+    TFNetwork::get_random_uint16 =
+    []() {
+        return static_cast<uint16_t>(rand());
+    };
+
+    TFModbusTCPMemoryRegisterBank bank(COIL_COUNT, 0, 0, REGISTER_COUNT);
+    TFModbusTCPServer server(TFModbusTCPByteOrder::Host);
+
+    if (!server.start(htonl(INADDR_LOOPBACK), PORT,
+    [](uint32_t peer_address, uint16_t port) {
+        (void)peer_address;
+        (void)port;
+    },
+    [](uint32_t peer_address, uint16_t port, TFModbusTCPServerDisconnectReason reason, int error_number) {
+        (void)peer_address;
+        (void)port;
+        (void)reason;
+        (void)error_number;
+    },
+    [&bank](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values) {
+        (void)unit_id;
+
+        return bank.handle_request(function_code, start_address, data_count, data_values);
+    })) {
+        fprintf(stderr, "could not start server\n");
+        return 1;
+    }
+
+    TFModbusTCPClientPool pool(TFModbusTCPByteOrder::Host);
+    TFModbusTCPDeviceProfile device_profile;
+    int64_t observer_ns = 0;
+
+    device_profile.max_pending_transaction_count = PIPELINE_DEPTH;
+
+    pool.set_device_profile("127.0.0.1", PORT, &device_profile);
+    pool.set_transaction_observer(
+    [&log, &observer_ns](const TFModbusTCPClientTransaction *transaction, TFModbusTCPClientTransactionResult result, micros_t latency) {
+        int64_t start_ns = get_thread_cpu_ns();
+
+        log.log_transaction(transaction, result, latency);
+
+        observer_ns += get_thread_cpu_ns() - start_ns;
+    });
+
+    Slot slots[PIPELINE_DEPTH]      = {};
+    uint8_t coil_values[(COIL_COUNT + 7) / 8];
+    uint64_t started_count          = 0;
+    uint64_t finished_count         = 0;
+    uint64_t failure_count          = 0;
+    TFModbusTCPSharedClient *client = nullptr;
+    bool acquiring                  = false;
+    micros_t start                  = now_us();
+
+    while (finished_count < transaction_count) {
+        server.tick();
+        pool.tick();
+
+        if (client == nullptr && !acquiring) {
+            acquiring = true;
+
+            pool.acquire("127.0.0.1", PORT,
+            [&client, &acquiring](TFGenericTCPClientConnectResult result, int error_number, TFGenericTCPSharedClient *shared_client, TFGenericTCPClientPoolShareLevel level) {
+                (void)error_number;
+                (void)level;
+
+                acquiring = false;
+
+                if (result == TFGenericTCPClientConnectResult::Connected) {
+                    client = static_cast<TFModbusTCPSharedClient *>(shared_client);
+                }
+            },
+            [&client](TFGenericTCPClientDisconnectReason reason, int error_number, TFGenericTCPSharedClient *shared_client, TFGenericTCPClientPoolShareLevel level) {
+                (void)reason;
+                (void)error_number;
+                (void)level;
+
+                if (shared_client == client) {
+                    client = nullptr;
+                }
+            });
+
+            continue;
+        }
+
+        if (client == nullptr) {
+            continue;
+        }
+
+        for (size_t i = 0; i < PIPELINE_DEPTH && started_count < transaction_count; ++i) {
+            Slot *slot = &slots[i];
+
+            if (slot->busy) {
+                continue;
+            }
+
+            auto callback =
+            [slot, &finished_count, &failure_count](TFModbusTCPClientTransactionResult result, const char *error_message) {
+                (void)error_message;
+
+                slot->busy = false;
+
+                if (result != TFModbusTCPClientTransactionResult::Success) {
+                    ++failure_count;
+                }
+
+                ++finished_count;
+            };
+
+            slot->busy = true;
+
+            if ((started_count % WRITE_INTERVAL) == WRITE_INTERVAL - 1) {
+                slot->values[0] = static_cast<uint16_t>(started_count);
+
+                client->transact(1, TFModbusTCPFunctionCode::WriteMultipleRegisters, 0, 1, slot->values, 1_s, callback);
+            }
+            else if ((started_count % 2) == 0) {
+                client->transact(1, TFModbusTCPFunctionCode::ReadHoldingRegisters, 0, REGISTER_COUNT, slot->values, 1_s, callback);
+            }
+            else {
+                client->transact(1, TFModbusTCPFunctionCode::ReadCoils, 0, COIL_COUNT, coil_values, 1_s, callback);
+            }
+
+            ++started_count;
+        }
+    }
+
+    int64_t duration_us = (now_us() - start).as<int64_t>();
+
+    if (client != nullptr) {
+        pool.release(client);
+    }
+
+    server.stop();
+
+    printf("%llu transactions in %lld ms, %llu failed, %.0f ns observer CPU time per transaction\n",
+           static_cast<unsigned long long>(finished_count),
+           static_cast<long long>(duration_us / 1000),
+           static_cast<unsigned long long>(failure_count),
+           static_cast<double>(observer_ns) / static_cast<double>(finished_count));
+
+    return failure_count > 0 ? 1 : 0;
+}
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void handle_sigint(int signal_number)
+{
+    (void)signal_number;
+
+    interrupted = 1;
+}
+
+static void print_record(const TFModbusTCPTelemetryRecord *record)
+{
+    time_t seconds = static_cast<time_t>(record->timestamp_us / 1000000);
+    struct tm tm;
+    char time_string[32];
+
+    localtime_r(&seconds, &tm);
+    strftime(time_string, sizeof(time_string), "%H:%M:%S", &tm);
+
+    printf("%llu %s.%06lld unit %u %s %u+%u",
+           static_cast<unsigned long long>(record->sequence),
+           time_string,
+           static_cast<long long>(record->timestamp_us % 1000000),
+           record->unit_id,
+           get_tf_modbus_tcp_function_code_name(record->function_code),
+           record->start_address,
+           record->data_count);
+
+    switch (record->type) {
+    case TFModbusTCPTelemetryRecordType::Transaction:
+        printf(" %s %u us\n", get_tf_modbus_tcp_client_transaction_result_name(record->result), record->latency_us);
+        break;
+
+    case TFModbusTCPTelemetryRecordType::RegisterValues:
+        printf(" registers");
+
+        for (uint16_t i = 0; i < record->data_count; ++i) {
+            printf(" %u", record->register_values[i]);
+        }
+
+        printf("\n");
+        break;
+
+    case TFModbusTCPTelemetryRecordType::BitValues:
+        printf(" bits ");
+
+        for (uint16_t i = 0; i < record->data_count; ++i) {
+            printf("%u", (record->bit_values[i / 8] >> (i % 8)) & 1);
+        }
+
+        printf("\n");
+        break;
+
+    default:
+        printf(" %s\n", get_tf_modbus_tcp_telemetry_record_type_name(record->type));
+        break;
+    }
+}
+
+static int read_log(const char *path, bool follow)
+{
+    TFModbusTCPTelemetryReader reader;
+
+    while (!reader.open(path)) {
+        if (!follow || interrupted) {
+            fprintf(stderr, "could not open log %s\n", path);
+            return 1;
+        }
+
+        usleep(100000);
+    }
+
+    TFModbusTCPTelemetryRecord record;
+    uint64_t record_count = 0;
+
+    while (!interrupted) {
+        if (reader.read(&record)) {
+            print_record(&record);
+            ++record_count;
+            continue;
+        }
+
+        if (!follow) {
+            break;
+        }
+
+        fflush(stdout);
+        usleep(10000);
+    }
+
+    fprintf(stderr, "%llu records, %llu lost\n",
+            static_cast<unsigned long long>(record_count),
+            static_cast<unsigned long long>(reader.get_lost_record_count()));
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 3 && strcmp(argv[1], "write") == 0) {
+        uint64_t transaction_count = argc > 3 ? strtoull(argv[3], nullptr, 0) : 100000;
+        uint32_t slot_count        = argc > 4 ? static_cast<uint32_t>(strtoul(argv[4], nullptr, 0)) : 65536;
+
+        return write_log(argv[2], transaction_count, slot_count);
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "read") == 0) {
+        signal(SIGINT, handle_sigint);
+
+        return read_log(argv[2], argc > 3 && strcmp(argv[3], "follow") == 0);
+    }
+
+    fprintf(stderr, "usage: %s write <path> [transaction-count] [slot-count]\n"
+                    "       %s read <path> [follow]\n", argv[0], argv[0]);
+
+    return 1;
+}
@@ -0,0 +1,258 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+// Write combining: consecutive scheduled writes are sent as one request and
+// a read of the written range is not reordered around the combined write
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <Arduino.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFModbusTCPServer.h"
+#include "../src/TFModbusTCPClient.h"
+
+#define PORT 15516
+#define MAX_REQUEST_COUNT 16
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    TFNetwork::logfln("%s: %s", condition ? "PASS" : "FAIL", description);
+
+    if (!condition) {
+        ++failures;
+    }
+}
+
+struct Request
+{
+    TFModbusTCPFunctionCode function_code;
+    uint16_t start_address;
+    uint16_t data_count;
+};
+
+static TFModbusTCPServer server(TFModbusTCPByteOrder::Host);
+static TFModbusTCPClient *client;
+static uint16_t registers[200];
+static bool coils[200];
+static Request requests[MAX_REQUEST_COUNT];
+static size_t request_count = 0;
+
+static bool tick_until(bool *condition)
+{
+    micros_t deadline = calculate_deadline(3_s);
+
+    while (!*condition) {
+        if (deadline_elapsed(deadline)) {
+            return false;
+        }
+
+        server.tick();
+        client->tick();
+    }
+
+    return true;
+}
+
+static bool check_request(size_t index, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count)
+{
+    return index < request_count
+        && requests[index].function_code == function_code
+        && requests[index].start_address == start_address
+        && requests[index].data_count == data_count;
+}
+
+int main()
+{
+    TFNetwork::vlogfln =
+    [](const char *format, va_list args) {
+        printf("%li | ", static_cast<int64_t>(now_us()));
+        vprintf(format, args);
+        puts("");
+    };
+
+    TFNetwork::resolve =
+    [](const char *host, TFNetworkResolveResultCallback &&callback) {
+        callback(inet_addr(host), 0);
+    };
+
+    TFNetwork::get_random_uint16 =
+    []() {
+        return static_cast<uint16_t>(rand());
+    };
+
+    check(server.start(htonl(INADDR_LOOPBACK), PORT,
+    [](uint32_t peer_address, uint16_t port) {
+        (void)peer_address;
+        (void)port;
+    },
+    [](uint32_t peer_address, uint16_t port, TFModbusTCPServerDisconnectReason reason, int error_number) {
+        (void)peer_address;
+        (void)port;
+        (void)reason;
+        (void)error_number;
+    },
+    [](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values) {
+        (void)unit_id;
+
+        if (start_address + data_count > 200) {
+            return TFModbusTCPExceptionCode::IllegalDataAddress;
+        }
+
+        if (request_count < MAX_REQUEST_COUNT) {
+            requests[request_count++] = Request{function_code, start_address, data_count};
+        }
+
+        switch (function_code) {
+        case TFModbusTCPFunctionCode::ReadHoldingRegisters:
+            memcpy(data_values, registers + start_address, data_count * 2);
+            break;
+
+        case TFModbusTCPFunctionCode::WriteMultipleRegisters:
+            memcpy(registers + start_address, data_values, data_count * 2);
+            break;
+
+        case TFModbusTCPFunctionCode::WriteMultipleCoils:
+            for (uint16_t i = 0; i < data_count; ++i) {
+                coils[start_address + i] = ((static_cast<uint8_t *>(data_values)[i / 8] >> (i % 8)) & 1) != 0;
+            }
+
+            break;
+
+        default:
+            return TFModbusTCPExceptionCode::IllegalFunction;
+        }
+
+        return TFModbusTCPExceptionCode::Success;
+    }), "start server");
+
+    client = new TFModbusTCPClient(TFModbusTCPByteOrder::Host);
+
+    client->set_write_combining_enabled(true);
+
+    bool connected = false;
+
+    client->connect("127.0.0.1", PORT,
+    [&connected](TFGenericTCPClientConnectResult result, int error_number) {
+        (void)error_number;
+
+        connected = result == TFGenericTCPClientConnectResult::Connected;
+    },
+    [&connected](TFGenericTCPClientDisconnectReason reason, int error_number) {
+        (void)reason;
+        (void)error_number;
+
+        connected = false;
+    });
+
+    check(tick_until(&connected), "client connected");
+
+    // all transactions are scheduled before the first tick, so they are
+    // visible to the combining logic together
+    uint16_t register_values[5] = {11, 12, 13, 14, 15};
+    uint16_t read_values[4]     = {0, 0, 0, 0};
+    uint8_t coil_values[3]      = {1, 0, 1};
+    size_t order[8];
+    size_t callback_count       = 0;
+    bool all_succeeded          = true;
+    bool done                   = false;
+
+    struct Transaction
+    {
+        TFModbusTCPFunctionCode function_code;
+        uint16_t start_address;
+        uint16_t data_count;
+        void *buffer;
+    };
+
+    Transaction transactions[8] = {
+        {TFModbusTCPFunctionCode::WriteSingleRegister,    100, 1, &register_values[0]},
+        {TFModbusTCPFunctionCode::WriteSingleRegister,    101, 1, &register_values[1]},
+        {TFModbusTCPFunctionCode::WriteMultipleRegisters, 102, 2, &register_values[3]},
+        {TFModbusTCPFunctionCode::ReadHoldingRegisters,   100, 4, read_values},
+        {TFModbusTCPFunctionCode::WriteSingleRegister,    104, 1, &register_values[2]},
+        {TFModbusTCPFunctionCode::WriteSingleCoil,          9, 1, &coil_values[0]},
+        {TFModbusTCPFunctionCode::WriteSingleCoil,         10, 1, &coil_values[1]},
+        {TFModbusTCPFunctionCode::WriteSingleCoil,         11, 1, &coil_values[2]},
+    };
+
+    for (size_t i = 0; i < 8; ++i) {
+        client->transact(1, transactions[i].function_code, transactions[i].start_address, transactions[i].data_count, transactions[i].buffer, 1_s,
+        [i, &order, &callback_count, &all_succeeded, &done](TFModbusTCPClientTransactionResult result, const char *error_message) {
+            (void)error_message;
+
+            if (result != TFModbusTCPClientTransactionResult::Success) {
+                all_succeeded = false;
+            }
+
+            order[callback_count++] = i;
+            done = callback_count == 8;
+        });
+    }
+
+    check(tick_until(&done), "all callbacks fired");
+    check(all_succeeded, "all transactions succeeded");
+
+    bool in_order = true;
+
+    for (size_t i = 0; i < callback_count; ++i) {
+        in_order = in_order && order[i] == i;
+    }
+
+    check(in_order, "callbacks fired in schedule order");
+
+    check(request_count == 4, "eight transactions sent as four requests");
+    check(check_request(0, TFModbusTCPFunctionCode::WriteMultipleRegisters, 100, 4), "adjacent register writes combined into one request");
+    check(check_request(1, TFModbusTCPFunctionCode::ReadHoldingRegisters, 100, 4), "read follows the combined write");
+    check(check_request(2, TFModbusTCPFunctionCode::WriteMultipleRegisters, 104, 1), "write after the read is not combined across it");
+    check(check_request(3, TFModbusTCPFunctionCode::WriteMultipleCoils, 9, 3), "adjacent coil writes combined into one request");
+
+    check(read_values[0] == 11 && read_values[1] == 12 && read_values[2] == 14 && read_values[3] == 15, "read sees the combined write");
+    check(registers[104] == 13, "single write after the read");
+    check(coils[9] && !coils[10] && coils[11], "combined coil values");
+
+    client->disconnect();
+    server.stop();
+
+    delete client;
+
+    TFNetwork::logfln("%d failure(s)", failures);
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,254 @@
+/* TFNetwork
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+// Write shadow: writes of unchanged values are suppressed until the refresh
+// interval elapsed, the connection got closed or a read revealed a change
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <Arduino.h>
+#include "../src/TFNetwork.h"
+#include "../src/TFModbusTCPServer.h"
+#include "../src/TFModbusTCPClient.h"
+
+#define PORT 15517
+
+micros_t now_us()
+{
+    struct timeval tv;
+    static int64_t baseline_sec = 0;
+
+    gettimeofday(&tv, nullptr);
+
+    if (baseline_sec == 0) {
+        baseline_sec = tv.tv_sec;
+    }
+
+    return micros_t{(static_cast<int64_t>(tv.tv_sec) - baseline_sec) * 1000000 + tv.tv_usec};
+}
+
+static int failures = 0;
+
+static void check(bool condition, const char *description)
+{
+    TFNetwork::logfln("%s: %s", condition ? "PASS" : "FAIL", description);
+
+    if (!condition) {
+        ++failures;
+    }
+}
+
+static TFModbusTCPServer server(TFModbusTCPByteOrder::Host);
+static TFModbusTCPClient *client;
+static uint16_t registers[100];
+static size_t write_count = 0;
+static size_t done_count = 0;
+static size_t failed_count = 0;
+static bool connected = false;
+
+static bool tick_until(std::function<bool(void)> &&condition)
+{
+    micros_t deadline = calculate_deadline(3_s);
+
+    while (!condition()) {
+        if (deadline_elapsed(deadline)) {
+            return false;
+        }
+
+        server.tick();
+        client->tick();
+    }
+
+    return true;
+}
+
+static bool connect()
+{
+    client->connect("127.0.0.1", PORT,
+    [](TFGenericTCPClientConnectResult result, int error_number) {
+        (void)error_number;
+
+        connected = result == TFGenericTCPClientConnectResult::Connected;
+    },
+    [](TFGenericTCPClientDisconnectReason reason, int error_number) {
+        (void)reason;
+        (void)error_number;
+
+        connected = false;
+    });
+
+    return tick_until([]() { return connected; });
+}
+
+static void transact(TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, uint16_t *values)
+{
+    client->transact(1, function_code, start_address, data_count, values, 1_s,
+    [](TFModbusTCPClientTransactionResult result, const char *error_message) {
+        (void)error_message;
+
+        if (result != TFModbusTCPClientTransactionResult::Success) {
+            ++failed_count;
+        }
+
+        ++done_count;
+    });
+}
+
+static void write(uint16_t start_address, uint16_t data_count, uint16_t *values)
+{
+    transact(data_count == 1 ? TFModbusTCPFunctionCode::WriteSingleRegister : TFModbusTCPFunctionCode::WriteMultipleRegisters, start_address, data_count, values);
+}
+
+static bool run(size_t target_done_count)
+{
+    return tick_until([target_done_count]() { return done_count >= target_done_count; });
+}
+
+int main()
+{
+    TFNetwork::vlogfln =
+    [](const char *format, va_list args) {
+        printf("%li | ", static_cast<int64_t>(now_us()));
+        vprintf(format, args);
+        puts("");
+    };
+
+    TFNetwork::resolve =
+    [](const char *host, TFNetworkResolveResultCallback &&callback) {
+        callback(inet_addr(host), 0);
+    };
+
+    TFNetwork::get_random_uint16 =
+    []() {
+        return static_cast<uint16_t>(rand());
+    };
+
+    check(server.start(htonl(INADDR_LOOPBACK), PORT,
+    [](uint32_t peer_address, uint16_t port) {
+        (void)peer_address;
+        (void)port;
+    },
+    [](uint32_t peer_address, uint16_t port, TFModbusTCPServerDisconnectReason reason, int error_number) {
+        (void)peer_address;
+        (void)port;
+        (void)reason;
+        (void)error_number;
+    },
+    [](uint8_t unit_id, TFModbusTCPFunctionCode function_code, uint16_t start_address, uint16_t data_count, void *data_values) {
+        (void)unit_id;
+
+        if (start_address + data_count > 100) {
+            return TFModbusTCPExceptionCode::IllegalDataAddress;
+        }
+
+        switch (function_code) {
+        case TFModbusTCPFunctionCode::ReadHoldingRegisters:
+            memcpy(data_values, registers + start_address, data_count * 2);
+            break;
+
+        case TFModbusTCPFunctionCode::WriteMultipleRegisters:
+            memcpy(registers + start_address, data_values, data_count * 2);
+            ++write_count;
+            break;
+
+        default:
+            return TFModbusTCPExceptionCode::IllegalFunction;
+        }
+
+        return TFModbusTCPExceptionCode::Success;
+    }), "start server");
+
+    client = new TFModbusTCPClient(TFModbusTCPByteOrder::Host);
+
+    client->set_write_shadow_enabled(true, 300_ms);
+
+    check(connect(), "client connected");
+
+    uint16_t value_a   = 5;
+    uint16_t value_b   = 6;
+    uint16_t values[2] = {5, 7};
+
+    write(10, 1, &value_a);
+    check(run(1) && write_count == 1, "first write is sent");
+
+    write(10, 1, &value_a);
+    check(done_count == 2 && write_count == 1, "unchanged write is suppressed without a request");
+
+    // the second write could be overtaken by the scheduled first write
+    write(10, 1, &value_b);
+    write(10, 1, &value_a);
+    check(done_count == 2, "write is not suppressed while an overlapping write is scheduled");
+    check(run(4) && write_count == 3, "both writes are sent");
+
+    // the first tick sends the write, the server has not answered it yet
+    write(10, 1, &value_b);
+    client->tick();
+    write(10, 1, &value_a);
+    check(done_count == 4, "write is not suppressed while an overlapping write is in flight");
+    check(run(6) && write_count == 5, "both in flight writes are sent");
+
+    write(10, 2, values);
+    check(run(7) && write_count == 6, "write including an unknown value is sent");
+
+    write(10, 2, values);
+    check(done_count == 8 && write_count == 6, "unchanged multiple write is suppressed");
+
+    // the device changed a value on its own, the read reveals that
+    registers[11] = 99;
+
+    uint16_t read_values[2];
+
+    transact(TFModbusTCPFunctionCode::ReadHoldingRegisters, 10, 2, read_values);
+    check(run(9), "read of changed value");
+
+    write(10, 2, values);
+    check(run(10) && write_count == 7, "write after a read of a changed value is sent");
+
+    write(10, 2, values);
+    check(done_count == 11 && write_count == 7, "write is suppressed again");
+
+    usleep(350000);
+
+    write(10, 2, values);
+    check(run(12) && write_count == 8, "write is sent after the refresh interval");
+
+    client->disconnect();
+
+    check(connect(), "client reconnected");
+
+    write(10, 2, values);
+    check(run(13) && write_count == 9, "write is sent after a reconnect");
+
+    check(failed_count == 0, "all transactions succeeded");
+
+    client->disconnect();
+    server.stop();
+
+    delete client;
+
+    TFNetwork::logfln("%d failure(s)", failures);
+
+    return failures > 0 ? 1 : 0;
+}